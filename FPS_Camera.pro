@@ -17,15 +17,75 @@ CONFIG-=app_bundle
 CONFIG +=c++11
 # Auto include all .cpp files in the project src directory (can specifiy individually if required)
 SOURCES+= $$PWD/src/NGLScene.cpp    \
-					$$PWD/src/main.cpp
+					$$PWD/src/main.cpp \
+					$$PWD/src/CameraController.cpp \
+					$$PWD/src/FrameProfiler.cpp \
+					$$PWD/src/Log.cpp \
+					$$PWD/src/FrameCapture.cpp \
+					$$PWD/src/FrameRecorder.cpp \
+					$$PWD/src/StagingPool.cpp \
+					$$PWD/src/InstancedMesh.cpp \
+					$$PWD/src/CameraUBO.cpp \
+					$$PWD/src/RaymarchPass.cpp \
+					$$PWD/src/OffscreenRenderer.cpp \
+					$$PWD/src/Frustum.cpp \
+					$$PWD/src/SceneBVH.cpp \
+					$$PWD/src/Scene.cpp \
+					$$PWD/src/TransformSystem.cpp \
+					$$PWD/src/CollisionWorld.cpp \
+					$$PWD/src/JobSystem.cpp \
+					$$PWD/src/RigidBodies.cpp \
+					$$PWD/src/InputSystem.cpp \
+					$$PWD/src/InputRecording.cpp \
+					$$PWD/src/Simulation.cpp \
+					$$PWD/src/SdfScene.cpp \
+					$$PWD/src/SdfBrickCache.cpp \
+					$$PWD/src/RgbImage.cpp \
+					$$PWD/src/Raymarcher.cpp \
+					$$PWD/src/DynamicResolution.cpp
 # same for the .h files
-HEADERS+= $$PWD/include/NGLScene.h
+HEADERS+= $$PWD/include/NGLScene.h \
+					$$PWD/include/CameraController.h \
+					$$PWD/include/PhysicsState.h \
+					$$PWD/include/FixedTimestep.h \
+					$$PWD/include/CoreMath.h \
+					$$PWD/include/FrameProfiler.h \
+					$$PWD/include/Log.h \
+					$$PWD/include/SpscQueue.h \
+					$$PWD/include/FrameCapture.h \
+					$$PWD/include/FrameRecorder.h \
+					$$PWD/include/StagingPool.h \
+					$$PWD/include/InstancedMesh.h \
+					$$PWD/include/CameraUBO.h \
+					$$PWD/include/RaymarchPass.h \
+					$$PWD/include/OffscreenRenderer.h \
+					$$PWD/include/Bounds.h \
+					$$PWD/include/Frustum.h \
+					$$PWD/include/SceneBVH.h \
+					$$PWD/include/Scene.h \
+					$$PWD/include/TransformSystem.h \
+					$$PWD/include/CollisionWorld.h \
+					$$PWD/include/JobSystem.h \
+					$$PWD/include/RigidBodies.h \
+					$$PWD/include/InputSystem.h \
+					$$PWD/include/InputRecording.h \
+					$$PWD/include/Simulation.h \
+					$$PWD/include/FrameSnapshot.h \
+					$$PWD/include/TripleBuffer.h \
+					$$PWD/include/SdfScene.h \
+					$$PWD/include/SdfBrickCache.h \
+					$$PWD/include/RgbImage.h \
+					$$PWD/include/Raymarcher.h \
+					$$PWD/include/DynamicResolution.h \
+					$$PWD/include/SdfPrimitives.h \
+					$$PWD/include/SimdFloat.h
 # and add the include dir into the search path for Qt and make
 INCLUDEPATH +=./include
 # where our exe is going to live (root of project)
 DESTDIR=./
 # add the glsl shader files
 OTHER_FILES+= shaders/*.glsl \
+							scenes/*.scene \
 							README.md
 # were are going to default to a console app
 CONFIG += console
@@ -35,9 +95,11 @@ CONFIG += console
 	copydata.commands = echo "creating destination dirs" ;
 	# now make a dir
 	copydata.commands += mkdir -p $$OUT_PWD/shaders ;
+	copydata.commands += mkdir -p $$OUT_PWD/scenes ;
 	copydata.commands += echo "copying files" ;
 	# then copy the files
 	copydata.commands += $(COPY_DIR) $$PWD/shaders/* $$OUT_PWD/shaders/ ;
+	copydata.commands += $(COPY_DIR) $$PWD/scenes/* $$OUT_PWD/scenes/ ;
 	# now make sure the first target is built before copy
 	first.depends = $(first) copydata
 	export(first.depends)
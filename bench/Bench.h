@@ -0,0 +1,76 @@
+#ifndef BENCH_H__
+#define BENCH_H__
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Bench.h
+/// @brief tiny microbenchmark harness. Each benchmark registers a factory that is given a batch size and
+/// returns a kernel processing that many items, the runner times the kernel and reports ns per item.
+//----------------------------------------------------------------------------------------------------------------------
+namespace bench
+{
+
+typedef std::function<void()> Kernel;
+typedef std::function<Kernel(size_t _batch)> Factory;
+
+struct Benchmark
+{
+  std::string name;
+  Factory factory;
+  /// @brief the largest batch this benchmark will be run at (some are too slow or big for 1M)
+  size_t maxBatch;
+};
+
+struct Result
+{
+  std::string name;
+  size_t batch;
+  size_t iterations;
+  double nsPerOp;
+  double itemsPerSecond;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief all benchmarks linked into the executable
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<Benchmark> & registry();
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief registers a benchmark at static initialisation time
+//----------------------------------------------------------------------------------------------------------------------
+struct Registrar
+{
+  Registrar(const char *_name, Factory _factory, size_t _maxBatch=1000000)
+  {
+    registry().push_back({_name,_factory,_maxBatch});
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief stop the optimiser from discarding a value we computed only to time it
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void doNotOptimize(const T &_value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(_value) : "memory");
+#else
+  static volatile const T *sink;
+  sink=&_value;
+#endif
+}
+
+} // end namespace bench
+
+#define BENCH_CONCAT_INNER(a,b) a##b
+#define BENCH_CONCAT(a,b) BENCH_CONCAT_INNER(a,b)
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief BENCHMARK("name",factory) or BENCHMARK("name",factory,maxBatch)
+//----------------------------------------------------------------------------------------------------------------------
+#define BENCHMARK(...) static bench::Registrar BENCH_CONCAT(s_benchRegistrar,__LINE__)(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,108 @@
+/****************************************************************************
+microbenchmark runner, usage
+  FPSBench [--format csv|json] [--filter substring] [--max-batch N] [--min-time seconds]
+results go to stdout so they can be redirected and diffed between builds
+****************************************************************************/
+#include "Bench.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace bench
+{
+
+std::vector<Benchmark> & registry()
+{
+  static std::vector<Benchmark> s_registry;
+  return s_registry;
+}
+
+} // end namespace bench
+
+static bench::Result runOne(const bench::Benchmark &_b, size_t _batch, double _minTime)
+{
+  typedef std::chrono::steady_clock Clock;
+  bench::Kernel kernel=_b.factory(_batch);
+  // warm caches and let any lazy setup happen outside the timed region
+  kernel();
+
+  size_t iterations=1;
+  double elapsed=0.0;
+  for(;;)
+  {
+    Clock::time_point start=Clock::now();
+    for(size_t i=0; i<iterations; ++i)
+    {
+      kernel();
+    }
+    elapsed=std::chrono::duration<double>(Clock::now()-start).count();
+    if(elapsed>=_minTime)
+    {
+      break;
+    }
+    iterations*=2;
+  }
+  double ops=static_cast<double>(iterations)*static_cast<double>(_batch);
+  return {_b.name,_batch,iterations,elapsed*1.0e9/ops,ops/elapsed};
+}
+
+int main(int argc, char **argv)
+{
+  std::string format="csv";
+  std::string filter;
+  size_t maxBatch=1000000;
+  double minTime=0.05;
+  for(int i=1; i<argc; ++i)
+  {
+    if(!strcmp(argv[i],"--format") && i+1<argc)         format=argv[++i];
+    else if(!strcmp(argv[i],"--filter") && i+1<argc)    filter=argv[++i];
+    else if(!strcmp(argv[i],"--max-batch") && i+1<argc) maxBatch=std::strtoull(argv[++i],nullptr,10);
+    else if(!strcmp(argv[i],"--min-time") && i+1<argc)  minTime=std::atof(argv[++i]);
+    else
+    {
+      std::cerr<<"usage : "<<argv[0]<<" [--format csv|json] [--filter substring] [--max-batch N] [--min-time seconds]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  bool json= format=="json";
+  if(json)
+  {
+    std::printf("[\n");
+  }
+  else
+  {
+    std::printf("name,batch,iterations,ns_per_op,items_per_second\n");
+  }
+
+  bool first=true;
+  for(const bench::Benchmark &b : bench::registry())
+  {
+    if(!filter.empty() && b.name.find(filter)==std::string::npos)
+    {
+      continue;
+    }
+    for(size_t batch=1; batch<=maxBatch && batch<=b.maxBatch; batch*=10)
+    {
+      bench::Result r=runOne(b,batch,minTime);
+      if(json)
+      {
+        std::printf("%s  {\"name\": \"%s\", \"batch\": %zu, \"iterations\": %zu, \"ns_per_op\": %.3f, \"items_per_second\": %.1f}",
+                    first ? "" : ",\n",r.name.c_str(),r.batch,r.iterations,r.nsPerOp,r.itemsPerSecond);
+      }
+      else
+      {
+        std::printf("%s,%zu,%zu,%.3f,%.1f\n",r.name.c_str(),r.batch,r.iterations,r.nsPerOp,r.itemsPerSecond);
+      }
+      std::fflush(stdout);
+      first=false;
+    }
+  }
+  if(json)
+  {
+    std::printf("\n]\n");
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/****************************************************************************
+camera, matrix and collision hot paths that NGLScene runs every tick / draw
+****************************************************************************/
+#include "Bench.h"
+#include "CameraController.h"
+#include "CoreMath.h"
+#include <memory>
+
+// WASD movement plus jump integration, one step per controller
+static bench::Kernel cameraStep(size_t _batch)
+{
+  std::vector<fps::CameraController> bodies(_batch);
+  for(size_t i=0; i<_batch; ++i)
+  {
+    bodies[i].setLook(static_cast<float>(i%90),static_cast<float>(i%360));
+    bodies[i].setAction(fps::CameraController::FORWARD,true);
+    bodies[i].setAction(fps::CameraController::LEFT,(i&1)!=0);
+  }
+  return [bodies]() mutable
+  {
+    for(fps::CameraController &b : bodies)
+    {
+      b.step(1.0f/120.0f);
+    }
+    bench::doNotOptimize(bodies[0].position());
+  };
+}
+BENCHMARK("camera_step",cameraStep);
+
+// the lookAt + perspective + MV / MVP / normal matrix chain from loadMatricesToShader
+static bench::Kernel matrixChain(size_t _batch)
+{
+  std::vector<fps::Vec3> eyes(_batch);
+  std::vector<fps::Vec3> models(_batch);
+  for(size_t i=0; i<_batch; ++i)
+  {
+    float f=static_cast<float>(i);
+    eyes[i].set(f*0.01f,5.0f,15.0f);
+    models[i].set(-2.0f+f*0.001f,-3.0f,0.0f);
+  }
+  return [eyes,models]()
+  {
+    fps::Vec3 front(0.0f,0.0f,-1.0f);
+    fps::Vec3 up(0.0f,1.0f,0.0f);
+    float sum=0.0f;
+    for(size_t i=0; i<eyes.size(); ++i)
+    {
+      fps::Mat4 M;
+      M.translate(models[i].m_x,models[i].m_y,models[i].m_z);
+      fps::Mat4 view=fps::lookAt(eyes[i],eyes[i]+front,up);
+      fps::Mat4 project=fps::perspective(45.0f,1024.0f/768.0f,0.5f,200.0f);
+      fps::Mat4 MV=M*view;
+      fps::Mat4 MVP=MV*project;
+      fps::Mat3 normalMatrix=MV.toMat3();
+      normalMatrix.inverse();
+      sum+=MVP.m_m[3][2]+normalMatrix.m_m[1][1];
+    }
+    bench::doNotOptimize(sum);
+  };
+}
+BENCHMARK("matrix_chain",matrixChain);
+
+static bench::Kernel sphereToPlane(size_t _batch)
+{
+  std::vector<fps::Vec3> centres(_batch);
+  for(size_t i=0; i<_batch; ++i)
+  {
+    centres[i].set(0.0f,static_cast<float>(i%7)-2.0f,0.0f);
+  }
+  return [centres]()
+  {
+    fps::Vec3 planePoint(0.0f,0.01f,0.0f);
+    fps::Vec3 planeNormal(0.0f,1.0f,0.0f);
+    size_t hits=0;
+    for(const fps::Vec3 &c : centres)
+    {
+      hits+=fps::sphereToPlane(c,planePoint,planeNormal) ? 1 : 0;
+    }
+    bench::doNotOptimize(hits);
+  };
+}
+BENCHMARK("sphere_to_plane",sphereToPlane);
+
+// restitution impulse against the ground, the velocity is reset each call so it never decays to denormals
+static bench::Kernel collisionResponse(size_t _batch)
+{
+  std::vector<fps::CameraController> bodies(_batch);
+  return [bodies]() mutable
+  {
+    fps::Vec3 normal(0.0f,1.0f,0.0f);
+    for(fps::CameraController &b : bodies)
+    {
+      b.physics().velocity.set(1.0f,-20.0f,0.5f);
+      b.collisionResponse(normal);
+    }
+    bench::doNotOptimize(bodies[0].physics().velocity);
+  };
+}
+BENCHMARK("collision_response",collisionResponse);
+
+// fast bodies at a 30Hz tick running into a wall thinner than one tick of their movement, tests/CameraTest.cpp
+// checks none of them tunnel through it
+static bench::Kernel cameraStepCCD(size_t _batch)
+{
+  std::shared_ptr<fps::CollisionWorld> world=std::make_shared<fps::CollisionWorld>();
+  world->addPlane(fps::Vec3(0.0f,1.0f,0.0f),1.0f);
+  world->addBox(fps::AABB(fps::Vec3(-1.0e4f,-1.0f,-20.05f),fps::Vec3(1.0e4f,50.0f,-20.0f)));
+  world->build();
+  std::vector<fps::CameraController> bodies(_batch);
+  for(size_t i=0; i<_batch; ++i)
+  {
+    bodies[i].setCollisionWorld(world.get());
+    bodies[i].reset(fps::Vec3(static_cast<float>(i%100),0.0f,0.0f));
+    bodies[i].setLook(0.0f,static_cast<float>(i%120)-60.0f);
+    bodies[i].setAction(fps::CameraController::FORWARD,true);
+    bodies[i].m_walkSpeed=500.0f;
+  }
+  // walk them up against the wall first
+  for(size_t s=0; s<30; ++s)
+  {
+    for(fps::CameraController &b : bodies)
+    {
+      b.step(1.0f/30.0f);
+    }
+  }
+  return [world,bodies]() mutable
+  {
+    for(fps::CameraController &b : bodies)
+    {
+      b.step(1.0f/30.0f);
+    }
+    bench::doNotOptimize(bodies[0].position());
+  };
+}
+BENCHMARK("camera_step_ccd",cameraStepCCD,100000);
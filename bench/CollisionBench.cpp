@@ -0,0 +1,86 @@
+/****************************************************************************
+camera body sweeps against a level, batch is both the number of colliders
+and the number of sweeps so ns_per_op is the cost of one sweep. The level
+grows with the batch at a fixed density, as real levels do. The grid is
+checked against the brute force sweep in tests/CollisionTest.cpp
+****************************************************************************/
+#include "Bench.h"
+#include "CollisionWorld.h"
+#include <cmath>
+#include <memory>
+#include <random>
+
+namespace
+{
+
+struct CollisionScene
+{
+  fps::CollisionWorld m_world;
+  std::vector<fps::Vec3> m_starts;
+  std::vector<fps::Vec3> m_ends;
+};
+
+std::shared_ptr<CollisionScene> makeScene(size_t _count)
+{
+  std::shared_ptr<CollisionScene> scene=std::make_shared<CollisionScene>();
+  float half=4.0f*std::sqrt(static_cast<float>(_count));
+  std::mt19937 rng(99);
+  std::uniform_real_distribution<float> pos(-half,half);
+  std::uniform_real_distribution<float> size(0.2f,2.0f);
+  std::uniform_real_distribution<float> move(-0.5f,0.5f);
+  for(size_t i=0; i<_count; ++i)
+  {
+    fps::Vec3 c(pos(rng),size(rng)*2.0f,pos(rng));
+    switch(i%3)
+    {
+      case 0 : scene->m_world.addSphere(c,size(rng)); break;
+      case 1 :
+      {
+        fps::Vec3 e(size(rng),size(rng),size(rng));
+        scene->m_world.addBox(fps::AABB(c-e,c+e));
+        break;
+      }
+      default : scene->m_world.addTriangle(c,c+fps::Vec3(size(rng),0.0f,0.0f),c+fps::Vec3(0.0f,size(rng),size(rng))); break;
+    }
+  }
+  scene->m_world.addPlane(fps::Vec3(0.0f,1.0f,0.0f),1.0f);
+  scene->m_world.build();
+  // a tick of camera movement from random places in the level
+  for(size_t i=0; i<_count; ++i)
+  {
+    fps::Vec3 start(pos(rng),1.0f+size(rng),pos(rng));
+    scene->m_starts.push_back(start);
+    scene->m_ends.push_back(start+fps::Vec3(move(rng),move(rng),move(rng)));
+  }
+  return scene;
+}
+
+} // end anonymous namespace
+
+static bench::Kernel collisionSweepGrid(size_t _batch)
+{
+  std::shared_ptr<CollisionScene> scene=makeScene(_batch);
+  return [scene,_batch]()
+  {
+    fps::CollisionWorld::Hit hit;
+    for(size_t i=0; i<_batch; ++i)
+    {
+      bench::doNotOptimize(scene->m_world.sweepSphere(scene->m_starts[i],scene->m_ends[i],1.0f,hit));
+    }
+  };
+}
+BENCHMARK("collision_sweep_grid",collisionSweepGrid,100000);
+
+static bench::Kernel collisionSweepBruteForce(size_t _batch)
+{
+  std::shared_ptr<CollisionScene> scene=makeScene(_batch);
+  return [scene,_batch]()
+  {
+    fps::CollisionWorld::Hit hit;
+    for(size_t i=0; i<_batch; ++i)
+    {
+      bench::doNotOptimize(scene->m_world.sweepSphereBruteForce(scene->m_starts[i],scene->m_ends[i],1.0f,hit));
+    }
+  };
+}
+BENCHMARK("collision_sweep_brute_force",collisionSweepBruteForce,1000);
@@ -0,0 +1,63 @@
+/****************************************************************************
+frustum culling of a scattered scene, batch is the number of objects. The
+tree is checked against the brute force loop in tests/CullTest.cpp
+****************************************************************************/
+#include "Bench.h"
+#include "SceneBVH.h"
+#include <memory>
+#include <random>
+
+namespace
+{
+
+struct CullScene
+{
+  fps::SceneBVH m_bvh;
+  fps::Mat4 m_viewProject;
+  std::vector<uint32_t> m_visible;
+};
+
+std::shared_ptr<CullScene> makeScene(size_t _count)
+{
+  std::shared_ptr<CullScene> scene=std::make_shared<CullScene>();
+  // objects spread over a 1000 unit square, about the density of a large level
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> pos(-500.0f,500.0f);
+  std::uniform_real_distribution<float> height(0.0f,20.0f);
+  std::uniform_real_distribution<float> radius(0.5f,3.0f);
+  std::vector<fps::AABB> bounds(_count);
+  for(size_t i=0; i<_count; ++i)
+  {
+    bounds[i]=fps::AABB::fromSphere(fps::Vec3(pos(rng),height(rng),pos(rng)),radius(rng));
+  }
+  scene->m_bvh.build(bounds);
+  scene->m_viewProject=fps::lookAt(fps::Vec3(0.0f,5.0f,0.0f),fps::Vec3(100.0f,0.0f,-100.0f),fps::Vec3(0.0f,1.0f,0.0f))*
+                       fps::perspective(45.0f,16.0f/9.0f,0.05f,350.0f);
+  return scene;
+}
+
+} // end anonymous namespace
+
+static bench::Kernel cullBVH(size_t _batch)
+{
+  std::shared_ptr<CullScene> scene=makeScene(_batch);
+  return [scene]()
+  {
+    fps::Frustum frustum(scene->m_viewProject);
+    scene->m_bvh.cull(frustum,scene->m_visible);
+    bench::doNotOptimize(scene->m_visible.data());
+  };
+}
+BENCHMARK("cull_bvh",cullBVH,100000);
+
+static bench::Kernel cullBruteForce(size_t _batch)
+{
+  std::shared_ptr<CullScene> scene=makeScene(_batch);
+  return [scene]()
+  {
+    fps::Frustum frustum(scene->m_viewProject);
+    scene->m_bvh.cullBruteForce(frustum,scene->m_visible);
+    bench::doNotOptimize(scene->m_visible.data());
+  };
+}
+BENCHMARK("cull_brute_force",cullBruteForce,100000);
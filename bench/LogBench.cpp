@@ -0,0 +1,36 @@
+/****************************************************************************
+cost of a log call on the calling thread, compiled out and enabled
+****************************************************************************/
+#include "Bench.h"
+#include "Log.h"
+
+// below FPS_LOG_LEVEL so this should cost nothing at all
+static bench::Kernel logCompiledOut(size_t _batch)
+{
+  return [_batch]()
+  {
+    for(size_t i=0; i<_batch; ++i)
+    {
+      FPS_LOG(-1,"velocity=%f",static_cast<float>(i));
+    }
+  };
+}
+BENCHMARK("log_compiled_out",logCompiledOut);
+
+// the writer goes to /dev/null, the queue may fill and drop which is part of what we measure
+static bench::Kernel logEnabled(size_t _batch)
+{
+  static FILE *s_null=fopen("/dev/null","w");
+  if(s_null!=nullptr)
+  {
+    fps::Log::instance().setOutput(s_null);
+  }
+  return [_batch]()
+  {
+    for(size_t i=0; i<_batch; ++i)
+    {
+      FPS_LOG_ERROR("velocity=%f",static_cast<float>(i));
+    }
+  };
+}
+BENCHMARK("log_enabled",logEnabled,10000);
@@ -0,0 +1,91 @@
+/****************************************************************************
+one physics tick of many debris bodies, batch is the number of bodies so
+ns_per_op is the cost of one body per tick. The active benchmarks never let
+bodies sleep, rigid_step_sleeping is a settled layer where every body is
+asleep. rigid_step_threads_N steps scattered heaps of debris (many contact
+islands) on an N thread JobSystem. tests/PhysicsTest.cpp checks the SSE
+kernels against the scalar ones and the threaded step against the single
+thread one on the same scenes, built in PhysicsScenes.h
+****************************************************************************/
+#include "Bench.h"
+#include "PhysicsScenes.h"
+#include <memory>
+
+namespace
+{
+
+const float DT=1.0f/120.0f;
+
+bench::Kernel makeActive(size_t _batch, fps::RigidBodies::Integrator _integrator, bool _simd)
+{
+  std::shared_ptr<bench::PhysicsScene> scene=bench::makeScene(_batch,bench::activeConfig(_integrator,_simd),false);
+  for(int s=0; s<10; ++s)
+  {
+    scene->m_bodies.step(DT);
+  }
+  return [scene]()
+  {
+    scene->m_bodies.step(DT);
+    bench::doNotOptimize(scene->m_bodies.contactCount());
+  };
+}
+
+bench::Kernel makeThreaded(size_t _batch, size_t _threads)
+{
+  std::shared_ptr<bench::PhysicsScene> scene=bench::makeHeaps(_batch,_threads);
+  for(int s=0; s<10; ++s)
+  {
+    scene->m_bodies.step(DT);
+  }
+  return [scene]()
+  {
+    scene->m_bodies.step(DT);
+    bench::doNotOptimize(scene->m_bodies.contactCount());
+  };
+}
+
+} // end anonymous namespace
+
+static bench::Kernel rigidStepEuler(size_t _batch)
+{
+  return makeActive(_batch,fps::RigidBodies::SEMI_IMPLICIT_EULER,true);
+}
+BENCHMARK("rigid_step_euler",rigidStepEuler,100000);
+
+static bench::Kernel rigidStepVerlet(size_t _batch)
+{
+  return makeActive(_batch,fps::RigidBodies::VERLET,true);
+}
+BENCHMARK("rigid_step_verlet",rigidStepVerlet,100000);
+
+static bench::Kernel rigidStepScalar(size_t _batch)
+{
+  return makeActive(_batch,fps::RigidBodies::SEMI_IMPLICIT_EULER,false);
+}
+BENCHMARK("rigid_step_scalar",rigidStepScalar,100000);
+
+static bench::Kernel rigidStepSleeping(size_t _batch)
+{
+  std::shared_ptr<bench::PhysicsScene> scene=bench::makeScene(_batch,fps::RigidBodies::Config(),true);
+  for(int s=0; s<240 && scene->m_bodies.awakeCount()!=0; ++s)
+  {
+    scene->m_bodies.step(DT);
+  }
+  return [scene]()
+  {
+    scene->m_bodies.step(DT);
+    bench::doNotOptimize(scene->m_bodies.contactCount());
+  };
+}
+BENCHMARK("rigid_step_sleeping",rigidStepSleeping,100000);
+
+static bench::Kernel rigidStepThreads1(size_t _batch) { return makeThreaded(_batch,1); }
+static bench::Kernel rigidStepThreads2(size_t _batch) { return makeThreaded(_batch,2); }
+static bench::Kernel rigidStepThreads4(size_t _batch) { return makeThreaded(_batch,4); }
+static bench::Kernel rigidStepThreads8(size_t _batch) { return makeThreaded(_batch,8); }
+static bench::Kernel rigidStepThreads16(size_t _batch) { return makeThreaded(_batch,16); }
+BENCHMARK("rigid_step_threads_1",rigidStepThreads1,100000);
+BENCHMARK("rigid_step_threads_2",rigidStepThreads2,100000);
+BENCHMARK("rigid_step_threads_4",rigidStepThreads4,100000);
+BENCHMARK("rigid_step_threads_8",rigidStepThreads8,100000);
+BENCHMARK("rigid_step_threads_16",rigidStepThreads16,100000);
@@ -0,0 +1,105 @@
+#ifndef PHYSICSSCENES_H__
+#define PHYSICSSCENES_H__
+
+#include "JobSystem.h"
+#include "RigidBodies.h"
+#include <cmath>
+#include <memory>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file PhysicsScenes.h
+/// @brief the debris scenes PhysicsBench times and tests/PhysicsTest.cpp checks, built in one place so the
+/// tests cover exactly the bodies the benchmarks report on
+//----------------------------------------------------------------------------------------------------------------------
+namespace bench
+{
+
+const float DEBRIS_RADIUS=0.25f;
+
+struct PhysicsScene
+{
+  fps::CollisionWorld m_world;
+  fps::RigidBodies m_bodies;
+  /// @brief set when the scene steps on its own JobSystem
+  std::unique_ptr<fps::JobSystem> m_jobs;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a block of touching bodies settling in a walled pit, or one resting layer on the floor
+//----------------------------------------------------------------------------------------------------------------------
+inline std::shared_ptr<PhysicsScene> makeScene(size_t _count, const fps::RigidBodies::Config &_config, bool _layer)
+{
+  std::shared_ptr<PhysicsScene> scene=std::make_shared<PhysicsScene>();
+  size_t side=_layer ? static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>(_count))))
+                     : static_cast<size_t>(std::ceil(std::cbrt(static_cast<float>(_count))));
+  float spacing=2.0f*DEBRIS_RADIUS;
+  float half=0.5f*spacing*side+1.0f;
+  scene->m_world.addPlane(fps::Vec3(0.0f,1.0f,0.0f),1.0f);
+  scene->m_world.addPlane(fps::Vec3(1.0f,0.0f,0.0f),half);
+  scene->m_world.addPlane(fps::Vec3(-1.0f,0.0f,0.0f),half);
+  scene->m_world.addPlane(fps::Vec3(0.0f,0.0f,1.0f),half);
+  scene->m_world.addPlane(fps::Vec3(0.0f,0.0f,-1.0f),half);
+  scene->m_world.build();
+  fps::RigidBodies::Config config=_config;
+  config.cellSize=2.5f*DEBRIS_RADIUS;
+  scene->m_bodies.config()=config;
+  scene->m_bodies.setWorld(&scene->m_world);
+  for(size_t i=0; i<_count; ++i)
+  {
+    size_t x=i%side;
+    size_t z=(i/side)%side;
+    size_t y=_layer ? 0 : i/(side*side);
+    // a little jitter so the block does not stay a perfect lattice
+    float jitter=_layer ? 0.0f : 0.01f*static_cast<float>((i*7)%5);
+    scene->m_bodies.add(fps::Vec3(spacing*x-half+1.0f+jitter,-1.0f+DEBRIS_RADIUS+spacing*y,spacing*z-half+1.0f),
+                        DEBRIS_RADIUS);
+  }
+  return scene;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief bodies that never sleep, so every step does the full work
+//----------------------------------------------------------------------------------------------------------------------
+inline fps::RigidBodies::Config activeConfig(fps::RigidBodies::Integrator _integrator, bool _simd)
+{
+  fps::RigidBodies::Config config;
+  config.integrator=_integrator;
+  config.simd=_simd;
+  config.sleepTime=1.0e30f;
+  return config;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief heaps of 64 touching bodies dropped a few units apart across a floor, many separate contact islands
+/// @param [in] _threads size of the scene's own JobSystem, 0 steps on the calling thread
+//----------------------------------------------------------------------------------------------------------------------
+inline std::shared_ptr<PhysicsScene> makeHeaps(size_t _count, size_t _threads)
+{
+  std::shared_ptr<PhysicsScene> scene=std::make_shared<PhysicsScene>();
+  scene->m_world.addPlane(fps::Vec3(0.0f,1.0f,0.0f),1.0f);
+  scene->m_world.build();
+  fps::RigidBodies::Config config=activeConfig(fps::RigidBodies::SEMI_IMPLICIT_EULER,true);
+  config.cellSize=2.5f*DEBRIS_RADIUS;
+  scene->m_bodies.config()=config;
+  scene->m_bodies.setWorld(&scene->m_world);
+  if(_threads!=0)
+  {
+    scene->m_jobs.reset(new fps::JobSystem(_threads));
+    scene->m_bodies.setJobSystem(scene->m_jobs.get());
+  }
+  const size_t heap=64;
+  size_t heapsPerRow=static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>((_count+heap-1)/heap))));
+  for(size_t i=0; i<_count; ++i)
+  {
+    size_t h=i/heap;
+    size_t b=i%heap;
+    fps::Vec3 origin(4.0f*(h%heapsPerRow),0.0f,4.0f*(h/heapsPerRow));
+    fps::Vec3 offset(static_cast<float>(b%4)+0.01f*((i*7)%5),static_cast<float>(b/16),static_cast<float>((b/4)%4));
+    scene->m_bodies.add(origin+offset*(2.0f*DEBRIS_RADIUS),DEBRIS_RADIUS);
+  }
+  return scene;
+}
+
+} // end namespace bench
+
+#endif
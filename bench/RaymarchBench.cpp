@@ -0,0 +1,100 @@
+/****************************************************************************
+the CPU raymarcher on iq's original camera, batch is the number of pixels
+so ns_per_op is the cost of one shaded ray. Batches are rows of up to 100
+pixels of the same view, tests/RaymarchTest.cpp checks the packets against
+one ray at a time. dynamic_resolution feeds the live pass's resolution
+controller frame times from a model of a GPU, batch is the number of frames
+****************************************************************************/
+#include "Bench.h"
+#include "DynamicResolution.h"
+#include "Raymarcher.h"
+#include <algorithm>
+#include <deque>
+#include <memory>
+
+namespace
+{
+
+struct Frame
+{
+  fps::Raymarcher m_raymarcher;
+  fps::Mat4 m_view;
+  fps::RgbImage m_image;
+  int m_width;
+  int m_height;
+};
+
+std::shared_ptr<Frame> makeFrame(size_t _pixels, bool _scalar)
+{
+  std::shared_ptr<Frame> frame=std::make_shared<Frame>();
+  frame->m_raymarcher.settings().m_scalar=_scalar;
+  frame->m_view=fps::Raymarcher::shaderView(1.0f,0.0f,0.0f);
+  frame->m_width=static_cast<int>(std::min<size_t>(_pixels,100));
+  frame->m_height=static_cast<int>(_pixels/frame->m_width);
+  return frame;
+}
+
+void render(Frame &_frame)
+{
+  _frame.m_raymarcher.render(_frame.m_view,fps::Raymarcher::SHADER_FOV,_frame.m_width,_frame.m_height,nullptr,
+                             _frame.m_image);
+}
+
+// a frame costs a fixed part and a part per pixel, and its time is only known a few frames later as with
+// the GL_TIME_ELAPSED ring
+struct GpuModel
+{
+  fps::DynamicResolution m_controller;
+  std::deque<float> m_inFlight;
+  float m_fixedMs=2.0f;
+  float m_fullFrameMs=30.0f;
+
+  float frame()
+  {
+    float scale=m_controller.scale();
+    m_inFlight.push_back(m_fixedMs+m_fullFrameMs*scale*scale);
+    if(m_inFlight.size()>3)
+    {
+      m_controller.addFrame(m_inFlight.front());
+      m_inFlight.pop_front();
+    }
+    return scale;
+  }
+};
+
+} // end anonymous namespace
+
+static bench::Kernel raymarchScalar(size_t _batch)
+{
+  std::shared_ptr<Frame> frame=makeFrame(_batch,true);
+  return [frame]()
+  {
+    render(*frame);
+    bench::doNotOptimize(frame->m_image.pixels()[0]);
+  };
+}
+BENCHMARK("raymarch_scalar",raymarchScalar,10000);
+
+static bench::Kernel raymarchSimd(size_t _batch)
+{
+  std::shared_ptr<Frame> frame=makeFrame(_batch,false);
+  return [frame]()
+  {
+    render(*frame);
+    bench::doNotOptimize(frame->m_image.pixels()[0]);
+  };
+}
+BENCHMARK("raymarch_simd",raymarchSimd,10000);
+
+static bench::Kernel dynamicResolution(size_t _batch)
+{
+  std::shared_ptr<GpuModel> gpu=std::make_shared<GpuModel>();
+  return [gpu,_batch]()
+  {
+    for(size_t i=0; i<_batch; ++i)
+    {
+      bench::doNotOptimize(gpu->frame());
+    }
+  };
+}
+BENCHMARK("dynamic_resolution",dynamicResolution,10000);
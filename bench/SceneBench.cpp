@@ -0,0 +1,68 @@
+/****************************************************************************
+level load time, batch is the number of objects. scene_open_mapped maps a
+compiled file, scene_compile_text parses the same level from text
+****************************************************************************/
+#include "Bench.h"
+#include "Scene.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace
+{
+
+std::string levelText(size_t _count)
+{
+  std::ostringstream text;
+  text<<"material copper diffuse 0.7 0.27 0.08 shininess 12.8\n";
+  text<<"mesh teapot primitive teapot radius 2\n";
+  for(size_t i=0; i<_count; ++i)
+  {
+    text<<"object teapot copper position "<<(i%100)*4.0f<<" 0 "<<(i/100)*4.0f
+        <<" rotate 0 "<<(i*37)%360<<" 0 collider sphere 2\n";
+  }
+  return text.str();
+}
+
+// compiled once per batch size and removed when the kernel goes
+struct LevelFile
+{
+  std::string m_fname;
+  ~LevelFile() { unlink(m_fname.c_str()); }
+};
+
+} // end anonymous namespace
+
+static bench::Kernel sceneOpenMapped(size_t _batch)
+{
+  std::shared_ptr<LevelFile> file=std::make_shared<LevelFile>();
+  file->m_fname="/tmp/fps_scene_bench_"+std::to_string(getpid())+".fpsb";
+  fps::Scene compiler;
+  if(!compiler.compile(levelText(_batch)) || !compiler.save(file->m_fname))
+  {
+    std::fprintf(stderr,"%s\n",compiler.error().c_str());
+    std::abort();
+  }
+  std::shared_ptr<fps::Scene> scene=std::make_shared<fps::Scene>();
+  return [file,scene]()
+  {
+    scene->open(file->m_fname);
+    bench::doNotOptimize(scene->transforms());
+  };
+}
+BENCHMARK("scene_open_mapped",sceneOpenMapped,100000);
+
+static bench::Kernel sceneCompileText(size_t _batch)
+{
+  std::shared_ptr<std::string> text=std::make_shared<std::string>(levelText(_batch));
+  std::shared_ptr<fps::Scene> scene=std::make_shared<fps::Scene>();
+  return [text,scene]()
+  {
+    scene->compile(*text);
+    bench::doNotOptimize(scene->transforms());
+  };
+}
+BENCHMARK("scene_compile_text",sceneCompileText,100000);
@@ -0,0 +1,160 @@
+/****************************************************************************
+the raymarched scene's distance field on the CPU, batch is the number of
+points (or sweeps) so ns_per_op is the cost of one. Points are scattered
+through the shader's scene the way a raymarcher or the camera would sample
+it. tests/SdfTest.cpp checks the SIMD batches against the scalar reference,
+that sweep contacts sit on the surface and that the brick cache stays within
+a voxel of the analytic field under eviction
+****************************************************************************/
+#include "Bench.h"
+#include "CollisionWorld.h"
+#include "SdfBrickCache.h"
+#include "SdfScene.h"
+#include <cmath>
+#include <memory>
+#include <random>
+
+namespace
+{
+
+struct Points
+{
+  fps::SdfScene m_scene;
+  std::vector<float> m_x;
+  std::vector<float> m_y;
+  std::vector<float> m_z;
+  std::vector<float> m_distance;
+  std::vector<float> m_material;
+};
+
+std::shared_ptr<Points> makePoints(size_t _count)
+{
+  std::shared_ptr<Points> points=std::make_shared<Points>();
+  std::mt19937 rng(19);
+  std::uniform_real_distribution<float> xz(-2.5f,2.5f);
+  std::uniform_real_distribution<float> y(-0.1f,1.0f);
+  for(size_t i=0; i<_count; ++i)
+  {
+    points->m_x.push_back(xz(rng));
+    points->m_y.push_back(y(rng));
+    points->m_z.push_back(xz(rng));
+  }
+  points->m_distance.resize(_count);
+  points->m_material.resize(_count);
+  return points;
+}
+
+// points near the surfaces of the field at the scale of scenes/raymarch.scene, where collision queries land
+std::shared_ptr<std::vector<fps::Vec3>> nearPoints(const fps::SdfScene &_field, size_t _count, float _band)
+{
+  std::shared_ptr<std::vector<fps::Vec3>> points=std::make_shared<std::vector<fps::Vec3>>();
+  std::mt19937 rng(23);
+  std::uniform_real_distribution<float> xz(-15.0f,15.0f);
+  std::uniform_real_distribution<float> y(-1.0f,3.0f);
+  while(points->size()<_count)
+  {
+    fps::Vec3 p(xz(rng),y(rng),xz(rng));
+    if(std::fabs(_field.distance(p))<_band)
+    {
+      points->push_back(p);
+    }
+  }
+  return points;
+}
+
+// query everything and bake what was asked for until nothing more is
+void warm(fps::SdfBrickCache &_cache, const std::vector<fps::Vec3> &_points)
+{
+  for(int pass=0; pass<64; ++pass)
+  {
+    for(const fps::Vec3 &p : _points)
+    {
+      bench::doNotOptimize(_cache.distance(p));
+    }
+    if(_cache.update(nullptr)==0)
+    {
+      break;
+    }
+  }
+}
+
+} // end anonymous namespace
+
+static bench::Kernel sdfMapScalar(size_t _batch)
+{
+  std::shared_ptr<Points> points=makePoints(_batch);
+  return [points,_batch]()
+  {
+    Points &p=*points;
+    p.m_scene.mapScalar(&p.m_x[0],&p.m_y[0],&p.m_z[0],_batch,&p.m_distance[0],&p.m_material[0]);
+    bench::doNotOptimize(p.m_distance[0]);
+  };
+}
+BENCHMARK("sdf_map_scalar",sdfMapScalar,100000);
+
+static bench::Kernel sdfMapSimd(size_t _batch)
+{
+  std::shared_ptr<Points> points=makePoints(_batch);
+  return [points,_batch]()
+  {
+    Points &p=*points;
+    p.m_scene.map(&p.m_x[0],&p.m_y[0],&p.m_z[0],_batch,&p.m_distance[0],&p.m_material[0]);
+    bench::doNotOptimize(p.m_distance[0]);
+  };
+}
+BENCHMARK("sdf_map_simd",sdfMapSimd,100000);
+
+static bench::Kernel sdfCameraSweep(size_t _batch)
+{
+  // the field at the scale of scenes/raymarch.scene, swept by the camera body over one tick of walking
+  const float radius=1.0f;
+  fps::SdfScene field(fps::Vec3(0.0f,-1.0f,0.0f),6.0f);
+  std::shared_ptr<fps::CollisionWorld> world=std::make_shared<fps::CollisionWorld>();
+  world->addField(field);
+  world->build();
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> xz(-15.0f,15.0f);
+  std::uniform_real_distribution<float> up(0.0f,2.0f);
+  std::uniform_real_distribution<float> move(-0.5f,0.5f);
+  std::shared_ptr<std::vector<fps::Vec3>> starts=std::make_shared<std::vector<fps::Vec3>>();
+  std::shared_ptr<std::vector<fps::Vec3>> ends=std::make_shared<std::vector<fps::Vec3>>();
+  while(starts->size()<_batch)
+  {
+    fps::Vec3 start(xz(rng),0.0f,xz(rng));
+    // start just clear of whatever is below
+    start.m_y=up(rng);
+    if(field.distance(start)<radius)
+    {
+      continue;
+    }
+    starts->push_back(start);
+    ends->push_back(start+fps::Vec3(move(rng),move(rng)-0.5f,move(rng)));
+  }
+  return [world,starts,ends,radius,_batch]()
+  {
+    fps::CollisionWorld::Hit hit;
+    for(size_t i=0; i<_batch; ++i)
+    {
+      bench::doNotOptimize(world->sweepSphere((*starts)[i],(*ends)[i],radius,hit));
+    }
+  };
+}
+BENCHMARK("sdf_camera_sweep",sdfCameraSweep,100000);
+
+static bench::Kernel sdfCacheDistance(size_t _batch)
+{
+  fps::SdfScene field(fps::Vec3(0.0f,-1.0f,0.0f),6.0f);
+  fps::SdfBrickCache::Settings settings;
+  settings.m_voxelSize=6.0f/64.0f;
+  std::shared_ptr<std::vector<fps::Vec3>> points=nearPoints(field,_batch,settings.m_band);
+  std::shared_ptr<fps::SdfBrickCache> cache=std::make_shared<fps::SdfBrickCache>(field,settings);
+  warm(*cache,*points);
+  return [cache,points]()
+  {
+    for(const fps::Vec3 &p : *points)
+    {
+      bench::doNotOptimize(cache->distance(p));
+    }
+  };
+}
+BENCHMARK("sdf_cache_distance",sdfCacheDistance,100000);
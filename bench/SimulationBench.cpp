@@ -0,0 +1,118 @@
+/****************************************************************************
+one simulation tick and the snapshot it publishes for the renderer, batch is
+the number of scene objects so ns_per_op is the cost of culling and gathering
+one object's model matrix into the snapshot. The camera turns a little every
+tick so every tick publishes, tests/SimulationTest.cpp checks the snapshots
+reach the renderer whole. input_coalesce queues batch mouse motion samples
+and collects them as one tick. input_replay flies a recorded session again,
+batch is the number of ticks
+****************************************************************************/
+#include "Bench.h"
+#include "Simulation.h"
+#include <memory>
+#include <random>
+
+namespace
+{
+
+const double DT=1.0/120.0;
+
+// a scripted session of walking, jumping and looking, recorded through the live input. No debris, that would
+// make this a physics bench
+std::shared_ptr<fps::InputRecording> recordSession(size_t _ticks)
+{
+  std::shared_ptr<fps::InputRecording> recording=std::make_shared<fps::InputRecording>();
+  fps::Simulation sim(DT,16);
+  fps::InputBindings &bindings=sim.input().bindings();
+  bindings.bindKey('W',fps::INPUT_FORWARD);
+  bindings.bindKey('A',fps::INPUT_LEFT);
+  bindings.bindKey(' ',fps::INPUT_JUMP);
+  bindings.bindButton(1,fps::INPUT_LOOK);
+  sim.controller().reset(fps::Vec3(0.0f,5.0f,15.0f));
+  sim.record(recording.get());
+  for(size_t i=0; i<_ticks; ++i)
+  {
+    int phase=static_cast<int>(i%240);
+    fps::InputSystem &input=sim.input();
+    if(phase==0) input.push(fps::InputSample::key('W',true,0.0));
+    if(phase==30) input.push(fps::InputSample::key(' ',true,0.0));
+    if(phase==40) input.push(fps::InputSample::key(' ',false,0.0));
+    if(phase==60) input.push(fps::InputSample::button(1,true,0.0));
+    if(phase>60 && phase<120) input.push(fps::InputSample::motion(3.0f,phase%7-3.0f,0.0));
+    if(phase==120)
+    {
+      input.push(fps::InputSample::button(1,false,0.0));
+      input.push(fps::InputSample::key('A',true,0.0));
+    }
+    if(phase==180) input.push(fps::InputSample::key('W',false,0.0));
+    if(phase==200) input.push(fps::InputSample::key('A',false,0.0));
+    // uneven frame times so ticks take none, one or a few steps
+    sim.advance(DT*(0.5+(i%5)*0.4));
+  }
+  sim.record(nullptr);
+  return recording;
+}
+
+} // end anonymous namespace
+
+static bench::Kernel simTickPublish(size_t _batch)
+{
+  std::shared_ptr<fps::Simulation> sim=std::make_shared<fps::Simulation>(DT,1);
+  // objects scattered all around the camera, about an eighth are in view whichever way it faces
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> pos(-150.0f,150.0f);
+  std::vector<fps::AABB> bounds(_batch);
+  for(size_t i=0; i<_batch; ++i)
+  {
+    fps::Vec3 p(pos(rng),0.0f,pos(rng));
+    sim->transforms().add(p);
+    bounds[i]=fps::AABB::fromSphere(p,1.0f);
+  }
+  sim->sceneBVH().build(bounds);
+  sim->setObjectBatches(std::vector<int>(_batch,0),1);
+  sim->controller().reset(fps::Vec3(0.0f,5.0f,0.0f));
+  sim->post(fps::Simulation::Command::viewport(1920,1080));
+  sim->advance(DT);
+  return [sim]()
+  {
+    sim->post(fps::Simulation::Command::look(0.0f,0.5f));
+    sim->advance(DT);
+    sim->acquire();
+    bench::doNotOptimize(sim->snapshot().m_visibleCount);
+  };
+}
+BENCHMARK("sim_tick_publish",simTickPublish,100000);
+
+static bench::Kernel inputCoalesce(size_t _batch)
+{
+  std::shared_ptr<fps::InputSystem> input=std::make_shared<fps::InputSystem>(_batch+1);
+  input->bindings().bindButton(1,fps::INPUT_LOOK);
+  input->push(fps::InputSample::button(1,true,0.0));
+  input->collect(0.0);
+  return [input,_batch]()
+  {
+    // a 1000Hz mouse gives a 120Hz tick eight or nine of these
+    for(size_t i=0; i<_batch; ++i)
+    {
+      input->push(fps::InputSample::motion(1.0f,1.0f,0.0));
+    }
+    bench::doNotOptimize(input->collect(0.0).m_yaw);
+  };
+}
+BENCHMARK("input_coalesce",inputCoalesce,10000);
+
+static bench::Kernel inputReplay(size_t _batch)
+{
+  std::shared_ptr<fps::InputRecording> recording=recordSession(_batch);
+  std::shared_ptr<fps::Simulation> sim=std::make_shared<fps::Simulation>(DT,16);
+  return [sim,recording]()
+  {
+    sim->replay(recording.get(),false);
+    while(sim->replaying())
+    {
+      sim->advance(0.0);
+    }
+    bench::doNotOptimize(sim->controller().position().m_x);
+  };
+}
+BENCHMARK("input_replay",inputReplay,10000);
@@ -0,0 +1,42 @@
+/****************************************************************************
+capture buffer churn while a window edge is dragged, batch is the number of
+resize events, each one asking for a 4*W*H staging buffer
+****************************************************************************/
+#include "Bench.h"
+#include "StagingPool.h"
+#include <memory>
+
+static size_t resizeBytes(size_t _i)
+{
+  // sweep widths 800..1200 as a drag would
+  size_t w=800+(_i*7)%400;
+  return 4*w*720;
+}
+
+static bench::Kernel stagingPoolResize(size_t _batch)
+{
+  std::shared_ptr<fps::StagingPool> pool=std::make_shared<fps::StagingPool>();
+  return [pool,_batch]()
+  {
+    for(size_t i=0; i<_batch; ++i)
+    {
+      fps::StagingPool::Handle h=pool->acquire(resizeBytes(i));
+      bench::doNotOptimize(h->data());
+    }
+  };
+}
+BENCHMARK("staging_pool_resize",stagingPoolResize,10000);
+
+// what resizeGL used to do, a fresh array per event
+static bench::Kernel newArrayResize(size_t _batch)
+{
+  return [_batch]()
+  {
+    for(size_t i=0; i<_batch; ++i)
+    {
+      std::unique_ptr<unsigned char[]> pixels(new unsigned char[resizeBytes(i)]);
+      bench::doNotOptimize(pixels.get());
+    }
+  };
+}
+BENCHMARK("new_array_resize",newArrayResize,10000);
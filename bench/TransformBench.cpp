@@ -0,0 +1,92 @@
+/****************************************************************************
+per frame transform cost, batch is the number of objects and every object
+is dirty each frame. transform_per_object builds each matrix the way
+ngl::Transformation::getMatrix does
+****************************************************************************/
+#include "Bench.h"
+#include "TransformSystem.h"
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+std::shared_ptr<fps::TransformSystem> makeTransforms(size_t _count)
+{
+  std::shared_ptr<fps::TransformSystem> transforms=std::make_shared<fps::TransformSystem>();
+  for(size_t i=0; i<_count; ++i)
+  {
+    float f=static_cast<float>(i);
+    transforms->add(fps::Vec3(f,0.5f*f,-f),fps::Vec3(f,2.0f*f,3.0f*f),fps::Vec3(1.0f,1.0f,1.0f));
+  }
+  return transforms;
+}
+
+const fps::Mat4 VIEW=fps::lookAt(fps::Vec3(0.0f,5.0f,15.0f),fps::Vec3(0.0f,5.0f,0.0f),fps::Vec3(0.0f,1.0f,0.0f));
+
+} // end anonymous namespace
+
+static bench::Kernel transformBatchSimd(size_t _batch)
+{
+  std::shared_ptr<fps::TransformSystem> transforms=makeTransforms(_batch);
+  return [transforms]()
+  {
+    transforms->markAllDirty();
+    transforms->updateModels();
+    bench::doNotOptimize(transforms->models());
+  };
+}
+BENCHMARK("transform_batch_simd",transformBatchSimd,100000);
+
+static bench::Kernel transformBatchScalar(size_t _batch)
+{
+  std::shared_ptr<fps::TransformSystem> transforms=makeTransforms(_batch);
+  return [transforms]()
+  {
+    transforms->markAllDirty();
+    transforms->updateModelsScalar();
+    bench::doNotOptimize(transforms->models());
+  };
+}
+BENCHMARK("transform_batch_scalar",transformBatchScalar,100000);
+
+static bench::Kernel transformModelViewSimd(size_t _batch)
+{
+  std::shared_ptr<fps::TransformSystem> transforms=makeTransforms(_batch);
+  return [transforms]()
+  {
+    transforms->markAllDirty();
+    transforms->update(VIEW);
+    bench::doNotOptimize(transforms->modelViews());
+  };
+}
+BENCHMARK("transform_modelview_simd",transformModelViewSimd,100000);
+
+// euler angles through three rotation matrices per object, every frame
+static bench::Kernel transformPerObject(size_t _batch)
+{
+  std::shared_ptr<std::vector<fps::Mat4>> out=std::make_shared<std::vector<fps::Mat4>>(_batch);
+  return [out,_batch]()
+  {
+    const float toRad=3.14159265358979f/180.0f;
+    for(size_t i=0; i<_batch; ++i)
+    {
+      float f=static_cast<float>(i);
+      fps::Mat4 rx, ry, rz;
+      rx.m_m[1][1]=std::cos(f*toRad); rx.m_m[1][2]=std::sin(f*toRad);
+      rx.m_m[2][1]=-rx.m_m[1][2];     rx.m_m[2][2]=rx.m_m[1][1];
+      ry.m_m[0][0]=std::cos(2.0f*f*toRad); ry.m_m[0][2]=-std::sin(2.0f*f*toRad);
+      ry.m_m[2][0]=-ry.m_m[0][2];          ry.m_m[2][2]=ry.m_m[0][0];
+      rz.m_m[0][0]=std::cos(3.0f*f*toRad); rz.m_m[0][1]=std::sin(3.0f*f*toRad);
+      rz.m_m[1][0]=-rz.m_m[0][1];          rz.m_m[1][1]=rz.m_m[0][0];
+      fps::Mat4 m=rx*ry*rz;
+      m.m_m[3][0]=f;
+      m.m_m[3][1]=0.5f*f;
+      m.m_m[3][2]=-f;
+      (*out)[i]=m;
+    }
+    bench::doNotOptimize(out->data());
+  };
+}
+BENCHMARK("transform_per_object",transformPerObject,100000);
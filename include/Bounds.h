@@ -0,0 +1,58 @@
+#ifndef BOUNDS_H__
+#define BOUNDS_H__
+
+#include "CoreMath.h"
+#include <algorithm>
+#include <limits>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Bounds.h
+/// @brief bounding volumes shared by culling and collision
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+struct AABB
+{
+  Vec3 m_min;
+  Vec3 m_max;
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief an empty box, extend() it to grow it
+  //----------------------------------------------------------------------------------------------------------------------
+  AABB() :
+    m_min(std::numeric_limits<float>::max(),std::numeric_limits<float>::max(),std::numeric_limits<float>::max()),
+    m_max(-std::numeric_limits<float>::max(),-std::numeric_limits<float>::max(),-std::numeric_limits<float>::max()) {}
+  AABB(const Vec3 &_min, const Vec3 &_max) : m_min(_min), m_max(_max) {}
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the box around a sphere
+  //----------------------------------------------------------------------------------------------------------------------
+  static AABB fromSphere(const Vec3 &_centre, float _radius)
+  {
+    Vec3 r(_radius,_radius,_radius);
+    return AABB(_centre-r,_centre+r);
+  }
+
+  void extend(const Vec3 &_p)
+  {
+    m_min.set(std::min(m_min.m_x,_p.m_x),std::min(m_min.m_y,_p.m_y),std::min(m_min.m_z,_p.m_z));
+    m_max.set(std::max(m_max.m_x,_p.m_x),std::max(m_max.m_y,_p.m_y),std::max(m_max.m_z,_p.m_z));
+  }
+  void extend(const AABB &_b)
+  {
+    extend(_b.m_min);
+    extend(_b.m_max);
+  }
+  bool overlaps(const AABB &_b) const
+  {
+    return m_min.m_x<=_b.m_max.m_x && m_max.m_x>=_b.m_min.m_x &&
+           m_min.m_y<=_b.m_max.m_y && m_max.m_y>=_b.m_min.m_y &&
+           m_min.m_z<=_b.m_max.m_z && m_max.m_z>=_b.m_min.m_z;
+  }
+  Vec3 centre() const { return (m_min+m_max)*0.5f; }
+  Vec3 extents() const { return (m_max-m_min)*0.5f; }
+};
+
+} // end namespace fps
+
+#endif
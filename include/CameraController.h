@@ -0,0 +1,149 @@
+#ifndef CAMERACONTROLLER_H__
+#define CAMERACONTROLLER_H__
+
+#include "CoreMath.h"
+#include "PhysicsState.h"
+#include "CollisionWorld.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file CameraController.h
+/// @brief the FPS camera movement and jump physics, independent of Qt and OpenGL so it can be stepped
+/// in a headless process. NGLScene feeds it input and reads back the position to render from.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief sphere against plane test
+/// @param [in] _centre the sphere centre
+/// @param [in] _planePoint any point on the plane
+/// @param [in] _planeNormal the unit plane normal
+/// @param [in] _radius the sphere radius
+/// @returns true if the sphere touches or is behind the plane
+//----------------------------------------------------------------------------------------------------------------------
+bool sphereToPlane(const Vec3 &_centre, const Vec3 &_planePoint, const Vec3 &_planeNormal, float _radius=1.0f);
+
+class CameraController
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the movement actions the controller understands
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Action { FORWARD=0, BACK, LEFT, RIGHT, JUMP, NUM_ACTIONS };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief everything a step depends on, so a run can be restarted from exactly where another was
+    //----------------------------------------------------------------------------------------------------------------------
+    struct State
+    {
+      Vec3 m_position;
+      Vec3 m_prevPosition;
+      float m_pitch;
+      float m_yaw;
+      PhysicsState m_physics;
+      bool m_grounded;
+      bool m_actions[NUM_ACTIONS];
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor places the camera at the demo start position
+    //----------------------------------------------------------------------------------------------------------------------
+    CameraController();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reset the camera to a position with no velocity and no input held
+    //----------------------------------------------------------------------------------------------------------------------
+    void reset(const Vec3 &_pos);
+    State state() const;
+    void setState(const State &_state);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the held state of an action
+    //----------------------------------------------------------------------------------------------------------------------
+    void setAction(Action _a, bool _state) { m_actions[_a]=_state; }
+    bool action(Action _a) const { return m_actions[_a]; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the look angles in degrees, the pitch is clamped to +/-89
+    //----------------------------------------------------------------------------------------------------------------------
+    void setLook(float _pitch, float _yaw);
+    float pitch() const { return m_pitch; }
+    float yaw() const { return m_yaw; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief advance movement and physics by exactly one fixed step
+    /// @param [in] _dt the step size in seconds
+    //----------------------------------------------------------------------------------------------------------------------
+    void step(float _dt);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the camera position blended between the last two steps
+    /// @param [in] _alpha 0 is the previous step, 1 is the current one
+    //----------------------------------------------------------------------------------------------------------------------
+    Vec3 renderPosition(float _alpha) const { return lerp(m_prevPos,m_pos,_alpha); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief apply the restitution impulse for a contact with the given normal
+    //----------------------------------------------------------------------------------------------------------------------
+    Vec3 collisionResponse(const Vec3 &_normal);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the artificial ground friction used to bring a jump to rest
+    //----------------------------------------------------------------------------------------------------------------------
+    Vec3 coulombFriction();
+
+    const Vec3 & position() const { return m_pos; }
+    const Vec3 & prevPosition() const { return m_prevPos; }
+    void setPosition(const Vec3 &_pos) { m_pos=_pos; }
+    const Vec3 & front() const { return m_front; }
+    const Vec3 & up() const { return m_up; }
+    PhysicsState & physics() { return m_physics; }
+    const PhysicsState & physics() const { return m_physics; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief collide the camera body with a world instead of clamping it above y=0, null for the clamp
+    //----------------------------------------------------------------------------------------------------------------------
+    void setCollisionWorld(const CollisionWorld *_world) { m_world=_world; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if the last step ended standing on something, jumping needs it
+    //----------------------------------------------------------------------------------------------------------------------
+    bool grounded() const { return m_grounded; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief walk speed in units per second
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_walkSpeed=25.0f;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the original demo integrated 0.1s of physics per 10ms timer tick, keep that feel
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_timeScale=10.0f;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief radius of the camera body sphere
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_radius=1.0f;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief with a world each step is split so a sub step moves at most this fraction of the radius
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_substepFraction=0.5f;
+    static const int MAX_SUBSTEPS=16;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief surfaces a sub step can slide over before it gives up for this step
+    //----------------------------------------------------------------------------------------------------------------------
+    static const int MAX_SLIDES=4;
+
+  private :
+    void updateFront();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief move the body by _move against the world, sliding along whatever it hits
+    /// @returns the final position
+    //----------------------------------------------------------------------------------------------------------------------
+    Vec3 slide(const Vec3 &_start, const Vec3 &_move);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief velocity response to a contact, landing on ground or a restitution bounce off anything else
+    //----------------------------------------------------------------------------------------------------------------------
+    void contact(const Vec3 &_normal);
+
+    Vec3 m_pos;
+    Vec3 m_prevPos;
+    Vec3 m_front;
+    Vec3 m_up;
+    float m_pitch=0.0f;
+    float m_yaw=0.0f;
+    bool m_actions[NUM_ACTIONS];
+    PhysicsState m_physics;
+    const CollisionWorld *m_world=nullptr;
+    bool m_grounded=false;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CAMERAUBO_H__
+#define CAMERAUBO_H__
+
+#include <ngl/Types.h>
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file CameraUBO.h
+/// @brief the std140 Camera uniform block in PhongVertex.glsl. The view, projection, their product and
+/// the eye position are written once per frame with a single buffer update and every program that
+/// declares the block reads them from the same binding point.
+//----------------------------------------------------------------------------------------------------------------------
+class CameraUBO
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the uniform buffer binding point the block is attached to
+    //----------------------------------------------------------------------------------------------------------------------
+    static const GLuint BINDING=0;
+
+    CameraUBO();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief create the buffer and bind it to BINDING, needs a current GL context
+    //----------------------------------------------------------------------------------------------------------------------
+    void initialize();
+    void release();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief point a linked program's Camera block at our binding
+    /// @returns false if the program has no Camera block
+    //----------------------------------------------------------------------------------------------------------------------
+    bool attach(GLuint _program) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief upload this frame's camera, VP is computed here as _view*_project (ngl order)
+    //----------------------------------------------------------------------------------------------------------------------
+    void update(const ngl::Mat4 &_view, const ngl::Mat4 &_project, const ngl::Vec3 &_eye);
+
+  private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief matches the std140 layout of the block, three mat4 then a vec4
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Block
+    {
+      GLfloat V[16];
+      GLfloat P[16];
+      GLfloat VP[16];
+      GLfloat eye[4];
+    };
+    GLuint m_buffer;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef COLLISIONWORLD_H__
+#define COLLISIONWORLD_H__
+
+#include "Bounds.h"
+#include "CoreMath.h"
+#include "JobSystem.h"
+#include "SdfBrickCache.h"
+#include "SdfScene.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file CollisionWorld.h
+/// @brief static collision geometry for the camera body. Spheres, boxes and triangles are bucketed into a
+/// uniform grid addressed through a spatial hash so a query only looks at the colliders near it, whatever
+/// the size of the level. Planes and signed distance fields are unbounded and always tested. Queries are
+/// const and safe to run from several threads once build() has been called.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class CollisionWorld
+{
+  public :
+    enum Shape { SPHERE=0, BOX, PLANE, TRIANGLE, FIELD };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the first contact of a swept sphere
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Hit
+    {
+      /// @brief fraction of the sweep at first contact, 0 if the sphere started touching
+      float m_time=1.0f;
+      /// @brief unit contact normal pointing away from the collider
+      Vec3 m_normal;
+      /// @brief the closest point on the collider
+      Vec3 m_point;
+      /// @brief how far the sphere overlaps the collider at m_time, non zero only when starting inside
+      float m_depth=0.0f;
+      uint32_t m_collider=0;
+    };
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @param [in] _cellSize edge of a grid cell, roughly the size of a typical collider
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit CollisionWorld(float _cellSize=4.0f);
+
+    uint32_t addSphere(const Vec3 &_centre, float _radius);
+    uint32_t addBox(const AABB &_box);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the plane n.p+d=0, solid on the side the normal points away from
+    //----------------------------------------------------------------------------------------------------------------------
+    uint32_t addPlane(const Vec3 &_normal, float _d);
+    uint32_t addTriangle(const Vec3 &_a, const Vec3 &_b, const Vec3 &_c);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add a triangle list transformed by a 16 float model matrix in ngl layout
+    //----------------------------------------------------------------------------------------------------------------------
+    void addTriangles(const float *_xyz, size_t _vertexCount, const float *_model);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the raymarched scene as solid geometry, swept by sphere tracing its distance field and pushed
+    /// out of along its gradient
+    //----------------------------------------------------------------------------------------------------------------------
+    uint32_t addField(const SdfScene &_field);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the same answered from an SdfBrickCache near its surfaces, updateFields() bakes the bricks
+    //----------------------------------------------------------------------------------------------------------------------
+    uint32_t addField(const SdfScene &_field, const SdfBrickCache::Settings &_cache);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bake the bricks the cached fields were asked for since the last call, never alongside a query
+    /// @param [in] _jobs spreads the baking over its threads, may be null
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateFields(JobSystem *_jobs);
+    void clear();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bucket everything added so far into the grid, needed before querying
+    //----------------------------------------------------------------------------------------------------------------------
+    void build();
+
+    size_t size() const { return m_colliders.size(); }
+    Shape shape(uint32_t _i) const { return m_colliders[_i].m_shape; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief indices of the bounded colliders in the cells touched by _box, each listed once
+    //----------------------------------------------------------------------------------------------------------------------
+    void query(const AABB &_box, std::vector<uint32_t> &o_candidates) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sweep a sphere from _start to _end and find its first contact. Contacts the sphere is
+    /// already leaving are ignored so a body resting on a surface can move along or away from it.
+    /// @returns true on a hit, o_hit holds the earliest one
+    //----------------------------------------------------------------------------------------------------------------------
+    bool sweepSphere(const Vec3 &_start, const Vec3 &_end, float _radius, Hit &o_hit) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the same sweep against every collider, the reference for the grid
+    //----------------------------------------------------------------------------------------------------------------------
+    bool sweepSphereBruteForce(const Vec3 &_start, const Vec3 &_end, float _radius, Hit &o_hit) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief contacts of a resting sphere with everything it overlaps, m_time is 0 and m_depth the overlap
+    /// @returns the number of contacts written, at most _maxHits
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t collideSphere(const Vec3 &_centre, float _radius, Hit *o_hits, size_t _maxHits) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief closest point on a collider to _p
+    //----------------------------------------------------------------------------------------------------------------------
+    Vec3 closestPoint(uint32_t _i, const Vec3 &_p) const;
+
+  private :
+    struct Collider
+    {
+      Shape m_shape;
+      AABB m_box;
+      /// @brief sphere centre, plane normal or the first triangle corner
+      Vec3 m_a;
+      Vec3 m_b;
+      Vec3 m_c;
+      /// @brief sphere radius or plane offset
+      float m_r;
+      /// @brief index into m_fields of a FIELD
+      uint32_t m_field;
+    };
+    struct Field
+    {
+      SdfScene m_scene;
+      /// @brief null for a field always evaluated analytically
+      std::unique_ptr<SdfBrickCache> m_cache;
+    };
+    static bool bounded(Shape _shape) { return _shape!=PLANE && _shape!=FIELD; }
+    float fieldDistance(uint32_t _field, const Vec3 &_p) const;
+    float fieldDistanceAndNormal(uint32_t _field, const Vec3 &_p, Vec3 &o_normal) const;
+    uint32_t add(const Collider &_c);
+    bool sweepOne(uint32_t _i, const Vec3 &_start, const Vec3 &_delta, float _radius, Hit &o_hit) const;
+    void cellRange(const AABB &_box, int *o_lo, int *o_hi) const;
+    size_t hash(int _x, int _y, int _z) const;
+
+    float m_cellSize;
+    std::vector<Collider> m_colliders;
+    std::vector<Field> m_fields;
+    /// @brief planes and fields, tested by every query
+    std::vector<uint32_t> m_unbounded;
+    /// @brief grid buckets, the colliders of bucket b are m_items[m_start[b]] to m_items[m_start[b+1]]
+    std::vector<uint32_t> m_start;
+    std::vector<uint32_t> m_items;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef COREMATH_H__
+#define COREMATH_H__
+
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file CoreMath.h
+/// @brief minimal vector / matrix maths for the headless camera / physics core. This deliberately mirrors
+/// the parts of ngl::Vec3 and ngl::Mat4 we use (same member names, row vector convention with the
+/// translation in m_m[3]) so the core has no Qt or GL dependency and values can be copied straight
+/// across to NGL types when rendering.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+struct Vec3
+{
+  float m_x;
+  float m_y;
+  float m_z;
+
+  Vec3() : m_x(0.0f), m_y(0.0f), m_z(0.0f) {}
+  Vec3(float _x, float _y, float _z) : m_x(_x), m_y(_y), m_z(_z) {}
+
+  void set(float _x, float _y, float _z) { m_x=_x; m_y=_y; m_z=_z; }
+
+  Vec3 operator+(const Vec3 &_v) const { return Vec3(m_x+_v.m_x,m_y+_v.m_y,m_z+_v.m_z); }
+  Vec3 operator-(const Vec3 &_v) const { return Vec3(m_x-_v.m_x,m_y-_v.m_y,m_z-_v.m_z); }
+  Vec3 operator-() const { return Vec3(-m_x,-m_y,-m_z); }
+  Vec3 operator*(float _s) const { return Vec3(m_x*_s,m_y*_s,m_z*_s); }
+  Vec3 operator/(float _s) const { return Vec3(m_x/_s,m_y/_s,m_z/_s); }
+  Vec3 & operator+=(const Vec3 &_v) { m_x+=_v.m_x; m_y+=_v.m_y; m_z+=_v.m_z; return *this; }
+  Vec3 & operator-=(const Vec3 &_v) { m_x-=_v.m_x; m_y-=_v.m_y; m_z-=_v.m_z; return *this; }
+  Vec3 & operator*=(float _s) { m_x*=_s; m_y*=_s; m_z*=_s; return *this; }
+  bool operator==(const Vec3 &_v) const { return m_x==_v.m_x && m_y==_v.m_y && m_z==_v.m_z; }
+  bool operator!=(const Vec3 &_v) const { return !(*this==_v); }
+
+  float dot(const Vec3 &_v) const { return m_x*_v.m_x+m_y*_v.m_y+m_z*_v.m_z; }
+  Vec3 cross(const Vec3 &_v) const
+  {
+    return Vec3(m_y*_v.m_z-m_z*_v.m_y, m_z*_v.m_x-m_x*_v.m_z, m_x*_v.m_y-m_y*_v.m_x);
+  }
+  float lengthSquared() const { return dot(*this); }
+  float length() const { return std::sqrt(lengthSquared()); }
+  void normalize()
+  {
+    float l=length();
+    if(l>0.0f)
+    {
+      m_x/=l; m_y/=l; m_z/=l;
+    }
+  }
+};
+
+inline Vec3 operator*(float _s, const Vec3 &_v) { return _v*_s; }
+
+inline Vec3 lerp(const Vec3 &_a, const Vec3 &_b, float _t) { return _a+(_b-_a)*_t; }
+
+struct Mat3
+{
+  float m_m[3][3];
+
+  Mat3() { identity(); }
+  void identity()
+  {
+    for(int i=0; i<3; ++i)
+      for(int j=0; j<3; ++j)
+        m_m[i][j]= (i==j) ? 1.0f : 0.0f;
+  }
+  float determinant() const
+  {
+    return m_m[0][0]*(m_m[1][1]*m_m[2][2]-m_m[1][2]*m_m[2][1])
+          -m_m[0][1]*(m_m[1][0]*m_m[2][2]-m_m[1][2]*m_m[2][0])
+          +m_m[0][2]*(m_m[1][0]*m_m[2][1]-m_m[1][1]*m_m[2][0]);
+  }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief invert in place, a singular matrix is left untouched
+  //----------------------------------------------------------------------------------------------------------------------
+  void inverse()
+  {
+    float det=determinant();
+    if(det==0.0f)
+    {
+      return;
+    }
+    float inv=1.0f/det;
+    Mat3 r;
+    r.m_m[0][0]= (m_m[1][1]*m_m[2][2]-m_m[1][2]*m_m[2][1])*inv;
+    r.m_m[0][1]=-(m_m[0][1]*m_m[2][2]-m_m[0][2]*m_m[2][1])*inv;
+    r.m_m[0][2]= (m_m[0][1]*m_m[1][2]-m_m[0][2]*m_m[1][1])*inv;
+    r.m_m[1][0]=-(m_m[1][0]*m_m[2][2]-m_m[1][2]*m_m[2][0])*inv;
+    r.m_m[1][1]= (m_m[0][0]*m_m[2][2]-m_m[0][2]*m_m[2][0])*inv;
+    r.m_m[1][2]=-(m_m[0][0]*m_m[1][2]-m_m[0][2]*m_m[1][0])*inv;
+    r.m_m[2][0]= (m_m[1][0]*m_m[2][1]-m_m[1][1]*m_m[2][0])*inv;
+    r.m_m[2][1]=-(m_m[0][0]*m_m[2][1]-m_m[0][1]*m_m[2][0])*inv;
+    r.m_m[2][2]= (m_m[0][0]*m_m[1][1]-m_m[0][1]*m_m[1][0])*inv;
+    *this=r;
+  }
+};
+
+struct Mat4
+{
+  float m_m[4][4];
+
+  Mat4() { identity(); }
+  void identity()
+  {
+    for(int i=0; i<4; ++i)
+      for(int j=0; j<4; ++j)
+        m_m[i][j]= (i==j) ? 1.0f : 0.0f;
+  }
+  void translate(float _x, float _y, float _z)
+  {
+    identity();
+    m_m[3][0]=_x;
+    m_m[3][1]=_y;
+    m_m[3][2]=_z;
+  }
+  Mat4 operator*(const Mat4 &_m) const
+  {
+    Mat4 r;
+    for(int i=0; i<4; ++i)
+      for(int j=0; j<4; ++j)
+        r.m_m[i][j]=m_m[i][0]*_m.m_m[0][j]+m_m[i][1]*_m.m_m[1][j]+m_m[i][2]*_m.m_m[2][j]+m_m[i][3]*_m.m_m[3][j];
+    return r;
+  }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the upper 3x3, used for the normal matrix
+  //----------------------------------------------------------------------------------------------------------------------
+  Mat3 toMat3() const
+  {
+    Mat3 r;
+    for(int i=0; i<3; ++i)
+      for(int j=0; j<3; ++j)
+        r.m_m[i][j]=m_m[i][j];
+    return r;
+  }
+  const float * openGL() const { return &m_m[0][0]; }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief same as ngl::lookAt
+//----------------------------------------------------------------------------------------------------------------------
+inline Mat4 lookAt(const Vec3 &_eye, const Vec3 &_centre, const Vec3 &_up)
+{
+  Vec3 n=_centre-_eye;
+  Vec3 u=_up;
+  Vec3 v=n.cross(u);
+  u=v.cross(n);
+  n.normalize();
+  v.normalize();
+  u.normalize();
+  Mat4 r;
+  r.m_m[0][0]=v.m_x; r.m_m[1][0]=v.m_y; r.m_m[2][0]=v.m_z;
+  r.m_m[0][1]=u.m_x; r.m_m[1][1]=u.m_y; r.m_m[2][1]=u.m_z;
+  r.m_m[0][2]=-n.m_x; r.m_m[1][2]=-n.m_y; r.m_m[2][2]=-n.m_z;
+  r.m_m[3][0]=-_eye.dot(v);
+  r.m_m[3][1]=-_eye.dot(u);
+  r.m_m[3][2]=_eye.dot(n);
+  return r;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief same as ngl::perspective
+/// @param [in] _fovy vertical field of view in degrees
+//----------------------------------------------------------------------------------------------------------------------
+inline Mat4 perspective(float _fovy, float _aspect, float _zNear, float _zFar)
+{
+  float range=std::tan(_fovy*0.5f*static_cast<float>(M_PI/180.0))*_zNear;
+  float left=-range*_aspect;
+  float right=range*_aspect;
+  float bottom=-range;
+  float top=range;
+  Mat4 r;
+  r.m_m[0][0]=(2.0f*_zNear)/(right-left);
+  r.m_m[1][1]=(2.0f*_zNear)/(top-bottom);
+  r.m_m[2][2]=-(_zFar+_zNear)/(_zFar-_zNear);
+  r.m_m[2][3]=-1.0f;
+  r.m_m[3][2]=-(2.0f*_zFar*_zNear)/(_zFar-_zNear);
+  r.m_m[3][3]=0.0f;
+  return r;
+}
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef DYNAMICRESOLUTION_H__
+#define DYNAMICRESOLUTION_H__
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file DynamicResolution.h
+/// @brief picks the fraction of the window a fullscreen pass is rendered at so the GPU frame time settles on a
+/// target. The cost of a raymarched frame is close to proportional to its pixel count, so the scale moves by
+/// the square root of target over measured time. Times are smoothed, changes are capped and snapped to steps,
+/// and after a change the times still in flight from the old size are skipped, since GPU timings arrive a
+/// few frames late. A band around the target keeps it from hunting back and forth.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class DynamicResolution
+{
+  public :
+    struct Settings
+    {
+      /// @brief GPU milliseconds a frame should take
+      float m_targetMs=12.0f;
+      /// @brief limits of the scale applied to both axes
+      float m_minScale=0.25f;
+      float m_maxScale=1.0f;
+      /// @brief scales are multiples of this, so the render target is not reallocated every frame
+      float m_step=0.05f;
+      /// @brief weight of the newest time in the running average
+      float m_smoothing=0.2f;
+      /// @brief no change while the average is within this fraction of the target
+      float m_tolerance=0.1f;
+      /// @brief largest change of the scale at once, as a fraction of it
+      float m_maxChange=0.25f;
+      /// @brief how many frames late GPU times arrive, the times this soon after a change are of the old size
+      int m_latencyFrames=3;
+      /// @brief frames to measure at a new size before the next change
+      int m_settleFrames=6;
+    };
+
+    DynamicResolution();
+    explicit DynamicResolution(const Settings &_settings);
+    Settings & settings() { return m_settings; }
+    const Settings & settings() const { return m_settings; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief feed one frame's GPU time
+    /// @returns true if the scale changed
+    //----------------------------------------------------------------------------------------------------------------------
+    bool addFrame(float _gpuMs);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start again from the largest scale, after a resize or a change of what is drawn
+    //----------------------------------------------------------------------------------------------------------------------
+    void reset();
+    float scale() const { return m_scale; }
+    float averageMs() const { return m_averageMs; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the render size for a window, never smaller than a pixel
+    //----------------------------------------------------------------------------------------------------------------------
+    void renderSize(int _width, int _height, int &o_width, int &o_height) const;
+
+  private :
+    float snap(float _scale) const;
+
+    Settings m_settings;
+    float m_scale;
+    float m_averageMs;
+    int m_frames;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef FIXEDTIMESTEP_H__
+#define FIXEDTIMESTEP_H__
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file FixedTimestep.h
+/// @brief accumulator that turns variable real time deltas into a whole number of fixed simulation steps
+/// plus an interpolation factor for rendering between the last two states
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class FixedTimestep
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor
+    /// @param [in] _dt the fixed step size in seconds
+    /// @param [in] _maxSteps upper bound on steps per advance, the backlog is dropped past this
+    //----------------------------------------------------------------------------------------------------------------------
+    FixedTimestep(double _dt, int _maxSteps) : m_dt(_dt), m_maxSteps(_maxSteps) {}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add real elapsed time and return how many fixed steps should now be run
+    //----------------------------------------------------------------------------------------------------------------------
+    int advance(double _seconds)
+    {
+      m_accumulator+=_seconds;
+      int steps=0;
+      while(m_accumulator>=m_dt && steps<m_maxSteps)
+      {
+        m_accumulator-=m_dt;
+        ++steps;
+      }
+      // we fell too far behind, drop the backlog rather than trying to catch up
+      if(steps==m_maxSteps)
+      {
+        m_accumulator=0.0;
+      }
+      return steps;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief fraction of a step between the previous and current state
+    //----------------------------------------------------------------------------------------------------------------------
+    float alpha() const { return static_cast<float>(m_accumulator/m_dt); }
+    double dt() const { return m_dt; }
+    void reset() { m_accumulator=0.0; }
+
+  private :
+    double m_dt;
+    int m_maxSteps;
+    double m_accumulator=0.0;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef FRAMECAPTURE_H__
+#define FRAMECAPTURE_H__
+
+#include <ngl/Types.h>
+#include "SpscQueue.h"
+#include "FrameRecorder.h"
+#include "StagingPool.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file FrameCapture.h
+/// @brief asynchronous screenshots. The back buffer is read into one of a ring of pixel buffer objects,
+/// a fence tells us when the copy has finished on the GPU (normally a frame or two later) and only then is
+/// the buffer mapped and handed to a worker thread that flips and encodes the PNG with Magick++.
+/// The render thread never waits on the GPU or on the encoder. When a FrameRecorder is attached and
+/// recording, every frame goes through the same ring and is handed to the recorder instead.
+//----------------------------------------------------------------------------------------------------------------------
+class FrameCapture
+{
+  public :
+    FrameCapture();
+    ~FrameCapture();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief create the PBOs, needs a current GL context
+    //----------------------------------------------------------------------------------------------------------------------
+    void initialize();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief release the GL objects, needs a current GL context
+    //----------------------------------------------------------------------------------------------------------------------
+    void release();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ask for the next finished frame to be saved
+    /// @param [in] _fname the png to write
+    //----------------------------------------------------------------------------------------------------------------------
+    void request(const std::string &_fname);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief call once the frame has been drawn, with the read buffer still bound. Starts any requested
+    /// readback and collects earlier ones whose fences have signalled.
+    /// @param [in] _width framebuffer width in pixels
+    /// @param [in] _height framebuffer height in pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    void endFrame(int _width, int _height);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of captures either on the GPU or waiting to be encoded
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t pending() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief stream every frame to this recorder while it is recording, nullptr to detach
+    //----------------------------------------------------------------------------------------------------------------------
+    void setRecorder(fps::FrameRecorder *_recorder) { m_recorder=_recorder; }
+
+  private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief one PBO in the ring and the readback in flight in it
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Slot
+    {
+      GLuint pbo=0;
+      GLsync fence=nullptr;
+      //----------------------------------------------------------------------------------------------------------------------
+      /// @brief bytes in use and bytes allocated, the PBO is only reallocated when it has to grow
+      //----------------------------------------------------------------------------------------------------------------------
+      size_t size=0;
+      size_t capacity=0;
+      int width=0;
+      int height=0;
+      std::string fname;
+      bool record=false;
+    };
+    struct Job
+    {
+      int width;
+      int height;
+      fps::StagingPool::Handle pixels;
+      std::string fname;
+    };
+    struct Result
+    {
+      bool ok;
+      char fname[256];
+    };
+
+    void collect();
+    void encodeLoop();
+
+    static const int NUM_SLOTS=3;
+    Slot m_slots[NUM_SLOTS];
+    int m_nextSlot;
+    std::deque<std::string> m_requests;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief CPU copies for the encoder, allocated on the first screenshot and reused after that
+    //----------------------------------------------------------------------------------------------------------------------
+    fps::StagingPool m_staging;
+    fps::FrameRecorder *m_recorder;
+
+    std::thread m_worker;
+    mutable std::mutex m_jobMutex;
+    std::condition_variable m_jobReady;
+    std::deque<Job> m_jobs;
+    bool m_quit;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief finished encodes travel back to the render thread so only it writes to the log
+    //----------------------------------------------------------------------------------------------------------------------
+    fps::SpscQueue<Result> m_results;
+};
+
+#endif
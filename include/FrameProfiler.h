@@ -0,0 +1,125 @@
+#ifndef FRAMEPROFILER_H__
+#define FRAMEPROFILER_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file FrameProfiler.h
+/// @brief per frame CPU timing. Scoped timers add their duration to the stage of the frame currently being
+/// built, endFrame() publishes it into a fixed size history that the overlay can read without locking.
+/// Individual timer events can also be kept and written out as a Chrome trace (chrome://tracing).
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class FrameProfiler
+{
+  public :
+    enum Stage { INPUT=0, SIMULATION, MATRIX_UPLOAD, DRAW, READBACK, GPU, FRAME, NUM_STAGES };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of frames kept in the history
+    //----------------------------------------------------------------------------------------------------------------------
+    static const size_t HISTORY=256;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief stage times for one frame in milliseconds
+    //----------------------------------------------------------------------------------------------------------------------
+    typedef std::array<float,NUM_STAGES> FrameTimes;
+
+    struct Stats
+    {
+      float min;
+      float avg;
+      float p99;
+    };
+
+    FrameProfiler();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add time to a stage of the frame being built
+    //----------------------------------------------------------------------------------------------------------------------
+    void addTime(Stage _stage, std::chrono::steady_clock::time_point _start, std::chrono::steady_clock::time_point _end);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add a measurement made elsewhere (e.g. a GL timer query) in milliseconds
+    //----------------------------------------------------------------------------------------------------------------------
+    void addMs(Stage _stage, float _ms);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief publish the frame being built to the history, FRAME is the time since the last endFrame
+    //----------------------------------------------------------------------------------------------------------------------
+    void endFrame();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copy of the published history, oldest first. Safe to call from another thread, a slot endFrame()
+    /// rewrites while it is being copied is copied again so no frame comes back torn
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<FrameTimes> history() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief min / avg / p99 of each stage over the history
+    //----------------------------------------------------------------------------------------------------------------------
+    std::array<Stats,NUM_STAGES> stats() const;
+    uint64_t frameCount() const { return m_head.load(std::memory_order_acquire); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief keep every timer event for writeChromeTrace, capped so a long run can't grow without bound
+    //----------------------------------------------------------------------------------------------------------------------
+    void enableTrace(size_t _maxEvents=1000000);
+    bool traceEnabled() const { return m_traceEnabled; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write the recorded events in the Chrome trace event JSON format
+    /// @returns false if the file couldn't be written
+    //----------------------------------------------------------------------------------------------------------------------
+    bool writeChromeTrace(const std::string &_fname) const;
+    static const char * stageName(Stage _stage);
+
+  private :
+    struct TraceEvent
+    {
+      Stage stage;
+      int64_t startUs;
+      int64_t durationUs;
+    };
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief one frame of the history behind a sequence lock, m_sequence is odd while endFrame() writes it
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Slot
+    {
+      std::atomic<uint32_t> m_sequence;
+      std::array<std::atomic<float>,NUM_STAGES> m_times;
+    };
+
+    FrameTimes m_current;
+    std::array<Slot,HISTORY> m_history;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief total frames published, the writer is the only thread that stores to it
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<uint64_t> m_head;
+    std::chrono::steady_clock::time_point m_epoch;
+    std::chrono::steady_clock::time_point m_lastFrame;
+    bool m_traceEnabled=false;
+    size_t m_maxEvents=0;
+    std::vector<TraceEvent> m_events;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief times the enclosing scope into a profiler stage
+//----------------------------------------------------------------------------------------------------------------------
+class ScopedTimer
+{
+  public :
+    ScopedTimer(FrameProfiler &_profiler, FrameProfiler::Stage _stage) :
+      m_profiler(_profiler), m_stage(_stage), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { m_profiler.addTime(m_stage,m_start,std::chrono::steady_clock::now()); }
+    ScopedTimer(const ScopedTimer &)=delete;
+    ScopedTimer & operator=(const ScopedTimer &)=delete;
+
+  private :
+    FrameProfiler &m_profiler;
+    FrameProfiler::Stage m_stage;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef FRAMERECORDER_H__
+#define FRAMERECORDER_H__
+
+#include "SpscQueue.h"
+#include "StagingPool.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file FrameRecorder.h
+/// @brief streams a sequence of RGBA frames to disk or to an encoder process on a dedicated I/O thread.
+/// Frames come from a fixed pool, the render thread fills one and submits it and the I/O thread writes it
+/// with writev and hands it back. When the pool is empty the frame is either dropped or the caller waits,
+/// both are counted so we can see when the disk can't keep up.
+/// Frames are expected bottom row first as glReadPixels returns them, the writers flip them for free by
+/// handing the rows to writev in reverse order.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class FrameRecorder
+{
+  public :
+    enum Format
+    {
+      PAM,  //!< one binary P7 RGB_ALPHA file per frame, written straight from the frame with no conversion
+      PPM,  //!< one binary P6 file per frame, the alpha is stripped on the I/O thread
+      RAW   //!< all frames concatenated as raw RGBA into one file or the encoder pipe
+    };
+    enum Policy
+    {
+      DROP,  //!< drop the frame if no buffer is free
+      BLOCK  //!< wait for the I/O thread to free a buffer
+    };
+    struct Config
+    {
+      Format format=PAM;
+      Policy policy=DROP;
+      //----------------------------------------------------------------------------------------------------------------------
+      /// @brief frames are written to prefix_000000.pam etc, or prefix.rgba for RAW with no pipe
+      //----------------------------------------------------------------------------------------------------------------------
+      std::string prefix="frame";
+      //----------------------------------------------------------------------------------------------------------------------
+      /// @brief if set RAW frames are piped to this command, %W and %H are replaced by the frame size, e.g.
+      /// ffmpeg -y -f rawvideo -pix_fmt rgba -s %Wx%H -r 60 -i - out.mp4
+      //----------------------------------------------------------------------------------------------------------------------
+      std::string pipeCommand;
+      //----------------------------------------------------------------------------------------------------------------------
+      /// @brief number of frames that can be queued for the I/O thread
+      //----------------------------------------------------------------------------------------------------------------------
+      size_t queueDepth=8;
+    };
+    struct Frame
+    {
+      int width=0;
+      int height=0;
+      uint64_t index=0;
+      //----------------------------------------------------------------------------------------------------------------------
+      /// @brief only grows, so a window resize mid recording reuses the memory
+      //----------------------------------------------------------------------------------------------------------------------
+      StagingBuffer rgba;
+    };
+    struct Stats
+    {
+      uint64_t submitted;
+      uint64_t written;
+      uint64_t dropped;
+      uint64_t failed;
+      uint64_t bytes;
+    };
+
+    FrameRecorder();
+    ~FrameRecorder();
+    FrameRecorder(const FrameRecorder &)=delete;
+    FrameRecorder & operator=(const FrameRecorder &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief begin a new recording, the counters are reset
+    /// @returns false if already recording
+    //----------------------------------------------------------------------------------------------------------------------
+    bool start(const Config &_config);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write everything still queued and stop the I/O thread
+    //----------------------------------------------------------------------------------------------------------------------
+    void stop();
+    bool recording() const { return m_recording; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief render thread, get a free frame sized for width x height RGBA
+    /// @returns nullptr if the frame had to be dropped
+    //----------------------------------------------------------------------------------------------------------------------
+    Frame * acquire(int _width, int _height);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief render thread, queue a frame from acquire() for writing
+    //----------------------------------------------------------------------------------------------------------------------
+    void submit(Frame *_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief count a frame the caller had to drop before it got as far as acquire()
+    //----------------------------------------------------------------------------------------------------------------------
+    void dropFrame() { m_dropped.fetch_add(1,std::memory_order_relaxed); }
+    Stats stats() const;
+
+  private :
+    void run();
+    bool writeFrame(Frame &_frame);
+    bool openStream(const Frame &_frame);
+    void closeStream();
+
+    Config m_config;
+    bool m_recording;
+    std::vector<std::unique_ptr<Frame>> m_pool;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief render thread -> I/O thread
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<SpscQueue<Frame *>> m_filled;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief I/O thread -> render thread
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<SpscQueue<Frame *>> m_free;
+    std::thread m_io;
+    std::atomic<bool> m_running;
+    uint64_t m_nextIndex;
+    // only touched on the I/O thread
+    FILE *m_stream;
+    bool m_streamIsPipe;
+    int m_streamWidth;
+    int m_streamHeight;
+    StagingBuffer m_scratch;
+
+    std::atomic<uint64_t> m_submitted;
+    std::atomic<uint64_t> m_written;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_failed;
+    std::atomic<uint64_t> m_bytes;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef FRAMESNAPSHOT_H__
+#define FRAMESNAPSHOT_H__
+
+#include "CoreMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file FrameSnapshot.h
+/// @brief everything the renderer needs from one simulation tick, written by the simulation and handed to
+/// the render thread through a TripleBuffer. The renderer only ever reads it, so drawing never touches
+/// live simulation state. Matrices are 16 floats in the ngl layout, ready for an instance buffer.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+struct FrameSnapshot
+{
+  /// @brief fixed steps taken since the simulation started
+  uint64_t m_tick=0;
+  /// @brief steady clock seconds at which the current state was reached, and the step length, the renderer
+  /// blends from m_previousEye to m_eye over the step after it
+  double m_time=0.0;
+  double m_dt=0.0;
+  /// @brief wall time the simulation spent producing this snapshot
+  float m_simMs=0.0f;
+
+  Vec3 m_previousEye;
+  Vec3 m_eye;
+  Vec3 m_front;
+  Vec3 m_up;
+  /// @brief the view at m_eye and the projection, the visible lists were culled against these
+  Mat4 m_view;
+  Mat4 m_projection;
+
+  /// @brief model matrices of the visible objects of each instanced batch
+  std::vector<std::vector<float>> m_batchTransforms;
+  /// @brief visible objects drawn one by one (vertex meshes) and their model matrices
+  std::vector<uint32_t> m_meshObjects;
+  std::vector<float> m_meshTransforms;
+  /// @brief one translation matrix per debris body
+  std::vector<float> m_debrisTransforms;
+
+  /// @brief counts for the stats overlay
+  size_t m_visibleCount=0;
+  size_t m_objectCount=0;
+  size_t m_debrisAwake=0;
+  size_t m_debrisCount=0;
+  /// @brief the camera's vertical speed, logged by the renderer while debugging jumps
+  float m_velocity=0.0f;
+};
+
+} // end namespace fps
+
+#endif
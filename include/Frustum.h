@@ -0,0 +1,46 @@
+#ifndef FRUSTUM_H__
+#define FRUSTUM_H__
+
+#include "Bounds.h"
+#include "CoreMath.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Frustum.h
+/// @brief view frustum planes extracted from a view * projection matrix (ngl order, row vectors). The six
+/// planes are stored structure of arrays and padded to eight so a box can be tested against four planes
+/// per SSE instruction. Builds without SSE use the scalar path.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class Frustum
+{
+  public :
+    enum Result { OUTSIDE=0, INTERSECTS, INSIDE };
+    static const int NUM_PLANES=6;
+    static const int PADDED_PLANES=8;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief planes of viewMatrix*projection, points inside have a positive distance to all of them
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit Frustum(const Mat4 &_viewProject);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief classify a box, INSIDE means it needs no further testing
+    //----------------------------------------------------------------------------------------------------------------------
+    Result classify(const AABB &_box) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief scalar reference versions, used by the fallback and for checking the SIMD path
+    //----------------------------------------------------------------------------------------------------------------------
+    Result classifyScalar(const AABB &_box) const;
+    bool visible(const AABB &_box) const { return classify(_box)!=OUTSIDE; }
+
+  private :
+    alignas(16) float m_nx[PADDED_PLANES];
+    alignas(16) float m_ny[PADDED_PLANES];
+    alignas(16) float m_nz[PADDED_PLANES];
+    alignas(16) float m_d[PADDED_PLANES];
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef INPUTRECORDING_H__
+#define INPUTRECORDING_H__
+
+#include "CameraController.h"
+#include "InputSystem.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InputRecording.h
+/// @brief the input of a run tick by tick, so a camera path can be flown again exactly. A recording holds
+/// the camera's state when it began and, for every tick, the fixed steps it took, the InputState it
+/// collected and the commands that move things. Replaying it through Simulation takes the same steps with
+/// the same input and so follows the same trajectory, whatever the frame rate or the mouse of the machine
+/// it runs on. Window sized things like the viewport are not recorded, they belong to the run.
+///
+/// The file is a small header then one variable length record per tick, an idle tick is five bytes:
+/// u16 steps, u8 held commands, u8 pressed commands, u8 press count per pressed command, u8 flags, then
+/// f32 pitch and yaw if flag 1 and u8 count with (u8 type, f32 x, f32 y) commands if flag 2. Numbers are in
+/// the byte order of the machine that recorded them, the header is rejected on any other.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class InputRecording
+{
+  public :
+    static const uint32_t VERSION=1;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a Simulation::Command, kept as its type value so this does not depend on Simulation
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Command
+    {
+      uint8_t m_type;
+      float m_x;
+      float m_y;
+    };
+    struct Tick
+    {
+      int m_steps;
+      InputState m_input;
+      std::vector<Command> m_commands;
+    };
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief drop what was recorded and start again from a camera stepped every _dt seconds
+    //----------------------------------------------------------------------------------------------------------------------
+    void begin(double _dt, const CameraController::State &_camera);
+    void add(const Tick &_tick);
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief on failure error() says why
+    //----------------------------------------------------------------------------------------------------------------------
+    bool write(const std::string &_fname);
+    bool read(const std::string &_fname);
+    const std::string & error() const { return m_error; }
+
+    double dt() const { return m_dt; }
+    const CameraController::State & camera() const { return m_camera; }
+    uint64_t tickCount() const { return m_ticks; }
+    uint64_t stepCount() const { return m_steps; }
+    double seconds() const { return m_steps*m_dt; }
+    size_t bytes() const { return m_data.size(); }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief play the ticks back in order from the first
+    /// @returns false once every tick has been played
+    //----------------------------------------------------------------------------------------------------------------------
+    void rewind() { m_cursor=0; }
+    bool next(Tick &o_tick);
+
+  private :
+    template <typename T> void put(const T &_value);
+    template <typename T> bool get(T &o_value);
+
+    double m_dt=0.0;
+    CameraController::State m_camera=CameraController::State();
+    uint64_t m_ticks=0;
+    uint64_t m_steps=0;
+    std::vector<uint8_t> m_data;
+    size_t m_cursor=0;
+    std::string m_error;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef INPUTSYSTEM_H__
+#define INPUTSYSTEM_H__
+
+#include "SpscQueue.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InputSystem.h
+/// @brief raw key and mouse samples, stamped with the time they arrived, go from the window thread to the
+/// simulation through a lock free queue. Once a tick the simulation collects everything that arrived
+/// before it started and reduces it to one InputState: which commands are held, which were pressed, and
+/// the mouse motion summed while looking. However fast the mouse reports, a tick turns the camera once
+/// and nothing is repainted per event. Keys and buttons go through a binding table, so the window only
+/// forwards what it was given.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief one event as the window system gave it
+//----------------------------------------------------------------------------------------------------------------------
+struct InputSample
+{
+  enum Type
+  {
+    KEY=0,   //!< key m_code went down or up as m_pressed
+    BUTTON,  //!< mouse button m_code went down or up as m_pressed
+    MOTION   //!< the mouse moved m_dx, m_dy pixels
+  };
+  Type m_type;
+  int32_t m_code;
+  bool m_pressed;
+  float m_dx;
+  float m_dy;
+  /// @brief Simulation::now() when the sample arrived
+  double m_time;
+
+  static InputSample key(int _code, bool _pressed, double _time)
+  {
+    return InputSample{KEY,static_cast<int32_t>(_code),_pressed,0.0f,0.0f,_time};
+  }
+  static InputSample button(int _code, bool _pressed, double _time)
+  {
+    return InputSample{BUTTON,static_cast<int32_t>(_code),_pressed,0.0f,0.0f,_time};
+  }
+  static InputSample motion(float _dx, float _dy, double _time) { return InputSample{MOTION,0,false,_dx,_dy,_time}; }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief what the simulation does with input, the first five are the CameraController actions
+//----------------------------------------------------------------------------------------------------------------------
+enum InputCommand
+{
+  INPUT_FORWARD=0,
+  INPUT_BACK,
+  INPUT_LEFT,
+  INPUT_RIGHT,
+  INPUT_JUMP,
+  INPUT_SPAWN_DEBRIS, //!< on each press
+  INPUT_LOOK,         //!< mouse motion turns the camera while held
+  NUM_INPUT_COMMANDS
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief keys and mouse buttons to commands, codes are whatever the window system uses (Qt::Key and
+/// Qt::MouseButton values in the demo). Several codes may drive one command
+//----------------------------------------------------------------------------------------------------------------------
+class InputBindings
+{
+  public :
+    void bindKey(int _code, InputCommand _command) { bind(InputSample::KEY,_code,_command); }
+    void bindButton(int _code, InputCommand _command) { bind(InputSample::BUTTON,_code,_command); }
+    void clear() { m_bindings.clear(); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the command of a KEY or BUTTON sample, or -1 if it is not bound
+    //----------------------------------------------------------------------------------------------------------------------
+    int command(const InputSample &_sample) const;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief degrees turned per pixel of motion, pitch follows the mouse down unless inverted
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_lookDegreesPerPixel=0.2f;
+    bool m_invertY=false;
+
+  private :
+    struct Binding
+    {
+      InputSample::Type m_type;
+      int32_t m_code;
+      InputCommand m_command;
+    };
+    void bind(InputSample::Type _type, int _code, InputCommand _command);
+    std::vector<Binding> m_bindings;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the input of one tick
+//----------------------------------------------------------------------------------------------------------------------
+struct InputState
+{
+  /// @brief down at the end of the tick
+  bool m_held[NUM_INPUT_COMMANDS];
+  /// @brief times it went down during the tick, a tap shorter than a tick still counts
+  int m_presses[NUM_INPUT_COMMANDS];
+  /// @brief degrees to turn this tick, the motion of every sample summed
+  float m_pitch;
+  float m_yaw;
+  /// @brief samples collected and how many of them were motion folded into the one turn
+  size_t m_samples;
+  size_t m_motions;
+
+  bool active(InputCommand _command) const { return m_held[_command] || m_presses[_command]!=0; }
+};
+
+class InputSystem
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @param [in] _capacity samples that can wait for a tick, a fast mouse sends one a millisecond
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit InputSystem(size_t _capacity=4096);
+    InputSystem(const InputSystem &)=delete;
+    InputSystem & operator=(const InputSystem &)=delete;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief only to be changed while nothing is collecting
+    //----------------------------------------------------------------------------------------------------------------------
+    InputBindings & bindings() { return m_bindings; }
+    const InputBindings & bindings() const { return m_bindings; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief producer side, one thread only
+    /// @returns false if the queue is full and the sample was dropped
+    //----------------------------------------------------------------------------------------------------------------------
+    bool push(const InputSample &_sample) { return m_queue.tryPush(_sample); }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief consumer side, fold every sample stamped no later than _until into a fresh tick of state.
+    /// Held commands carry over from the last tick, presses and motion start from nothing
+    /// @param [out] o_samples if not null every sample taken, in order, e.g. for recording
+    //----------------------------------------------------------------------------------------------------------------------
+    const InputState & collect(double _until, std::vector<InputSample> *o_samples=nullptr);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief consumer side, fold samples that did not come through the queue, e.g. played back
+    //----------------------------------------------------------------------------------------------------------------------
+    void apply(const InputSample &_sample);
+    const InputState & state() const { return m_state; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief let go of everything, e.g. when the window loses focus and the releases will never come
+    //----------------------------------------------------------------------------------------------------------------------
+    void releaseAll();
+
+  private :
+    void beginTick();
+
+    InputBindings m_bindings;
+    SpscQueue<InputSample> m_queue;
+    InputState m_state;
+    /// @brief bound keys and buttons that are down, a command stays held while any of its codes is
+    std::vector<InputSample> m_down;
+};
+
+} // end namespace fps
+
+#endif
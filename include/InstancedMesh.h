@@ -0,0 +1,59 @@
+#ifndef INSTANCEDMESH_H__
+#define INSTANCEDMESH_H__
+
+#include <ngl/Types.h>
+#include <ngl/Mat4.h>
+#include <ngl/VertexArrayObject.h>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InstancedMesh.h
+/// @brief draws many copies of one of the ngl::VAOPrimitives meshes with a single call. A per instance
+/// model matrix buffer is attached to the primitive's VAO at attribute locations 3-6 (inModel in
+/// PhongVertex.glsl) with a divisor of one, so CPU submission cost no longer depends on the copy count.
+/// Several InstancedMesh may share one primitive, each attaches its own buffer when it draws.
+//----------------------------------------------------------------------------------------------------------------------
+class InstancedMesh
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief first attribute location used by the model matrix, it takes four
+    //----------------------------------------------------------------------------------------------------------------------
+    static const GLuint MODEL_ATTRIBUTE=3;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor
+    /// @param [in] _primitive the name of the mesh in ngl::VAOPrimitives e.g. "teapot"
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit InstancedMesh(const std::string &_primitive);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief find the primitive and attach the instance buffer, needs a current GL context
+    //----------------------------------------------------------------------------------------------------------------------
+    void initialize();
+    void release();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief upload the model matrices, the buffer is only reallocated when it has to grow
+    //----------------------------------------------------------------------------------------------------------------------
+    void setTransforms(const float *_matrices, size_t _count);
+    void setTransforms(const ngl::Mat4 *_transforms, size_t _count) { setTransforms(&_transforms->m_m[0][0],_count); }
+    void setTransforms(const std::vector<ngl::Mat4> &_transforms) { setTransforms(_transforms.data(),_transforms.size()); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw every instance, the shader must have instanced set
+    //----------------------------------------------------------------------------------------------------------------------
+    void draw() const;
+    size_t instanceCount() const { return m_count; }
+
+  private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief point attributes 3-6 of the bound VAO at this mesh's instance buffer
+    //----------------------------------------------------------------------------------------------------------------------
+    void attachInstances() const;
+
+    std::string m_primitive;
+    ngl::VertexArrayObject *m_vao;
+    GLuint m_instanceBuffer;
+    size_t m_count;
+    size_t m_capacity;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef JOBSYSTEM_H__
+#define JOBSYSTEM_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file JobSystem.h
+/// @brief a small fork / join job system for the simulation. Every thread owns a deque of jobs, it takes
+/// work from the back of its own and steals from the front of the others' when it runs dry, so uneven jobs
+/// balance themselves out. The thread calling parallelFor is worker 0 and works on the jobs too rather than
+/// waiting. parallelFor is not reentrant, jobs must not call it.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class JobSystem
+{
+  public :
+    typedef std::function<void(size_t _begin, size_t _end)> RangeFunction;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @param [in] _threads total threads including the caller, 0 for one per hardware thread
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit JobSystem(size_t _threads=0);
+    ~JobSystem();
+    JobSystem(const JobSystem &)=delete;
+    JobSystem & operator=(const JobSystem &)=delete;
+    size_t threadCount() const { return m_workers.size(); }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief call _function on [0,_count) split into the ranges [k*_grain,(k+1)*_grain) and return once all
+    /// are done. The ranges do not depend on the thread count, so work that writes per range results gives
+    /// the same answer however many threads ran it.
+    //----------------------------------------------------------------------------------------------------------------------
+    void parallelFor(size_t _count, size_t _grain, const RangeFunction &_function);
+
+  private :
+    struct Job
+    {
+      const RangeFunction *m_function;
+      size_t m_begin;
+      size_t m_end;
+    };
+    struct Worker
+    {
+      std::mutex m_mutex;
+      std::deque<Job> m_jobs;
+    };
+    bool pop(size_t _worker, Job &o_job);
+    bool steal(size_t _thief, Job &o_job);
+    bool find(size_t _worker, Job &o_job);
+    void run(const Job &_job);
+    void workerLoop(size_t _worker);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    /// @brief jobs queued but not yet taken, the sleeping workers wait for it to rise
+    std::atomic<size_t> m_queued;
+    /// @brief jobs of the current parallelFor not yet finished
+    std::atomic<size_t> m_remaining;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_quit;
+};
+
+} // end namespace fps
+
+#endif
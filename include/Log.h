@@ -0,0 +1,97 @@
+#ifndef LOG_H__
+#define LOG_H__
+
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Log.h
+/// @brief leveled asynchronous logging. Messages are formatted into a fixed size slot of a lock free queue on
+/// the calling thread and written out by a background thread, so logging never waits on stdout.
+/// Levels below FPS_LOG_LEVEL are removed at compile time, pass -DFPS_LOG_LEVEL=0 to keep everything.
+/// The queue is single producer so only the GUI thread should log.
+//----------------------------------------------------------------------------------------------------------------------
+
+#define FPS_LOG_LEVEL_TRACE 0
+#define FPS_LOG_LEVEL_DEBUG 1
+#define FPS_LOG_LEVEL_INFO  2
+#define FPS_LOG_LEVEL_WARN  3
+#define FPS_LOG_LEVEL_ERROR 4
+
+#ifndef FPS_LOG_LEVEL
+  #define FPS_LOG_LEVEL FPS_LOG_LEVEL_DEBUG
+#endif
+
+namespace fps
+{
+
+class Log
+{
+  public :
+    enum Level { LEVEL_TRACE=FPS_LOG_LEVEL_TRACE, LEVEL_DEBUG, LEVEL_INFO, LEVEL_WARN, LEVEL_ERROR };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief longest message kept, anything longer is truncated
+    //----------------------------------------------------------------------------------------------------------------------
+    static const size_t MAX_MESSAGE=240;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the process wide logger, started on first use and flushed when the program exits
+    //----------------------------------------------------------------------------------------------------------------------
+    static Log & instance();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief format and queue a message, dropped (and counted) if the queue is full
+    //----------------------------------------------------------------------------------------------------------------------
+    void write(Level _level, const char *_fmt, ...)
+#if defined(__GNUC__)
+      __attribute__((format(printf,3,4)))
+#endif
+    ;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief messages below this level are discarded at run time as well
+    //----------------------------------------------------------------------------------------------------------------------
+    void setLevel(Level _level) { m_level.store(_level,std::memory_order_relaxed); }
+    bool enabled(Level _level) const { return _level>=m_level.load(std::memory_order_relaxed); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief send output somewhere other than stdout, the file is not closed by the logger
+    //----------------------------------------------------------------------------------------------------------------------
+    void setOutput(FILE *_file) { m_output.store(_file,std::memory_order_relaxed); }
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    ~Log();
+
+  private :
+    struct Message
+    {
+      Level level;
+      double seconds;
+      char text[MAX_MESSAGE];
+    };
+
+    Log();
+    Log(const Log &)=delete;
+    Log & operator=(const Log &)=delete;
+    void run();
+    void drain();
+
+    SpscQueue<Message> m_queue;
+    std::atomic<int> m_level;
+    std::atomic<FILE *> m_output;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<bool> m_running;
+    std::thread m_writer;
+};
+
+} // end namespace fps
+
+#define FPS_LOG(level,...) \
+  do { if(level>=FPS_LOG_LEVEL && fps::Log::instance().enabled(static_cast<fps::Log::Level>(level))) \
+         fps::Log::instance().write(static_cast<fps::Log::Level>(level),__VA_ARGS__); } while(0)
+
+#define FPS_LOG_TRACE(...) FPS_LOG(FPS_LOG_LEVEL_TRACE,__VA_ARGS__)
+#define FPS_LOG_DEBUG(...) FPS_LOG(FPS_LOG_LEVEL_DEBUG,__VA_ARGS__)
+#define FPS_LOG_INFO(...)  FPS_LOG(FPS_LOG_LEVEL_INFO,__VA_ARGS__)
+#define FPS_LOG_WARN(...)  FPS_LOG(FPS_LOG_LEVEL_WARN,__VA_ARGS__)
+#define FPS_LOG_ERROR(...) FPS_LOG(FPS_LOG_LEVEL_ERROR,__VA_ARGS__)
+
+#endif
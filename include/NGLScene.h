@@ -6,8 +6,17 @@
 #include <ngl/Light.h>
 #include <ngl/Text.h>
 #include <QOpenGLWindow>
+#include <QElapsedTimer>
+#include "FrameProfiler.h"
+#include "FrameCapture.h"
+#include "InstancedMesh.h"
+#include "CameraUBO.h"
+#include "RaymarchPass.h"
+#include "DynamicResolution.h"
+#include "Scene.h"
+#include "Simulation.h"
+#include <memory>
 #include <ngl/VertexArrayObject.h>
-#include <ngl/Transformation.h>
 
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -27,7 +36,6 @@ class NGLScene : public QOpenGLWindow
 {
   Q_OBJECT
   public:
-    ngl::VertexArrayObject *m_vao;
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief ctor for our NGL drawing class
     /// @param [in] parent the parent window to the class
@@ -53,44 +61,29 @@ class NGLScene : public QOpenGLWindow
     void resizeGL(QResizeEvent *_event);
     // Qt 5.x uses this instead! http://doc.qt.io/qt-5/qopenglwindow.html#resizeGL
     void resizeGL(int _w, int _h);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw into _fbo on whatever context is current instead of the window, set before initializeGL.
+    /// The simulation thread is not started, it only ticks when simulation().advance() is called, every
+    /// frame is drawn at the newest tick and the raymarched pass stays at full size, so the same ticks
+    /// always give the same pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    void setOffscreenTarget(GLuint _fbo);
+    fps::Simulation & simulation() { return m_sim; }
+    const fps::FrameProfiler & profiler() const { return m_profiler; }
 
-    void buildVAO();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief load the scene named by FPS_SCENE (default scenes/default.scene) and build its draw batches
+    //----------------------------------------------------------------------------------------------------------------------
+    void loadScene();
 
 
 
 private:
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief used to store the x rotation mouse value
-    //----------------------------------------------------------------------------------------------------------------------
-    int m_spinXFace;
-    //----------------------------------------------------------------------------------------------------------------------
-    /// @brief used to store the y rotation mouse value
-    //----------------------------------------------------------------------------------------------------------------------
-    int m_spinYFace;
-    //----------------------------------------------------------------------------------------------------------------------
-    /// @brief flag to indicate if the mouse button is pressed when dragging
-    //----------------------------------------------------------------------------------------------------------------------
-    bool m_rotate;
-    //----------------------------------------------------------------------------------------------------------------------
-    /// @brief flag to indicate if the Right mouse button is pressed when dragging
-    //----------------------------------------------------------------------------------------------------------------------
-    bool m_translate;
+    /// @brief where the mouse was at its last event, motion samples carry the difference
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief the previous x mouse value
-    //----------------------------------------------------------------------------------------------------------------------
-    int m_origX;
-    //----------------------------------------------------------------------------------------------------------------------
-    /// @brief the previous y mouse value
-    //----------------------------------------------------------------------------------------------------------------------
-    int m_origY;
-    //----------------------------------------------------------------------------------------------------------------------
-    /// @brief the previous x mouse value for Position changes
-    //----------------------------------------------------------------------------------------------------------------------
-    int m_origXPos;
-    //----------------------------------------------------------------------------------------------------------------------
-    /// @brief the previous y mouse value for Position changes
-    //----------------------------------------------------------------------------------------------------------------------
-    int m_origYPos;
+    int m_mouseX;
+    int m_mouseY;
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief window width
     //----------------------------------------------------------------------------------------------------------------------
@@ -100,22 +93,10 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     int m_height;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief used to store the global mouse transforms
-    //----------------------------------------------------------------------------------------------------------------------
-    ngl::Mat4 m_mouseGlobalTX;
-    //----------------------------------------------------------------------------------------------------------------------
     /// @brief Our Camera
     //----------------------------------------------------------------------------------------------------------------------
     ngl::Camera m_cam;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief the model position for mouse movement
-    //----------------------------------------------------------------------------------------------------------------------
-    ngl::Vec3 m_modelPos;
-    //----------------------------------------------------------------------------------------------------------------------
-    /// @brief method to load transform matrices to the shader
-    //----------------------------------------------------------------------------------------------------------------------
-    void loadMatricesToShader();
-    //----------------------------------------------------------------------------------------------------------------------
     /// @brief Qt Event called when a key is pressed
     /// @param [in] _event the Qt event to query for size etc
     //----------------------------------------------------------------------------------------------------------------------
@@ -139,39 +120,146 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     void mouseReleaseEvent ( QMouseEvent *_event );
 
-    //----------------------------------------------------------------------------------------------------------------------
-    /// @brief this method is called everytime the mouse wheel is moved
-    /// inherited from QObject and overridden here.
-    /// @param _event the Qt Event structure
-    //----------------------------------------------------------------------------------------------------------------------
-    void wheelEvent( QWheelEvent *_event);
-
-    void timerEvent(QTimerEvent * _event);
-
     //fps camera stuff adapted from http://learnopengl.com/#!Getting-started/Camera
 
-    float radius=2;
-    float toradians;
-    float _x ;
-    float _z ;
-    ngl::Vec3 currentCameraorigin;
     ngl::Vec3 currentCameraUp;
-    ngl::Vec3 currentCameraPos;
-    ngl::Vec3 prevCameraPos;
     ngl::Mat4 viewMatrix;
+    ngl::Mat4 m_projection;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief build viewMatrix and m_projection from the snapshot camera, once per frame
+    /// @returns how far the frame is between the snapshot's previous and current eye, 0 to 1
+    //----------------------------------------------------------------------------------------------------------------------
+    float updateViewProjection(const fps::FrameSnapshot &_snapshot);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the per frame view / projection block shared by every draw
+    //----------------------------------------------------------------------------------------------------------------------
+    CameraUBO m_cameraUBO;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief cached uniform locations in the Phong program for the per draw values
+    //----------------------------------------------------------------------------------------------------------------------
+    GLint m_modelLocation;
+    GLint m_instancedLocation;
 
     ngl::Vec3 currentCameraFront;
-    ngl::Vec3 cameraSpeed;
-    ngl::Vec3 currentRight;
-    ngl::Vec3 newCamPos;
-
-    bool keys[1024];
-    void updateCameraPos();
-
-    ngl::Transformation m_transform;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the camera, debris and culling on their own thread, input goes in as samples and commands and
+    /// every frame draws the newest snapshot it publishes
+    //----------------------------------------------------------------------------------------------------------------------
+    fps::Simulation m_sim;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief queue a command or a key and mouse sample for the next tick, logging it if the queue is full
+    //----------------------------------------------------------------------------------------------------------------------
+    void post(const fps::Simulation::Command &_command);
+    void push(const fps::InputSample &_sample);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the interpolated camera position the current frame is drawn from
+    //----------------------------------------------------------------------------------------------------------------------
+    ngl::Vec3 m_renderCameraPos;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief per frame CPU timings, shown with the T key and optionally dumped as a Chrome trace on exit
+    //----------------------------------------------------------------------------------------------------------------------
+    fps::FrameProfiler m_profiler;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief where to write the trace on exit, empty if FPS_TRACE wasn't set
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_traceFile;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief FPS_INPUT_RECORD records the session's input to write on exit, FPS_INPUT_REPLAY flies a recorded
+    /// one again in place of the keyboard and mouse
+    //----------------------------------------------------------------------------------------------------------------------
+    fps::InputRecording m_inputRecording;
+    std::string m_inputRecordFile;
+    bool m_replayingInput;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief where the replay started, so its frames can be summed up when it ends
+    //----------------------------------------------------------------------------------------------------------------------
+    uint64_t m_replayFirstFrame;
+    double m_replayStart;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief debris count last written to the log, the simulation thread cannot log it itself
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_loggedDebris;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start recording or replaying input as the environment asks, before the simulation starts
+    //----------------------------------------------------------------------------------------------------------------------
+    void setupInputRecording();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true when drawing into m_offscreenFBO for a headless run
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_offscreen;
+    GLuint m_offscreenFBO;
+    GLuint framebuffer() { return m_offscreen ? m_offscreenFBO : defaultFramebufferObject(); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief log the frame times of the finished replay and quit if FPS_REPLAY_EXIT is set
+    //----------------------------------------------------------------------------------------------------------------------
+    void finishReplay();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief text used for the stats overlay
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<ngl::Text> m_text;
+    bool m_showStats;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief GL_TIME_ELAPSED queries, a ring so we read results a couple of frames late and never stall
+    //----------------------------------------------------------------------------------------------------------------------
+    static const int NUM_GPU_QUERIES=3;
+    GLuint m_gpuQueries[NUM_GPU_QUERIES];
+    unsigned int m_gpuQueryFrame;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw the min / avg / p99 timings for each stage
+    //----------------------------------------------------------------------------------------------------------------------
+    void drawStats(const fps::FrameSnapshot &_snapshot);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief PBO based screenshots, the P key requests one
+    //----------------------------------------------------------------------------------------------------------------------
+    FrameCapture m_capture;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief streams every frame to disk or an encoder while recording, the R key toggles it
+    //----------------------------------------------------------------------------------------------------------------------
+    fps::FrameRecorder m_recorder;
+    void toggleRecording(bool _on);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the loaded scene, its transform array is read in place
+    //----------------------------------------------------------------------------------------------------------------------
+    fps::Scene m_scene;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief primitive mesh objects sharing a mesh and material, drawn with one instanced call
+    //----------------------------------------------------------------------------------------------------------------------
+    struct DrawBatch
+    {
+      uint32_t m_material;
+      std::unique_ptr<InstancedMesh> m_instances;
+    };
+    std::vector<DrawBatch> m_batches;
+    /// @brief VAOs for the scene's vertex meshes, null for primitives
+    std::vector<ngl::VertexArrayObject *> m_meshVAOs;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief upload the snapshot's visible model matrices into the instance buffers
+    //----------------------------------------------------------------------------------------------------------------------
+    void uploadInstances(const fps::FrameSnapshot &_snapshot);
+    void drawScene(const fps::FrameSnapshot &_snapshot);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief upload a scene material into the Materials struct of the Phong shader
+    //----------------------------------------------------------------------------------------------------------------------
+    void loadMaterial(uint32_t _material);
+    enum { MAT_AMBIENT, MAT_DIFFUSE, MAT_SPECULAR, MAT_SHININESS, NUM_MATERIAL_UNIFORMS };
+    GLint m_materialLocations[NUM_MATERIAL_UNIFORMS];
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief debris thrown from the camera with B, simulated against the scene colliders and drawn as
+    /// one instanced batch of spheres
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<InstancedMesh> m_debrisMesh;
+    void drawDebris(const fps::FrameSnapshot &_snapshot);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the scene's signed distance field raymarched in place of the rasterized objects, toggled with
+    /// M and on from the start when the scene has an sdf collider. It is drawn at the size m_resolution
+    /// picks from the GPU time to hold FPS_RAYMARCH_MS, [ and ] change the march steps and K turns the
+    /// shadows and ambient occlusion off and on
+    //----------------------------------------------------------------------------------------------------------------------
+    RaymarchPass m_raymarch;
+    fps::DynamicResolution m_resolution;
+    bool m_raymarching;
+    void toggleRaymarching(bool _on);
 
-    ngl::Vec3 calculateCollisionResponse(const ngl::Vec3 & normal);
-    ngl::Vec3 calculateCoulombFriction(ngl::Vec3 & velocity);
 
 
 
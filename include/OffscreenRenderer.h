@@ -0,0 +1,70 @@
+#ifndef OFFSCREENRENDERER_H__
+#define OFFSCREENRENDERER_H__
+
+#include <ngl/Types.h>
+#include "InputRecording.h"
+#include "RgbImage.h"
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file OffscreenRenderer.h
+/// @brief the demo with no window, for timing the renderer on build servers with no GPU (llvmpipe). NGLScene
+/// draws into a framebuffer object on a QOffscreenSurface while a camera path, a recorded input session or
+/// a built in walk, takes one simulation tick per frame. Each frame is finished before the clock stops so
+/// its time is the whole of its work, and the frames can be hashed or written out to compare two builds.
+//----------------------------------------------------------------------------------------------------------------------
+class OffscreenRenderer
+{
+  public :
+    struct Settings
+    {
+      int m_width=1024;
+      int m_height=720;
+      /// @brief samples per pixel of the colour and depth targets, 0 for none
+      int m_samples=4;
+      int m_frames=300;
+      /// @brief frames drawn before timing starts, while shaders and caches settle
+      int m_warmup=10;
+      /// @brief the recorded session to fly, the built in walk if empty
+      std::string m_session;
+      /// @brief print every frame's image hash
+      bool m_hash=false;
+      /// @brief write every frame as prefix0000.ppm and on if not empty
+      std::string m_outPrefix;
+    };
+
+    explicit OffscreenRenderer(const Settings &_settings);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief make the context and targets, draw the frames and print their statistics, needs a
+    /// QGuiApplication
+    /// @returns the process exit status
+    //----------------------------------------------------------------------------------------------------------------------
+    int run();
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a walk forward that turns a full circle over _ticks ticks, nodding up and down as it goes
+    //----------------------------------------------------------------------------------------------------------------------
+    static void walkPath(int _ticks, double _dt, const fps::CameraController::State &_start,
+                         fps::InputRecording &o_path);
+
+  private :
+    bool createTargets();
+    void releaseTargets();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief resolve the multisampled target and read it back top row first
+    //----------------------------------------------------------------------------------------------------------------------
+    void readback(fps::RgbImage &o_image);
+
+    Settings m_settings;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the target NGLScene draws into and, when multisampled, the one it is resolved into to read
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint m_fbo;
+    GLuint m_colour;
+    GLuint m_depth;
+    GLuint m_resolveFBO;
+    GLuint m_resolveColour;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef PHYSICSSTATE_H__
+#define PHYSICSSTATE_H__
+
+#include "CoreMath.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file PhysicsState.h
+/// @brief the rigid body state of the camera body, previously the file scope globals in NGLScene.cpp
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+struct PhysicsState
+{
+  /// @brief current linear velocity
+  Vec3 velocity;
+  /// @brief constant force applied every step (gravity)
+  Vec3 force=Vec3(0.0f,-9.8f,0.0f);
+  /// @brief body mass
+  float mass=1.0f;
+  /// @brief coefficient of restitution, e=0 perfectly inelastic, e=1 perfectly elastic
+  float restitution=0.8f;
+  /// @brief accumulated artificial friction impulse used by coulombFriction
+  float frictionImpulse=0.0f;
+  /// @brief upwards speed given to the body when jumping from the ground
+  float jumpSpeed=20.0f;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef RAYMARCHPASS_H__
+#define RAYMARCHPASS_H__
+
+#include <ngl/Types.h>
+#include <ngl/Vec3.h>
+#include "CameraUBO.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RaymarchPass.h
+/// @brief shaders/testraymarching.glsl drawn as a fullscreen pass from the FPS camera. The scene is marched
+/// into an offscreen colour and depth target at whatever size the caller picks, then stretched over the
+/// window by a second pass that carries the depth across, so rasterized objects drawn afterwards are hidden
+/// behind the raymarched surfaces. At the window's own size the first pass draws straight into the window.
+//----------------------------------------------------------------------------------------------------------------------
+class RaymarchPass
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief iteration counts handed to the shader, the cost of a pixel is roughly their sum
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Settings
+    {
+      int m_marchSteps=50;
+      int m_shadowSteps=16;
+      int m_aoSteps=5;
+    };
+
+    RaymarchPass();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief build the programs and point their Camera block at _camera's binding, needs a current GL context
+    //----------------------------------------------------------------------------------------------------------------------
+    void initialize(const CameraUBO &_camera);
+    void release();
+    Settings & settings() { return m_settings; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief where the shader's origin sits in the world and world units per shader unit
+    //----------------------------------------------------------------------------------------------------------------------
+    void setPlacement(const ngl::Vec3 &_origin, float _scale);
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw the scene over the whole of _target, the Camera block must hold this frame's camera
+    /// @param [in] _target the framebuffer to draw into, the window's default one
+    /// @param [in] _width size of _target in pixels
+    /// @param [in] _renderWidth size the scene is marched at before it is stretched over _target
+    //----------------------------------------------------------------------------------------------------------------------
+    void draw(GLuint _target, int _width, int _height, int _renderWidth, int _renderHeight,
+              const ngl::Vec3 &_eye, const ngl::Vec3 &_front, const ngl::Vec3 &_up);
+
+  private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief (re)create the offscreen target when the render size changes
+    //----------------------------------------------------------------------------------------------------------------------
+    void resizeTarget(int _width, int _height);
+    enum { RESOLUTION, EYE, FRONT, UP, ORIGIN, SCALE, MARCH_STEPS, SHADOW_STEPS, AO_STEPS, NUM_UNIFORMS };
+
+    Settings m_settings;
+    ngl::Vec3 m_origin;
+    float m_scale;
+    GLuint m_raymarchProgram;
+    GLuint m_upscaleProgram;
+    GLint m_uniforms[NUM_UNIFORMS];
+    /// @brief core profiles draw nothing without a VAO bound, even with no attributes
+    GLuint m_vao;
+    GLuint m_fbo;
+    GLuint m_colour;
+    GLuint m_depth;
+    int m_targetWidth;
+    int m_targetHeight;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef RAYMARCHER_H__
+#define RAYMARCHER_H__
+
+#include "CoreMath.h"
+#include "JobSystem.h"
+#include "RgbImage.h"
+#include "SdfScene.h"
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Raymarcher.h
+/// @brief shaders/testraymarching.glsl on the CPU, castRay, softshadow, calcAO and the shading of render()
+/// step for step, as the reference the GPU pass is checked against and for golden images on machines with
+/// no GPU. The image is cut into square tiles shared out over a JobSystem, and each tile marches a row of
+/// four (SSE) or eight (AVX) neighbouring pixels as one packet. Lanes that hit or leave stop stepping while
+/// the rest carry on, so a packet gives the same pixels as marching its rays one by one.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class Raymarcher
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the shader's constants, lengths in shader units
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Settings
+    {
+      /// @brief march limits of castRay
+      int m_steps=50;
+      float m_tmin=1.0f;
+      float m_tmax=20.0f;
+      float m_precision=0.002f;
+      /// @brief steps of each soft shadow ray, 0 leaves everything lit
+      int m_shadowSteps=16;
+      bool m_ambientOcclusion=true;
+      /// @brief edge of the square tiles the image is shared out in
+      int m_tileSize=16;
+      /// @brief march one ray at a time, the reference for the packets
+      bool m_scalar=false;
+      /// @brief draw each pixel's castRay step count from black (none) to white (m_steps) instead of shading
+      bool m_heatmap=false;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief what the last render cost, march steps and map() points are counted per ray so the numbers do
+    /// not depend on the packet width
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Stats
+    {
+      uint64_t m_rays=0;
+      uint64_t m_marchSteps=0;
+      uint64_t m_mapPoints=0;
+      uint64_t m_hits=0;
+      double m_ms=0.0;
+    };
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief vertical field of view of iq's original camera, whose rays were normalize(vec3(p.xy,2.0))
+    //----------------------------------------------------------------------------------------------------------------------
+    static const float SHADER_FOV;
+
+    explicit Raymarcher(const SdfScene &_scene=SdfScene());
+    Settings & settings() { return m_settings; }
+    const Settings & settings() const { return m_settings; }
+    const SdfScene & scene() const { return m_scene; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief render the scene as seen through a view matrix like CameraController's
+    /// @param [in] _fovy vertical field of view in degrees, the aspect comes from the image size
+    /// @param [in] _jobs spreads the tiles over its threads, may be null
+    /// @param [out] o_image resized to _width by _height
+    //----------------------------------------------------------------------------------------------------------------------
+    void render(const Mat4 &_view, float _fovy, int _width, int _height, JobSystem *_jobs, RgbImage &o_image);
+    const Stats & stats() const { return m_stats; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the view of the camera iq's main() orbited the scene with before the shader took the FPS
+    /// camera, for iGlobalTime and the mouse in 0..1. With SHADER_FOV it gives the original frames
+    //----------------------------------------------------------------------------------------------------------------------
+    static Mat4 shaderView(float _time, float _mouseX, float _mouseY);
+
+  private :
+    template <typename F>
+    void renderTile(int _tile, const Mat4 &_view, float _fovy, RgbImage &o_image, Stats &o_stats) const;
+
+    SdfScene m_scene;
+    Settings m_settings;
+    Stats m_stats;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef RGBIMAGE_H__
+#define RGBIMAGE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RgbImage.h
+/// @brief 8 bit RGB pixels, top row first, for images made without a GPU. Reads and writes binary PPM so
+/// golden images need no image library, and hashes the pixels so two renders can be compared by value.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class RgbImage
+{
+  public :
+    RgbImage() {}
+    RgbImage(int _width, int _height) { resize(_width,_height); }
+    void resize(int _width, int _height);
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    uint8_t * pixel(int _x, int _y) { return &m_pixels[3*(static_cast<size_t>(_y)*m_width+_x)]; }
+    const uint8_t * pixel(int _x, int _y) const { return &m_pixels[3*(static_cast<size_t>(_y)*m_width+_x)]; }
+    const std::vector<uint8_t> & pixels() const { return m_pixels; }
+    std::vector<uint8_t> & pixels() { return m_pixels; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief binary P6 with a maxval of 255, the only kind read back
+    //----------------------------------------------------------------------------------------------------------------------
+    bool writePPM(const std::string &_fname) const;
+    bool readPPM(const std::string &_fname);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief 64 bit FNV-1a of the size and pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    uint64_t hash() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief largest difference of any channel, or 256 when the sizes differ
+    //----------------------------------------------------------------------------------------------------------------------
+    static int maxDifference(const RgbImage &_a, const RgbImage &_b);
+
+  private :
+    int m_width=0;
+    int m_height=0;
+    std::vector<uint8_t> m_pixels;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef RIGIDBODIES_H__
+#define RIGIDBODIES_H__
+
+#include "CollisionWorld.h"
+#include "CoreMath.h"
+#include "JobSystem.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RigidBodies.h
+/// @brief many sphere bodies (crates, debris) simulated alongside the camera. Body state is structure of
+/// arrays so integration and the sleep test run four bodies per SSE instruction, with a scalar path for
+/// other builds. Contacts with the CollisionWorld and between bodies are gathered into one batch per step
+/// and solved with sequential impulses, the restitution response of the camera's collisionResponse plus
+/// Coulomb friction clamped by the normal impulse. Contacts are found a step ahead (speculatively) so fast
+/// bodies stop at thin geometry. Bodies that stay slow for a while go to sleep and cost nothing until an
+/// awake body hits them. With a JobSystem the step is spread over its threads, body ranges for the kernels
+/// and the broadphase and contact islands for the solver, and the result is bit for bit the same for any
+/// thread count. One big pile is one island, so it is solved on one thread.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class RigidBodies
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief SEMI_IMPLICIT_EULER keeps an explicit velocity, pushing a body out of an overlap does not change
+    /// it. VERLET takes the velocity from the last two positions so overlap corrections become motion, the
+    /// position based behaviour that keeps piles of debris stable.
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Integrator { SEMI_IMPLICIT_EULER=0, VERLET };
+    struct Config
+    {
+      Integrator integrator=SEMI_IMPLICIT_EULER;
+      Vec3 gravity=Vec3(0.0f,-9.8f,0.0f);
+      /// @brief velocity solver passes over the contact batch
+      int iterations=4;
+      /// @brief approach speeds below this do not bounce, stops resting bodies chattering
+      float restSpeed=0.5f;
+      /// @brief bodies slower than sleepSpeed for sleepTime seconds go to sleep
+      float sleepSpeed=0.1f;
+      float sleepTime=0.5f;
+      /// @brief body to body broadphase cell, at least the largest diameter plus the distance two bodies close
+      /// in a step, contacts further apart than that are only found once they touch
+      float cellSize=1.0f;
+      /// @brief use the SSE kernels where available, off for the scalar reference
+      bool simd=true;
+    };
+
+    RigidBodies();
+    explicit RigidBodies(const Config &_config);
+    const Config & config() const { return m_config; }
+    Config & config() { return m_config; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief static geometry the bodies collide with, may be null
+    //----------------------------------------------------------------------------------------------------------------------
+    void setWorld(const CollisionWorld *_world) { m_world=_world; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief threads to step on, null steps on the calling thread
+    //----------------------------------------------------------------------------------------------------------------------
+    void setJobSystem(JobSystem *_jobs) { m_jobs=_jobs; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add a body, a mass of 0 makes it immovable
+    /// @returns the body index
+    //----------------------------------------------------------------------------------------------------------------------
+    uint32_t add(const Vec3 &_position, float _radius, float _mass=1.0f, const Vec3 &_velocity=Vec3());
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bounciness and Coulomb friction coefficient, 0.3 and 0.5 by default
+    //----------------------------------------------------------------------------------------------------------------------
+    void setMaterial(uint32_t _i, float _restitution, float _friction);
+    void clear();
+    size_t size() const { return m_size; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief advance every awake body by _dt seconds
+    //----------------------------------------------------------------------------------------------------------------------
+    void step(float _dt);
+
+    Vec3 position(uint32_t _i) const { return Vec3(m_px[_i],m_py[_i],m_pz[_i]); }
+    Vec3 velocity(uint32_t _i) const { return Vec3(m_vx[_i],m_vy[_i],m_vz[_i]); }
+    float radius(uint32_t _i) const { return m_radius[_i]; }
+    bool awake(uint32_t _i) const { return m_awake[_i]!=0.0f; }
+    void wake(uint32_t _i);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief change the velocity of a body by _impulse over its mass, waking it
+    //----------------------------------------------------------------------------------------------------------------------
+    void applyImpulse(uint32_t _i, const Vec3 &_impulse);
+    size_t awakeCount() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief contacts solved in the last step
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t contactCount() const { return m_contacts.size(); }
+
+  private :
+    struct Contact
+    {
+      uint32_t m_a;
+      /// @brief the other body or NO_BODY for static geometry
+      uint32_t m_b;
+      /// @brief unit normal from b (or the world) towards a
+      Vec3 m_normal;
+      Vec3 m_tangent;
+      /// @brief gap between the surfaces at the start of the step, negative when overlapping
+      float m_separation;
+      /// @brief the least normal velocity the solver allows, the bounce or how far a gap lets it approach
+      float m_target;
+      float m_friction;
+      /// @brief inverse masses for the step, zero for static geometry and sleeping bodies
+      float m_inverseMassA;
+      float m_inverseMassB;
+      /// @brief accumulated impulses, clamped rather than each iteration's share
+      float m_normalImpulse;
+      float m_tangentImpulse;
+    };
+    static const uint32_t NO_BODY=0xffffffffu;
+
+    void parallelFor(size_t _count, size_t _grain, const JobSystem::RangeFunction &_function);
+    void integrateVelocities(size_t _begin, size_t _end, float _dt);
+    void integratePositions(size_t _begin, size_t _end, float _dt);
+    void updateSleep(size_t _begin, size_t _end, float _dt);
+    void findContacts(float _dt);
+    void worldContacts(uint32_t _i, float _dt, std::vector<Contact> &o_contacts) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief contacts of the bodies m_cellItems[_begin] to m_cellItems[_end-1], sleepers they hit go in o_wakes
+    //----------------------------------------------------------------------------------------------------------------------
+    void bodyContacts(size_t _begin, size_t _end, float _dt, std::vector<Contact> &o_contacts,
+                      std::vector<uint32_t> &o_wakes) const;
+    Contact makeContact(uint32_t _a, uint32_t _b, const Vec3 &_normal, float _separation, float _dt) const;
+    uint32_t findRoot(uint32_t _i);
+    void buildIslands();
+    void solveIslands(size_t _begin, size_t _end);
+    void solveContact(Contact &_c);
+    void correctIslands(size_t _begin, size_t _end);
+    void correctContact(const Contact &_c);
+    void buildGrid();
+    size_t cell(int _x, int _y, int _z) const;
+    float effectiveInverseMass(uint32_t _i) const;
+
+    Config m_config;
+    const CollisionWorld *m_world=nullptr;
+    JobSystem *m_jobs=nullptr;
+    size_t m_size=0;
+    /// @brief the last step length, for turning impulses into Verlet position changes
+    float m_dt=1.0f/120.0f;
+    std::vector<float> m_px, m_py, m_pz;
+    std::vector<float> m_vx, m_vy, m_vz;
+    /// @brief positions at the start of the last step, Verlet's previous position
+    std::vector<float> m_ox, m_oy, m_oz;
+    std::vector<float> m_radius;
+    std::vector<float> m_invMass;
+    std::vector<float> m_restitution;
+    std::vector<float> m_friction;
+    /// @brief 1 or 0 so the kernels can mask sleeping bodies without branching
+    std::vector<float> m_awake;
+    std::vector<float> m_slowTime;
+    /// @brief radius plus the distance the body can move this step
+    std::vector<float> m_reach;
+    std::vector<Contact> m_contacts;
+    /// @brief per range contact lists and wakes, joined in range order after the search
+    std::vector<std::vector<Contact>> m_rangeContacts;
+    std::vector<std::vector<uint32_t>> m_rangeWakes;
+    /// @brief union find over the bodies, then the contacts counting sorted by island
+    std::vector<uint32_t> m_islandParent;
+    std::vector<uint32_t> m_islandOf;
+    std::vector<uint32_t> m_contactIsland;
+    std::vector<uint32_t> m_islandStart;
+    std::vector<Contact> m_islandContacts;
+    size_t m_islandCount=0;
+    /// @brief body broadphase, rebuilt every step
+    std::vector<uint32_t> m_cellStart;
+    std::vector<uint32_t> m_cellItems;
+    std::vector<uint32_t> m_cellOf;
+    std::vector<uint64_t> m_bodyKeys;
+    /// @brief cell key and x y z reach of the bodies in m_cellItems order
+    std::vector<uint64_t> m_cellKeys;
+    std::vector<float> m_cellBodies;
+    int m_cellMask=0;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef SCENE_H__
+#define SCENE_H__
+
+#include "Bounds.h"
+#include "StagingPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Scene.h
+/// @brief scene description loading. Levels are authored as text (see scenes/default.scene) and compiled by
+/// FPSSceneCompile into a binary image that open() maps straight into memory, the record arrays below are
+/// used in place so a level of tens of thousands of objects costs one mmap and a validation pass. open()
+/// also accepts the text form and compiles it into the same in memory layout, so both share one interface.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a mesh is either one of the ngl::VAOPrimitives by name or a range of the vertex array
+//----------------------------------------------------------------------------------------------------------------------
+struct SceneMesh
+{
+  enum Mode { PRIMITIVE=0, LINES, TRIANGLES };
+  static const size_t NAME_SIZE=32;
+  char m_name[NAME_SIZE];
+  char m_primitive[NAME_SIZE];
+  uint32_t m_mode;
+  uint32_t m_firstVertex;
+  uint32_t m_vertexCount;
+  /// @brief bounding sphere radius about the mesh origin, used for the object bounds
+  float m_radius;
+};
+
+struct SceneVertex
+{
+  float m_x;
+  float m_y;
+  float m_z;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief matches the Materials struct in PhongFragment.glsl
+//----------------------------------------------------------------------------------------------------------------------
+struct SceneMaterial
+{
+  char m_name[SceneMesh::NAME_SIZE];
+  float m_ambient[4];
+  float m_diffuse[4];
+  float m_specular[4];
+  float m_shininess;
+  float m_pad[3];
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief collision shape of an object, stored in world space. Spheres use m_params[0] as the radius
+/// about the object position, boxes are axis aligned half extents about it (rotation is ignored), planes
+/// are nx ny nz d and MESH uses the triangles of the object's mesh. SDF is the raymarched scene of
+/// SdfScene with its origin at the object position and m_params[0] the object scale.
+//----------------------------------------------------------------------------------------------------------------------
+struct SceneCollider
+{
+  enum Type { NONE=0, SPHERE, BOX, PLANE, MESH, SDF };
+  uint32_t m_type;
+  float m_params[4];
+};
+
+struct SceneObject
+{
+  uint32_t m_mesh;
+  uint32_t m_material;
+  SceneCollider m_collider;
+  /// @brief world space bounds for culling, min xyz then max xyz
+  float m_bounds[6];
+  /// @brief the authored transform the matrix was built from, for seeding a TransformSystem
+  float m_position[3];
+  float m_rotation[3];
+  float m_scale;
+
+  AABB bounds() const { return AABB(Vec3(m_bounds[0],m_bounds[1],m_bounds[2]),Vec3(m_bounds[3],m_bounds[4],m_bounds[5])); }
+};
+
+class Scene
+{
+  public :
+    static const uint32_t VERSION=2;
+    enum Section { MESHES=0, VERTICES, MATERIALS, OBJECTS, TRANSFORMS, NUM_SECTIONS };
+
+    Scene()=default;
+    ~Scene();
+    Scene(const Scene &)=delete;
+    Scene & operator=(const Scene &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief load a compiled scene (mapped) or a text one (compiled in memory), on failure error() says why
+    //----------------------------------------------------------------------------------------------------------------------
+    bool open(const std::string &_fname);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief compile scene text, _source is only used in error messages
+    //----------------------------------------------------------------------------------------------------------------------
+    bool compile(const std::string &_text, const std::string &_source="scene");
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write the binary image of the loaded scene
+    //----------------------------------------------------------------------------------------------------------------------
+    bool save(const std::string &_fname);
+    void close();
+    bool mapped() const { return m_map!=nullptr; }
+    const std::string & error() const { return m_error; }
+
+    size_t meshCount() const { return count(MESHES); }
+    const SceneMesh * meshes() const { return section<SceneMesh>(MESHES); }
+    size_t vertexCount() const { return count(VERTICES); }
+    const SceneVertex * vertices() const { return section<SceneVertex>(VERTICES); }
+    size_t materialCount() const { return count(MATERIALS); }
+    const SceneMaterial * materials() const { return section<SceneMaterial>(MATERIALS); }
+    size_t objectCount() const { return count(OBJECTS); }
+    const SceneObject * objects() const { return section<SceneObject>(OBJECTS); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief one 4x4 model matrix per object in ngl layout (row vectors, translation in row 3), 64 byte
+    /// aligned so it can be handed to the instance buffer as is
+    //----------------------------------------------------------------------------------------------------------------------
+    const float * transforms() const { return section<float>(TRANSFORMS); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief index of the named mesh or -1
+    //----------------------------------------------------------------------------------------------------------------------
+    int findMesh(const std::string &_name) const;
+
+  private :
+    struct SectionEntry
+    {
+      uint64_t m_offset;
+      uint64_t m_count;
+    };
+    struct Header
+    {
+      char m_magic[8];
+      uint32_t m_version;
+      uint32_t m_sectionCount;
+      SectionEntry m_sections[NUM_SECTIONS];
+    };
+    bool validate(size_t _size);
+    size_t count(Section _s) const { return m_header ? m_header->m_sections[_s].m_count : 0; }
+    template<typename T> const T * section(Section _s) const
+    {
+      return m_header ? reinterpret_cast<const T *>(m_image+m_header->m_sections[_s].m_offset) : nullptr;
+    }
+
+    const unsigned char *m_image=nullptr;
+    size_t m_size=0;
+    const Header *m_header=nullptr;
+    /// @brief the mapping of a compiled file, null when the image lives in m_compiled
+    void *m_map=nullptr;
+    StagingBuffer m_compiled;
+    std::string m_error;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SCENEBVH_H__
+#define SCENEBVH_H__
+
+#include "Bounds.h"
+#include "Frustum.h"
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file SceneBVH.h
+/// @brief bounding volume hierarchy over the scene objects used to cull them against the camera frustum
+/// each frame. Nodes live in one flat array and every node covers a contiguous range of the reordered
+/// object list, so a node that is wholly inside the frustum is emitted without visiting its children.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class SceneBVH
+{
+  public :
+    static const uint32_t LEAF_SIZE=4;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief build over the bounds of every object, the object index is the position in _bounds
+    //----------------------------------------------------------------------------------------------------------------------
+    void build(const std::vector<AABB> &_bounds);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief replace _visible with the indices of the objects touching the frustum, in tree order
+    //----------------------------------------------------------------------------------------------------------------------
+    void cull(const Frustum &_frustum, std::vector<uint32_t> &o_visible) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the same query testing every object, kept as a reference for the tree
+    //----------------------------------------------------------------------------------------------------------------------
+    void cullBruteForce(const Frustum &_frustum, std::vector<uint32_t> &o_visible) const;
+    size_t size() const { return m_bounds.size(); }
+    size_t nodeCount() const { return m_nodes.size(); }
+
+  private :
+    struct Node
+    {
+      AABB m_box;
+      /// @brief first object in m_order
+      uint32_t m_first;
+      /// @brief number of objects covered by this node
+      uint32_t m_count;
+      /// @brief index of the right child, the left child follows its parent, 0 for a leaf
+      uint32_t m_right;
+    };
+    uint32_t buildRange(uint32_t _first, uint32_t _count, std::vector<Vec3> &_centres);
+    void emit(const Node &_node, std::vector<uint32_t> &o_visible) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<AABB> m_bounds;
+    std::vector<uint32_t> m_order;
+};
+
+} // end namespace fps
+
+#endif
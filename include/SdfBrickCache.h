@@ -0,0 +1,119 @@
+#ifndef SDFBRICKCACHE_H__
+#define SDFBRICKCACHE_H__
+
+#include "CoreMath.h"
+#include "JobSystem.h"
+#include "SdfScene.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file SdfBrickCache.h
+/// @brief distances of an SdfScene baked into a sparse set of small voxel bricks around its surfaces, so a
+/// query near a surface is a hash lookup and a trilinear blend instead of the whole map(). Bricks are baked
+/// on demand. A query that finds no brick answers from the analytic field and asks for one, and update(),
+/// run between ticks, bakes what was asked for across a JobSystem. Bricks with no surface within the band
+/// are remembered as far and keep using the analytic field. Once the memory budget is reached the least
+/// recently used bricks make room. Which bricks exist only changes in update(), so the answers within a
+/// tick do not depend on how many threads asked.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class SdfBrickCache
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief voxels along each edge of a brick, a brick stores one more sample than that per edge so the
+    /// blend never needs a neighbour
+    //----------------------------------------------------------------------------------------------------------------------
+    static const int BRICK=8;
+    static const int SAMPLES=(BRICK+1)*(BRICK+1)*(BRICK+1);
+
+    struct Settings
+    {
+      /// @brief world size of a voxel, the blend error grows with it around edges and thin parts
+      float m_voxelSize=0.1f;
+      /// @brief bricks are baked where a surface is closer than this, past it the analytic field answers.
+      /// It should cover the largest body radius plus a step of travel so contacts come from bricks
+      float m_band=1.5f;
+      /// @brief memory for baked samples, bricks are evicted least recently used first past it
+      size_t m_budgetBytes=16u<<20;
+      /// @brief bricks baked by one update(), the rest are asked for again by later queries
+      size_t m_maxBakesPerUpdate=256;
+    };
+
+    SdfBrickCache(const SdfScene &_scene, const Settings &_settings);
+    SdfBrickCache(const SdfBrickCache &)=delete;
+    SdfBrickCache & operator=(const SdfBrickCache &)=delete;
+
+    const SdfScene & scene() const { return m_scene; }
+    const Settings & settings() const { return m_settings; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the field at _p from a brick if there is one, safe from several threads but not alongside update()
+    //----------------------------------------------------------------------------------------------------------------------
+    float distance(const Vec3 &_p) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief as SdfScene::distanceAndNormal, where bricks answer the normal is from central differences
+    //----------------------------------------------------------------------------------------------------------------------
+    float distanceAndNormal(const Vec3 &_p, Vec3 &o_normal) const;
+    Vec3 normal(const Vec3 &_p) const;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bake the bricks queries asked for since the last call, making room by eviction if needed
+    /// @param [in] _jobs spreads the baking over its threads, may be null
+    /// @returns the number of bricks baked
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t update(JobSystem *_jobs);
+    void clear();
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bricks holding samples, bricks known to be far from surfaces and the bytes of samples allocated
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t residentBricks() const { return m_slotCount-m_free.size(); }
+    size_t farBricks() const { return m_entries.size()-residentBricks(); }
+    size_t memoryBytes() const { return m_samples.size()*sizeof(float); }
+
+  private :
+    struct Entry
+    {
+      Entry(int32_t _slot, uint32_t _used) : m_slot(_slot), m_used(_used) {}
+      /// @brief brick of samples, -1 for a far brick
+      int32_t m_slot;
+      /// @brief update count at the last query, for the least recently used eviction
+      mutable std::atomic<uint32_t> m_used;
+    };
+    uint64_t key(const Vec3 &_p) const;
+    Vec3 brickOrigin(uint64_t _key) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the entry of _p, or null after asking update() for it
+    //----------------------------------------------------------------------------------------------------------------------
+    const Entry * find(const Vec3 &_p) const;
+    float blend(int32_t _slot, const Vec3 &_origin, const Vec3 &_p) const;
+    void bake(uint64_t _key, int32_t _slot);
+    void evict(size_t _slots, size_t _entries);
+
+    SdfScene m_scene;
+    Settings m_settings;
+    float m_brickSize;
+    float m_invVoxel;
+    float m_invBrick;
+    size_t m_maxSlots;
+    size_t m_maxEntries;
+    std::unordered_map<uint64_t,Entry> m_entries;
+    std::vector<float> m_samples;
+    size_t m_slotCount=0;
+    std::vector<int32_t> m_free;
+    uint32_t m_tick=0;
+    mutable std::mutex m_requestMutex;
+    mutable std::vector<uint64_t> m_requests;
+};
+
+} // end namespace fps
+
+#endif
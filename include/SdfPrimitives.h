@@ -0,0 +1,234 @@
+#ifndef SDFPRIMITIVES_H__
+#define SDFPRIMITIVES_H__
+
+#include "SimdFloat.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file SdfPrimitives.h
+/// @brief the signed distance primitives and CSG operators of shaders/testraymarching.glsl, written once
+/// over the lane type F so the same code evaluates one point as float or a packet as Float4 / Float8.
+/// Names and arguments follow the shader so the two can be read side by side, a change to one should be
+/// made to the other.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+namespace sdf
+{
+
+template <typename F>
+struct Vec2T
+{
+  F m_x;
+  F m_y;
+  Vec2T() {}
+  Vec2T(const F &_x, const F &_y) : m_x(_x), m_y(_y) {}
+};
+
+template <typename F>
+struct Vec3T
+{
+  F m_x;
+  F m_y;
+  F m_z;
+  Vec3T() {}
+  Vec3T(const F &_x, const F &_y, const F &_z) : m_x(_x), m_y(_y), m_z(_z) {}
+  Vec3T operator+(const Vec3T &_v) const { return Vec3T(m_x+_v.m_x,m_y+_v.m_y,m_z+_v.m_z); }
+  Vec3T operator-(const Vec3T &_v) const { return Vec3T(m_x-_v.m_x,m_y-_v.m_y,m_z-_v.m_z); }
+  Vec3T operator*(const F &_s) const { return Vec3T(m_x*_s,m_y*_s,m_z*_s); }
+  Vec3T operator/(const Vec3T &_v) const { return Vec3T(m_x/_v.m_x,m_y/_v.m_y,m_z/_v.m_z); }
+  Vec2T<F> xz() const { return Vec2T<F>(m_x,m_z); }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a distance and the material of the surface it is to, as the vec2 the shader passes around
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F>
+struct Result
+{
+  F m_distance;
+  F m_material;
+  Result() {}
+  Result(const F &_distance, const F &_material) : m_distance(_distance), m_material(_material) {}
+};
+
+template <typename F> inline F dot(const Vec2T<F> &_a, const Vec2T<F> &_b) { return _a.m_x*_b.m_x+_a.m_y*_b.m_y; }
+template <typename F> inline F dot(const Vec3T<F> &_a, const Vec3T<F> &_b)
+{
+  return _a.m_x*_b.m_x+_a.m_y*_b.m_y+_a.m_z*_b.m_z;
+}
+template <typename F> inline F length(const Vec2T<F> &_v) { return vsqrt(dot(_v,_v)); }
+template <typename F> inline F length(const Vec3T<F> &_v) { return vsqrt(dot(_v,_v)); }
+template <typename F> inline Vec2T<F> abs(const Vec2T<F> &_v) { return Vec2T<F>(vabs(_v.m_x),vabs(_v.m_y)); }
+template <typename F> inline Vec3T<F> abs(const Vec3T<F> &_v)
+{
+  return Vec3T<F>(vabs(_v.m_x),vabs(_v.m_y),vabs(_v.m_z));
+}
+template <typename F> inline Vec2T<F> max(const Vec2T<F> &_v, float _s)
+{
+  return Vec2T<F>(vmax(_v.m_x,F(_s)),vmax(_v.m_y,F(_s)));
+}
+template <typename F> inline Vec3T<F> max(const Vec3T<F> &_v, float _s)
+{
+  return Vec3T<F>(vmax(_v.m_x,F(_s)),vmax(_v.m_y,F(_s)),vmax(_v.m_z,F(_s)));
+}
+template <typename F> inline F clamp(const F &_x, float _lo, float _hi) { return vmin(vmax(_x,F(_lo)),F(_hi)); }
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief glsl mod, the result takes the sign of _y
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F> inline F mod(const F &_x, const F &_y) { return _x-_y*vfloor(_x/_y); }
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the exact distance outside and inside of the common two sided primitives
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F> inline F rounded(const F &_d1, const F &_d2)
+{
+  return length(max(Vec2T<F>(_d1,_d2),0.0f))+vmin(vmax(_d1,_d2),F(0.0f));
+}
+
+template <typename F> inline F sdPlane(const Vec3T<F> &_p) { return _p.m_y; }
+
+template <typename F> inline F sdSphere(const Vec3T<F> &_p, float _s) { return length(_p)-F(_s); }
+
+template <typename F> inline F sdBox(const Vec3T<F> &_p, const Vec3T<F> &_b)
+{
+  Vec3T<F> d=abs(_p)-_b;
+  return vmin(vmax(d.m_x,vmax(d.m_y,d.m_z)),F(0.0f))+length(max(d,0.0f));
+}
+
+template <typename F> inline F sdEllipsoid(const Vec3T<F> &_p, const Vec3T<F> &_r)
+{
+  return (length(_p/_r)-F(1.0f))*vmin(vmin(_r.m_x,_r.m_y),_r.m_z);
+}
+
+template <typename F> inline F udRoundBox(const Vec3T<F> &_p, const Vec3T<F> &_b, float _r)
+{
+  return length(max(abs(_p)-_b,0.0f))-F(_r);
+}
+
+template <typename F> inline F sdTorus(const Vec3T<F> &_p, float _tx, float _ty)
+{
+  return length(Vec2T<F>(length(_p.xz())-F(_tx),_p.m_y))-F(_ty);
+}
+
+template <typename F> inline F sdHexPrism(const Vec3T<F> &_p, float _hx, float _hy)
+{
+  Vec3T<F> q=abs(_p);
+  F d1=q.m_z-F(_hy);
+  F d2=vmax(q.m_x*F(0.866025f)+q.m_y*F(0.5f),q.m_y)-F(_hx);
+  return rounded(d1,d2);
+}
+
+template <typename F> inline F sdCapsule(const Vec3T<F> &_p, const Vec3T<F> &_a, const Vec3T<F> &_b, float _r)
+{
+  Vec3T<F> pa=_p-_a;
+  Vec3T<F> ba=_b-_a;
+  F h=clamp(dot(pa,ba)/dot(ba,ba),0.0f,1.0f);
+  return length(pa-ba*h)-F(_r);
+}
+
+template <typename F> inline F sdTriPrism(const Vec3T<F> &_p, float _hx, float _hy)
+{
+  Vec3T<F> q=abs(_p);
+  F d1=q.m_z-F(_hy);
+  F d2=vmax(q.m_x*F(0.866025f)+_p.m_y*F(0.5f),-_p.m_y)-F(_hx*0.5f);
+  return rounded(d1,d2);
+}
+
+template <typename F> inline F sdCylinder(const Vec3T<F> &_p, float _hx, float _hy)
+{
+  Vec2T<F> d=abs(Vec2T<F>(length(_p.xz()),_p.m_y));
+  d=Vec2T<F>(d.m_x-F(_hx),d.m_y-F(_hy));
+  return vmin(vmax(d.m_x,d.m_y),F(0.0f))+length(max(d,0.0f));
+}
+
+template <typename F> inline F sdCone(const Vec3T<F> &_p, float _cx, float _cy, float _cz)
+{
+  Vec2T<F> q(length(_p.xz()),_p.m_y);
+  F d1=-q.m_y-F(_cz);
+  F d2=vmax(dot(q,Vec2T<F>(F(_cx),F(_cy))),q.m_y);
+  return rounded(d1,d2);
+}
+
+template <typename F> inline F sdConeSection(const Vec3T<F> &_p, float _h, float _r1, float _r2)
+{
+  F d1=-_p.m_y-F(_h);
+  F q=_p.m_y-F(_h);
+  float si=0.5f*(_r1-_r2)/_h;
+  F d2=vmax(vsqrt(dot(_p.xz(),_p.xz())*F(1.0f-si*si))+q*F(si)-F(_r2),q);
+  return rounded(d1,d2);
+}
+
+template <typename F> inline F length2(const Vec2T<F> &_p) { return vsqrt(_p.m_x*_p.m_x+_p.m_y*_p.m_y); }
+
+template <typename F> inline F length6(const Vec2T<F> &_p)
+{
+  F x=_p.m_x*_p.m_x*_p.m_x;
+  F y=_p.m_y*_p.m_y*_p.m_y;
+  return vpow(x*x+y*y,F(1.0f/6.0f));
+}
+
+template <typename F> inline F length8(const Vec2T<F> &_p)
+{
+  F x=_p.m_x*_p.m_x;
+  F y=_p.m_y*_p.m_y;
+  x=x*x;
+  y=y*y;
+  // pow(s,1/8) as three square roots, which have an instruction
+  return vsqrt(vsqrt(vsqrt(x*x+y*y)));
+}
+
+template <typename F> inline F sdTorus82(const Vec3T<F> &_p, float _tx, float _ty)
+{
+  Vec2T<F> q(length2(_p.xz())-F(_tx),_p.m_y);
+  return length8(q)-F(_ty);
+}
+
+template <typename F> inline F sdTorus88(const Vec3T<F> &_p, float _tx, float _ty)
+{
+  Vec2T<F> q(length8(_p.xz())-F(_tx),_p.m_y);
+  return length8(q)-F(_ty);
+}
+
+template <typename F> inline F sdCylinder6(const Vec3T<F> &_p, float _hx, float _hy)
+{
+  return vmax(length6(_p.xz())-F(_hx),vabs(_p.m_y)-F(_hy));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief subtraction, _d2 carved out of _d1
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F> inline F opS(const F &_d1, const F &_d2) { return vmax(-_d2,_d1); }
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief union, the nearer surface and its material
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F> inline Result<F> opU(const Result<F> &_d1, const Result<F> &_d2)
+{
+  auto nearer=_d1.m_distance<_d2.m_distance;
+  return Result<F>(select(nearer,_d1.m_distance,_d2.m_distance),select(nearer,_d1.m_material,_d2.m_material));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief infinite repetition with period _c
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F> inline Vec3T<F> opRep(const Vec3T<F> &_p, float _cx, float _cy, float _cz)
+{
+  return Vec3T<F>(mod(_p.m_x,F(_cx))-F(0.5f*_cx),mod(_p.m_y,F(_cy))-F(0.5f*_cy),mod(_p.m_z,F(_cz))-F(0.5f*_cz));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief twist around y, like the shader the result is (m*p.xz,p.y) so y and z swap places
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F> inline Vec3T<F> opTwist(const Vec3T<F> &_p)
+{
+  F a=F(10.0f)*_p.m_y+F(10.0f);
+  F c=vcos(a);
+  F s=vsin(a);
+  // glsl mat2(c,-s,s,c) is column major
+  return Vec3T<F>(c*_p.m_x+s*_p.m_z,c*_p.m_z-s*_p.m_x,_p.m_y);
+}
+
+} // end namespace sdf
+} // end namespace fps
+
+#endif
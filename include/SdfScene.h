@@ -0,0 +1,78 @@
+#ifndef SDFSCENE_H__
+#define SDFSCENE_H__
+
+#include "CoreMath.h"
+#include "SdfPrimitives.h"
+#include <cstddef>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file SdfScene.h
+/// @brief the map() of shaders/testraymarching.glsl on the CPU, so the camera can collide with the same
+/// geometry the raymarcher draws. The shader's scene is about four units across with its floor at y=0, here
+/// it is placed in the world by an origin and a uniform scale. Points can be evaluated one at a time or in
+/// batches that run four (SSE) or eight (AVX) points through every primitive at once.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class SdfScene
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief points per batch of the widest lanes this build has
+    //----------------------------------------------------------------------------------------------------------------------
+    static const size_t WIDTH=FloatWide::WIDTH;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief offset of the gradient samples in shader units, the shader's calcNormal uses the same
+    //----------------------------------------------------------------------------------------------------------------------
+    static const float NORMAL_EPSILON;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @param [in] _origin where the shader's origin sits in the world
+    /// @param [in] _scale world units per shader unit
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit SdfScene(const Vec3 &_origin=Vec3(0.0f,0.0f,0.0f), float _scale=1.0f);
+    void setPlacement(const Vec3 &_origin, float _scale);
+    const Vec3 & origin() const { return m_origin; }
+    float scale() const { return m_scale; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the shader's map() in its own units, one template for float, Float4 and Float8
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename F>
+    static sdf::Result<F> mapLocal(const sdf::Vec3T<F> &_p);
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief world space distance to the nearest surface, negative inside, and the shader's material id
+    //----------------------------------------------------------------------------------------------------------------------
+    sdf::Result<float> map(const Vec3 &_p) const;
+    float distance(const Vec3 &_p) const { return map(_p).m_distance; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief _count world space points as separate x, y and z arrays, WIDTH at a time
+    /// @param [out] o_material may be null when only the distances are wanted
+    //----------------------------------------------------------------------------------------------------------------------
+    void map(const float *_x, const float *_y, const float *_z, size_t _count, float *o_distance, float *o_material) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the same one point at a time, the reference for the batches
+    //----------------------------------------------------------------------------------------------------------------------
+    void mapScalar(const float *_x, const float *_y, const float *_z, size_t _count,
+                   float *o_distance, float *o_material) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief unit surface normal from the gradient, sampled at the four corners of a tetrahedron which
+    /// go through the primitives together as one Float4
+    //----------------------------------------------------------------------------------------------------------------------
+    Vec3 normal(const Vec3 &_p) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief distance and normal from the same four samples, their mean is the distance at _p to second order
+    //----------------------------------------------------------------------------------------------------------------------
+    float distanceAndNormal(const Vec3 &_p, Vec3 &o_normal) const;
+
+  private :
+    Vec3 m_origin;
+    float m_scale;
+    float m_invScale;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,327 @@
+#ifndef SIMDFLOAT_H__
+#define SIMDFLOAT_H__
+
+#include <cmath>
+#include <cstddef>
+#if defined(__AVX__)
+  #include <immintrin.h>
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file SimdFloat.h
+/// @brief float lanes with ordinary operators so a kernel can be written once as a template and run on a
+/// float, four lanes (SSE) or eight lanes (AVX). Comparisons give a mask that select() uses in place of the
+/// ?: of scalar code, and andNot() drops lanes from a mask where a scalar loop would break. Builds without
+/// the instruction set get the same types as plain arrays. sin, cos, atan2, exp and pow have no SIMD
+/// instruction and go lane by lane through std::.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the scalar versions, so templates can call the same names on float
+//----------------------------------------------------------------------------------------------------------------------
+inline float select(bool _mask, float _a, float _b) { return _mask ? _a : _b; }
+inline float vmin(float _a, float _b) { return _a<_b ? _a : _b; }
+inline float vmax(float _a, float _b) { return _a>_b ? _a : _b; }
+inline float vabs(float _a) { return std::fabs(_a); }
+inline float vsqrt(float _a) { return std::sqrt(_a); }
+inline float vfloor(float _a) { return std::floor(_a); }
+inline float vsin(float _a) { return std::sin(_a); }
+inline float vcos(float _a) { return std::cos(_a); }
+inline float vatan2(float _y, float _x) { return std::atan2(_y,_x); }
+inline float vpow(float _a, float _b) { return std::pow(_a,_b); }
+inline float vexp(float _a) { return std::exp(_a); }
+inline bool andNot(bool _a, bool _b) { return _a && !_b; }
+inline int countLanes(bool _mask) { return _mask ? 1 : 0; }
+inline bool any(bool _mask) { return _mask; }
+inline bool all(bool _mask) { return _mask; }
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief N lanes as a plain array, the fallback when the instruction set is missing. The operators are
+/// friends so a float converts to lanes on either side, as it does for the register types
+//----------------------------------------------------------------------------------------------------------------------
+template <size_t N>
+struct FloatArray
+{
+  static const size_t WIDTH=N;
+  struct Mask
+  {
+    bool m_v[N];
+    friend Mask operator|(const Mask &_a, const Mask &_b)
+    {
+      Mask r;
+      for(size_t i=0; i<N; ++i) r.m_v[i]=_a.m_v[i] || _b.m_v[i];
+      return r;
+    }
+    friend bool any(const Mask &_mask)
+    {
+      for(size_t i=0; i<N; ++i) if(_mask.m_v[i]) return true;
+      return false;
+    }
+    friend Mask andNot(const Mask &_a, const Mask &_b)
+    {
+      Mask r;
+      for(size_t i=0; i<N; ++i) r.m_v[i]=_a.m_v[i] && !_b.m_v[i];
+      return r;
+    }
+    friend int countLanes(const Mask &_mask)
+    {
+      int n=0;
+      for(size_t i=0; i<N; ++i) n+=_mask.m_v[i] ? 1 : 0;
+      return n;
+    }
+    friend bool all(const Mask &_mask)
+    {
+      for(size_t i=0; i<N; ++i) if(!_mask.m_v[i]) return false;
+      return true;
+    }
+  };
+  float m_v[N];
+
+  FloatArray() {}
+  FloatArray(float _s) { for(size_t i=0; i<N; ++i) m_v[i]=_s; }
+  static FloatArray load(const float *_p) { FloatArray r; for(size_t i=0; i<N; ++i) r.m_v[i]=_p[i]; return r; }
+  void store(float *o_p) const { for(size_t i=0; i<N; ++i) o_p[i]=m_v[i]; }
+  float operator[](size_t _i) const { return m_v[_i]; }
+
+  template <typename Fn> static FloatArray lanewise(const FloatArray &_a, const FloatArray &_b, Fn _fn)
+  {
+    FloatArray r;
+    for(size_t i=0; i<N; ++i) r.m_v[i]=_fn(_a.m_v[i],_b.m_v[i]);
+    return r;
+  }
+  template <typename Fn> static Mask compare(const FloatArray &_a, const FloatArray &_b, Fn _fn)
+  {
+    Mask r;
+    for(size_t i=0; i<N; ++i) r.m_v[i]=_fn(_a.m_v[i],_b.m_v[i]);
+    return r;
+  }
+
+  friend FloatArray operator+(const FloatArray &_a, const FloatArray &_b)
+  {
+    return lanewise(_a,_b,[](float _x, float _y) { return _x+_y; });
+  }
+  friend FloatArray operator-(const FloatArray &_a, const FloatArray &_b)
+  {
+    return lanewise(_a,_b,[](float _x, float _y) { return _x-_y; });
+  }
+  friend FloatArray operator*(const FloatArray &_a, const FloatArray &_b)
+  {
+    return lanewise(_a,_b,[](float _x, float _y) { return _x*_y; });
+  }
+  friend FloatArray operator/(const FloatArray &_a, const FloatArray &_b)
+  {
+    return lanewise(_a,_b,[](float _x, float _y) { return _x/_y; });
+  }
+  friend FloatArray operator-(const FloatArray &_a) { return FloatArray(0.0f)-_a; }
+  friend Mask operator<(const FloatArray &_a, const FloatArray &_b)
+  {
+    return compare(_a,_b,[](float _x, float _y) { return _x<_y; });
+  }
+  friend Mask operator>(const FloatArray &_a, const FloatArray &_b) { return _b<_a; }
+  friend FloatArray select(const Mask &_mask, const FloatArray &_a, const FloatArray &_b)
+  {
+    FloatArray r;
+    for(size_t i=0; i<N; ++i) r.m_v[i]=_mask.m_v[i] ? _a.m_v[i] : _b.m_v[i];
+    return r;
+  }
+  friend FloatArray vmin(const FloatArray &_a, const FloatArray &_b)
+  {
+    return lanewise(_a,_b,[](float _x, float _y) { return _x<_y ? _x : _y; });
+  }
+  friend FloatArray vmax(const FloatArray &_a, const FloatArray &_b)
+  {
+    return lanewise(_a,_b,[](float _x, float _y) { return _x>_y ? _x : _y; });
+  }
+  friend FloatArray vexp(const FloatArray &_a) { return lanewise(_a,_a,[](float _x, float) { return std::exp(_x); }); }
+  friend FloatArray vpow(const FloatArray &_a, const FloatArray &_b)
+  {
+    return lanewise(_a,_b,[](float _x, float _y) { return std::pow(_x,_y); });
+  }
+  friend FloatArray vatan2(const FloatArray &_y, const FloatArray &_x)
+  {
+    return lanewise(_y,_x,[](float _a, float _b) { return std::atan2(_a,_b); });
+  }
+  friend FloatArray vabs(const FloatArray &_a) { return lanewise(_a,_a,[](float _x, float) { return std::fabs(_x); }); }
+  friend FloatArray vsqrt(const FloatArray &_a) { return lanewise(_a,_a,[](float _x, float) { return std::sqrt(_x); }); }
+  friend FloatArray vfloor(const FloatArray &_a) { return lanewise(_a,_a,[](float _x, float) { return std::floor(_x); }); }
+  friend FloatArray vsin(const FloatArray &_a) { return lanewise(_a,_a,[](float _x, float) { return std::sin(_x); }); }
+  friend FloatArray vcos(const FloatArray &_a) { return lanewise(_a,_a,[](float _x, float) { return std::cos(_x); }); }
+};
+
+#if defined(__SSE2__)
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief four lanes in an SSE register
+//----------------------------------------------------------------------------------------------------------------------
+struct Float4
+{
+  static const size_t WIDTH=4;
+  struct Mask
+  {
+    __m128 m_v;
+  };
+  __m128 m_v;
+
+  Float4() {}
+  Float4(float _s) : m_v(_mm_set1_ps(_s)) {}
+  explicit Float4(__m128 _v) : m_v(_v) {}
+  static Float4 load(const float *_p) { return Float4(_mm_loadu_ps(_p)); }
+  void store(float *o_p) const { _mm_storeu_ps(o_p,m_v); }
+  float operator[](size_t _i) const { alignas(16) float v[4]; _mm_store_ps(v,m_v); return v[_i]; }
+};
+
+inline Float4 operator+(const Float4 &_a, const Float4 &_b) { return Float4(_mm_add_ps(_a.m_v,_b.m_v)); }
+inline Float4 operator-(const Float4 &_a, const Float4 &_b) { return Float4(_mm_sub_ps(_a.m_v,_b.m_v)); }
+inline Float4 operator*(const Float4 &_a, const Float4 &_b) { return Float4(_mm_mul_ps(_a.m_v,_b.m_v)); }
+inline Float4 operator/(const Float4 &_a, const Float4 &_b) { return Float4(_mm_div_ps(_a.m_v,_b.m_v)); }
+inline Float4 operator-(const Float4 &_a) { return Float4(_mm_xor_ps(_a.m_v,_mm_set1_ps(-0.0f))); }
+inline Float4::Mask operator<(const Float4 &_a, const Float4 &_b) { return Float4::Mask{_mm_cmplt_ps(_a.m_v,_b.m_v)}; }
+inline Float4::Mask operator>(const Float4 &_a, const Float4 &_b) { return Float4::Mask{_mm_cmpgt_ps(_a.m_v,_b.m_v)}; }
+inline Float4::Mask operator|(const Float4::Mask &_a, const Float4::Mask &_b)
+{
+  return Float4::Mask{_mm_or_ps(_a.m_v,_b.m_v)};
+}
+inline Float4 select(const Float4::Mask &_mask, const Float4 &_a, const Float4 &_b)
+{
+  return Float4(_mm_or_ps(_mm_and_ps(_mask.m_v,_a.m_v),_mm_andnot_ps(_mask.m_v,_b.m_v)));
+}
+inline Float4::Mask andNot(const Float4::Mask &_a, const Float4::Mask &_b)
+{
+  return Float4::Mask{_mm_andnot_ps(_b.m_v,_a.m_v)};
+}
+inline int countLanes(const Float4::Mask &_mask) { return __builtin_popcount(_mm_movemask_ps(_mask.m_v)); }
+inline bool any(const Float4::Mask &_mask) { return _mm_movemask_ps(_mask.m_v)!=0; }
+inline bool all(const Float4::Mask &_mask) { return _mm_movemask_ps(_mask.m_v)==0xf; }
+inline Float4 vmin(const Float4 &_a, const Float4 &_b) { return Float4(_mm_min_ps(_a.m_v,_b.m_v)); }
+inline Float4 vmax(const Float4 &_a, const Float4 &_b) { return Float4(_mm_max_ps(_a.m_v,_b.m_v)); }
+inline Float4 vabs(const Float4 &_a) { return Float4(_mm_andnot_ps(_mm_set1_ps(-0.0f),_a.m_v)); }
+inline Float4 vsqrt(const Float4 &_a) { return Float4(_mm_sqrt_ps(_a.m_v)); }
+inline Float4 vfloor(const Float4 &_a)
+{
+  // SSE2 has no round instruction, truncate and step down where that went up (negative non integers)
+  __m128 t=_mm_cvtepi32_ps(_mm_cvttps_epi32(_a.m_v));
+  __m128 up=_mm_and_ps(_mm_cmpgt_ps(t,_a.m_v),_mm_set1_ps(1.0f));
+  return Float4(_mm_sub_ps(t,up));
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief lane by lane through a scalar function, for the few calls with no instruction
+//----------------------------------------------------------------------------------------------------------------------
+template <typename Fn>
+inline Float4 lanewise(const Float4 &_a, const Float4 &_b, Fn _fn)
+{
+  alignas(16) float a[4];
+  alignas(16) float b[4];
+  _mm_store_ps(a,_a.m_v);
+  _mm_store_ps(b,_b.m_v);
+  for(int i=0; i<4; ++i) a[i]=_fn(a[i],b[i]);
+  return Float4(_mm_load_ps(a));
+}
+inline Float4 vsin(const Float4 &_a) { return lanewise(_a,_a,[](float _x, float) { return std::sin(_x); }); }
+inline Float4 vcos(const Float4 &_a) { return lanewise(_a,_a,[](float _x, float) { return std::cos(_x); }); }
+inline Float4 vatan2(const Float4 &_y, const Float4 &_x)
+{
+  return lanewise(_y,_x,[](float _a, float _b) { return std::atan2(_a,_b); });
+}
+inline Float4 vexp(const Float4 &_a) { return lanewise(_a,_a,[](float _x, float) { return std::exp(_x); }); }
+inline Float4 vpow(const Float4 &_a, const Float4 &_b)
+{
+  return lanewise(_a,_b,[](float _x, float _y) { return std::pow(_x,_y); });
+}
+#else
+typedef FloatArray<4> Float4;
+#endif
+
+#if defined(__AVX__)
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief eight lanes in an AVX register
+//----------------------------------------------------------------------------------------------------------------------
+struct Float8
+{
+  static const size_t WIDTH=8;
+  struct Mask
+  {
+    __m256 m_v;
+  };
+  __m256 m_v;
+
+  Float8() {}
+  Float8(float _s) : m_v(_mm256_set1_ps(_s)) {}
+  explicit Float8(__m256 _v) : m_v(_v) {}
+  static Float8 load(const float *_p) { return Float8(_mm256_loadu_ps(_p)); }
+  void store(float *o_p) const { _mm256_storeu_ps(o_p,m_v); }
+  float operator[](size_t _i) const { alignas(32) float v[8]; _mm256_store_ps(v,m_v); return v[_i]; }
+};
+
+inline Float8 operator+(const Float8 &_a, const Float8 &_b) { return Float8(_mm256_add_ps(_a.m_v,_b.m_v)); }
+inline Float8 operator-(const Float8 &_a, const Float8 &_b) { return Float8(_mm256_sub_ps(_a.m_v,_b.m_v)); }
+inline Float8 operator*(const Float8 &_a, const Float8 &_b) { return Float8(_mm256_mul_ps(_a.m_v,_b.m_v)); }
+inline Float8 operator/(const Float8 &_a, const Float8 &_b) { return Float8(_mm256_div_ps(_a.m_v,_b.m_v)); }
+inline Float8 operator-(const Float8 &_a) { return Float8(_mm256_xor_ps(_a.m_v,_mm256_set1_ps(-0.0f))); }
+inline Float8::Mask operator<(const Float8 &_a, const Float8 &_b)
+{
+  return Float8::Mask{_mm256_cmp_ps(_a.m_v,_b.m_v,_CMP_LT_OQ)};
+}
+inline Float8::Mask operator>(const Float8 &_a, const Float8 &_b)
+{
+  return Float8::Mask{_mm256_cmp_ps(_a.m_v,_b.m_v,_CMP_GT_OQ)};
+}
+inline Float8::Mask operator|(const Float8::Mask &_a, const Float8::Mask &_b)
+{
+  return Float8::Mask{_mm256_or_ps(_a.m_v,_b.m_v)};
+}
+inline Float8 select(const Float8::Mask &_mask, const Float8 &_a, const Float8 &_b)
+{
+  return Float8(_mm256_blendv_ps(_b.m_v,_a.m_v,_mask.m_v));
+}
+inline Float8::Mask andNot(const Float8::Mask &_a, const Float8::Mask &_b)
+{
+  return Float8::Mask{_mm256_andnot_ps(_b.m_v,_a.m_v)};
+}
+inline int countLanes(const Float8::Mask &_mask) { return __builtin_popcount(_mm256_movemask_ps(_mask.m_v)); }
+inline bool any(const Float8::Mask &_mask) { return _mm256_movemask_ps(_mask.m_v)!=0; }
+inline bool all(const Float8::Mask &_mask) { return _mm256_movemask_ps(_mask.m_v)==0xff; }
+inline Float8 vmin(const Float8 &_a, const Float8 &_b) { return Float8(_mm256_min_ps(_a.m_v,_b.m_v)); }
+inline Float8 vmax(const Float8 &_a, const Float8 &_b) { return Float8(_mm256_max_ps(_a.m_v,_b.m_v)); }
+inline Float8 vabs(const Float8 &_a) { return Float8(_mm256_andnot_ps(_mm256_set1_ps(-0.0f),_a.m_v)); }
+inline Float8 vsqrt(const Float8 &_a) { return Float8(_mm256_sqrt_ps(_a.m_v)); }
+inline Float8 vfloor(const Float8 &_a) { return Float8(_mm256_floor_ps(_a.m_v)); }
+template <typename Fn>
+inline Float8 lanewise(const Float8 &_a, const Float8 &_b, Fn _fn)
+{
+  alignas(32) float a[8];
+  alignas(32) float b[8];
+  _mm256_store_ps(a,_a.m_v);
+  _mm256_store_ps(b,_b.m_v);
+  for(int i=0; i<8; ++i) a[i]=_fn(a[i],b[i]);
+  return Float8(_mm256_load_ps(a));
+}
+inline Float8 vsin(const Float8 &_a) { return lanewise(_a,_a,[](float _x, float) { return std::sin(_x); }); }
+inline Float8 vcos(const Float8 &_a) { return lanewise(_a,_a,[](float _x, float) { return std::cos(_x); }); }
+inline Float8 vatan2(const Float8 &_y, const Float8 &_x)
+{
+  return lanewise(_y,_x,[](float _a, float _b) { return std::atan2(_a,_b); });
+}
+inline Float8 vexp(const Float8 &_a) { return lanewise(_a,_a,[](float _x, float) { return std::exp(_x); }); }
+inline Float8 vpow(const Float8 &_a, const Float8 &_b)
+{
+  return lanewise(_a,_b,[](float _x, float _y) { return std::pow(_x,_y); });
+}
+#else
+typedef FloatArray<8> Float8;
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the widest lanes the build has, what batch kernels should be instantiated for
+//----------------------------------------------------------------------------------------------------------------------
+#if defined(__AVX__)
+typedef Float8 FloatWide;
+#else
+typedef Float4 FloatWide;
+#endif
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef SIMULATION_H__
+#define SIMULATION_H__
+
+#include "CameraController.h"
+#include "CollisionWorld.h"
+#include "FixedTimestep.h"
+#include "FrameSnapshot.h"
+#include "InputRecording.h"
+#include "InputSystem.h"
+#include "JobSystem.h"
+#include "RigidBodies.h"
+#include "Scene.h"
+#include "SceneBVH.h"
+#include "SpscQueue.h"
+#include "TransformSystem.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Simulation.h
+/// @brief the camera, debris and scene culling run on their own thread at the fixed step rate. Key and
+/// mouse samples and other commands arrive through lock free queues, and after each tick that changed something the
+/// simulation writes an immutable FrameSnapshot (camera matrices and the visible instance lists) into a
+/// triple buffer for the render thread. A slow frame never holds up a tick and a slow tick never holds up
+/// a frame, the renderer just draws the newest snapshot it has. The same tick can be run on the calling
+/// thread with advance() when nothing else is drawing, for headless runs. The input of every tick can be
+/// recorded and played back in place of live input, so two runs follow exactly the same camera path.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class Simulation
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief requests for the simulation that are not key or mouse input, applied at the start of the next
+    /// tick in the order posted. Held movement only comes through input() so nothing else can fight it
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Command
+    {
+      enum Type
+      {
+        LOOK=0,       //!< turn by m_x degrees of pitch and m_y degrees of yaw
+        VIEWPORT,     //!< the window is now m_x by m_y pixels
+        SPAWN_DEBRIS  //!< throw a block of debris the way the camera is looking
+      };
+      Type m_type;
+      float m_x;
+      float m_y;
+
+      static Command look(float _pitch, float _yaw) { return Command{LOOK,_pitch,_yaw}; }
+      static Command viewport(int _width, int _height)
+      {
+        return Command{VIEWPORT,static_cast<float>(_width),static_cast<float>(_height)};
+      }
+      static Command spawnDebris() { return Command{SPAWN_DEBRIS,0.0f,0.0f}; }
+    };
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor
+    /// @param [in] _dt the fixed step size in seconds
+    /// @param [in] _maxSteps upper bound on steps per tick, the backlog is dropped past this
+    //----------------------------------------------------------------------------------------------------------------------
+    Simulation(double _dt, int _maxSteps);
+    ~Simulation();
+    Simulation(const Simulation &)=delete;
+    Simulation & operator=(const Simulation &)=delete;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the simulated state, only to be set up or read while the thread is stopped
+    //----------------------------------------------------------------------------------------------------------------------
+    CameraController & controller() { return m_controller; }
+    RigidBodies & debris() { return m_debris; }
+    TransformSystem & transforms() { return m_transforms; }
+    SceneBVH & sceneBVH() { return m_sceneBVH; }
+    CollisionWorld & collisionWorld() { return m_collisionWorld; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the instanced batch of each scene object, -1 for objects drawn one by one
+    //----------------------------------------------------------------------------------------------------------------------
+    void setObjectBatches(const std::vector<int> &_objectBatch, size_t _batchCount);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief place the scene's objects, build their culling tree and collision world and clear the debris.
+    /// The scene must outlive the simulation's use of it, mesh colliders point into its vertices
+    //----------------------------------------------------------------------------------------------------------------------
+    void setScene(const Scene &_scene);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief called on the simulation thread after each publish, e.g. to ask the window for a repaint
+    //----------------------------------------------------------------------------------------------------------------------
+    void setPublishCallback(const std::function<void()> &_callback) { m_onPublish=_callback; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief run ticks on a dedicated thread until stop(), the first snapshot is published straight away
+    //----------------------------------------------------------------------------------------------------------------------
+    void start();
+    void stop();
+    bool running() const { return m_thread.joinable(); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief run one tick covering _seconds of real time on the calling thread, only while stopped
+    /// @returns the number of fixed steps taken
+    //----------------------------------------------------------------------------------------------------------------------
+    int advance(double _seconds);
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief append every tick's input to _recording from the current camera state on, null to stop. Only
+    /// while stopped, and _recording is only to be read once stopped again
+    //----------------------------------------------------------------------------------------------------------------------
+    void record(InputRecording *_recording);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief put the camera where _recording began, clear the debris, which is not recorded, and take its
+    /// ticks in place of live input until it ends, only while stopped. In real time a tick waits until its
+    /// steps are due. Otherwise every tick is taken as soon as the last snapshot has been acquired, so each
+    /// one is drawn once as fast as the renderer goes, and advance() takes the next tick on every call
+    /// whatever _seconds says
+    /// @returns false if the recording was stepped at a different rate and cannot follow the same path
+    //----------------------------------------------------------------------------------------------------------------------
+    bool replay(InputRecording *_recording, bool _realTime);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true until the last recorded tick has been taken, from any thread
+    //----------------------------------------------------------------------------------------------------------------------
+    bool replaying() const { return m_replaying.load(std::memory_order_acquire); }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief input side, one thread only
+    /// @returns false if the queue is full and the command was dropped
+    //----------------------------------------------------------------------------------------------------------------------
+    bool post(const Command &_command) { return m_commands.tryPush(_command); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief raw key and mouse samples, pushed from the same thread as post(). Each tick takes the samples
+    /// stamped before it began and turns the camera once by their summed motion
+    //----------------------------------------------------------------------------------------------------------------------
+    InputSystem & input() { return m_input; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief render side, one thread only, take the newest published snapshot
+    /// @returns false if nothing new was published, snapshot() is the one from before
+    //----------------------------------------------------------------------------------------------------------------------
+    bool acquire() { return m_snapshots.acquire(); }
+    const FrameSnapshot & snapshot() const { return m_snapshots.front(); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief seconds on the clock the snapshot times use, for interpolating between ticks
+    //----------------------------------------------------------------------------------------------------------------------
+    static double now();
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief vertical field of view in degrees and clip planes of the projection
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_fov=45.0f;
+    float m_near=0.5f;
+    float m_far=200.0f;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief size and launch speed of the spawned debris
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_debrisRadius=0.25f;
+    float m_debrisSpeed=10.0f;
+
+  private :
+    void run();
+    void apply(const Command &_command);
+    void apply(const InputState &_input);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief apply the tick's input, live or recorded
+    /// @returns the number of fixed steps to take
+    //----------------------------------------------------------------------------------------------------------------------
+    int liveInput(double _seconds, double _begin);
+    int replayInput(double _seconds, double _begin);
+    void spawnDebris();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief fill the back snapshot from the current state and publish it
+    //----------------------------------------------------------------------------------------------------------------------
+    void publish(float _simMs);
+
+    CameraController m_controller;
+    CollisionWorld m_collisionWorld;
+    TransformSystem m_transforms;
+    SceneBVH m_sceneBVH;
+    JobSystem m_jobs;
+    RigidBodies m_debris;
+    FixedTimestep m_timestep;
+    std::vector<int> m_objectBatch;
+    size_t m_batchCount=0;
+    std::vector<uint32_t> m_visible;
+    float m_aspect=1.0f;
+    uint64_t m_tick=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set by commands that change the picture without moving anything, cleared by publish
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_dirty=true;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief debris awake at the last publish, one more snapshot goes out once they have all settled
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_publishedAwake=0;
+    SpscQueue<Command> m_commands;
+    InputSystem m_input;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief jump was active last tick, so a release can be told from not pressing
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_jumpHeld=false;
+    InputRecording *m_recording=nullptr;
+    InputRecording *m_replay=nullptr;
+    bool m_replayRealTime=false;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the recorded tick that is being built or waits for its steps to be due
+    //----------------------------------------------------------------------------------------------------------------------
+    InputRecording::Tick m_recordedTick;
+    bool m_tickPending=false;
+    int m_replaySteps=0;
+    std::atomic<bool> m_replaying;
+    TripleBuffer<FrameSnapshot> m_snapshots;
+    std::function<void()> m_onPublish;
+    std::thread m_thread;
+    std::atomic<bool> m_quit;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef SPSCQUEUE_H__
+#define SPSCQUEUE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file SpscQueue.h
+/// @brief bounded lock free single producer / single consumer ring. Exactly one thread may push and exactly
+/// one (possibly different) thread may pop, neither ever blocks.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+template <typename T>
+class SpscQueue
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor
+    /// @param [in] _capacity rounded up to a power of two
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit SpscQueue(size_t _capacity) : m_head(0), m_tail(0)
+    {
+      size_t size=1;
+      while(size<_capacity)
+      {
+        size<<=1;
+      }
+      m_slots.resize(size);
+      m_mask=size-1;
+    }
+    SpscQueue(const SpscQueue &)=delete;
+    SpscQueue & operator=(const SpscQueue &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief producer side
+    /// @returns false if the queue is full
+    //----------------------------------------------------------------------------------------------------------------------
+    bool tryPush(const T &_value)
+    {
+      size_t head=m_head.load(std::memory_order_relaxed);
+      if(head-m_tail.load(std::memory_order_acquire)>m_mask)
+      {
+        return false;
+      }
+      m_slots[head&m_mask]=_value;
+      m_head.store(head+1,std::memory_order_release);
+      return true;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief producer side, reserve a slot to fill in place, commit() publishes it. Avoids a copy for big T
+    /// @returns nullptr if the queue is full
+    //----------------------------------------------------------------------------------------------------------------------
+    T * prepare()
+    {
+      size_t head=m_head.load(std::memory_order_relaxed);
+      if(head-m_tail.load(std::memory_order_acquire)>m_mask)
+      {
+        return nullptr;
+      }
+      return &m_slots[head&m_mask];
+    }
+    void commit()
+    {
+      m_head.store(m_head.load(std::memory_order_relaxed)+1,std::memory_order_release);
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief consumer side
+    /// @returns false if the queue is empty
+    //----------------------------------------------------------------------------------------------------------------------
+    bool tryPop(T &_value)
+    {
+      T *front=peek();
+      if(front==nullptr)
+      {
+        return false;
+      }
+      _value=*front;
+      pop();
+      return true;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief consumer side, look at the oldest element without copying it, pop() releases the slot
+    //----------------------------------------------------------------------------------------------------------------------
+    T * peek()
+    {
+      size_t tail=m_tail.load(std::memory_order_relaxed);
+      if(tail==m_head.load(std::memory_order_acquire))
+      {
+        return nullptr;
+      }
+      return &m_slots[tail&m_mask];
+    }
+    void pop()
+    {
+      m_tail.store(m_tail.load(std::memory_order_relaxed)+1,std::memory_order_release);
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief approximate when called from a thread that is neither producer nor consumer
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t size() const { return m_head.load(std::memory_order_acquire)-m_tail.load(std::memory_order_acquire); }
+    size_t capacity() const { return m_mask+1; }
+    bool empty() const { return size()==0; }
+
+  private :
+    std::vector<T> m_slots;
+    size_t m_mask;
+    // producer and consumer indices a cache line apart so they don't false share, padding rather than
+    // alignas so the queue can still be heap allocated with C++11 operator new
+    char m_padBefore[64];
+    std::atomic<size_t> m_head;
+    char m_padBetween[64];
+    std::atomic<size_t> m_tail;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef STAGINGPOOL_H__
+#define STAGINGPOOL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file StagingPool.h
+/// @brief CPU side staging memory for framebuffer captures. A StagingBuffer only ever grows (geometrically)
+/// so resizing the window back and forth reuses the same allocation, and StagingPool hands out buffers that
+/// return themselves to the pool when released. Nothing is allocated until a capture actually asks for it.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class StagingBuffer
+{
+  public :
+    StagingBuffer()=default;
+    ~StagingBuffer();
+    StagingBuffer(const StagingBuffer &)=delete;
+    StagingBuffer & operator=(const StagingBuffer &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the used size, the memory is only reallocated if this is beyond the capacity. Existing
+    /// contents are not preserved across a reallocation and new memory is not cleared.
+    //----------------------------------------------------------------------------------------------------------------------
+    void resize(size_t _size);
+    unsigned char * data() { return m_data; }
+    const unsigned char * data() const { return m_data; }
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief total number of (re)allocations made by all buffers, for checking reuse
+    //----------------------------------------------------------------------------------------------------------------------
+    static uint64_t allocations();
+
+  private :
+    unsigned char *m_data=nullptr;
+    size_t m_size=0;
+    size_t m_capacity=0;
+};
+
+class StagingPool
+{
+  public :
+    struct Releaser
+    {
+      StagingPool *pool;
+      void operator()(StagingBuffer *_buffer) const { pool->release(_buffer); }
+    };
+    typedef std::unique_ptr<StagingBuffer,Releaser> Handle;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor
+    /// @param [in] _maxFree how many idle buffers to keep around, extra ones are freed on release
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit StagingPool(size_t _maxFree=4) : m_maxFree(_maxFree) {}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a buffer of at least _size bytes, preferring an idle one that is already big enough.
+    /// Safe to call and release from any thread.
+    //----------------------------------------------------------------------------------------------------------------------
+    Handle acquire(size_t _size);
+    size_t idle() const;
+
+  private :
+    void release(StagingBuffer *_buffer);
+
+    size_t m_maxFree;
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<StagingBuffer>> m_free;
+};
+
+} // end namespace fps
+
+#endif
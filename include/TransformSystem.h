@@ -0,0 +1,86 @@
+#ifndef TRANSFORMSYSTEM_H__
+#define TRANSFORMSYSTEM_H__
+
+#include "CoreMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TransformSystem.h
+/// @brief object transforms stored as structure of arrays (position, rotation quaternion, scale) with a
+/// dirty flag per object. update() rebuilds the model matrices of every dirty object in one pass, four or
+/// eight objects per instruction with SSE / AVX and a scalar loop otherwise, and can produce model view
+/// matrices in the same pass. The matrices use the ngl layout (row vectors, translation in row 3) so
+/// models() can be handed to an instance buffer without conversion.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+class TransformSystem
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief objects handled per SIMD step, the arrays are padded to a multiple of this
+    //----------------------------------------------------------------------------------------------------------------------
+#if defined(__AVX__)
+    static const size_t WIDTH=8;
+#else
+    static const size_t WIDTH=4;
+#endif
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add an object, the rotation is in degrees about x, then y, then z as ngl::Transformation does
+    /// @returns the object index
+    //----------------------------------------------------------------------------------------------------------------------
+    uint32_t add(const Vec3 &_position, const Vec3 &_rotation=Vec3(), const Vec3 &_scale=Vec3(1.0f,1.0f,1.0f));
+    void clear();
+    size_t size() const { return m_size; }
+
+    void setPosition(uint32_t _i, const Vec3 &_position);
+    void setRotation(uint32_t _i, const Vec3 &_degrees);
+    void setScale(uint32_t _i, const Vec3 &_scale);
+    Vec3 position(uint32_t _i) const { return Vec3(m_px[_i],m_py[_i],m_pz[_i]); }
+    void markAllDirty();
+    size_t dirtyCount() const;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief rebuild the model matrix of every dirty object and clear the flags
+    /// @returns the number of objects rebuilt
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t updateModels();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief as updateModels and also modelView=model*view for every object, in the same pass
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t update(const Mat4 &_view);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief scalar versions of the passes, the fallback without SSE and a reference for the SIMD ones
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t updateModelsScalar();
+    size_t updateScalar(const Mat4 &_view);
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief 16 floats per object
+    //----------------------------------------------------------------------------------------------------------------------
+    const float * models() const { return m_models.data(); }
+    const float * modelViews() const { return m_modelViews.data(); }
+    const float * model(uint32_t _i) const { return &m_models[16*_i]; }
+
+  private :
+    size_t pass(const Mat4 *_view, bool _simd);
+    void composeScalar(size_t _i);
+    void modelViewScalar(size_t _i, const Mat4 &_view);
+    void grow();
+
+    size_t m_size=0;
+    std::vector<float> m_px, m_py, m_pz;
+    std::vector<float> m_qx, m_qy, m_qz, m_qw;
+    std::vector<float> m_sx, m_sy, m_sz;
+    std::vector<uint8_t> m_dirty;
+    size_t m_dirtyCount=0;
+    std::vector<float> m_models;
+    std::vector<float> m_modelViews;
+};
+
+} // end namespace fps
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef TRIPLEBUFFER_H__
+#define TRIPLEBUFFER_H__
+
+#include <atomic>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TripleBuffer.h
+/// @brief lock free hand over of the latest value from one writer thread to one reader thread. The writer
+/// fills back() and publishes it, the reader takes the newest published value with acquire(). Neither side
+/// ever waits for the other: the writer always has a slot the reader isn't using, and a value published
+/// again before the reader looked is simply replaced. Slots are reused, so a T holding vectors stops
+/// allocating once they have grown, but the writer must rewrite all of back() as it may be any old value.
+//----------------------------------------------------------------------------------------------------------------------
+namespace fps
+{
+
+template <typename T>
+class TripleBuffer
+{
+  public :
+    TripleBuffer() : m_back(0), m_middle(1), m_front(2) {}
+    TripleBuffer(const TripleBuffer &)=delete;
+    TripleBuffer & operator=(const TripleBuffer &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writer side, the slot to fill
+    //----------------------------------------------------------------------------------------------------------------------
+    T & back() { return m_slots[m_back]; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writer side, make back() the newest value and take the unread or released slot as the new back
+    //----------------------------------------------------------------------------------------------------------------------
+    void publish()
+    {
+      m_back=m_middle.exchange(m_back|FRESH,std::memory_order_acq_rel)&INDEX;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reader side, swap the newest published value into front()
+    /// @returns false if nothing was published since the last acquire, front() is unchanged
+    //----------------------------------------------------------------------------------------------------------------------
+    bool acquire()
+    {
+      if(!fresh())
+      {
+        return false;
+      }
+      m_front=m_middle.exchange(m_front,std::memory_order_acq_rel)&INDEX;
+      return true;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reader side, the value from the last successful acquire
+    //----------------------------------------------------------------------------------------------------------------------
+    const T & front() const { return m_slots[m_front]; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if a value is waiting for acquire, safe from any thread
+    //----------------------------------------------------------------------------------------------------------------------
+    bool fresh() const { return (m_middle.load(std::memory_order_acquire)&FRESH)!=0; }
+
+  private :
+    /// @brief the middle word is a slot index plus a flag set by publish and cleared by acquire
+    enum { INDEX=3, FRESH=4 };
+    T m_slots[3];
+    // writer and reader indices a cache line apart from the shared word, as SpscQueue does
+    unsigned m_back;
+    char m_padBefore[64];
+    std::atomic<unsigned> m_middle;
+    char m_padAfter[64];
+    unsigned m_front;
+};
+
+} // end namespace fps
+
+#endif
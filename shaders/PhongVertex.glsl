@@ -5,10 +5,19 @@ layout (location = 0) in vec3 inVert;
 layout (location = 2) in vec3 inNormal;
 /// @brief the in uv
 layout (location = 1) in vec2 inUV;
+/// @brief per instance model matrix (uses locations 3-6), only read when instanced is set
+layout (location = 3) in mat4 inModel;
 /// @brief flag to indicate if model has unit normals if not normalize
 uniform bool Normalize;
-// the eye position of the camera
-uniform vec3 viewerPos;
+/// @brief per frame camera data, filled once a frame from a uniform buffer shared by every draw
+layout (std140) uniform Camera
+{
+  mat4 V;
+  mat4 P;
+  mat4 VP;
+  // the eye position of the camera (w unused)
+  vec4 eye;
+};
 /// @brief the current fragment normal for the vert being processed
 out  vec3 fragmentNormal;
 
@@ -34,16 +43,20 @@ out vec3 halfVector;
 out vec3 eyeDirection;
 out vec3 vPosition;
 
-uniform mat4 MV;
-uniform mat4 MVP;
-uniform mat3 normalMatrix;
+/// @brief the only per draw matrix, everything else is built here from the Camera block
 uniform mat4 M;
+/// @brief when set the model matrix comes from inModel instead of M
+uniform bool instanced;
 
 
 void main()
 {
+mat4 model = instanced ? inModel : M;
+mat4 modelView=V*model;
+mat4 modelViewProjection=VP*model;
+mat3 normalMat=transpose(inverse(mat3(modelView)));
 // calculate the fragments surface normal
-fragmentNormal = (normalMatrix*inNormal);
+fragmentNormal = (normalMat*inNormal);
 
 
 if (Normalize == true)
@@ -51,14 +64,14 @@ if (Normalize == true)
  fragmentNormal = normalize(fragmentNormal);
 }
 // calculate the vertex position
-gl_Position = MVP*vec4(inVert,1.0);
+gl_Position = modelViewProjection*vec4(inVert,1.0);
 
-vec4 worldPosition = M * vec4(inVert, 1.0);
-eyeDirection = normalize(viewerPos - worldPosition.xyz);
+vec4 worldPosition = model * vec4(inVert, 1.0);
+eyeDirection = normalize(eye.xyz - worldPosition.xyz);
 // Get vertex position in eye coordinates
 // Transform the vertex to eye co-ordinates for frag shader
 /// @brief the vertex in eye co-ordinates  homogeneous
-vec4 eyeCord=MV*vec4(inVert,1);
+vec4 eyeCord=modelView*vec4(inVert,1);
 
 vPosition = eyeCord.xyz / eyeCord.w;;
 
@@ -0,0 +1,12 @@
+#version 410 core
+/// @brief the scaled down raymarched frame stretched over the window, colour filtered and depth nearest
+uniform sampler2D colourMap;
+uniform sampler2D depthMap;
+in vec2 uv;
+layout (location = 0) out vec4 fragColour;
+
+void main()
+{
+  fragColour=texture(colourMap,uv);
+  gl_FragDepth=texture(depthMap,uv).r;
+}
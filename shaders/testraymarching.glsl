@@ -1,14 +1,4 @@
-//uniform sampler2D qt_Texture0;
-//varying highp vec4 qt_TexCoord0;
-
-//void main(void)
-//{
-//    gl_FragColor = texture2D(qt_Texture0, qt_TexCoord0.st);
-//}
-
-
-
-
+#version 410 core
 // Created by inigo quilez - iq/2013
 // License Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License.
 
@@ -18,7 +8,34 @@
 // More info here: http://www.iquilezles.org/www/articles/distfunctions/distfunctions.htm
 
 
-varying out vec4 fragColor;
+// Adapted to run as a fullscreen pass of the FPS camera: the camera, the render size and the march
+// iteration counts are uniforms, the scene is placed in the world by an origin and a scale and the hit
+// writes its depth so rasterized objects can be drawn into the same frame.
+
+/// @brief size of the target being drawn, smaller than the window when the resolution is scaled down
+uniform vec2 resolution;
+/// @brief the FPS camera in world space
+uniform vec3 camEye;
+uniform vec3 camFront;
+uniform vec3 camUp;
+/// @brief where the scene's origin sits in the world and world units per scene unit
+uniform vec3 sceneOrigin;
+uniform float sceneScale;
+/// @brief sphere tracing steps of castRay, soft shadow steps and ambient occlusion samples, 0 turns the
+/// last two off
+uniform int marchSteps;
+uniform int shadowSteps;
+uniform int aoSteps;
+/// @brief per frame camera data shared with the Phong program, P gives the field of view and VP the depth
+layout (std140) uniform Camera
+{
+  mat4 V;
+  mat4 P;
+  mat4 VP;
+  vec4 eye;
+};
+
+layout (location = 0) out vec4 fragColor;
 
 float sdPlane( vec3 p )
 {
@@ -218,7 +235,7 @@ vec2 castRay( in vec3 ro, in vec3 rd )
         float precis = 0.002;
     float t = tmin;
     float m = -1.0;
-    for( int i=0; i<50; i++ )
+    for( int i=0; i<marchSteps; i++ )
     {
             vec2 res = map( ro+rd*t );
         if( res.x<precis || t>tmax ) break;
@@ -235,7 +252,7 @@ float softshadow( in vec3 ro, in vec3 rd, in float mint, in float tmax )
 {
         float res = 1.0;
     float t = mint;
-    for( int i=0; i<16; i++ )
+    for( int i=0; i<shadowSteps; i++ )
     {
                 float h = map( ro + rd*t ).x;
         res = min( res, 8.0*h/t );
@@ -260,7 +277,7 @@ float calcAO( in vec3 pos, in vec3 nor )
 {
         float occ = 0.0;
     float sca = 1.0;
-    for( int i=0; i<5; i++ )
+    for( int i=0; i<aoSteps; i++ )
     {
         float hr = 0.01 + 0.12*float(i)/4.0;
         vec3 aopos =  nor * hr + pos;
@@ -274,12 +291,13 @@ float calcAO( in vec3 pos, in vec3 nor )
 
 
 
-vec3 render( in vec3 ro, in vec3 rd )
+vec3 render( in vec3 ro, in vec3 rd, out float hit )
 {
     vec3 col = vec3(0.8, 0.9, 1.0);
     vec2 res = castRay(ro,rd);
     float t = res.x;
         float m = res.y;
+    hit = m>-0.5 ? t : -1.0;
     if( m>-0.5 )
     {
         vec3 pos = ro + t*rd;
@@ -326,46 +344,33 @@ vec3 render( in vec3 ro, in vec3 rd )
         return vec3( clamp(col,0.0,1.0) );
 }
 
-mat3 setCamera( in vec3 ro, in vec3 ta, float cr )
-{
-        vec3 cw = normalize(ta-ro);
-        vec3 cp = vec3(sin(cr), cos(cr),0.0);
-        vec3 cu = normalize( cross(cw,cp) );
-        vec3 cv = normalize( cross(cu,cw) );
-    return mat3( cu, cv, cw );
-}
-
-vec2 iResolution=vec2(500,500);
-vec3 iMouse=vec3(1,1,1);
-float iGlobalTime;
-
-
-vec2 fragCoord=vec2(0,0);
-
 void main()
 {
-    iGlobalTime++;
-        vec2 q = fragCoord.xy/iResolution.xy;
-    vec2 p = -1.0+2.0*q;
-        p.x *= iResolution.x/iResolution.y;
-    vec2 mo = iMouse.xy/iResolution.xy;
-
-        float time = 15.0 + iGlobalTime;
-
-        // camera
-        vec3 ro = vec3( -0.5+3.5*cos(0.1*time + 6.0*mo.x), 1.0 + 2.0*mo.y, 0.5 + 3.5*sin(0.1*time + 6.0*mo.x) );
-        vec3 ta = vec3( -0.5, -0.4, 0.5 );
+    // the shader's p, -1 to 1 up the target and wider across
+    vec2 p = -1.0+2.0*gl_FragCoord.xy/resolution;
+    p.x *= resolution.x/resolution.y;
 
-        // camera-to-world transformation
-    mat3 ca = setCamera( ro, ta, 0.0 );
+    // the FPS camera's basis, with the focal length of the projection the rest of the frame uses
+    vec3 cw = normalize( camFront );
+    vec3 cu = normalize( cross(cw,camUp) );
+    vec3 cv = cross( cu, cw );
+    vec3 rd = normalize( p.x*cu + p.y*cv + P[1][1]*cw );
 
-    // ray direction
-        vec3 rd = ca * normalize( vec3(p.xy,2.0) );
-
-    // render
-    vec3 col = render( ro, rd );
+    // march in the scene's own units, the direction is the same in both
+    vec3 ro = (camEye-sceneOrigin)/sceneScale;
+    float t;
+    vec3 col = render( ro, rd, t );
 
         col = pow( col, vec3(0.4545) );
 
     fragColor=vec4( col, 1.0 );
+    if( t<0.0 )
+    {
+        gl_FragDepth = 1.0;
+    }
+    else
+    {
+        vec4 clip = VP*vec4( camEye+rd*(t*sceneScale), 1.0 );
+        gl_FragDepth = clamp( 0.5+0.5*clip.z/clip.w, 0.0, 1.0 );
+    }
 }
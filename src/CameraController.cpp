@@ -0,0 +1,223 @@
+#include "CameraController.h"
+#include <algorithm>
+#include <cmath>
+
+namespace fps
+{
+
+const int CameraController::MAX_SUBSTEPS;
+const int CameraController::MAX_SLIDES;
+
+static const float DEG_TO_RAD=static_cast<float>(M_PI/180.0);
+// contacts with a normal this close to up are ground we can stand on
+static const float GROUND_SLOPE=0.7f;
+// gap left between the body and a surface after a contact
+static const float SKIN=1.0e-3f;
+// bounces slower than this come to rest against the surface
+static const float REST_SPEED=0.5f;
+
+bool sphereToPlane(const Vec3 &_centre, const Vec3 &_planePoint, const Vec3 &_planeNormal, float _radius)
+{
+  //Calculate a vector from the point on the plane to the center of the sphere
+  Vec3 vecTemp(_centre-_planePoint);
+  //Calculate the distance: dot product of the new vector with the plane's normal
+  float dist=vecTemp.dot(_planeNormal);
+  // if the distance is greater than the radius the sphere is not touching the plane
+  return dist<=_radius;
+}
+
+CameraController::CameraController()
+{
+  reset(Vec3(0.0f,5.0f,15.0f));
+}
+
+void CameraController::reset(const Vec3 &_pos)
+{
+  m_pos=_pos;
+  m_prevPos=_pos;
+  m_up.set(0.0f,1.0f,0.0f);
+  m_pitch=0.0f;
+  m_yaw=0.0f;
+  updateFront();
+  std::fill(m_actions,m_actions+NUM_ACTIONS,false);
+  m_physics=PhysicsState();
+  m_grounded=false;
+}
+
+CameraController::State CameraController::state() const
+{
+  State s;
+  s.m_position=m_pos;
+  s.m_prevPosition=m_prevPos;
+  s.m_pitch=m_pitch;
+  s.m_yaw=m_yaw;
+  s.m_physics=m_physics;
+  s.m_grounded=m_grounded;
+  std::copy(m_actions,m_actions+NUM_ACTIONS,s.m_actions);
+  return s;
+}
+
+void CameraController::setState(const State &_state)
+{
+  m_pos=_state.m_position;
+  m_prevPos=_state.m_prevPosition;
+  m_pitch=_state.m_pitch;
+  m_yaw=_state.m_yaw;
+  updateFront();
+  m_physics=_state.m_physics;
+  m_grounded=_state.m_grounded;
+  std::copy(_state.m_actions,_state.m_actions+NUM_ACTIONS,m_actions);
+}
+
+void CameraController::setLook(float _pitch, float _yaw)
+{
+  m_pitch=std::max(-89.0f,std::min(89.0f,_pitch));
+  m_yaw=_yaw;
+  updateFront();
+}
+
+void CameraController::updateFront()
+{
+  // this is the forward vector of ngl's rotY*rotX so it matches the rendered view exactly
+  float sx=std::sin(m_pitch*DEG_TO_RAD);
+  float cx=std::cos(m_pitch*DEG_TO_RAD);
+  float sy=std::sin(m_yaw*DEG_TO_RAD);
+  float cy=std::cos(m_yaw*DEG_TO_RAD);
+  m_front.set(-sy,cy*sx,-cy*cx);
+}
+
+void CameraController::step(float _dt)
+{
+  m_prevPos=m_pos;
+
+  // WASD movement, speed is in units per second so scale by the step size
+  float stepSpeed=m_walkSpeed*_dt;
+  Vec3 walk;
+  if(m_actions[FORWARD]) walk+=m_front*stepSpeed;
+  if(m_actions[BACK])    walk-=m_front*stepSpeed;
+  if(m_actions[LEFT] || m_actions[RIGHT])
+  {
+    // right vector is front X up, we only want its direction
+    Vec3 right=m_front.cross(m_up);
+    right.normalize();
+    if(m_actions[LEFT])  walk-=right*stepSpeed;
+    if(m_actions[RIGHT]) walk+=right*stepSpeed;
+  }
+
+  // physics runs in the scaled time of the original demo
+  float dt=_dt*m_timeScale;
+
+  // jump is a one shot, it is consumed whether or not we were on the ground
+  if(m_actions[JUMP])
+  {
+    if(m_grounded)
+    {
+      m_physics.velocity.m_y=m_physics.jumpSpeed;
+    }
+    m_actions[JUMP]=false;
+  }
+
+  Vec3 accel=m_physics.force/m_physics.mass;
+  if(!m_world)
+  {
+    m_pos+=walk;
+    //u=a*t
+    m_physics.velocity+=accel*dt;
+    //x=u*t..euler integration..
+    m_pos+=m_physics.velocity*dt;
+    //force camera position to stay above y=0
+    if(m_pos.m_y<0.0f)
+    {
+      m_pos.m_y=0.0f;
+      m_physics.velocity.m_y=0.0f;
+    }
+    m_grounded=m_pos.m_y==0.0f;
+    return;
+  }
+
+  // split the step so no sub step moves further than a fraction of the body, the sweeps already stop
+  // tunnelling, this keeps the arc of a fast jump and the order of contacts along it
+  Vec3 predicted=walk+(m_physics.velocity+accel*dt)*dt;
+  int substeps=static_cast<int>(std::ceil(predicted.length()/(m_radius*m_substepFraction)));
+  substeps=std::max(1,std::min(substeps,MAX_SUBSTEPS));
+  float h=dt/substeps;
+  m_grounded=false;
+  for(int i=0; i<substeps; ++i)
+  {
+    m_physics.velocity+=accel*h;
+    m_pos=slide(m_pos,walk/static_cast<float>(substeps)+m_physics.velocity*h);
+  }
+}
+
+Vec3 CameraController::slide(const Vec3 &_start, const Vec3 &_move)
+{
+  Vec3 pos=_start;
+  Vec3 remaining=_move;
+  for(int i=0; i<MAX_SLIDES && remaining.lengthSquared()>SKIN*SKIN; ++i)
+  {
+    CollisionWorld::Hit hit;
+    if(!m_world->sweepSphere(pos,pos+remaining,m_radius,hit))
+    {
+      return pos+remaining;
+    }
+    const Vec3 &n=hit.m_normal;
+    // stop at the time of impact just clear of the surface, then carry on along it with what is left
+    pos+=remaining*hit.m_time+n*(hit.m_depth+SKIN);
+    remaining*=1.0f-hit.m_time;
+    remaining-=n*std::min(remaining.dot(n),0.0f);
+    contact(n);
+  }
+  return pos;
+}
+
+void CameraController::contact(const Vec3 &_normal)
+{
+  float into=m_physics.velocity.dot(_normal);
+  if(into>=0.0f)
+  {
+    return;
+  }
+  if(_normal.m_y>GROUND_SLOPE)
+  {
+    // landing, stop falling as the ground clamp used to
+    m_physics.velocity-=_normal*into;
+    m_grounded=true;
+  }
+  else if(-into*m_physics.restitution<REST_SPEED)
+  {
+    // too slow to bounce, slide along the surface instead of jittering against it
+    m_physics.velocity-=_normal*into;
+  }
+  else
+  {
+    collisionResponse(_normal);
+  }
+}
+
+Vec3 CameraController::collisionResponse(const Vec3 &_normal)
+{
+  float d=m_physics.velocity.dot(_normal);
+  float mag=-(1.0f+m_physics.restitution)*d;
+  float j=std::max(mag,0.0f);
+  m_physics.velocity+=_normal*j;
+  return m_physics.velocity;
+}
+
+Vec3 CameraController::coulombFriction()
+{
+  Vec3 &velocity=m_physics.velocity;
+  m_physics.frictionImpulse+=0.1f;
+  velocity-=Vec3(0.0f,1.0f,0.0f)*m_physics.frictionImpulse;
+  velocity.m_y=std::max(velocity.m_y,0.0f);
+
+  //Stabilized, reset so as to let player press Jump-space again
+  if(velocity.m_y==0.0f)
+  {
+    m_actions[JUMP]=false;
+    velocity.set(0.0f,-10.0f,0.0f);
+    m_physics.frictionImpulse=0.0f;
+  }
+  return velocity;
+}
+
+} // end namespace fps
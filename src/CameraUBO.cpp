@@ -0,0 +1,50 @@
+#include "CameraUBO.h"
+#include <cstring>
+
+CameraUBO::CameraUBO() : m_buffer(0)
+{
+}
+
+void CameraUBO::initialize()
+{
+  glGenBuffers(1,&m_buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER,m_buffer);
+  glBufferData(GL_UNIFORM_BUFFER,sizeof(Block),nullptr,GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER,0);
+  glBindBufferBase(GL_UNIFORM_BUFFER,BINDING,m_buffer);
+}
+
+void CameraUBO::release()
+{
+  glDeleteBuffers(1,&m_buffer);
+  m_buffer=0;
+}
+
+bool CameraUBO::attach(GLuint _program) const
+{
+  GLuint index=glGetUniformBlockIndex(_program,"Camera");
+  if(index==GL_INVALID_INDEX)
+  {
+    return false;
+  }
+  glUniformBlockBinding(_program,index,BINDING);
+  return true;
+}
+
+void CameraUBO::update(const ngl::Mat4 &_view, const ngl::Mat4 &_project, const ngl::Vec3 &_eye)
+{
+  Block block;
+  ngl::Mat4 VP=_view*_project;
+  // ngl matrices are laid out the way setShaderParamFromMat4 uploads them so copy them straight in
+  memcpy(block.V,_view.openGL(),sizeof(block.V));
+  memcpy(block.P,_project.openGL(),sizeof(block.P));
+  memcpy(block.VP,VP.openGL(),sizeof(block.VP));
+  block.eye[0]=_eye.m_x;
+  block.eye[1]=_eye.m_y;
+  block.eye[2]=_eye.m_z;
+  block.eye[3]=1.0f;
+  glBindBuffer(GL_UNIFORM_BUFFER,m_buffer);
+  // orphan and refill the whole block, the driver can hand us fresh storage while last frame's is in use
+  glBufferData(GL_UNIFORM_BUFFER,sizeof(Block),&block,GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER,0);
+}
@@ -0,0 +1,563 @@
+#include "CollisionWorld.h"
+#include <algorithm>
+#include <cmath>
+
+namespace fps
+{
+
+namespace
+{
+
+// contacts closer than this count as touching
+const float CONTACT_EPSILON=1.0e-4f;
+// conservative advancement steps before a grazing sweep that is already close is treated as a contact
+const int MAX_ADVANCE_STEPS=64;
+
+Vec3 clampToBox(const Vec3 &_p, const AABB &_box)
+{
+  return Vec3(std::max(_box.m_min.m_x,std::min(_p.m_x,_box.m_max.m_x)),
+              std::max(_box.m_min.m_y,std::min(_p.m_y,_box.m_max.m_y)),
+              std::max(_box.m_min.m_z,std::min(_p.m_z,_box.m_max.m_z)));
+}
+
+// Ericson, Real-Time Collision Detection 5.1.5
+Vec3 closestOnTriangle(const Vec3 &_p, const Vec3 &_a, const Vec3 &_b, const Vec3 &_c)
+{
+  Vec3 ab=_b-_a;
+  Vec3 ac=_c-_a;
+  Vec3 ap=_p-_a;
+  float d1=ab.dot(ap);
+  float d2=ac.dot(ap);
+  if(d1<=0.0f && d2<=0.0f)
+  {
+    return _a;
+  }
+  Vec3 bp=_p-_b;
+  float d3=ab.dot(bp);
+  float d4=ac.dot(bp);
+  if(d3>=0.0f && d4<=d3)
+  {
+    return _b;
+  }
+  float vc=d1*d4-d3*d2;
+  if(vc<=0.0f && d1>=0.0f && d3<=0.0f)
+  {
+    return _a+ab*(d1/(d1-d3));
+  }
+  Vec3 cp=_p-_c;
+  float d5=ab.dot(cp);
+  float d6=ac.dot(cp);
+  if(d6>=0.0f && d5<=d6)
+  {
+    return _c;
+  }
+  float vb=d5*d2-d1*d6;
+  if(vb<=0.0f && d2>=0.0f && d6<=0.0f)
+  {
+    return _a+ac*(d2/(d2-d6));
+  }
+  float va=d3*d6-d5*d4;
+  if(va<=0.0f && (d4-d3)>=0.0f && (d5-d6)>=0.0f)
+  {
+    return _b+(_c-_b)*((d4-d3)/((d4-d3)+(d5-d6)));
+  }
+  float denom=1.0f/(va+vb+vc);
+  return _a+ab*(vb*denom)+ac*(vc*denom);
+}
+
+} // end anonymous namespace
+
+CollisionWorld::CollisionWorld(float _cellSize) : m_cellSize(_cellSize)
+{
+}
+
+void CollisionWorld::clear()
+{
+  m_colliders.clear();
+  m_fields.clear();
+  m_unbounded.clear();
+  m_start.clear();
+  m_items.clear();
+}
+
+uint32_t CollisionWorld::add(const Collider &_c)
+{
+  m_colliders.push_back(_c);
+  return static_cast<uint32_t>(m_colliders.size()-1);
+}
+
+uint32_t CollisionWorld::addSphere(const Vec3 &_centre, float _radius)
+{
+  Collider c;
+  c.m_shape=SPHERE;
+  c.m_box=AABB::fromSphere(_centre,_radius);
+  c.m_a=_centre;
+  c.m_r=_radius;
+  return add(c);
+}
+
+uint32_t CollisionWorld::addBox(const AABB &_box)
+{
+  Collider c;
+  c.m_shape=BOX;
+  c.m_box=_box;
+  c.m_r=0.0f;
+  return add(c);
+}
+
+uint32_t CollisionWorld::addPlane(const Vec3 &_normal, float _d)
+{
+  Collider c;
+  c.m_shape=PLANE;
+  float len=_normal.length();
+  c.m_a=_normal/len;
+  c.m_r=_d/len;
+  m_unbounded.push_back(static_cast<uint32_t>(m_colliders.size()));
+  return add(c);
+}
+
+uint32_t CollisionWorld::addField(const SdfScene &_field)
+{
+  Collider c;
+  c.m_shape=FIELD;
+  c.m_r=0.0f;
+  c.m_field=static_cast<uint32_t>(m_fields.size());
+  m_fields.push_back(Field{_field,nullptr});
+  m_unbounded.push_back(static_cast<uint32_t>(m_colliders.size()));
+  return add(c);
+}
+
+uint32_t CollisionWorld::addField(const SdfScene &_field, const SdfBrickCache::Settings &_cache)
+{
+  uint32_t i=addField(_field);
+  m_fields.back().m_cache.reset(new SdfBrickCache(_field,_cache));
+  return i;
+}
+
+void CollisionWorld::updateFields(JobSystem *_jobs)
+{
+  for(Field &f : m_fields)
+  {
+    if(f.m_cache)
+    {
+      f.m_cache->update(_jobs);
+    }
+  }
+}
+
+float CollisionWorld::fieldDistance(uint32_t _field, const Vec3 &_p) const
+{
+  const Field &f=m_fields[_field];
+  return f.m_cache ? f.m_cache->distance(_p) : f.m_scene.distance(_p);
+}
+
+float CollisionWorld::fieldDistanceAndNormal(uint32_t _field, const Vec3 &_p, Vec3 &o_normal) const
+{
+  const Field &f=m_fields[_field];
+  return f.m_cache ? f.m_cache->distanceAndNormal(_p,o_normal) : f.m_scene.distanceAndNormal(_p,o_normal);
+}
+
+uint32_t CollisionWorld::addTriangle(const Vec3 &_a, const Vec3 &_b, const Vec3 &_c)
+{
+  Collider c;
+  c.m_shape=TRIANGLE;
+  c.m_box.extend(_a);
+  c.m_box.extend(_b);
+  c.m_box.extend(_c);
+  c.m_a=_a;
+  c.m_b=_b;
+  c.m_c=_c;
+  c.m_r=0.0f;
+  return add(c);
+}
+
+void CollisionWorld::addTriangles(const float *_xyz, size_t _vertexCount, const float *_model)
+{
+  auto transform=[_model](const float *_v)
+  {
+    return Vec3(_v[0]*_model[0]+_v[1]*_model[4]+_v[2]*_model[8]+_model[12],
+                _v[0]*_model[1]+_v[1]*_model[5]+_v[2]*_model[9]+_model[13],
+                _v[0]*_model[2]+_v[1]*_model[6]+_v[2]*_model[10]+_model[14]);
+  };
+  for(size_t i=0; i+2<_vertexCount; i+=3)
+  {
+    addTriangle(transform(_xyz+3*i),transform(_xyz+3*i+3),transform(_xyz+3*i+6));
+  }
+}
+
+void CollisionWorld::cellRange(const AABB &_box, int *o_lo, int *o_hi) const
+{
+  const float *lo=&_box.m_min.m_x;
+  const float *hi=&_box.m_max.m_x;
+  for(int i=0; i<3; ++i)
+  {
+    o_lo[i]=static_cast<int>(std::floor(lo[i]/m_cellSize));
+    o_hi[i]=static_cast<int>(std::floor(hi[i]/m_cellSize));
+  }
+}
+
+size_t CollisionWorld::hash(int _x, int _y, int _z) const
+{
+  // Teschner et al. spatial hash, colliding cells only cost extra candidates
+  uint32_t h=(static_cast<uint32_t>(_x)*73856093u)^(static_cast<uint32_t>(_y)*19349663u)^(static_cast<uint32_t>(_z)*83492791u);
+  return h&(m_start.size()-2);
+}
+
+void CollisionWorld::build()
+{
+  // pairs of (bucket, collider) counting sorted into one flat array
+  std::vector<std::pair<size_t,uint32_t>> entries;
+  size_t cells=0;
+  int lo[3];
+  int hi[3];
+  for(const Collider &c : m_colliders)
+  {
+    if(bounded(c.m_shape))
+    {
+      cellRange(c.m_box,lo,hi);
+      cells+=static_cast<size_t>(hi[0]-lo[0]+1)*(hi[1]-lo[1]+1)*(hi[2]-lo[2]+1);
+    }
+  }
+  size_t buckets=64;
+  while(buckets<cells)
+  {
+    buckets*=2;
+  }
+  m_start.assign(buckets+1,0);
+  entries.reserve(cells);
+  for(uint32_t i=0; i<m_colliders.size(); ++i)
+  {
+    if(!bounded(m_colliders[i].m_shape))
+    {
+      continue;
+    }
+    cellRange(m_colliders[i].m_box,lo,hi);
+    for(int z=lo[2]; z<=hi[2]; ++z)
+    {
+      for(int y=lo[1]; y<=hi[1]; ++y)
+      {
+        for(int x=lo[0]; x<=hi[0]; ++x)
+        {
+          entries.push_back(std::make_pair(hash(x,y,z),i));
+        }
+      }
+    }
+  }
+  for(const std::pair<size_t,uint32_t> &e : entries)
+  {
+    ++m_start[e.first+1];
+  }
+  for(size_t b=0; b<buckets; ++b)
+  {
+    m_start[b+1]+=m_start[b];
+  }
+  m_items.resize(entries.size());
+  std::vector<uint32_t> fill(m_start.begin(),m_start.end()-1);
+  for(const std::pair<size_t,uint32_t> &e : entries)
+  {
+    m_items[fill[e.first]++]=e.second;
+  }
+}
+
+void CollisionWorld::query(const AABB &_box, std::vector<uint32_t> &o_candidates) const
+{
+  o_candidates.clear();
+  if(m_start.empty())
+  {
+    return;
+  }
+  int lo[3];
+  int hi[3];
+  cellRange(_box,lo,hi);
+  double cells=static_cast<double>(hi[0]-lo[0]+1)*(hi[1]-lo[1]+1)*(hi[2]-lo[2]+1);
+  if(cells>static_cast<double>(m_colliders.size()))
+  {
+    // a query bigger than the level is cheaper as a straight scan
+    for(uint32_t i=0; i<m_colliders.size(); ++i)
+    {
+      if(bounded(m_colliders[i].m_shape) && m_colliders[i].m_box.overlaps(_box))
+      {
+        o_candidates.push_back(i);
+      }
+    }
+    return;
+  }
+  for(int z=lo[2]; z<=hi[2]; ++z)
+  {
+    for(int y=lo[1]; y<=hi[1]; ++y)
+    {
+      for(int x=lo[0]; x<=hi[0]; ++x)
+      {
+        size_t b=hash(x,y,z);
+        for(uint32_t j=m_start[b]; j<m_start[b+1]; ++j)
+        {
+          if(m_colliders[m_items[j]].m_box.overlaps(_box))
+          {
+            o_candidates.push_back(m_items[j]);
+          }
+        }
+      }
+    }
+  }
+  std::sort(o_candidates.begin(),o_candidates.end());
+  o_candidates.erase(std::unique(o_candidates.begin(),o_candidates.end()),o_candidates.end());
+}
+
+Vec3 CollisionWorld::closestPoint(uint32_t _i, const Vec3 &_p) const
+{
+  const Collider &c=m_colliders[_i];
+  switch(c.m_shape)
+  {
+    case SPHERE :
+    {
+      Vec3 d=_p-c.m_a;
+      float len=d.length();
+      return len>0.0f ? c.m_a+d*(c.m_r/len) : c.m_a+Vec3(0.0f,c.m_r,0.0f);
+    }
+    case BOX : return clampToBox(_p,c.m_box);
+    case PLANE : return _p-c.m_a*(c.m_a.dot(_p)+c.m_r);
+    case TRIANGLE : return closestOnTriangle(_p,c.m_a,c.m_b,c.m_c);
+    case FIELD :
+    {
+      Vec3 n;
+      float d=fieldDistanceAndNormal(c.m_field,_p,n);
+      return _p-n*d;
+    }
+  }
+  return _p;
+}
+
+bool CollisionWorld::sweepOne(uint32_t _i, const Vec3 &_start, const Vec3 &_delta, float _radius, Hit &o_hit) const
+{
+  const Collider &c=m_colliders[_i];
+  if(c.m_shape==PLANE)
+  {
+    float d0=c.m_a.dot(_start)+c.m_r-_radius;
+    float speed=c.m_a.dot(_delta);
+    if(speed>=0.0f || d0+speed>CONTACT_EPSILON)
+    {
+      // moving away or not reaching the plane this sweep
+      return false;
+    }
+    o_hit.m_time=d0>0.0f ? d0/-speed : 0.0f;
+    o_hit.m_normal=c.m_a;
+    o_hit.m_depth=std::max(-d0,0.0f);
+    o_hit.m_point=_start+_delta*o_hit.m_time-c.m_a*(_radius-o_hit.m_depth);
+    o_hit.m_collider=_i;
+    return true;
+  }
+  if(c.m_shape==SPHERE)
+  {
+    // ray against the sphere grown by our radius
+    Vec3 m=_start-c.m_a;
+    float r=c.m_r+_radius;
+    float b=m.dot(_delta);
+    float cc=m.lengthSquared()-r*r;
+    if(cc<=0.0f)
+    {
+      // already touching, only a contact if we are moving in
+      if(b>=0.0f)
+      {
+        return false;
+      }
+      float len=m.length();
+      o_hit.m_time=0.0f;
+      o_hit.m_normal= len>0.0f ? m/len : Vec3(0.0f,1.0f,0.0f);
+      o_hit.m_depth=r-len;
+    }
+    else
+    {
+      float a=_delta.lengthSquared();
+      float disc=b*b-a*cc;
+      if(b>=0.0f || a==0.0f || disc<0.0f)
+      {
+        return false;
+      }
+      float t=(-b-std::sqrt(disc))/a;
+      if(t>1.0f)
+      {
+        return false;
+      }
+      o_hit.m_time=t;
+      o_hit.m_normal=(m+_delta*t)/r;
+      o_hit.m_depth=0.0f;
+    }
+    o_hit.m_point=c.m_a+o_hit.m_normal*c.m_r;
+    o_hit.m_collider=_i;
+    return true;
+  }
+  if(c.m_shape==FIELD)
+  {
+    // sphere tracing, the same stepping the shader's raymarcher trusts, the gradient is only taken at contact
+    float speed=_delta.length();
+    float t=0.0f;
+    for(int step=0; step<MAX_ADVANCE_STEPS; ++step)
+    {
+      Vec3 p=_start+_delta*t;
+      float dist=fieldDistance(c.m_field,p)-_radius;
+      bool exhausted=step==MAX_ADVANCE_STEPS-1;
+      if(exhausted && dist>=_radius)
+      {
+        return false;
+      }
+      if(dist<CONTACT_EPSILON || exhausted)
+      {
+        Vec3 n;
+        fieldDistanceAndNormal(c.m_field,p,n);
+        if(n.dot(_delta)>=0.0f)
+        {
+          return false;
+        }
+        o_hit.m_time=t;
+        o_hit.m_normal=n;
+        o_hit.m_point=p-n*(dist+_radius);
+        o_hit.m_depth=std::max(-dist,0.0f);
+        o_hit.m_collider=_i;
+        return true;
+      }
+      t+=dist/speed;
+      if(t>1.0f)
+      {
+        return false;
+      }
+    }
+    return false;
+  }
+  // boxes and triangles advance along the sweep by the distance to the shape, which can never skip
+  // past it, until the sphere touches
+  float speed=_delta.length();
+  float t=0.0f;
+  for(int step=0; step<MAX_ADVANCE_STEPS; ++step)
+  {
+    Vec3 p=_start+_delta*t;
+    Vec3 q=closestPoint(_i,p);
+    Vec3 n=p-q;
+    float len=n.length();
+    float dist=len-_radius;
+    bool exhausted=step==MAX_ADVANCE_STEPS-1;
+    if(exhausted && dist>=_radius)
+    {
+      return false;
+    }
+    if(dist<CONTACT_EPSILON || exhausted)
+    {
+      n= len>0.0f ? n/len : (speed>0.0f ? _delta/-speed : Vec3(0.0f,1.0f,0.0f));
+      if(n.dot(_delta)>=0.0f)
+      {
+        return false;
+      }
+      o_hit.m_time=t;
+      o_hit.m_normal=n;
+      o_hit.m_point=q;
+      o_hit.m_depth=std::max(-dist,0.0f);
+      o_hit.m_collider=_i;
+      return true;
+    }
+    // moving away from a convex shape means we can never reach it
+    if(n.dot(_delta)>=0.0f)
+    {
+      return false;
+    }
+    t+=dist/speed;
+    if(t>1.0f)
+    {
+      return false;
+    }
+  }
+  return false;
+}
+
+bool CollisionWorld::sweepSphere(const Vec3 &_start, const Vec3 &_end, float _radius, Hit &o_hit) const
+{
+  static thread_local std::vector<uint32_t> candidates;
+  AABB box=AABB::fromSphere(_start,_radius);
+  box.extend(AABB::fromSphere(_end,_radius));
+  query(box,candidates);
+  candidates.insert(candidates.end(),m_unbounded.begin(),m_unbounded.end());
+  Vec3 delta=_end-_start;
+  bool found=false;
+  Hit hit;
+  for(uint32_t i : candidates)
+  {
+    if(sweepOne(i,_start,delta,_radius,hit) && (!found || hit.m_time<o_hit.m_time))
+    {
+      o_hit=hit;
+      found=true;
+    }
+  }
+  return found;
+}
+
+size_t CollisionWorld::collideSphere(const Vec3 &_centre, float _radius, Hit *o_hits, size_t _maxHits) const
+{
+  static thread_local std::vector<uint32_t> candidates;
+  query(AABB::fromSphere(_centre,_radius),candidates);
+  candidates.insert(candidates.end(),m_unbounded.begin(),m_unbounded.end());
+  size_t count=0;
+  for(uint32_t i : candidates)
+  {
+    if(count==_maxHits)
+    {
+      break;
+    }
+    const Collider &c=m_colliders[i];
+    Vec3 q;
+    Vec3 n;
+    float dist;
+    if(c.m_shape==FIELD)
+    {
+      // fields are signed too, distance and gradient come from one evaluation
+      dist=fieldDistanceAndNormal(c.m_field,_centre,n);
+      q=_centre-n*dist;
+    }
+    else if(c.m_shape==PLANE)
+    {
+      // planes are solid behind, so the signed distance decides
+      q=closestPoint(i,_centre);
+      dist=c.m_a.dot(_centre)+c.m_r;
+      n=c.m_a;
+    }
+    else
+    {
+      q=closestPoint(i,_centre);
+      n=_centre-q;
+      dist=n.length();
+      if(dist>0.0f)
+      {
+        n=n/dist;
+      }
+      else
+      {
+        n.set(0.0f,1.0f,0.0f);
+      }
+    }
+    if(dist<_radius)
+    {
+      Hit &hit=o_hits[count++];
+      hit.m_time=0.0f;
+      hit.m_normal=n;
+      hit.m_point=q;
+      hit.m_depth=_radius-dist;
+      hit.m_collider=i;
+    }
+  }
+  return count;
+}
+
+bool CollisionWorld::sweepSphereBruteForce(const Vec3 &_start, const Vec3 &_end, float _radius, Hit &o_hit) const
+{
+  Vec3 delta=_end-_start;
+  bool found=false;
+  Hit hit;
+  for(uint32_t i=0; i<m_colliders.size(); ++i)
+  {
+    if(sweepOne(i,_start,delta,_radius,hit) && (!found || hit.m_time<o_hit.m_time))
+    {
+      o_hit=hit;
+      found=true;
+    }
+  }
+  return found;
+}
+
+} // end namespace fps
@@ -0,0 +1,68 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+namespace fps
+{
+
+DynamicResolution::DynamicResolution()
+{
+  reset();
+}
+
+DynamicResolution::DynamicResolution(const Settings &_settings) :
+  m_settings(_settings)
+{
+  reset();
+}
+
+void DynamicResolution::reset()
+{
+  m_scale=snap(m_settings.m_maxScale);
+  m_averageMs=0.0f;
+  m_frames=0;
+}
+
+float DynamicResolution::snap(float _scale) const
+{
+  float step=std::max(m_settings.m_step,1.0e-3f);
+  float snapped=std::round(_scale/step)*step;
+  return std::min(std::max(snapped,m_settings.m_minScale),m_settings.m_maxScale);
+}
+
+bool DynamicResolution::addFrame(float _gpuMs)
+{
+  // frames drawn before the last change are still arriving, the average starts afresh after them
+  int frame=m_frames++;
+  if(frame<m_settings.m_latencyFrames)
+  {
+    return false;
+  }
+  m_averageMs= frame==m_settings.m_latencyFrames ? _gpuMs : m_averageMs+(_gpuMs-m_averageMs)*m_settings.m_smoothing;
+  if(frame-m_settings.m_latencyFrames+1<m_settings.m_settleFrames || m_averageMs<=0.0f)
+  {
+    return false;
+  }
+  float ratio=m_settings.m_targetMs/m_averageMs;
+  if(std::fabs(ratio-1.0f)<=m_settings.m_tolerance)
+  {
+    return false;
+  }
+  float change=std::min(std::max(std::sqrt(ratio),1.0f-m_settings.m_maxChange),1.0f+m_settings.m_maxChange);
+  float scale=snap(m_scale*change);
+  if(scale==m_scale)
+  {
+    return false;
+  }
+  m_scale=scale;
+  m_frames=0;
+  return true;
+}
+
+void DynamicResolution::renderSize(int _width, int _height, int &o_width, int &o_height) const
+{
+  o_width=std::max(1,static_cast<int>(std::lround(_width*m_scale)));
+  o_height=std::max(1,static_cast<int>(std::lround(_height*m_scale)));
+}
+
+} // end namespace fps
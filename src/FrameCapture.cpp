@@ -0,0 +1,212 @@
+#include "FrameCapture.h"
+#include "Log.h"
+#include <Magick++.h>
+#include <algorithm>
+#include <cstring>
+
+static const GLuint FORMAT_NBYTES=4;
+
+FrameCapture::FrameCapture() : m_nextSlot(0), m_recorder(nullptr), m_quit(false), m_results(64)
+{
+  m_worker=std::thread(&FrameCapture::encodeLoop,this);
+}
+
+FrameCapture::~FrameCapture()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    m_quit=true;
+  }
+  m_jobReady.notify_one();
+  // the worker finishes everything already queued before it exits
+  m_worker.join();
+}
+
+void FrameCapture::initialize()
+{
+  for(Slot &s : m_slots)
+  {
+    glGenBuffers(1,&s.pbo);
+  }
+}
+
+void FrameCapture::release()
+{
+  for(Slot &s : m_slots)
+  {
+    if(s.fence!=nullptr)
+    {
+      glDeleteSync(s.fence);
+      s.fence=nullptr;
+    }
+    glDeleteBuffers(1,&s.pbo);
+    s.pbo=0;
+  }
+}
+
+void FrameCapture::request(const std::string &_fname)
+{
+  m_requests.push_back(_fname);
+}
+
+size_t FrameCapture::pending() const
+{
+  size_t count=0;
+  for(const Slot &s : m_slots)
+  {
+    count+= s.fence!=nullptr ? 1 : 0;
+  }
+  std::lock_guard<std::mutex> lock(m_jobMutex);
+  return count+m_jobs.size();
+}
+
+void FrameCapture::endFrame(int _width, int _height)
+{
+  collect();
+
+  bool record=m_recorder!=nullptr && m_recorder->recording();
+  if(!m_requests.empty() || record)
+  {
+    Slot &s=m_slots[m_nextSlot];
+    // every slot is still in flight, leave the request for a later frame rather than wait
+    if(s.fence!=nullptr)
+    {
+      if(record)
+      {
+        m_recorder->dropFrame();
+      }
+    }
+    else
+    {
+      size_t size=FORMAT_NBYTES*_width*_height;
+      glBindBuffer(GL_PIXEL_PACK_BUFFER,s.pbo);
+      // the PBO is allocated on the first capture and only grows, so resizing the window costs nothing
+      if(size>s.capacity)
+      {
+        s.capacity=std::max(size,s.capacity+s.capacity/2);
+        glBufferData(GL_PIXEL_PACK_BUFFER,s.capacity,nullptr,GL_STREAM_READ);
+      }
+      s.size=size;
+      // with a pack buffer bound this only queues the copy, it returns straight away
+      glReadPixels(0,0,_width,_height,GL_RGBA,GL_UNSIGNED_BYTE,nullptr);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+      s.fence=glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+      s.width=_width;
+      s.height=_height;
+      s.record=record;
+      s.fname.clear();
+      if(!m_requests.empty())
+      {
+        s.fname=m_requests.front();
+        m_requests.pop_front();
+      }
+      m_nextSlot=(m_nextSlot+1)%NUM_SLOTS;
+    }
+  }
+
+  Result r;
+  while(m_results.tryPop(r))
+  {
+    if(r.ok)
+    {
+      FPS_LOG_INFO("saved %s",r.fname);
+    }
+    else
+    {
+      FPS_LOG_ERROR("failed to save %s",r.fname);
+    }
+  }
+}
+
+void FrameCapture::collect()
+{
+  // slots are filled in ring order, so from m_nextSlot on the ones in flight come oldest first. Stopping at the
+  // first copy that is not done hands frames to the recorder in the order they were drawn
+  for(int i=0; i<NUM_SLOTS; ++i)
+  {
+    Slot &s=m_slots[(m_nextSlot+i)%NUM_SLOTS];
+    if(s.fence==nullptr)
+    {
+      continue;
+    }
+    // zero timeout, we only want to know if the copy is done
+    GLenum status=glClientWaitSync(s.fence,0,0);
+    if(status!=GL_ALREADY_SIGNALED && status!=GL_CONDITION_SATISFIED)
+    {
+      break;
+    }
+    glDeleteSync(s.fence);
+    s.fence=nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER,s.pbo);
+    void *data=glMapBufferRange(GL_PIXEL_PACK_BUFFER,0,s.size,GL_MAP_READ_BIT);
+    if(data==nullptr)
+    {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+      FPS_LOG_ERROR("unable to map capture buffer");
+      continue;
+    }
+
+    if(s.record && m_recorder!=nullptr)
+    {
+      // acquire counts the drop itself if the I/O thread is behind
+      fps::FrameRecorder::Frame *frame=m_recorder->acquire(s.width,s.height);
+      if(frame!=nullptr)
+      {
+        memcpy(frame->rgba.data(),data,s.size);
+        m_recorder->submit(frame);
+      }
+    }
+    if(!s.fname.empty())
+    {
+      Job job{s.width,s.height,m_staging.acquire(s.size),s.fname};
+      memcpy(job.pixels->data(),data,s.size);
+      {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_jobs.push_back(std::move(job));
+      }
+      m_jobReady.notify_one();
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+  }
+}
+
+void FrameCapture::encodeLoop()
+{
+  for(;;)
+  {
+    Job job{0,0,fps::StagingPool::Handle(nullptr,fps::StagingPool::Releaser{&m_staging}),std::string()};
+    {
+      std::unique_lock<std::mutex> lock(m_jobMutex);
+      m_jobReady.wait(lock,[this]{ return m_quit || !m_jobs.empty(); });
+      if(m_jobs.empty())
+      {
+        return;
+      }
+      job=std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+
+    Result r;
+    snprintf(r.fname,sizeof(r.fname),"%s",job.fname.c_str());
+    try
+    {
+      // now create an image data block
+      Magick::Image output(job.width,job.height,"RGBA",Magick::CharPixel,job.pixels->data());
+      // GL rows start at the bottom
+      output.flip();
+      // set the output image depth to 16 bit
+      output.depth(16);
+      // write the file
+      output.write(job.fname);
+      r.ok=true;
+    }
+    catch(const Magick::Exception &)
+    {
+      r.ok=false;
+    }
+    // if the render thread has stopped draining we just lose the message, not the image
+    m_results.tryPush(r);
+  }
+}
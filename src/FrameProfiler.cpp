@@ -0,0 +1,165 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+namespace fps
+{
+
+const size_t FrameProfiler::HISTORY;
+
+FrameProfiler::FrameProfiler() : m_head(0)
+{
+  m_current.fill(0.0f);
+  for(Slot &slot : m_history)
+  {
+    slot.m_sequence.store(0,std::memory_order_relaxed);
+    for(std::atomic<float> &t : slot.m_times)
+    {
+      t.store(0.0f,std::memory_order_relaxed);
+    }
+  }
+  m_epoch=std::chrono::steady_clock::now();
+  m_lastFrame=m_epoch;
+}
+
+void FrameProfiler::addTime(Stage _stage, std::chrono::steady_clock::time_point _start, std::chrono::steady_clock::time_point _end)
+{
+  m_current[_stage]+=std::chrono::duration<float,std::milli>(_end-_start).count();
+  if(m_traceEnabled && m_events.size()<m_maxEvents)
+  {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    m_events.push_back({_stage,
+                        duration_cast<microseconds>(_start-m_epoch).count(),
+                        duration_cast<microseconds>(_end-_start).count()});
+  }
+}
+
+void FrameProfiler::addMs(Stage _stage, float _ms)
+{
+  m_current[_stage]+=_ms;
+}
+
+void FrameProfiler::endFrame()
+{
+  std::chrono::steady_clock::time_point now=std::chrono::steady_clock::now();
+  m_current[FRAME]=std::chrono::duration<float,std::milli>(now-m_lastFrame).count();
+  if(m_traceEnabled && m_events.size()<m_maxEvents)
+  {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    m_events.push_back({FRAME,
+                        duration_cast<microseconds>(m_lastFrame-m_epoch).count(),
+                        duration_cast<microseconds>(now-m_lastFrame).count()});
+  }
+  m_lastFrame=now;
+
+  uint64_t head=m_head.load(std::memory_order_relaxed);
+  Slot &slot=m_history[head%HISTORY];
+  // odd while the times change, each time is a release store so none can be seen before the odd sequence
+  uint32_t sequence=slot.m_sequence.load(std::memory_order_relaxed);
+  slot.m_sequence.store(sequence+1,std::memory_order_relaxed);
+  for(int s=0; s<NUM_STAGES; ++s)
+  {
+    slot.m_times[s].store(m_current[s],std::memory_order_release);
+  }
+  slot.m_sequence.store(sequence+2,std::memory_order_release);
+  // release so a reader that sees the new head also sees the slot contents
+  m_head.store(head+1,std::memory_order_release);
+  m_current.fill(0.0f);
+}
+
+std::vector<FrameProfiler::FrameTimes> FrameProfiler::history() const
+{
+  uint64_t head=m_head.load(std::memory_order_acquire);
+  size_t count=static_cast<size_t>(std::min<uint64_t>(head,HISTORY));
+  std::vector<FrameTimes> frames;
+  frames.reserve(count);
+  for(uint64_t i=head-count; i<head; ++i)
+  {
+    const Slot &slot=m_history[i%HISTORY];
+    FrameTimes times;
+    for(;;)
+    {
+      // the copy only counts if the sequence was even and the same before and after it, the acquire loads
+      // keep the second read of the sequence after the copy
+      uint32_t sequence=slot.m_sequence.load(std::memory_order_acquire);
+      if((sequence&1)==0)
+      {
+        for(int s=0; s<NUM_STAGES; ++s)
+        {
+          times[s]=slot.m_times[s].load(std::memory_order_acquire);
+        }
+        if(slot.m_sequence.load(std::memory_order_relaxed)==sequence)
+        {
+          break;
+        }
+      }
+      std::this_thread::yield();
+    }
+    frames.push_back(times);
+  }
+  return frames;
+}
+
+std::array<FrameProfiler::Stats,FrameProfiler::NUM_STAGES> FrameProfiler::stats() const
+{
+  std::array<Stats,NUM_STAGES> result;
+  std::vector<FrameTimes> frames=history();
+  std::vector<float> values(frames.size());
+  for(int s=0; s<NUM_STAGES; ++s)
+  {
+    if(frames.empty())
+    {
+      result[s]={0.0f,0.0f,0.0f};
+      continue;
+    }
+    float sum=0.0f;
+    for(size_t i=0; i<frames.size(); ++i)
+    {
+      values[i]=frames[i][s];
+      sum+=values[i];
+    }
+    size_t p99=std::min(values.size()-1,(values.size()*99)/100);
+    std::nth_element(values.begin(),values.begin()+p99,values.end());
+    float p99Value=values[p99];
+    result[s]={*std::min_element(values.begin(),values.end()),sum/values.size(),p99Value};
+  }
+  return result;
+}
+
+void FrameProfiler::enableTrace(size_t _maxEvents)
+{
+  m_traceEnabled=true;
+  m_maxEvents=_maxEvents;
+  m_events.reserve(std::min<size_t>(_maxEvents,65536));
+}
+
+bool FrameProfiler::writeChromeTrace(const std::string &_fname) const
+{
+  FILE *f=fopen(_fname.c_str(),"w");
+  if(f==nullptr)
+  {
+    return false;
+  }
+  fprintf(f,"{\"traceEvents\":[\n");
+  for(size_t i=0; i<m_events.size(); ++i)
+  {
+    const TraceEvent &e=m_events[i];
+    // frames go on their own row so the stages nest underneath them in the viewer
+    fprintf(f,"%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}",
+            i==0 ? "" : ",\n",stageName(e.stage),e.stage==FRAME ? 1 : 2,
+            static_cast<long long>(e.startUs),static_cast<long long>(e.durationUs));
+  }
+  fprintf(f,"\n],\"displayTimeUnit\":\"ms\"}\n");
+  return fclose(f)==0;
+}
+
+const char * FrameProfiler::stageName(Stage _stage)
+{
+  static const char *names[NUM_STAGES]={"input","simulation","matrix upload","draw","readback","gpu","frame"};
+  return names[_stage];
+}
+
+} // end namespace fps
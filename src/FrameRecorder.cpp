@@ -0,0 +1,317 @@
+#include "FrameRecorder.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fps
+{
+
+#ifndef IOV_MAX
+  #define IOV_MAX 1024
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief writev everything, coping with short writes and the IOV_MAX limit
+//----------------------------------------------------------------------------------------------------------------------
+static bool writeAll(int _fd, std::vector<iovec> &_iov)
+{
+  size_t first=0;
+  while(first<_iov.size())
+  {
+    int count=static_cast<int>(std::min<size_t>(_iov.size()-first,IOV_MAX));
+    ssize_t written=writev(_fd,&_iov[first],count);
+    if(written<0)
+    {
+      if(errno==EINTR)
+      {
+        continue;
+      }
+      return false;
+    }
+    // skip the fully written entries and trim the partially written one
+    size_t left=static_cast<size_t>(written);
+    while(first<_iov.size() && left>=_iov[first].iov_len)
+    {
+      left-=_iov[first].iov_len;
+      ++first;
+    }
+    if(left!=0)
+    {
+      _iov[first].iov_base=static_cast<char *>(_iov[first].iov_base)+left;
+      _iov[first].iov_len-=left;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief header followed by the rows top first, GL gives us the bottom row first
+//----------------------------------------------------------------------------------------------------------------------
+static void flippedRows(std::vector<iovec> &_iov, unsigned char *_data, int _height, size_t _rowBytes)
+{
+  for(int y=_height-1; y>=0; --y)
+  {
+    _iov.push_back({_data+y*_rowBytes,_rowBytes});
+  }
+}
+
+static std::string replaceAll(std::string _s, const std::string &_from, const std::string &_to)
+{
+  for(size_t pos=_s.find(_from); pos!=std::string::npos; pos=_s.find(_from,pos+_to.size()))
+  {
+    _s.replace(pos,_from.size(),_to);
+  }
+  return _s;
+}
+
+FrameRecorder::FrameRecorder() :
+  m_recording(false),
+  m_running(false),
+  m_nextIndex(0),
+  m_stream(nullptr),
+  m_streamIsPipe(false),
+  m_streamWidth(0),
+  m_streamHeight(0),
+  m_submitted(0),
+  m_written(0),
+  m_dropped(0),
+  m_failed(0),
+  m_bytes(0)
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+  stop();
+}
+
+bool FrameRecorder::start(const Config &_config)
+{
+  if(m_recording)
+  {
+    return false;
+  }
+  m_config=_config;
+  m_config.queueDepth=std::max<size_t>(m_config.queueDepth,1);
+  m_filled.reset(new SpscQueue<Frame *>(m_config.queueDepth));
+  m_free.reset(new SpscQueue<Frame *>(m_config.queueDepth));
+  // the pixel storage is only sized on first use so idle pool entries cost nothing, and the pool is
+  // kept between recordings so starting again reuses the memory
+  m_pool.resize(std::min(m_pool.size(),m_config.queueDepth));
+  for(const std::unique_ptr<Frame> &f : m_pool)
+  {
+    m_free->tryPush(f.get());
+  }
+  for(size_t i=m_pool.size(); i<m_config.queueDepth; ++i)
+  {
+    m_pool.emplace_back(new Frame);
+    m_free->tryPush(m_pool.back().get());
+  }
+  m_nextIndex=0;
+  m_submitted=0;
+  m_written=0;
+  m_dropped=0;
+  m_failed=0;
+  m_bytes=0;
+  if(!m_config.pipeCommand.empty())
+  {
+    // an encoder that exits early must not take us down with it
+    signal(SIGPIPE,SIG_IGN);
+  }
+  m_running=true;
+  m_recording=true;
+  m_io=std::thread(&FrameRecorder::run,this);
+  return true;
+}
+
+void FrameRecorder::stop()
+{
+  if(!m_recording)
+  {
+    return;
+  }
+  m_running=false;
+  m_io.join();
+  m_recording=false;
+}
+
+FrameRecorder::Frame * FrameRecorder::acquire(int _width, int _height)
+{
+  if(!m_recording)
+  {
+    return nullptr;
+  }
+  Frame *frame=nullptr;
+  while(!m_free->tryPop(frame))
+  {
+    if(m_config.policy==DROP)
+    {
+      m_dropped.fetch_add(1,std::memory_order_relaxed);
+      return nullptr;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  frame->width=_width;
+  frame->height=_height;
+  frame->index=m_nextIndex++;
+  frame->rgba.resize(static_cast<size_t>(_width)*_height*4);
+  return frame;
+}
+
+void FrameRecorder::submit(Frame *_frame)
+{
+  m_submitted.fetch_add(1,std::memory_order_relaxed);
+  // can't fail, there are never more frames out than slots in the queue
+  m_filled->tryPush(_frame);
+}
+
+FrameRecorder::Stats FrameRecorder::stats() const
+{
+  return {m_submitted.load(),m_written.load(),m_dropped.load(),m_failed.load(),m_bytes.load()};
+}
+
+void FrameRecorder::run()
+{
+  for(;;)
+  {
+    Frame *frame=nullptr;
+    if(m_filled->tryPop(frame))
+    {
+      if(writeFrame(*frame))
+      {
+        m_written.fetch_add(1,std::memory_order_relaxed);
+      }
+      else
+      {
+        m_failed.fetch_add(1,std::memory_order_relaxed);
+      }
+      m_free->tryPush(frame);
+    }
+    else if(!m_running.load(std::memory_order_acquire))
+    {
+      break;
+    }
+    else
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  closeStream();
+}
+
+bool FrameRecorder::openStream(const Frame &_frame)
+{
+  if(m_stream!=nullptr)
+  {
+    // a raw stream has no per frame header so the size can't change mid recording
+    return _frame.width==m_streamWidth && _frame.height==m_streamHeight;
+  }
+  m_streamWidth=_frame.width;
+  m_streamHeight=_frame.height;
+  if(!m_config.pipeCommand.empty())
+  {
+    std::string cmd=replaceAll(m_config.pipeCommand,"%W",std::to_string(_frame.width));
+    cmd=replaceAll(cmd,"%H",std::to_string(_frame.height));
+    m_stream=popen(cmd.c_str(),"w");
+    m_streamIsPipe=true;
+  }
+  else
+  {
+    m_stream=fopen((m_config.prefix+".rgba").c_str(),"wb");
+    m_streamIsPipe=false;
+  }
+  return m_stream!=nullptr;
+}
+
+void FrameRecorder::closeStream()
+{
+  if(m_stream==nullptr)
+  {
+    return;
+  }
+  if(m_streamIsPipe)
+  {
+    pclose(m_stream);
+  }
+  else
+  {
+    fclose(m_stream);
+  }
+  m_stream=nullptr;
+}
+
+bool FrameRecorder::writeFrame(Frame &_frame)
+{
+  size_t rgbaRow=static_cast<size_t>(_frame.width)*4;
+  std::vector<iovec> iov;
+  iov.reserve(_frame.height+1);
+
+  if(m_config.format==RAW)
+  {
+    if(!openStream(_frame))
+    {
+      return false;
+    }
+    flippedRows(iov,_frame.rgba.data(),_frame.height,rgbaRow);
+    bool ok=writeAll(fileno(m_stream),iov);
+    if(ok)
+    {
+      m_bytes.fetch_add(rgbaRow*_frame.height,std::memory_order_relaxed);
+    }
+    return ok;
+  }
+
+  char fname[512];
+  char header[128];
+  int headerSize=0;
+  unsigned char *pixels=_frame.rgba.data();
+  size_t rowBytes=rgbaRow;
+  if(m_config.format==PAM)
+  {
+    snprintf(fname,sizeof(fname),"%s_%06llu.pam",m_config.prefix.c_str(),static_cast<unsigned long long>(_frame.index));
+    headerSize=snprintf(header,sizeof(header),"P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n",
+                        _frame.width,_frame.height);
+  }
+  else
+  {
+    snprintf(fname,sizeof(fname),"%s_%06llu.ppm",m_config.prefix.c_str(),static_cast<unsigned long long>(_frame.index));
+    headerSize=snprintf(header,sizeof(header),"P6\n%d %d\n255\n",_frame.width,_frame.height);
+    // strip the alpha into a scratch buffer that is reused across frames
+    size_t count=static_cast<size_t>(_frame.width)*_frame.height;
+    m_scratch.resize(count*3);
+    const unsigned char *src=_frame.rgba.data();
+    unsigned char *dst=m_scratch.data();
+    for(size_t i=0; i<count; ++i)
+    {
+      dst[0]=src[0];
+      dst[1]=src[1];
+      dst[2]=src[2];
+      src+=4;
+      dst+=3;
+    }
+    pixels=m_scratch.data();
+    rowBytes=static_cast<size_t>(_frame.width)*3;
+  }
+
+  int fd=open(fname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+  if(fd<0)
+  {
+    return false;
+  }
+  iov.push_back({header,static_cast<size_t>(headerSize)});
+  flippedRows(iov,pixels,_frame.height,rowBytes);
+  bool ok=writeAll(fd,iov);
+  ok= (close(fd)==0) && ok;
+  if(ok)
+  {
+    m_bytes.fetch_add(headerSize+rowBytes*_frame.height,std::memory_order_relaxed);
+  }
+  return ok;
+}
+
+} // end namespace fps
@@ -0,0 +1,101 @@
+#include "Frustum.h"
+#include <cmath>
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+namespace fps
+{
+
+Frustum::Frustum(const Mat4 &_viewProject)
+{
+  // clip=[x y z 1]*VP so clip.x is the dot product with column 0 and so on, the planes are
+  // w+x, w-x, w+y, w-y, w+z and w-z
+  const float (*m)[4]=_viewProject.m_m;
+  static const int axis[NUM_PLANES]={0,0,1,1,2,2};
+  static const float sign[NUM_PLANES]={1.0f,-1.0f,1.0f,-1.0f,1.0f,-1.0f};
+  for(int i=0; i<NUM_PLANES; ++i)
+  {
+    int a=axis[i];
+    float s=sign[i];
+    float nx=m[0][3]+s*m[0][a];
+    float ny=m[1][3]+s*m[1][a];
+    float nz=m[2][3]+s*m[2][a];
+    float d =m[3][3]+s*m[3][a];
+    float len=std::sqrt(nx*nx+ny*ny+nz*nz);
+    float inv= len>0.0f ? 1.0f/len : 0.0f;
+    m_nx[i]=nx*inv;
+    m_ny[i]=ny*inv;
+    m_nz[i]=nz*inv;
+    m_d[i]=d*inv;
+  }
+  // padding planes that everything is well inside
+  for(int i=NUM_PLANES; i<PADDED_PLANES; ++i)
+  {
+    m_nx[i]=0.0f;
+    m_ny[i]=0.0f;
+    m_nz[i]=0.0f;
+    m_d[i]=1.0e30f;
+  }
+}
+
+Frustum::Result Frustum::classifyScalar(const AABB &_box) const
+{
+  Vec3 c=_box.centre();
+  Vec3 e=_box.extents();
+  Result result=INSIDE;
+  for(int i=0; i<NUM_PLANES; ++i)
+  {
+    float dist=m_nx[i]*c.m_x+m_ny[i]*c.m_y+m_nz[i]*c.m_z+m_d[i];
+    // projected radius of the box onto the plane normal
+    float r=std::fabs(m_nx[i])*e.m_x+std::fabs(m_ny[i])*e.m_y+std::fabs(m_nz[i])*e.m_z;
+    if(dist<-r)
+    {
+      return OUTSIDE;
+    }
+    if(dist<r)
+    {
+      result=INTERSECTS;
+    }
+  }
+  return result;
+}
+
+Frustum::Result Frustum::classify(const AABB &_box) const
+{
+#if defined(__SSE2__)
+  Vec3 c=_box.centre();
+  Vec3 e=_box.extents();
+  const __m128 cx=_mm_set1_ps(c.m_x);
+  const __m128 cy=_mm_set1_ps(c.m_y);
+  const __m128 cz=_mm_set1_ps(c.m_z);
+  const __m128 ex=_mm_set1_ps(e.m_x);
+  const __m128 ey=_mm_set1_ps(e.m_y);
+  const __m128 ez=_mm_set1_ps(e.m_z);
+  const __m128 absMask=_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  int outside=0;
+  int intersects=0;
+  for(int i=0; i<PADDED_PLANES; i+=4)
+  {
+    __m128 nx=_mm_load_ps(m_nx+i);
+    __m128 ny=_mm_load_ps(m_ny+i);
+    __m128 nz=_mm_load_ps(m_nz+i);
+    __m128 dist=_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx,cx),_mm_mul_ps(ny,cy)),
+                           _mm_add_ps(_mm_mul_ps(nz,cz),_mm_load_ps(m_d+i)));
+    __m128 r=_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(nx,absMask),ex),_mm_mul_ps(_mm_and_ps(ny,absMask),ey)),
+                        _mm_mul_ps(_mm_and_ps(nz,absMask),ez));
+    __m128 negR=_mm_sub_ps(_mm_setzero_ps(),r);
+    outside|=_mm_movemask_ps(_mm_cmplt_ps(dist,negR));
+    intersects|=_mm_movemask_ps(_mm_cmplt_ps(dist,r));
+  }
+  if(outside)
+  {
+    return OUTSIDE;
+  }
+  return intersects ? INTERSECTS : INSIDE;
+#else
+  return classifyScalar(_box);
+#endif
+}
+
+} // end namespace fps
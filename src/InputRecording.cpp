@@ -0,0 +1,254 @@
+#include "InputRecording.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace fps
+{
+
+const uint32_t InputRecording::VERSION;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief start of every recording, the order the bytes come back in tells a foreign byte order apart
+//----------------------------------------------------------------------------------------------------------------------
+static const uint32_t MAGIC=0x49535046; // FPSI
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief tick flags, a turn and commands are rare enough to cost nothing when absent
+//----------------------------------------------------------------------------------------------------------------------
+static const uint8_t HAS_LOOK=1;
+static const uint8_t HAS_COMMANDS=2;
+
+template <typename T> void InputRecording::put(const T &_value)
+{
+  const uint8_t *bytes=reinterpret_cast<const uint8_t *>(&_value);
+  m_data.insert(m_data.end(),bytes,bytes+sizeof(T));
+}
+
+template <typename T> bool InputRecording::get(T &o_value)
+{
+  if(m_data.size()-m_cursor<sizeof(T))
+  {
+    return false;
+  }
+  std::memcpy(&o_value,&m_data[m_cursor],sizeof(T));
+  m_cursor+=sizeof(T);
+  return true;
+}
+
+void InputRecording::begin(double _dt, const CameraController::State &_camera)
+{
+  m_dt=_dt;
+  m_camera=_camera;
+  m_ticks=0;
+  m_steps=0;
+  m_data.clear();
+  m_cursor=0;
+}
+
+void InputRecording::add(const Tick &_tick)
+{
+  uint8_t held=0;
+  uint8_t pressed=0;
+  for(int i=0; i<NUM_INPUT_COMMANDS; ++i)
+  {
+    held|=static_cast<uint8_t>(_tick.m_input.m_held[i])<<i;
+    pressed|=static_cast<uint8_t>(_tick.m_input.m_presses[i]!=0)<<i;
+  }
+  put(static_cast<uint16_t>(_tick.m_steps));
+  put(held);
+  put(pressed);
+  for(int i=0; i<NUM_INPUT_COMMANDS; ++i)
+  {
+    if(_tick.m_input.m_presses[i]!=0)
+    {
+      put(static_cast<uint8_t>(std::min(_tick.m_input.m_presses[i],255)));
+    }
+  }
+  bool look=_tick.m_input.m_pitch!=0.0f || _tick.m_input.m_yaw!=0.0f;
+  size_t commands=std::min<size_t>(_tick.m_commands.size(),255);
+  put(static_cast<uint8_t>((look ? HAS_LOOK : 0) | (commands!=0 ? HAS_COMMANDS : 0)));
+  if(look)
+  {
+    put(_tick.m_input.m_pitch);
+    put(_tick.m_input.m_yaw);
+  }
+  if(commands!=0)
+  {
+    put(static_cast<uint8_t>(commands));
+    for(size_t i=0; i<commands; ++i)
+    {
+      put(_tick.m_commands[i].m_type);
+      put(_tick.m_commands[i].m_x);
+      put(_tick.m_commands[i].m_y);
+    }
+  }
+  ++m_ticks;
+  m_steps+=_tick.m_steps;
+}
+
+bool InputRecording::next(Tick &o_tick)
+{
+  uint16_t steps;
+  uint8_t held;
+  uint8_t pressed;
+  uint8_t flags;
+  size_t start=m_cursor;
+  if(!get(steps) || !get(held) || !get(pressed))
+  {
+    m_cursor=start;
+    return false;
+  }
+  o_tick.m_steps=steps;
+  InputState &input=o_tick.m_input;
+  for(int i=0; i<NUM_INPUT_COMMANDS; ++i)
+  {
+    uint8_t presses=0;
+    input.m_held[i]=(held>>i)&1;
+    if(((pressed>>i)&1) && !get(presses))
+    {
+      m_cursor=start;
+      return false;
+    }
+    input.m_presses[i]=presses;
+  }
+  input.m_pitch=0.0f;
+  input.m_yaw=0.0f;
+  input.m_samples=0;
+  input.m_motions=0;
+  o_tick.m_commands.clear();
+  bool ok=get(flags);
+  if(ok && (flags&HAS_LOOK))
+  {
+    ok=get(input.m_pitch) && get(input.m_yaw);
+    input.m_motions=1;
+  }
+  uint8_t commands=0;
+  if(ok && (flags&HAS_COMMANDS))
+  {
+    ok=get(commands);
+  }
+  for(uint8_t i=0; ok && i<commands; ++i)
+  {
+    Command command;
+    ok=get(command.m_type) && get(command.m_x) && get(command.m_y);
+    o_tick.m_commands.push_back(command);
+  }
+  if(!ok)
+  {
+    m_cursor=start;
+  }
+  return ok;
+}
+
+bool InputRecording::write(const std::string &_fname)
+{
+  std::unique_ptr<FILE,int(*)(FILE *)> file(std::fopen(_fname.c_str(),"wb"),&std::fclose);
+  if(!file)
+  {
+    m_error="unable to write "+_fname;
+    return false;
+  }
+  // the header goes through the same put as the ticks, then ahead of them
+  std::vector<uint8_t> ticks;
+  ticks.swap(m_data);
+  put(MAGIC);
+  put(VERSION);
+  put(m_dt);
+  put(m_ticks);
+  put(m_steps);
+  const CameraController::State &c=m_camera;
+  const float camera[]={c.m_position.m_x,c.m_position.m_y,c.m_position.m_z,
+                        c.m_prevPosition.m_x,c.m_prevPosition.m_y,c.m_prevPosition.m_z,c.m_pitch,c.m_yaw,
+                        c.m_physics.velocity.m_x,c.m_physics.velocity.m_y,c.m_physics.velocity.m_z,
+                        c.m_physics.force.m_x,c.m_physics.force.m_y,c.m_physics.force.m_z,c.m_physics.mass,
+                        c.m_physics.restitution,c.m_physics.frictionImpulse,c.m_physics.jumpSpeed};
+  put(camera);
+  uint8_t actions=0;
+  for(int i=0; i<CameraController::NUM_ACTIONS; ++i)
+  {
+    actions|=static_cast<uint8_t>(c.m_actions[i])<<i;
+  }
+  put(static_cast<uint8_t>(c.m_grounded));
+  put(actions);
+  bool written=std::fwrite(m_data.data(),1,m_data.size(),file.get())==m_data.size() &&
+               std::fwrite(ticks.data(),1,ticks.size(),file.get())==ticks.size();
+  m_data.swap(ticks);
+  if(!written)
+  {
+    m_error="unable to write "+_fname;
+  }
+  return written;
+}
+
+bool InputRecording::read(const std::string &_fname)
+{
+  std::unique_ptr<FILE,int(*)(FILE *)> file(std::fopen(_fname.c_str(),"rb"),&std::fclose);
+  if(!file)
+  {
+    m_error="unable to read "+_fname;
+    return false;
+  }
+  m_data.clear();
+  uint8_t buffer[65536];
+  size_t read;
+  while((read=std::fread(buffer,1,sizeof(buffer),file.get()))!=0)
+  {
+    m_data.insert(m_data.end(),buffer,buffer+read);
+  }
+  m_cursor=0;
+  uint32_t magic=0;
+  uint32_t version=0;
+  float camera[18];
+  uint8_t grounded=0;
+  uint8_t actions=0;
+  if(!get(magic) || magic!=MAGIC || !get(version) || version!=VERSION)
+  {
+    m_error=_fname+" is not an input recording of version "+std::to_string(VERSION)+" in this byte order";
+    m_data.clear();
+    return false;
+  }
+  if(!get(m_dt) || !get(m_ticks) || !get(m_steps) || !get(camera) || !get(grounded) || !get(actions) || m_dt<=0.0)
+  {
+    m_error=_fname+" has a truncated header";
+    m_data.clear();
+    return false;
+  }
+  CameraController::State &c=m_camera;
+  c.m_position=Vec3(camera[0],camera[1],camera[2]);
+  c.m_prevPosition=Vec3(camera[3],camera[4],camera[5]);
+  c.m_pitch=camera[6];
+  c.m_yaw=camera[7];
+  c.m_physics.velocity=Vec3(camera[8],camera[9],camera[10]);
+  c.m_physics.force=Vec3(camera[11],camera[12],camera[13]);
+  c.m_physics.mass=camera[14];
+  c.m_physics.restitution=camera[15];
+  c.m_physics.frictionImpulse=camera[16];
+  c.m_physics.jumpSpeed=camera[17];
+  c.m_grounded=grounded!=0;
+  for(int i=0; i<CameraController::NUM_ACTIONS; ++i)
+  {
+    c.m_actions[i]=(actions>>i)&1;
+  }
+  m_data.erase(m_data.begin(),m_data.begin()+m_cursor);
+
+  // walk the ticks once so a cut off file fails here and not half way through a replay
+  Tick tick;
+  uint64_t ticks=0;
+  uint64_t steps=0;
+  m_cursor=0;
+  while(next(tick))
+  {
+    ++ticks;
+    steps+=tick.m_steps;
+  }
+  bool whole=m_cursor==m_data.size() && ticks==m_ticks && steps==m_steps;
+  m_cursor=0;
+  if(!whole)
+  {
+    m_error=_fname+" is truncated after "+std::to_string(ticks)+" of "+std::to_string(m_ticks)+" ticks";
+  }
+  return whole;
+}
+
+} // end namespace fps
@@ -0,0 +1,111 @@
+#include "InputSystem.h"
+#include <algorithm>
+
+namespace fps
+{
+
+void InputBindings::bind(InputSample::Type _type, int _code, InputCommand _command)
+{
+  for(Binding &binding : m_bindings)
+  {
+    if(binding.m_type==_type && binding.m_code==_code)
+    {
+      binding.m_command=_command;
+      return;
+    }
+  }
+  m_bindings.push_back(Binding{_type,static_cast<int32_t>(_code),_command});
+}
+
+int InputBindings::command(const InputSample &_sample) const
+{
+  // a handful of bindings, a scan beats any map
+  for(const Binding &binding : m_bindings)
+  {
+    if(binding.m_type==_sample.m_type && binding.m_code==_sample.m_code)
+    {
+      return binding.m_command;
+    }
+  }
+  return -1;
+}
+
+InputSystem::InputSystem(size_t _capacity) :
+  m_queue(_capacity)
+{
+  std::fill(m_state.m_held,m_state.m_held+NUM_INPUT_COMMANDS,false);
+  beginTick();
+}
+
+void InputSystem::beginTick()
+{
+  std::fill(m_state.m_presses,m_state.m_presses+NUM_INPUT_COMMANDS,0);
+  m_state.m_pitch=0.0f;
+  m_state.m_yaw=0.0f;
+  m_state.m_samples=0;
+  m_state.m_motions=0;
+}
+
+const InputState & InputSystem::collect(double _until, std::vector<InputSample> *o_samples)
+{
+  beginTick();
+  // samples stamped after the tick began wait for the next one, so a tick only sees what came before it
+  const InputSample *sample;
+  while((sample=m_queue.peek())!=nullptr && sample->m_time<=_until)
+  {
+    apply(*sample);
+    if(o_samples!=nullptr)
+    {
+      o_samples->push_back(*sample);
+    }
+    m_queue.pop();
+  }
+  return m_state;
+}
+
+void InputSystem::apply(const InputSample &_sample)
+{
+  ++m_state.m_samples;
+  if(_sample.m_type==InputSample::MOTION)
+  {
+    if(m_state.m_held[INPUT_LOOK])
+    {
+      float pitch=_sample.m_dy*m_bindings.m_lookDegreesPerPixel;
+      m_state.m_pitch+= m_bindings.m_invertY ? -pitch : pitch;
+      m_state.m_yaw+=_sample.m_dx*m_bindings.m_lookDegreesPerPixel;
+      ++m_state.m_motions;
+    }
+    return;
+  }
+  int command=m_bindings.command(_sample);
+  if(command<0)
+  {
+    return;
+  }
+  std::vector<InputSample>::iterator down=std::find_if(m_down.begin(),m_down.end(),
+    [&_sample](const InputSample &_other){ return _other.m_type==_sample.m_type && _other.m_code==_sample.m_code; });
+  if(_sample.m_pressed && down==m_down.end())
+  {
+    m_down.push_back(_sample);
+    ++m_state.m_presses[command];
+  }
+  else if(!_sample.m_pressed && down!=m_down.end())
+  {
+    m_down.erase(down);
+  }
+  else
+  {
+    // a repeat or a release whose press was never seen
+    return;
+  }
+  m_state.m_held[command]=std::any_of(m_down.begin(),m_down.end(),
+    [this,command](const InputSample &_other){ return m_bindings.command(_other)==command; });
+}
+
+void InputSystem::releaseAll()
+{
+  m_down.clear();
+  std::fill(m_state.m_held,m_state.m_held+NUM_INPUT_COMMANDS,false);
+}
+
+} // end namespace fps
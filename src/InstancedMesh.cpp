@@ -0,0 +1,85 @@
+#include "InstancedMesh.h"
+#include "Log.h"
+#include <ngl/VAOPrimitives.h>
+#include <algorithm>
+
+InstancedMesh::InstancedMesh(const std::string &_primitive) :
+  m_primitive(_primitive),
+  m_vao(nullptr),
+  m_instanceBuffer(0),
+  m_count(0),
+  m_capacity(0)
+{
+}
+
+void InstancedMesh::initialize()
+{
+  m_vao=ngl::VAOPrimitives::instance()->getVAOFromName(m_primitive);
+  if(m_vao==nullptr)
+  {
+    FPS_LOG_ERROR("no primitive called %s",m_primitive.c_str());
+    return;
+  }
+  glGenBuffers(1,&m_instanceBuffer);
+  // the VAO keeps the attributes enabled with a divisor of one, which buffer they read is set per draw
+  m_vao->bind();
+  glBindBuffer(GL_ARRAY_BUFFER,m_instanceBuffer);
+  for(GLuint i=0; i<4; ++i)
+  {
+    glEnableVertexAttribArray(MODEL_ATTRIBUTE+i);
+    glVertexAttribDivisor(MODEL_ATTRIBUTE+i,1);
+  }
+  attachInstances();
+  m_vao->unbind();
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+void InstancedMesh::attachInstances() const
+{
+  glBindBuffer(GL_ARRAY_BUFFER,m_instanceBuffer);
+  for(GLuint i=0; i<4; ++i)
+  {
+    glVertexAttribPointer(MODEL_ATTRIBUTE+i,4,GL_FLOAT,GL_FALSE,sizeof(ngl::Mat4),
+                          reinterpret_cast<const GLvoid *>(i*4*sizeof(GLfloat)));
+  }
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+void InstancedMesh::release()
+{
+  glDeleteBuffers(1,&m_instanceBuffer);
+  m_instanceBuffer=0;
+  m_capacity=0;
+}
+
+void InstancedMesh::setTransforms(const float *_matrices, size_t _count)
+{
+  m_count=_count;
+  if(m_instanceBuffer==0 || _count==0)
+  {
+    return;
+  }
+  glBindBuffer(GL_ARRAY_BUFFER,m_instanceBuffer);
+  if(_count>m_capacity)
+  {
+    m_capacity=std::max(_count,m_capacity+m_capacity/2);
+    glBufferData(GL_ARRAY_BUFFER,m_capacity*sizeof(ngl::Mat4),nullptr,GL_DYNAMIC_DRAW);
+  }
+  // ngl::Mat4 is 16 contiguous floats with the translation in the last row, which GL reads as the
+  // last column of the mat4 attribute, the same layout setShaderParamFromMat4 uploads
+  glBufferSubData(GL_ARRAY_BUFFER,0,_count*sizeof(ngl::Mat4),_matrices);
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+void InstancedMesh::draw() const
+{
+  if(m_vao==nullptr || m_count==0)
+  {
+    return;
+  }
+  m_vao->bind();
+  // batches of the same primitive with different materials share its VAO, so point it at our matrices
+  attachInstances();
+  glDrawArraysInstanced(m_vao->getMode(),0,m_vao->numIndices(),static_cast<GLsizei>(m_count));
+  m_vao->unbind();
+}
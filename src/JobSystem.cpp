@@ -0,0 +1,147 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace fps
+{
+
+JobSystem::JobSystem(size_t _threads) :
+  m_queued(0),
+  m_remaining(0),
+  m_quit(false)
+{
+  size_t threads=_threads!=0 ? _threads : std::max(1u,std::thread::hardware_concurrency());
+  for(size_t i=0; i<threads; ++i)
+  {
+    m_workers.emplace_back(new Worker);
+  }
+  // worker 0 is whoever calls parallelFor
+  for(size_t i=1; i<threads; ++i)
+  {
+    m_threads.emplace_back(&JobSystem::workerLoop,this,i);
+  }
+}
+
+JobSystem::~JobSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_quit=true;
+  }
+  m_wake.notify_all();
+  for(std::thread &t : m_threads)
+  {
+    t.join();
+  }
+}
+
+void JobSystem::parallelFor(size_t _count, size_t _grain, const RangeFunction &_function)
+{
+  size_t grain=std::max<size_t>(_grain,1);
+  size_t jobs=(_count+grain-1)/grain;
+  if(jobs<=1 || m_workers.size()==1)
+  {
+    // nothing to share, the same ranges are run in order on this thread
+    for(size_t begin=0; begin<_count; begin+=grain)
+    {
+      _function(begin,std::min(begin+grain,_count));
+    }
+    return;
+  }
+  m_remaining.store(jobs,std::memory_order_relaxed);
+  // deal the ranges out round robin so every worker starts with a share, stealing evens out the rest
+  for(size_t k=0; k<jobs; ++k)
+  {
+    Worker &worker=*m_workers[k%m_workers.size()];
+    std::lock_guard<std::mutex> lock(worker.m_mutex);
+    worker.m_jobs.push_back(Job{&_function,k*grain,std::min((k+1)*grain,_count)});
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_queued.fetch_add(jobs,std::memory_order_release);
+  }
+  m_wake.notify_all();
+
+  Job job;
+  while(m_remaining.load(std::memory_order_acquire)!=0)
+  {
+    if(find(0,job))
+    {
+      run(job);
+    }
+    else
+    {
+      // the last jobs are running elsewhere
+      std::this_thread::yield();
+    }
+  }
+}
+
+bool JobSystem::pop(size_t _worker, Job &o_job)
+{
+  Worker &worker=*m_workers[_worker];
+  std::lock_guard<std::mutex> lock(worker.m_mutex);
+  if(worker.m_jobs.empty())
+  {
+    return false;
+  }
+  o_job=worker.m_jobs.back();
+  worker.m_jobs.pop_back();
+  return true;
+}
+
+bool JobSystem::steal(size_t _thief, Job &o_job)
+{
+  for(size_t i=1; i<m_workers.size(); ++i)
+  {
+    Worker &victim=*m_workers[(_thief+i)%m_workers.size()];
+    std::lock_guard<std::mutex> lock(victim.m_mutex);
+    if(!victim.m_jobs.empty())
+    {
+      o_job=victim.m_jobs.front();
+      victim.m_jobs.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool JobSystem::find(size_t _worker, Job &o_job)
+{
+  if(m_queued.load(std::memory_order_acquire)==0)
+  {
+    return false;
+  }
+  if(pop(_worker,o_job) || steal(_worker,o_job))
+  {
+    m_queued.fetch_sub(1,std::memory_order_acq_rel);
+    return true;
+  }
+  return false;
+}
+
+void JobSystem::run(const Job &_job)
+{
+  (*_job.m_function)(_job.m_begin,_job.m_end);
+  m_remaining.fetch_sub(1,std::memory_order_acq_rel);
+}
+
+void JobSystem::workerLoop(size_t _worker)
+{
+  Job job;
+  for(;;)
+  {
+    if(find(_worker,job))
+    {
+      run(job);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_wake.wait(lock,[this]{ return m_quit || m_queued.load(std::memory_order_acquire)!=0; });
+    if(m_quit)
+    {
+      return;
+    }
+  }
+}
+
+} // end namespace fps
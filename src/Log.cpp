@@ -0,0 +1,90 @@
+#include "Log.h"
+#include <chrono>
+#include <cstdarg>
+
+namespace fps
+{
+
+const size_t Log::MAX_MESSAGE;
+
+static double secondsSinceStart()
+{
+  static const std::chrono::steady_clock::time_point s_start=std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-s_start).count();
+}
+
+Log & Log::instance()
+{
+  static Log s_log;
+  return s_log;
+}
+
+Log::Log() :
+  m_queue(4096),
+  m_level(FPS_LOG_LEVEL),
+  m_output(stdout),
+  m_dropped(0),
+  m_running(true)
+{
+  secondsSinceStart();
+  m_writer=std::thread(&Log::run,this);
+}
+
+Log::~Log()
+{
+  m_running.store(false,std::memory_order_release);
+  m_writer.join();
+  uint64_t dropped=m_dropped.load();
+  if(dropped!=0)
+  {
+    fprintf(m_output.load(),"log : %llu messages dropped\n",static_cast<unsigned long long>(dropped));
+  }
+}
+
+void Log::write(Level _level, const char *_fmt, ...)
+{
+  Message *m=m_queue.prepare();
+  if(m==nullptr)
+  {
+    m_dropped.fetch_add(1,std::memory_order_relaxed);
+    return;
+  }
+  m->level=_level;
+  m->seconds=secondsSinceStart();
+  va_list args;
+  va_start(args,_fmt);
+  vsnprintf(m->text,MAX_MESSAGE,_fmt,args);
+  va_end(args);
+  m_queue.commit();
+}
+
+void Log::drain()
+{
+  static const char *names[]={"TRACE","DEBUG","INFO ","WARN ","ERROR"};
+  FILE *out=m_output.load(std::memory_order_relaxed);
+  bool wrote=false;
+  while(Message *m=m_queue.peek())
+  {
+    fprintf(out,"[%10.4f] %s %s\n",m->seconds,names[m->level],m->text);
+    m_queue.pop();
+    wrote=true;
+  }
+  // one flush per batch rather than per line
+  if(wrote)
+  {
+    fflush(out);
+  }
+}
+
+void Log::run()
+{
+  while(m_running.load(std::memory_order_acquire))
+  {
+    drain();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  // pick up anything queued while we were shutting down
+  drain();
+}
+
+} // end namespace fps
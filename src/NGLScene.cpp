@@ -9,204 +9,191 @@
 #include <ngl/VAOPrimitives.h>
 #include <ngl/ShaderLib.h>
 #include <memory>
+#include <cstdlib>
+#include "Log.h"
+#include <algorithm>
+#include <map>
 
-#include <Magick++.h>
-#include <Magick++/Blob.h>
 
 
 //----------------------------------------------------------------------------------------------------------------------
-/// @brief the increment for x/y translation with mouse movement
+/// @brief fixed simulation step in seconds, the camera and physics are always advanced by exactly this amount
 //----------------------------------------------------------------------------------------------------------------------
-const static float INCREMENT=0.01f;
+const static double SIM_DT=1.0/120.0;
 //----------------------------------------------------------------------------------------------------------------------
-/// @brief the increment for the wheel zoom
+/// @brief FPS_SIM_HZ overrides the tick rate, the swept collisions keep low rates from tunnelling
 //----------------------------------------------------------------------------------------------------------------------
-const static float ZOOM=0.1f;
-
-struct data
-  {
-    ngl::Vec2 po;
-  };
+static double simDt()
+{
+  const char *hz=std::getenv("FPS_SIM_HZ");
+  double rate= hz!=nullptr ? std::atof(hz) : 0.0;
+  return rate>0.0 ? 1.0/rate : SIM_DT;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief upper bound on steps taken per pump so a long stall (debugger, window drag) can't spiral
+//----------------------------------------------------------------------------------------------------------------------
+const static int MAX_SIM_STEPS=16;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief size and launch speed of the debris thrown with B
+//----------------------------------------------------------------------------------------------------------------------
+const static float DEBRIS_RADIUS=0.25f;
+const static float DEBRIS_SPEED=10.0f;
 
 
-static std::unique_ptr<GLubyte> pixels = NULL;
-static const GLenum FORMAT = GL_RGBA;
-static const GLuint FORMAT_NBYTES = 4;
-//static  unsigned int HEIGHT = 500;
-//static  unsigned int WIDTH = 500;
 static unsigned int nscreenshots = 0;
 
 
-static void create_ppm(char *prefix, int frame_id, unsigned int width, unsigned int height,
-        unsigned int color_max, unsigned int pixel_nbytes, const std::unique_ptr<GLubyte> &pixels) {
-    size_t i, j, k, cur;
-    enum Constants { max_filename = 256 };
-    char filename[max_filename];
-    snprintf(filename, max_filename, "%s%d.ppm", prefix, frame_id);
-    FILE *f = fopen(filename, "w");
-    fprintf(f, "P3\n%d %d\n%d\n", width, height, 255);
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            cur = pixel_nbytes * ((height - i - 1) * width + j);
-            fprintf(f, "%3d %3d %3d ", pixels.get()[cur], pixels.get()[cur + 1], pixels.get()[cur + 2]);
-        }
-        fprintf(f, "\n");
-    }
-    fclose(f);
-}
-
-NGLScene::NGLScene()
+NGLScene::NGLScene() : m_sim(simDt(),MAX_SIM_STEPS)
 {
-  // re-size the widget to that of the parent (in that case the GLFrame passed in on construction)
-  m_rotate=false;
-  // mouse rotation values set to 0
-  m_spinXFace=0.0f;
-  m_spinYFace=0.0f;
   setTitle("Qt5 Simple NGL Demo");
 
-  cameraSpeed =0.05;
-
-  memset(keys, false, sizeof(keys)/sizeof(bool));
 
   //needed for properly handling saving screenshots while resizing (see resizeGL)
   m_width=0;
   m_height=0;
 
+  m_showStats=false;
+  m_raymarching=false;
+  m_replayingInput=false;
+  m_offscreen=false;
+  m_offscreenFBO=0;
+  m_replayFirstFrame=0;
+  m_replayStart=0.0;
+  m_loggedDebris=0;
+  m_gpuQueryFrame=0;
+  m_modelLocation=-1;
+  m_instancedLocation=-1;
+  std::fill(m_materialLocations,m_materialLocations+NUM_MATERIAL_UNIFORMS,-1);
+  m_mouseX=0;
+  m_mouseY=0;
+  // WASD moves, space jumps, B throws debris and dragging with the left button looks around
+  fps::InputBindings &bindings=m_sim.input().bindings();
+  bindings.bindKey(Qt::Key_W,fps::INPUT_FORWARD);
+  bindings.bindKey(Qt::Key_S,fps::INPUT_BACK);
+  bindings.bindKey(Qt::Key_A,fps::INPUT_LEFT);
+  bindings.bindKey(Qt::Key_D,fps::INPUT_RIGHT);
+  bindings.bindKey(Qt::Key_Space,fps::INPUT_JUMP);
+  bindings.bindKey(Qt::Key_B,fps::INPUT_SPAWN_DEBRIS);
+  bindings.bindButton(Qt::LeftButton,fps::INPUT_LOOK);
+  m_sim.m_debrisRadius=DEBRIS_RADIUS;
+  m_sim.m_debrisSpeed=DEBRIS_SPEED;
+  // FPS_RAYMARCH_MS sets the GPU time the raymarched frames are scaled to fit
+  const char *raymarchMs=std::getenv("FPS_RAYMARCH_MS");
+  if(raymarchMs!=nullptr && std::atof(raymarchMs)>0.0)
+  {
+    m_resolution.settings().m_targetMs=static_cast<float>(std::atof(raymarchMs));
+  }
+  // FPS_TRACE=file.json records every timed scope and writes a Chrome trace when we exit
+  const char *trace=std::getenv("FPS_TRACE");
+  if(trace!=nullptr && *trace!='\0')
+  {
+    m_traceFile=trace;
+    m_profiler.enableTrace();
+  }
+
 }
 
 
 NGLScene::~NGLScene()
 {
-  m_vao->removeVOA();
-  std::cout<<"Shutting down NGL, removing VAO's and Shaders\n";
-}
-
-
-
-
-static bool SphereToPlane(const ngl::Vec3& centerObjPos, const ngl::Vec3& planePoint, const ngl::Vec3& planePointNormal)
+  // the publish callback points at us, the simulation must not tick past this point
+  m_sim.stop();
+  if(!m_inputRecordFile.empty())
+  {
+    if(m_inputRecording.write(m_inputRecordFile))
     {
-        //Calculate a vector from the point on the plane to the center of the sphere
-        ngl::Vec3 vecTemp(centerObjPos - planePoint);
-
-        //Calculate the distance: dot product of the new vector with the plane's normal
-        float fDist= vecTemp.dot(planePointNormal);
-
-        float radius=1;
-        if(fDist > radius)
-        {
-            //The sphere is not touching the plane
-            return false;
-        }
-
-        //Else, the sphere is colliding with the plane
-        return true;
+      FPS_LOG_INFO("input of %llu ticks (%.1f s) written to %s, %zu bytes",
+                   static_cast<unsigned long long>(m_inputRecording.tickCount()),m_inputRecording.seconds(),
+                   m_inputRecordFile.c_str(),m_inputRecording.bytes());
     }
-
-
-#define MAX(x,y) (((x) < (y)) ? (y) : (x))
-
-static float j=0;
-ngl::Vec3 NGLScene::calculateCoulombFriction(ngl::Vec3 & velocity)
-{
-  /*
-    jt is the magnitude of the friction impulse (pre-cone limit)
-    u is the coefficient of friction [0,1]
-    t in the tangent vector in the direction of sliding
-    v is the the go stone velocity at the contact point
-    r is the contact point minus the center of the go stone
-    I is the inertia tensor of the go stone
-    m is the mass of the go stone
-  */
-//    ngl::Vec3 u(1,0,0);
-//    float m=1;
-
-//    jt= -velocity
-
-//    float d = velocity.dot (normal);
-//    float mag= - ( 1 + e ) * d;
-//    float j = MAX( mag, 0.0 );
-
-    j+=0.1;
-    velocity += -j* ngl::Vec3(0,1,0);
-
-    velocity.m_y= MAX(velocity.m_y,0.0);
-
-    //Stabilized, reset so as to let player press Jump-space again
-    if (velocity.m_y==0)
+    else
     {
-        keys[4]=false;
-        velocity.set(0,-10,0);
-        j=0;
+      FPS_LOG_ERROR("%s",m_inputRecording.error().c_str());
     }
-
-    return velocity;
+  }
+  for(ngl::VertexArrayObject *vao : m_meshVAOs)
+  {
+    if(vao!=nullptr)
+    {
+      vao->removeVOA();
+    }
+  }
+  glDeleteQueries(NUM_GPU_QUERIES,m_gpuQueries);
+  toggleRecording(false);
+  m_capture.release();
+  for(DrawBatch &batch : m_batches)
+  {
+    batch.m_instances->release();
+  }
+  if(m_debrisMesh)
+  {
+    m_debrisMesh->release();
+  }
+  m_raymarch.release();
+  m_cameraUBO.release();
+  if(!m_traceFile.empty() && !m_profiler.writeChromeTrace(m_traceFile))
+  {
+    FPS_LOG_ERROR("unable to write trace %s",m_traceFile.c_str());
+  }
+  FPS_LOG_INFO("Shutting down NGL, removing VAO's and Shaders");
 }
 
 
 
-float dt = 0.1;
 
-ngl::Vec3 velocity(0,0,0);
-ngl::Vec3 position = 0;
-ngl::Vec3 force(0,-9.8,0);
-float mass = 1;
-ngl::Vec3 groundNormal (0,1,0);
-
-float e=0.8; //when e=0 ->  collision is perfectly inelastic, when e=1 ->  collision is perfectly elastic;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief copy a core vector into an ngl one for rendering
+//----------------------------------------------------------------------------------------------------------------------
+static ngl::Vec3 toNGL(const fps::Vec3 &_v)
+{
+  return ngl::Vec3(_v.m_x,_v.m_y,_v.m_z);
+}
 
-ngl::Vec3 NGLScene::calculateCollisionResponse(const ngl::Vec3 & normal)
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief copy a core matrix into an ngl one, both use the same row vector layout
+//----------------------------------------------------------------------------------------------------------------------
+static ngl::Mat4 toNGL(const fps::Mat4 &_m)
 {
-    float d = velocity.dot (normal);
-    float mag= - ( 1 + e ) * d;
-    float j = MAX( mag, 0.0 );
-    velocity += j* normal;
-    return velocity;
+  ngl::Mat4 m;
+  for(int r=0; r<4; ++r)
+  {
+    for(int c=0; c<4; ++c)
+    {
+      m.m_m[r][c]=_m.m_m[r][c];
+    }
+  }
+  return m;
 }
 
 void NGLScene::resizeGL(QResizeEvent *_event)
 {
   // now set the camera size values as the screen size has changed
   m_cam.setShape(45.0f,(float)width()/height(),0.05f,350.0f);
-
-  //first time it runs
-  if (pixels==nullptr && m_width==0 && m_height==0)
+  if(m_text)
   {
-      m_width=_event->size().width()*devicePixelRatio();
-      m_height=_event->size().height()*devicePixelRatio();
-      pixels.reset(new GLubyte[FORMAT_NBYTES * m_width * m_height]);
+    m_text->setScreenSize(_event->size().width(),_event->size().height());
   }
-  else //delete and allocate properly sized memory to hold the new framebuffer
-  {
-      m_width=_event->size().width()*devicePixelRatio();
-      m_height=_event->size().height()*devicePixelRatio();
-      pixels.reset(new GLubyte[FORMAT_NBYTES * m_width * m_height]);
-
-  }
-
 
+  // capture memory is sized lazily by m_capture when a screenshot or recording needs it
+  m_width=_event->size().width()*devicePixelRatio();
+  m_height=_event->size().height()*devicePixelRatio();
+  post(fps::Simulation::Command::viewport(m_width,m_height));
 }
 
 void NGLScene::resizeGL(int _w , int _h)
 {
   m_cam.setShape(45.0f,(float)_w/_h,0.05f,350.0f);
-
-  // now set the camera size values as the screen size has changed
-  if (pixels==nullptr && m_width==0 && m_height==0)
-  {
-      m_width=_w*devicePixelRatio();
-      m_height=_h*devicePixelRatio();
-      pixels.reset(new GLubyte[FORMAT_NBYTES * m_width * m_height]);
-  }
-  else //delete and allocate properly sized memory to hold the new framebuffer
+  if(m_text)
   {
-      m_width=_w*devicePixelRatio();
-      m_height=_h*devicePixelRatio();
-      pixels.reset(new GLubyte[FORMAT_NBYTES * m_width * m_height]);
-
+    m_text->setScreenSize(_w,_h);
   }
 
-
+  // capture memory is sized lazily by m_capture when a screenshot or recording needs it, an offscreen
+  // target is already in pixels
+  double ratio= m_offscreen ? 1.0 : devicePixelRatio();
+  m_width=static_cast<int>(_w*ratio);
+  m_height=static_cast<int>(_h*ratio);
+  post(fps::Simulation::Command::viewport(m_width,m_height));
 }
 
 void NGLScene::initializeGL()
@@ -263,7 +250,17 @@ void NGLScene::initializeGL()
   // set the shape using FOV 45 Aspect Ratio based on Width and Height
   // The final two are near and far clipping planes of 0.5 and 10
   m_cam.setShape(45.0f,(float)720.0/576.0f,0.05f,350.0f);
-  shader->setUniform("viewerPos",m_cam.getEye().toVec3());
+  // the eye position now comes from the Camera uniform block, filled every frame in updateViewProjection
+  GLuint phongID=shader->getProgramID("Phong");
+  m_cameraUBO.initialize();
+  m_cameraUBO.attach(phongID);
+  // look the per draw uniforms up once rather than by name on every draw
+  m_modelLocation=glGetUniformLocation(phongID,"M");
+  m_instancedLocation=glGetUniformLocation(phongID,"instanced");
+  m_materialLocations[MAT_AMBIENT]=glGetUniformLocation(phongID,"material.ambient");
+  m_materialLocations[MAT_DIFFUSE]=glGetUniformLocation(phongID,"material.diffuse");
+  m_materialLocations[MAT_SPECULAR]=glGetUniformLocation(phongID,"material.specular");
+  m_materialLocations[MAT_SHININESS]=glGetUniformLocation(phongID,"material.shininess");
   // now create our light that is done after the camera so we can pass the
   // transpose of the projection matrix to the light to do correct eye space
   // transformations
@@ -277,96 +274,287 @@ void NGLScene::initializeGL()
   // set the viewport for openGL we need to take into account retina display
 
 
-  //create a line VAO
-  buildVAO();  
 
-  startTimer(10);
+  m_sim.controller().reset(fps::Vec3(0,5,15));
+  m_renderCameraPos=toNGL(m_sim.controller().position());
+  currentCameraUp=toNGL(m_sim.controller().up());
+  currentCameraFront=toNGL(m_sim.controller().front());
 
-  currentCameraPos.set(0,5,15);
-  prevCameraPos=currentCameraPos;
-  currentCameraUp.set(0,1,0);
-  currentCameraFront.set(0,0,-1);
 
+  //glReadPixels will read from back buffer, an offscreen target has none
+  if(!m_offscreen)
+  {
+    glReadBuffer(GL_BACK);
+  }
 
-  //glReadPixels will read from back buffer
-  glReadBuffer(GL_BACK);
-
+  m_text.reset(new ngl::Text(QFont("Arial",12)));
+  m_text->setScreenSize(width(),height());
+  m_text->setColour(1.0f,1.0f,0.0f);
+  glGenQueries(NUM_GPU_QUERIES,m_gpuQueries);
+  m_capture.initialize();
+  m_capture.setRecorder(&m_recorder);
+  m_raymarch.initialize(m_cameraUBO);
+
+  // the objects, their meshes and materials come from the scene file
+  loadScene();
+  ngl::VAOPrimitives::instance()->createSphere("debris",DEBRIS_RADIUS,16);
+  m_debrisMesh.reset(new InstancedMesh("debris"));
+  m_debrisMesh->initialize();
+
+  // offscreen runs tick the simulation themselves, one tick a frame
+  if(m_offscreen)
+  {
+    return;
+  }
+  // the simulation ticks on its own thread at SIM_DT or FPS_SIM_HZ and asks for a frame whenever it
+  // publishes something new, nothing is repainted while the scene is idle
+  m_sim.setPublishCallback([this]()
+  {
+    QMetaObject::invokeMethod(this,"update",Qt::QueuedConnection);
+  });
+  setupInputRecording();
+  m_sim.start();
 }
 
-static float rot=0.0f;
-void NGLScene::loadMatricesToShader()
+void NGLScene::setOffscreenTarget(GLuint _fbo)
 {
-  updateCameraPos();  
-
-  ngl::ShaderLib *shader=ngl::ShaderLib::instance();
-
-  ngl::Mat4 MV;
-  ngl::Mat4 MVP;
-  ngl::Mat3 normalMatrix;
-  ngl::Mat4 M;
-
+  m_offscreen=true;
+  m_offscreenFBO=_fbo;
+  // GPU times of a software rasterizer would shrink the raymarched frames and change what is measured
+  fps::DynamicResolution::Settings &settings=m_resolution.settings();
+  settings.m_minScale=settings.m_maxScale;
+  m_resolution.reset();
+}
 
-  //camera stuff
-  radius=2;
-  toradians=M_PI/180.0f;
-  _x = radius * sin( rot*toradians);
-  _z = radius * cos( rot*toradians);
-//  currentCameraorigin.set(0,0,0);
-//  currentCameraUp.set(0,1,0);
-//  currentCameraFront.set(0,0,-1);
-//  currentCameraPos.set(ngl::Vec3( 2*_x, 2, 2*_z ));
-//  viewMatrix=ngl::lookAt(currentCameraPos, currentCameraorigin, currentCameraUp );
+void NGLScene::setupInputRecording()
+{
+  // FPS_INPUT_REPLAY=file flies a recorded session again, in real time unless FPS_REPLAY_FAST is set, when
+  // every tick is drawn once as fast as frames go so two builds can be timed on the same workload
+  const char *replay=std::getenv("FPS_INPUT_REPLAY");
+  if(replay!=nullptr && *replay!='\0')
+  {
+    const char *fast=std::getenv("FPS_REPLAY_FAST");
+    if(!m_inputRecording.read(replay))
+    {
+      FPS_LOG_ERROR("%s",m_inputRecording.error().c_str());
+    }
+    else if(m_sim.replay(&m_inputRecording,fast==nullptr || *fast=='\0' || *fast=='0'))
+    {
+      m_replayingInput=true;
+      m_replayFirstFrame=m_profiler.frameCount();
+      m_replayStart=fps::Simulation::now();
+      FPS_LOG_INFO("replaying %llu ticks (%.1f s) from %s",
+                   static_cast<unsigned long long>(m_inputRecording.tickCount()),m_inputRecording.seconds(),replay);
+    }
+    return;
+  }
+  // FPS_INPUT_RECORD=file records the input of every tick from here and writes it when we exit
+  const char *record=std::getenv("FPS_INPUT_RECORD");
+  if(record!=nullptr && *record!='\0')
+  {
+    m_inputRecordFile=record;
+    m_sim.record(&m_inputRecording);
+  }
+}
 
+void NGLScene::finishReplay()
+{
+  m_replayingInput=false;
+  uint64_t frames=m_profiler.frameCount()-m_replayFirstFrame;
+  double seconds=fps::Simulation::now()-m_replayStart;
+  // the profiler keeps the last HISTORY frames, the end of the replay
+  std::array<fps::FrameProfiler::Stats,fps::FrameProfiler::NUM_STAGES> stats=m_profiler.stats();
+  const fps::FrameProfiler::Stats &frame=stats[fps::FrameProfiler::FRAME];
+  const fps::FrameProfiler::Stats &gpu=stats[fps::FrameProfiler::GPU];
+  FPS_LOG_INFO("replay drew %llu frames in %.3f s, frame min/avg/p99 %.3f/%.3f/%.3f ms gpu %.3f/%.3f/%.3f ms",
+               static_cast<unsigned long long>(frames),seconds,frame.min,frame.avg,frame.p99,gpu.min,gpu.avg,gpu.p99);
+  const char *quit=std::getenv("FPS_REPLAY_EXIT");
+  if(quit!=nullptr && *quit!='\0' && *quit!='0')
+  {
+    QGuiApplication::exit(EXIT_SUCCESS);
+  }
+}
 
-  //update front vector, calculated from m_mouseGlobalTX (based on rotX, rotY mouse spining )
-  currentCameraFront=m_mouseGlobalTX.getForwardVector();
+float NGLScene::updateViewProjection(const fps::FrameSnapshot &_snapshot)
+{
+  // blend between the snapshot's last two steps, alpha is how far real time is into the step after it.
+  // Offscreen frames are drawn at the tick so they do not depend on how long the last one took
+  float alpha= _snapshot.m_dt>0.0 && !m_offscreen ?
+               static_cast<float>((fps::Simulation::now()-_snapshot.m_time)/_snapshot.m_dt) : 1.0f;
+  alpha=std::max(0.0f,std::min(1.0f,alpha));
+  m_renderCameraPos=toNGL(fps::lerp(_snapshot.m_previousEye,_snapshot.m_eye,alpha));
+  //front and up vectors, calculated by the controller from the mouse look
+  currentCameraFront=toNGL(_snapshot.m_front);
+  currentCameraUp=toNGL(_snapshot.m_up);
+
+  //calculate viewMatrix from the interpolated render position so motion is smooth between sim steps
+  viewMatrix=ngl::lookAt(m_renderCameraPos, m_renderCameraPos + currentCameraFront, currentCameraUp);
+  m_projection=toNGL(_snapshot.m_projection);
+
+  fps::ScopedTimer timer(m_profiler,fps::FrameProfiler::MATRIX_UPLOAD);
+  m_cameraUBO.update(viewMatrix,m_projection,m_renderCameraPos);
+  return alpha;
+}
 
-  //get current camera position matrix
-  M=m_transform.getMatrix();//*m_mouseGlobalTX;
+void NGLScene::loadScene()
+{
+  const char *fname=std::getenv("FPS_SCENE");
+  std::string scene= fname!=nullptr && *fname!='\0' ? fname : "scenes/default.scene";
+  QElapsedTimer timer;
+  timer.start();
+  if(!m_scene.open(scene))
+  {
+    FPS_LOG_ERROR("%s",m_scene.error().c_str());
+    return;
+  }
+  FPS_LOG_INFO("loaded %s (%s) %zu objects in %.3f ms",scene.c_str(),m_scene.mapped() ? "mapped" : "text",
+               m_scene.objectCount(),timer.nsecsElapsed()*1.0e-6);
 
-  //calculate viewMatrix based on currentCameraPos, currentCameraPos + currentCameraFront, and currentCameraUp
-  viewMatrix=ngl::lookAt(currentCameraPos, currentCameraPos + currentCameraFront, currentCameraUp);
+  // vertex meshes get a VAO straight from the mapped vertex array
+  const fps::SceneMesh *meshes=m_scene.meshes();
+  m_meshVAOs.assign(m_scene.meshCount(),nullptr);
+  for(size_t i=0; i<m_scene.meshCount(); ++i)
+  {
+    if(meshes[i].m_mode==fps::SceneMesh::PRIMITIVE || meshes[i].m_vertexCount==0)
+    {
+      continue;
+    }
+    ngl::VertexArrayObject *vao=ngl::VertexArrayObject::createVOA(meshes[i].m_mode==fps::SceneMesh::LINES ? GL_LINES : GL_TRIANGLES);
+    vao->bind();
+    vao->setData(meshes[i].m_vertexCount*sizeof(fps::SceneVertex),m_scene.vertices()[meshes[i].m_firstVertex].m_x,GL_STATIC_DRAW);
+    vao->setVertexAttributePointer(0,3,GL_FLOAT,0,0);
+    vao->setNumIndices(meshes[i].m_vertexCount);
+    vao->unbind();
+    m_meshVAOs[i]=vao;
+  }
 
-  ngl::Mat4 projectionMatrix=ngl::perspective(45.0f, 1024/768, 0.5f, 200.0f);
+  // the simulation places the objects and builds the culling tree and collision world from the same scene
+  m_sim.setScene(m_scene);
 
-  MV=  M*viewMatrix;//m_cam.getViewMatrix();
-  MVP= MV*projectionMatrix;//m_cam.getVPMatrix();
-  normalMatrix=MV;
-  normalMatrix.inverse();
-  shader->setShaderParamFromMat4("MV",MV);
-  shader->setShaderParamFromMat4("MVP",MVP);
-  shader->setShaderParamFromMat3("normalMatrix",normalMatrix);
-  shader->setShaderParamFromMat4("M",M);
+  // one instanced batch per primitive mesh and material pair
+  const fps::SceneObject *objects=m_scene.objects();
+  std::map<std::pair<uint32_t,uint32_t>,int> batchIndex;
+  std::vector<int> objectBatch(m_scene.objectCount(),-1);
+  for(size_t i=0; i<m_scene.objectCount(); ++i)
+  {
+    const fps::SceneObject &o=objects[i];
+    if(o.m_collider.m_type==fps::SceneCollider::SDF)
+    {
+      // the field is what the level looks like too, draw it with the raymarcher
+      m_raymarch.setPlacement(ngl::Vec3(o.m_position[0],o.m_position[1],o.m_position[2]),o.m_collider.m_params[0]);
+      toggleRaymarching(true);
+    }
+    if(meshes[o.m_mesh].m_mode!=fps::SceneMesh::PRIMITIVE)
+    {
+      continue;
+    }
+    std::pair<uint32_t,uint32_t> key(o.m_mesh,o.m_material);
+    if(!batchIndex.count(key))
+    {
+      batchIndex[key]=static_cast<int>(m_batches.size());
+      DrawBatch batch;
+      batch.m_material=o.m_material;
+      batch.m_instances.reset(new InstancedMesh(meshes[o.m_mesh].m_primitive));
+      batch.m_instances->initialize();
+      m_batches.push_back(std::move(batch));
+    }
+    objectBatch[i]=batchIndex[key];
+  }
+  m_sim.setObjectBatches(objectBatch,m_batches.size());
 }
 
-
-void NGLScene::buildVAO()
+void NGLScene::uploadInstances(const fps::FrameSnapshot &_snapshot)
 {
+  fps::ScopedTimer timer(m_profiler,fps::FrameProfiler::MATRIX_UPLOAD);
+  // the simulation already culled and gathered the visible model matrices, this is just the copy to the GPU
+  for(size_t i=0; i<m_batches.size() && i<_snapshot.m_batchTransforms.size(); ++i)
+  {
+    const std::vector<float> &visible=_snapshot.m_batchTransforms[i];
+    m_batches[i].m_instances->setTransforms(visible.data(),visible.size()/16);
+  }
+  if(m_debrisMesh)
+  {
+    m_debrisMesh->setTransforms(_snapshot.m_debrisTransforms.data(),_snapshot.m_debrisCount);
+  }
+}
 
-    std::vector <data> points;
-    data p;
-    p.po.m_x=-0.5;
-    p.po.m_y=-0.5;
-    points.push_back(p);
-
-    p.po.m_x=0.5;
-    p.po.m_y=1.0;
-    points.push_back(p);
-
-
-      m_vao = ngl::VertexArrayObject::createVOA(GL_LINES);
-      m_vao->bind();
-      m_vao->setData(sizeof(points),points[0].po.m_x,GL_STATIC_DRAW);
+void NGLScene::drawDebris(const fps::FrameSnapshot &_snapshot)
+{
+  if(_snapshot.m_debrisCount==0)
+  {
+    return;
+  }
+  if(m_scene.materialCount()!=0)
+  {
+    loadMaterial(0);
+  }
+  glUniform1i(m_instancedLocation,1);
+  m_debrisMesh->draw();
+  glUniform1i(m_instancedLocation,0);
+}
 
-      m_vao->setVertexAttributePointer(0,2,GL_FLOAT,0,0);
+void NGLScene::loadMaterial(uint32_t _material)
+{
+  const fps::SceneMaterial &m=m_scene.materials()[_material];
+  glUniform4fv(m_materialLocations[MAT_AMBIENT],1,m.m_ambient);
+  glUniform4fv(m_materialLocations[MAT_DIFFUSE],1,m.m_diffuse);
+  glUniform4fv(m_materialLocations[MAT_SPECULAR],1,m.m_specular);
+  glUniform1f(m_materialLocations[MAT_SHININESS],m.m_shininess);
+}
 
-      m_vao->setNumIndices(sizeof(points)/sizeof(ngl::Vec2));
-      m_vao->unbind();
+void NGLScene::drawScene(const fps::FrameSnapshot &_snapshot)
+{
+  fps::ScopedTimer timer(m_profiler,fps::FrameProfiler::DRAW);
+  // every primitive batch in one call each, the model matrices come from the instance buffers
+  glUniform1i(m_instancedLocation,1);
+  for(const DrawBatch &batch : m_batches)
+  {
+    if(batch.m_instances->instanceCount()!=0)
+    {
+      loadMaterial(batch.m_material);
+      batch.m_instances->draw();
+    }
+  }
+  glUniform1i(m_instancedLocation,0);
 
+  // vertex meshes are few, they are drawn one by one with the model matrix from the snapshot
+  const fps::SceneObject *objects=m_scene.objects();
+  for(size_t i=0; i<_snapshot.m_meshObjects.size(); ++i)
+  {
+    uint32_t index=_snapshot.m_meshObjects[i];
+    ngl::VertexArrayObject *vao=m_meshVAOs[objects[index].m_mesh];
+    if(vao!=nullptr)
+    {
+      loadMaterial(objects[index].m_material);
+      glUniformMatrix4fv(m_modelLocation,1,GL_FALSE,&_snapshot.m_meshTransforms[16*i]);
+      vao->bind();
+      vao->draw();
+      vao->unbind();
+    }
+  }
 }
 
 void NGLScene::paintGL()
 {
+  // collect the oldest GPU timing if it is ready, we never wait on it
+  GLuint query=m_gpuQueries[m_gpuQueryFrame%NUM_GPU_QUERIES];
+  if(m_gpuQueryFrame>=NUM_GPU_QUERIES)
+  {
+    GLint available=0;
+    glGetQueryObjectiv(query,GL_QUERY_RESULT_AVAILABLE,&available);
+    if(available)
+    {
+      GLuint64 ns=0;
+      glGetQueryObjectui64v(query,GL_QUERY_RESULT,&ns);
+      m_profiler.addMs(fps::FrameProfiler::GPU,ns*1.0e-6f);
+      if(m_raymarching)
+      {
+        m_resolution.addFrame(ns*1.0e-6f);
+      }
+    }
+  }
+  glBeginQuery(GL_TIME_ELAPSED,query);
+
   glViewport(0,0,m_width,m_height);
   // clear the screen and depth buffer
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -375,144 +563,163 @@ void NGLScene::paintGL()
   ngl::ShaderLib *shader=ngl::ShaderLib::instance();
   (*shader)["Phong"]->use();
 
-  // Rotation based on the mouse position for our global transform
-  ngl::Mat4 rotX;
-  ngl::Mat4 rotY;
-  // create the rotation matrices
-  if (m_spinXFace> 89.0f)
-      m_spinXFace= 89.0f;
-  if (m_spinXFace< -89.0f)
-      m_spinXFace= -89.0f;
-
-
-//  std::cout<<"m_spinXFace="<<m_spinXFace<<std::endl;
-  rotX.rotateX(m_spinXFace);
-  rotY.rotateY(m_spinYFace);
-  // multiply the rotations
-  m_mouseGlobalTX=rotY*rotX;
-  // add the translations
-  m_mouseGlobalTX.m_m[3][0] = m_modelPos.m_x;
-  m_mouseGlobalTX.m_m[3][1] = m_modelPos.m_y;
-  m_mouseGlobalTX.m_m[3][2] = m_modelPos.m_z;
-
-   // get the VBO instance and draw the built in teapot
-  ngl::VAOPrimitives *prim=ngl::VAOPrimitives::instance();
-  // draw
-
-
-
-      m_transform.reset();
-      m_transform.setPosition(-2,-3,0);
-      loadMatricesToShader();
-      prim->draw("teapot");
-      m_transform.setPosition(2,3,0);
-      loadMatricesToShader();
-      prim->draw("teapot");
-      m_transform.setPosition(-2,4,-5);
-      loadMatricesToShader();
-      prim->draw("teapot");
-      m_transform.setPosition(2,-5,5);
-      loadMatricesToShader();
-      prim->draw("teapot");
-
-    m_transform.reset();
-    loadMatricesToShader();
-    m_vao->bind();
-    m_vao->draw();
-    m_vao->unbind();
-
-
-}
+  // the newest tick the simulation published, it is never touched by the simulation while we draw it
+  // and frames in between ticks redraw the last one
+  if(m_sim.acquire())
+  {
+    m_profiler.addMs(fps::FrameProfiler::SIMULATION,m_sim.snapshot().m_simMs);
+    // the log is only written from this thread, so what the simulation did is reported from its snapshots
+    FPS_LOG_TRACE("velocity=%f",m_sim.snapshot().m_velocity);
+    if(m_sim.snapshot().m_debrisCount!=m_loggedDebris)
+    {
+      m_loggedDebris=m_sim.snapshot().m_debrisCount;
+      FPS_LOG_INFO("debris %zu bodies",m_loggedDebris);
+    }
+    // only the objects touching the frustum go into the instance buffers
+    uploadInstances(m_sim.snapshot());
+  }
+  const fps::FrameSnapshot &snapshot=m_sim.snapshot();
+  // the view and projection are the same for every object so only build them once a frame
+  float alpha=updateViewProjection(snapshot);
+  if(m_raymarching)
+  {
+    fps::ScopedTimer timer(m_profiler,fps::FrameProfiler::DRAW);
+    int renderWidth;
+    int renderHeight;
+    m_resolution.renderSize(m_width,m_height,renderWidth,renderHeight);
+    m_raymarch.draw(framebuffer(),m_width,m_height,renderWidth,renderHeight,m_renderCameraPos,
+                    currentCameraFront,currentCameraUp);
+    // debris is rasterized on top, hidden behind the marched surfaces by the depth they wrote
+    (*shader)["Phong"]->use();
+  }
+  else
+  {
+    drawScene(snapshot);
+  }
+  drawDebris(snapshot);
+  glEndQuery(GL_TIME_ELAPSED);
+  ++m_gpuQueryFrame;
 
-//----------------------------------------------------------------------------------------------------------------------
-void NGLScene::mouseMoveEvent (QMouseEvent * _event)
-{
-  // note the method buttons() is the button state when event was called
-  // that is different from button() which is used to check which button was
-  // pressed when the mousePress/Release event is generated
-  if(m_rotate && _event->buttons() == Qt::LeftButton)
-  {
-    int diffx=_event->x()-m_origX;
-    int diffy=_event->y()-m_origY;
-    m_spinXFace += (float) 0.2f * diffy;
-    m_spinYFace += (float) 0.2f * diffx;
-    m_origX = _event->x();
-    m_origY = _event->y();
-    update();
+  {
+    // only queues a copy into a PBO, finished captures are mapped a frame or two later
+    fps::ScopedTimer timer(m_profiler,fps::FrameProfiler::READBACK);
+    m_capture.endFrame(m_width,m_height);
+  }
 
+  if(m_showStats)
+  {
+    drawStats(snapshot);
+  }
+  m_profiler.endFrame();
+  if(m_replayingInput && !m_sim.replaying())
+  {
+    finishReplay();
   }
-        // right mouse translate code
-  else if(m_translate && _event->buttons() == Qt::RightButton)
+  // keep drawing until the camera has caught up with the last tick, the next tick asks for its own frame
+  if(alpha<1.0f)
   {
-    int diffX = (int)(_event->x() - m_origXPos);
-    int diffY = (int)(_event->y() - m_origYPos);
-    m_origXPos=_event->x();
-    m_origYPos=_event->y();
-    m_modelPos.m_x += INCREMENT * diffX;
-    m_modelPos.m_y -= INCREMENT * diffY;
     update();
-
-   }
+  }
 }
 
-
-//----------------------------------------------------------------------------------------------------------------------
-void NGLScene::mousePressEvent ( QMouseEvent * _event)
+void NGLScene::drawStats(const fps::FrameSnapshot &_snapshot)
 {
-  // that method is called when the mouse button is pressed in this case we
-  // store the value where the maouse was clicked (x,y) and set the Rotate flag to true
-  if(_event->button() == Qt::LeftButton)
+  std::array<fps::FrameProfiler::Stats,fps::FrameProfiler::NUM_STAGES> stats=m_profiler.stats();
+  m_text->renderText(10,18,"stage  min / avg / p99 ms");
+  for(int i=0; i<fps::FrameProfiler::NUM_STAGES; ++i)
   {
-    m_origX = _event->x();
-    m_origY = _event->y();
-    m_rotate =true;
+    fps::FrameProfiler::Stage stage=static_cast<fps::FrameProfiler::Stage>(i);
+    m_text->renderText(10,36+18*i,QString("%1  %2 / %3 / %4")
+                       .arg(fps::FrameProfiler::stageName(stage))
+                       .arg(stats[i].min,0,'f',3)
+                       .arg(stats[i].avg,0,'f',3)
+                       .arg(stats[i].p99,0,'f',3));
   }
-  // right mouse translate mode
-  else if(_event->button() == Qt::RightButton)
+  if(m_recorder.recording())
   {
-    m_origXPos = _event->x();
-    m_origYPos = _event->y();
-    m_translate=true;
+    fps::FrameRecorder::Stats rec=m_recorder.stats();
+    m_text->renderText(10,36+18*fps::FrameProfiler::NUM_STAGES,QString("REC %1 written %2 dropped")
+                       .arg(rec.written).arg(rec.dropped));
+  }
+  m_text->renderText(10,54+18*fps::FrameProfiler::NUM_STAGES,QString("visible %1 / %2")
+                     .arg(_snapshot.m_visibleCount).arg(_snapshot.m_objectCount));
+  m_text->renderText(10,72+18*fps::FrameProfiler::NUM_STAGES,QString("debris awake %1 / %2")
+                     .arg(_snapshot.m_debrisAwake).arg(_snapshot.m_debrisCount));
+  if(m_raymarching)
+  {
+    int renderWidth;
+    int renderHeight;
+    m_resolution.renderSize(m_width,m_height,renderWidth,renderHeight);
+    m_text->renderText(10,90+18*fps::FrameProfiler::NUM_STAGES,QString("raymarch %1x%2 (%3) %4 steps gpu %5 ms")
+                       .arg(renderWidth).arg(renderHeight).arg(m_resolution.scale(),0,'f',2)
+                       .arg(m_raymarch.settings().m_marchSteps).arg(m_resolution.averageMs(),0,'f',2));
   }
-
-
 }
 
-//----------------------------------------------------------------------------------------------------------------------
-void NGLScene::mouseReleaseEvent ( QMouseEvent * _event )
+void NGLScene::toggleRecording(bool _on)
 {
-  // that event is called when the mouse button is released
-  // we then set Rotate to false
-  if (_event->button() == Qt::LeftButton)
+  if(_on && !m_recorder.recording())
   {
-    m_rotate=false;
+    // FPS_RECORD_PIPE streams raw frames to an encoder, otherwise one PAM per frame
+    fps::FrameRecorder::Config config;
+    config.prefix="record";
+    const char *pipe=std::getenv("FPS_RECORD_PIPE");
+    if(pipe!=nullptr && *pipe!='\0')
+    {
+      config.format=fps::FrameRecorder::RAW;
+      config.pipeCommand=pipe;
+    }
+    m_recorder.start(config);
+    FPS_LOG_INFO("recording started");
   }
-        // right mouse translate mode
-  if (_event->button() == Qt::RightButton)
+  else if(!_on && m_recorder.recording())
   {
-    m_translate=false;
+    m_recorder.stop();
+    fps::FrameRecorder::Stats rec=m_recorder.stats();
+    FPS_LOG_INFO("recording stopped, %llu frames written %llu dropped %llu failed %llu MB",
+                 static_cast<unsigned long long>(rec.written),static_cast<unsigned long long>(rec.dropped),
+                 static_cast<unsigned long long>(rec.failed),static_cast<unsigned long long>(rec.bytes>>20));
   }
 }
 
+void NGLScene::toggleRaymarching(bool _on)
+{
+  // the frame times so far were of the other renderer, start over at full size
+  m_raymarching=_on;
+  m_resolution.reset();
+  FPS_LOG_INFO("raymarching %s",_on ? "on" : "off");
+}
+
 //----------------------------------------------------------------------------------------------------------------------
-void NGLScene::wheelEvent(QWheelEvent *_event)
+void NGLScene::mouseMoveEvent (QMouseEvent * _event)
 {
+  fps::ScopedTimer timer(m_profiler,fps::FrameProfiler::INPUT);
+  // only queued, however fast the mouse reports the next tick turns the camera once by the summed motion
+  // and its snapshot asks for the repaint
+  push(fps::InputSample::motion(static_cast<float>(_event->x()-m_mouseX),static_cast<float>(_event->y()-m_mouseY),
+                                fps::Simulation::now()));
+  m_mouseX=_event->x();
+  m_mouseY=_event->y();
+}
 
-	// check the diff of the wheel position (0 means no change)
-	if(_event->delta() > 0)
-	{
-		m_modelPos.m_z+=ZOOM;
-	}
-	else if(_event->delta() <0 )
-	{
-		m_modelPos.m_z-=ZOOM;
-	}
-	update();
+//----------------------------------------------------------------------------------------------------------------------
+void NGLScene::mousePressEvent ( QMouseEvent * _event)
+{
+  m_mouseX=_event->x();
+  m_mouseY=_event->y();
+  push(fps::InputSample::button(_event->button(),true,fps::Simulation::now()));
 }
+
 //----------------------------------------------------------------------------------------------------------------------
+void NGLScene::mouseReleaseEvent ( QMouseEvent * _event )
+{
+  push(fps::InputSample::button(_event->button(),false,fps::Simulation::now()));
+}
 
+//----------------------------------------------------------------------------------------------------------------------
 void NGLScene::keyPressEvent(QKeyEvent *_event)
 {
+  fps::ScopedTimer timer(m_profiler,fps::FrameProfiler::INPUT);
   // that method is called every time the main window recives a key event.
   // we then switch on the key value and set the camera in the GLWindow
   switch (_event->key())
@@ -527,227 +734,71 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
   case Qt::Key_F : showFullScreen(); break;
   // show windowed
   case Qt::Key_N : showNormal(); break;
-
-
-  case Qt::Key_W :
-  {
-      keys[0] = true;
-      std::cout<<"Up Pressed"<<std::endl;
-      break;
-  }
-  case Qt::Key_S:
-  {
-      keys[1] = true;
-      std::cout<<"Down Pressed"<<std::endl;
-      break;
-  }
-  case Qt::Key_A :
-  {
-      keys[2] = true;
-      std::cout<<"Left Pressed"<<std::endl;
-      break;
-  }
-  case Qt::Key_D :
+  // toggle the frame timing overlay
+  case Qt::Key_T : m_showStats=!m_showStats; break;
+  // start / stop recording every frame
+  case Qt::Key_R : toggleRecording(!m_recorder.recording()); break;
+  // raymarch the distance field instead of drawing the objects
+  case Qt::Key_M : toggleRaymarching(!m_raymarching); break;
+  // fewer or more sphere tracing steps, fewer show as holes at grazing angles
+  case Qt::Key_BracketLeft :
+    m_raymarch.settings().m_marchSteps=std::max(10,m_raymarch.settings().m_marchSteps-10);
+  break;
+  case Qt::Key_BracketRight :
+    m_raymarch.settings().m_marchSteps=std::min(200,m_raymarch.settings().m_marchSteps+10);
+  break;
+  // soft shadows and ambient occlusion cost more than the march itself, turn them off together
+  case Qt::Key_K :
   {
-      keys[3] = true;
-      std::cout<<"Right Pressed"<<std::endl;
-      break;
-  }
-  case Qt::Key_Space :
-  {
-      keys[4] = true;
-      std::cout<<"Space Pressed"<<std::endl;
-      break;
+    RaymarchPass::Settings &settings=m_raymarch.settings();
+    bool on=settings.m_shadowSteps==0;
+    settings.m_shadowSteps= on ? RaymarchPass::Settings().m_shadowSteps : 0;
+    settings.m_aoSteps= on ? RaymarchPass::Settings().m_aoSteps : 0;
+    break;
   }
+
   case Qt::Key_P :
   {
-      glReadPixels(0, 0, m_width, m_height, FORMAT, GL_UNSIGNED_BYTE, pixels.get());
-
-      //create_ppm("tmp", nscreenshots, m_width, m_height, 255, FORMAT_NBYTES, pixels);
-
-
-
-//      Magick::Blob b( pixels.get(), FORMAT_NBYTES * m_width * m_height );
-//      Magick::Image saveimage(b);
-//      saveimage.write("subimageGcrop.png");
-
-      // now create an image data block
-      Magick::Image output(m_width,m_height,"RGBA",Magick::CharPixel,pixels.get());
-      // set the output image depth to 16 bit
-      output.depth(16);
-      // write the file
-      output.write("Test.png");
-
-
+      // the readback happens at the end of the next frame and the png is written on the capture thread
+      m_capture.request(nscreenshots==0 ? std::string("Test.png") : "Test"+std::to_string(nscreenshots)+".png");
       nscreenshots++;
-      std::cout<<"Save Image"<<std::endl;
+      FPS_LOG_INFO("Save Image");
       break;
   }
-
-
-
-
-
+  // movement and debris go to the simulation through the bindings, the tick that applies them asks for
+  // the repaint
+  default :
+    if(!_event->isAutoRepeat())
+    {
+      push(fps::InputSample::key(_event->key(),true,fps::Simulation::now()));
+    }
+    return;
   }
-  // finally update the GLWindow and re-draw
-  //if (isExposed())
-    update();
+  // the settings above only show on the next frame
+  update();
 }
 
 void NGLScene::keyReleaseEvent(QKeyEvent *_event)
 {
-    switch (_event->key())
-    {
-        case Qt::Key_W :
-        {
-            keys[0] = false;
-            std::cout<<"Up Released"<<std::endl;
-            break;
-        }
-        case Qt::Key_S:
-        {
-            keys[1] = false;
-            std::cout<<"Down Released"<<std::endl;
-            break;
-        }
-        case Qt::Key_A :
-        {
-            keys[2] = false;
-            std::cout<<"Left Released"<<std::endl;
-            break;
-        }
-        case Qt::Key_D :
-        {
-            keys[3] = false;
-            std::cout<<"Right Released"<<std::endl;
-            break;
-        }
-        case Qt::Key_Space :
-        {
-            keys[4] = false;
-            velocity.m_y = 0;
-            std::cout<<"Space Pressed"<<std::endl;
-            break;
-        }
-
-
-
-    }
+  fps::ScopedTimer timer(m_profiler,fps::FrameProfiler::INPUT);
+  if(!_event->isAutoRepeat())
+  {
+    push(fps::InputSample::key(_event->key(),false,fps::Simulation::now()));
+  }
 }
 
-static float friction=0.0f;
-float a=1.1;
-float b=2.3;
-void NGLScene::timerEvent(QTimerEvent * _event)
+void NGLScene::post(const fps::Simulation::Command &_command)
 {
-//    rot+=0.15;
-
-//    //Jump implementation - rbd collision with artificial friction
-//    if (keys[4]==true)
-//    {
-//        //u=a* ,a=f/mt
-//        //friction+=0.1;
-//        velocity +=  ( force / mass ) * dt;
-
-
-
-//        ngl::Vec3 planeCenter(0,0.01,0);
-//        ngl::Vec3 planeNormal(0,1,0);
-
-//        //correct velocity - apply response impulse if hits the ground
-//        bool collidedwithPlane = SphereToPlane (currentCameraPos, planeCenter, planeNormal);
-
-//        if (collidedwithPlane)
-//        {
-//            velocity = calculateCollisionResponse(planeNormal);
-
-//            velocity = calculateCoulombFriction(velocity);
-//        }
-
-//        currentCameraPos += velocity * dt;
-//    }
-
-
-
-
-    //Jump implementation - rbd collision with artificial friction
-    if (keys[4]==true)
-    {
-        if (currentCameraPos.m_y == 0) // >=  lets jump on the top of jump
-        {
-            velocity.m_y = 20;
-        }
-        keys[4]=false;
-    }
-
-    //u=a*t
-    velocity +=  (force/mass) *dt;
-    //x=u*t..euler integration..
-    currentCameraPos += velocity * dt;
-
-
-//    //save current pos
-//    ngl::Vec3 tempPos=currentCameraPos;
-//    //update to new pos using prev pos
-//    currentCameraPos += currentCameraPos-prevCameraPos+(force/mass) *dt*dt;
-//    //xi+1 = xi + (xi - xi-1) + a * dt * dt , verlet integration
-
-//    //set previous camera position (to be used in Verlet Integration)
-//    prevCameraPos=tempPos;
-
-
-
-
-    //force camera position to stay above y=0
-    if(currentCameraPos.m_y<0)
-    {
-        currentCameraPos.m_y=0;
-        velocity.m_y=0;
-    }
-
-    std::cout<<"velocity="<<velocity.m_y<<std::endl;
-
-
-
-
-    update();
+  if(!m_sim.post(_command))
+  {
+    FPS_LOG_WARN("simulation input queue full, command %d dropped",static_cast<int>(_command.m_type));
+  }
 }
 
-
-
-
-void NGLScene::updateCameraPos()
+void NGLScene::push(const fps::InputSample &_sample)
 {
-    //    if(sizeof(keys)!=0)
-    {
-        if (keys[0]==true) currentCameraPos += cameraSpeed * currentCameraFront;
-        if (keys[1]==true) currentCameraPos -= cameraSpeed * currentCameraFront;
-        if (keys[2]==true )// move left
-        {
-            //get right vector ---> front X up
-            currentRight.set(currentCameraFront.cross(currentCameraUp) );
-            //normalize it
-            currentRight.normalize();// normalize cause we are interested only in the direction of the right vector
-            //set new camera position
-            newCamPos.set( currentRight * cameraSpeed );//move it to a new left position
-            currentCameraPos -=newCamPos;
-        }
-        if (keys[3]==true)// move right
-        {
-            //get right vector ---> front X up
-            currentRight.set(currentCameraFront.cross(currentCameraUp) );// ---> front X up
-            //normalize it
-            currentRight.normalize();// normalize cause we are interested only in the direction of the right vector
-            //set new camera position
-            newCamPos.set( currentRight * cameraSpeed );//move it to a new right position
-            currentCameraPos +=newCamPos;
-        }
-    }
-
-    //make Camera stay at a certain y level (if wanted)
-//    currentCameraPos.m_y=0;
-//    std::cout<<"currentCameraPos.m_y="<<currentCameraPos.m_y<<std::endl;
-
-
-
+  if(!m_sim.input().push(_sample))
+  {
+    FPS_LOG_WARN("simulation input queue full, sample %d dropped",static_cast<int>(_sample.m_type));
+  }
 }
@@ -0,0 +1,241 @@
+#include "OffscreenRenderer.h"
+#include "NGLScene.h"
+#include "Log.h"
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+OffscreenRenderer::OffscreenRenderer(const Settings &_settings) :
+  m_settings(_settings),
+  m_fbo(0),
+  m_colour(0),
+  m_depth(0),
+  m_resolveFBO(0),
+  m_resolveColour(0)
+{
+}
+
+void OffscreenRenderer::walkPath(int _ticks, double _dt, const fps::CameraController::State &_start,
+                                 fps::InputRecording &o_path)
+{
+  o_path.begin(_dt,_start);
+  fps::InputRecording::Tick tick;
+  tick.m_steps=1;
+  fps::InputState &input=tick.m_input;
+  std::fill(input.m_held,input.m_held+fps::NUM_INPUT_COMMANDS,false);
+  std::fill(input.m_presses,input.m_presses+fps::NUM_INPUT_COMMANDS,0);
+  input.m_held[fps::INPUT_FORWARD]=true;
+  input.m_samples=0;
+  input.m_motions=1;
+  for(int i=0; i<_ticks; ++i)
+  {
+    // the nod sums to nothing over a circle so the walk ends looking level
+    input.m_yaw=360.0f/_ticks;
+    input.m_pitch=0.05f*std::cos(static_cast<float>(2.0*M_PI*i/_ticks*3.0));
+    o_path.add(tick);
+  }
+}
+
+bool OffscreenRenderer::createTargets()
+{
+  int width=m_settings.m_width;
+  int height=m_settings.m_height;
+  int samples=m_settings.m_samples;
+  glGenFramebuffers(1,&m_fbo);
+  glGenRenderbuffers(1,&m_colour);
+  glGenRenderbuffers(1,&m_depth);
+  glBindRenderbuffer(GL_RENDERBUFFER,m_colour);
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER,samples,GL_RGBA8,width,height);
+  glBindRenderbuffer(GL_RENDERBUFFER,m_depth);
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER,samples,GL_DEPTH_COMPONENT24,width,height);
+  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_RENDERBUFFER,m_colour);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,GL_RENDERBUFFER,m_depth);
+  bool complete=glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE;
+  if(complete && samples>0)
+  {
+    // multisampled pixels can't be read, they are resolved into a plain target first
+    glGenFramebuffers(1,&m_resolveFBO);
+    glGenRenderbuffers(1,&m_resolveColour);
+    glBindRenderbuffer(GL_RENDERBUFFER,m_resolveColour);
+    glRenderbufferStorage(GL_RENDERBUFFER,GL_RGBA8,width,height);
+    glBindFramebuffer(GL_FRAMEBUFFER,m_resolveFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_RENDERBUFFER,m_resolveColour);
+    complete=glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE;
+  }
+  glBindRenderbuffer(GL_RENDERBUFFER,0);
+  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo);
+  return complete;
+}
+
+void OffscreenRenderer::releaseTargets()
+{
+  glBindFramebuffer(GL_FRAMEBUFFER,0);
+  glDeleteFramebuffers(1,&m_fbo);
+  glDeleteRenderbuffers(1,&m_colour);
+  glDeleteRenderbuffers(1,&m_depth);
+  if(m_resolveFBO!=0)
+  {
+    glDeleteFramebuffers(1,&m_resolveFBO);
+    glDeleteRenderbuffers(1,&m_resolveColour);
+  }
+  m_fbo=m_colour=m_depth=m_resolveFBO=m_resolveColour=0;
+}
+
+void OffscreenRenderer::readback(fps::RgbImage &o_image)
+{
+  int width=m_settings.m_width;
+  int height=m_settings.m_height;
+  GLuint source=m_fbo;
+  if(m_resolveFBO!=0)
+  {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,m_fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER,m_resolveFBO);
+    glBlitFramebuffer(0,0,width,height,0,0,width,height,GL_COLOR_BUFFER_BIT,GL_NEAREST);
+    source=m_resolveFBO;
+  }
+  glBindFramebuffer(GL_READ_FRAMEBUFFER,source);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glPixelStorei(GL_PACK_ALIGNMENT,1);
+  std::vector<uint8_t> rows(3*static_cast<size_t>(width)*height);
+  glReadPixels(0,0,width,height,GL_RGB,GL_UNSIGNED_BYTE,rows.data());
+  // GL rows start at the bottom
+  o_image.resize(width,height);
+  size_t stride=3*static_cast<size_t>(width);
+  for(int y=0; y<height; ++y)
+  {
+    std::copy(&rows[stride*(height-1-y)],&rows[stride*(height-y)],o_image.pixel(0,y));
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo);
+}
+
+int OffscreenRenderer::run()
+{
+  QOpenGLContext context;
+  context.setFormat(QSurfaceFormat::defaultFormat());
+  QOffscreenSurface surface;
+  surface.setFormat(context.format());
+  surface.create();
+  if(!context.create() || !surface.isValid() || !context.makeCurrent(&surface))
+  {
+    FPS_LOG_ERROR("no offscreen OpenGL %d.%d context",QSurfaceFormat::defaultFormat().majorVersion(),
+                  QSurfaceFormat::defaultFormat().minorVersion());
+    return EXIT_FAILURE;
+  }
+  FPS_LOG_INFO("offscreen %s %s",reinterpret_cast<const char *>(glGetString(GL_RENDERER)),
+               reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+  if(!createTargets())
+  {
+    FPS_LOG_ERROR("unable to make a %dx%d target with %d samples",m_settings.m_width,m_settings.m_height,
+                  m_settings.m_samples);
+    releaseTargets();
+    return EXIT_FAILURE;
+  }
+
+  int status=EXIT_SUCCESS;
+  {
+    // the scene's GL objects are released in its dtor, while the context is still current
+    NGLScene scene;
+    scene.setOffscreenTarget(m_fbo);
+    scene.initializeGL();
+    scene.resizeGL(m_settings.m_width,m_settings.m_height);
+    fps::Simulation &sim=scene.simulation();
+
+    fps::InputRecording path;
+    if(!m_settings.m_session.empty() && !path.read(m_settings.m_session))
+    {
+      FPS_LOG_ERROR("%s",path.error().c_str());
+      status=EXIT_FAILURE;
+    }
+    else if(m_settings.m_session.empty())
+    {
+      walkPath(m_settings.m_frames,1.0/120.0,sim.controller().state(),path);
+    }
+    if(status==EXIT_SUCCESS && !sim.replay(&path,false))
+    {
+      status=EXIT_FAILURE;
+    }
+
+    std::vector<double> frameMs;
+    fps::RgbImage image;
+    uint64_t runHash=14695981039346656037ull;
+    int frame=0;
+    for(; status==EXIT_SUCCESS && frame<m_settings.m_frames; ++frame)
+    {
+      // one tick a frame, timed with the frame as the simulation thread's share of it
+      double begin=fps::Simulation::now();
+      sim.advance(0.0);
+      if(!sim.replaying())
+      {
+        break;
+      }
+      glBindFramebuffer(GL_FRAMEBUFFER,m_fbo);
+      scene.paintGL();
+      glFinish();
+      double ms=(fps::Simulation::now()-begin)*1000.0;
+      if(frame>=m_settings.m_warmup)
+      {
+        frameMs.push_back(ms);
+      }
+      if(!m_settings.m_hash && m_settings.m_outPrefix.empty())
+      {
+        continue;
+      }
+      readback(image);
+      uint64_t hash=image.hash();
+      runHash=(runHash^hash)*1099511628211ull;
+      if(m_settings.m_hash)
+      {
+        std::printf("frame %d hash %016" PRIx64 "\n",frame,hash);
+      }
+      if(!m_settings.m_outPrefix.empty())
+      {
+        char name[16];
+        std::snprintf(name,sizeof(name),"%04d.ppm",frame);
+        if(!image.writePPM(m_settings.m_outPrefix+name))
+        {
+          FPS_LOG_ERROR("unable to write %s%s",m_settings.m_outPrefix.c_str(),name);
+          status=EXIT_FAILURE;
+        }
+      }
+    }
+
+    if(status==EXIT_SUCCESS && frameMs.empty())
+    {
+      FPS_LOG_ERROR("%d frames drawn, none past the %d warmup frames",frame,m_settings.m_warmup);
+      status=EXIT_FAILURE;
+    }
+    else if(status==EXIT_SUCCESS)
+    {
+      std::vector<double> sorted(frameMs);
+      std::sort(sorted.begin(),sorted.end());
+      double total=0.0;
+      for(double ms : frameMs)
+      {
+        total+=ms;
+      }
+      double avg=total/frameMs.size();
+      std::array<fps::FrameProfiler::Stats,fps::FrameProfiler::NUM_STAGES> stats=scene.profiler().stats();
+      const fps::FrameProfiler::Stats &gpu=stats[fps::FrameProfiler::GPU];
+      std::printf("%dx%d %dx msaa, %zu frames timed after %d: min/avg/p50/p99/max %.3f/%.3f/%.3f/%.3f/%.3f ms,"
+                  " %.1f fps\n",m_settings.m_width,m_settings.m_height,m_settings.m_samples,frameMs.size(),
+                  m_settings.m_warmup,sorted.front(),avg,sorted[sorted.size()/2],
+                  sorted[std::min(sorted.size()-1,sorted.size()*99/100)],sorted.back(),1000.0/avg);
+      std::printf("gpu min/avg/p99 %.3f/%.3f/%.3f ms over the last %zu frames\n",gpu.min,gpu.avg,gpu.p99,
+                  std::min<size_t>(frameMs.size(),fps::FrameProfiler::HISTORY));
+      if(m_settings.m_hash || !m_settings.m_outPrefix.empty())
+      {
+        std::printf("run hash %016" PRIx64 "\n",runHash);
+      }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER,m_fbo);
+  }
+  releaseTargets();
+  context.doneCurrent();
+  return status;
+}
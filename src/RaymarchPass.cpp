@@ -0,0 +1,159 @@
+#include "RaymarchPass.h"
+#include <ngl/ShaderLib.h>
+#include "Log.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a program of the shared fullscreen triangle and one fragment shader
+//----------------------------------------------------------------------------------------------------------------------
+static GLuint buildProgram(const std::string &_name, const std::string &_fragmentFile)
+{
+  ngl::ShaderLib *shader=ngl::ShaderLib::instance();
+  shader->createShaderProgram(_name);
+  shader->attachShader(_name+"Fragment",ngl::ShaderType::FRAGMENT);
+  shader->loadShaderSource(_name+"Fragment",_fragmentFile);
+  shader->compileShader(_name+"Fragment");
+  shader->attachShaderToProgram(_name,"FullscreenVertex");
+  shader->attachShaderToProgram(_name,_name+"Fragment");
+  shader->linkProgramObject(_name);
+  return shader->getProgramID(_name);
+}
+
+RaymarchPass::RaymarchPass() :
+  m_origin(0.0f,0.0f,0.0f),
+  m_scale(1.0f),
+  m_raymarchProgram(0),
+  m_upscaleProgram(0),
+  m_vao(0),
+  m_fbo(0),
+  m_colour(0),
+  m_depth(0),
+  m_targetWidth(0),
+  m_targetHeight(0)
+{
+  std::fill(m_uniforms,m_uniforms+NUM_UNIFORMS,-1);
+}
+
+void RaymarchPass::initialize(const CameraUBO &_camera)
+{
+  ngl::ShaderLib *shader=ngl::ShaderLib::instance();
+  shader->attachShader("FullscreenVertex",ngl::ShaderType::VERTEX);
+  shader->loadShaderSource("FullscreenVertex","shaders/FullscreenVertex.glsl");
+  shader->compileShader("FullscreenVertex");
+  m_raymarchProgram=buildProgram("Raymarch","shaders/testraymarching.glsl");
+  m_upscaleProgram=buildProgram("Upscale","shaders/UpscaleFragment.glsl");
+  if(!_camera.attach(m_raymarchProgram))
+  {
+    FPS_LOG_ERROR("the raymarching program has no Camera block");
+  }
+
+  const char *names[NUM_UNIFORMS]={"resolution","camEye","camFront","camUp","sceneOrigin","sceneScale",
+                                   "marchSteps","shadowSteps","aoSteps"};
+  for(int i=0; i<NUM_UNIFORMS; ++i)
+  {
+    m_uniforms[i]=glGetUniformLocation(m_raymarchProgram,names[i]);
+  }
+  glUseProgram(m_upscaleProgram);
+  glUniform1i(glGetUniformLocation(m_upscaleProgram,"colourMap"),0);
+  glUniform1i(glGetUniformLocation(m_upscaleProgram,"depthMap"),1);
+  glGenVertexArrays(1,&m_vao);
+}
+
+void RaymarchPass::release()
+{
+  glDeleteVertexArrays(1,&m_vao);
+  glDeleteFramebuffers(1,&m_fbo);
+  glDeleteTextures(1,&m_colour);
+  glDeleteTextures(1,&m_depth);
+  m_vao=m_fbo=m_colour=m_depth=0;
+  m_targetWidth=m_targetHeight=0;
+}
+
+void RaymarchPass::setPlacement(const ngl::Vec3 &_origin, float _scale)
+{
+  m_origin=_origin;
+  m_scale=_scale;
+}
+
+void RaymarchPass::resizeTarget(int _width, int _height)
+{
+  if(_width==m_targetWidth && _height==m_targetHeight)
+  {
+    return;
+  }
+  if(m_fbo==0)
+  {
+    glGenFramebuffers(1,&m_fbo);
+    glGenTextures(1,&m_colour);
+    glGenTextures(1,&m_depth);
+  }
+  // colour is filtered when it is stretched, depth is taken from the nearest texel so edges stay sharp
+  glBindTexture(GL_TEXTURE_2D,m_colour);
+  glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,_width,_height,0,GL_RGBA,GL_UNSIGNED_BYTE,nullptr);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D,m_depth);
+  glTexImage2D(GL_TEXTURE_2D,0,GL_DEPTH_COMPONENT24,_width,_height,0,GL_DEPTH_COMPONENT,GL_UNSIGNED_INT,nullptr);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D,0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,m_colour,0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,GL_TEXTURE_2D,m_depth,0);
+  if(glCheckFramebufferStatus(GL_FRAMEBUFFER)!=GL_FRAMEBUFFER_COMPLETE)
+  {
+    FPS_LOG_ERROR("raymarch target %dx%d is incomplete",_width,_height);
+  }
+  m_targetWidth=_width;
+  m_targetHeight=_height;
+}
+
+void RaymarchPass::draw(GLuint _target, int _width, int _height, int _renderWidth, int _renderHeight,
+                        const ngl::Vec3 &_eye, const ngl::Vec3 &_front, const ngl::Vec3 &_up)
+{
+  bool scaled=_renderWidth!=_width || _renderHeight!=_height;
+  if(scaled)
+  {
+    resizeTarget(_renderWidth,_renderHeight);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER,scaled ? m_fbo : _target);
+  glViewport(0,0,_renderWidth,_renderHeight);
+  // every pixel is written, depth only has to be let through
+  glDepthFunc(GL_ALWAYS);
+  glBindVertexArray(m_vao);
+
+  glUseProgram(m_raymarchProgram);
+  glUniform2f(m_uniforms[RESOLUTION],static_cast<float>(_renderWidth),static_cast<float>(_renderHeight));
+  glUniform3f(m_uniforms[EYE],_eye.m_x,_eye.m_y,_eye.m_z);
+  glUniform3f(m_uniforms[FRONT],_front.m_x,_front.m_y,_front.m_z);
+  glUniform3f(m_uniforms[UP],_up.m_x,_up.m_y,_up.m_z);
+  glUniform3f(m_uniforms[ORIGIN],m_origin.m_x,m_origin.m_y,m_origin.m_z);
+  glUniform1f(m_uniforms[SCALE],m_scale);
+  glUniform1i(m_uniforms[MARCH_STEPS],m_settings.m_marchSteps);
+  glUniform1i(m_uniforms[SHADOW_STEPS],m_settings.m_shadowSteps);
+  glUniform1i(m_uniforms[AO_STEPS],m_settings.m_aoSteps);
+  glDrawArrays(GL_TRIANGLES,0,3);
+
+  if(scaled)
+  {
+    glBindFramebuffer(GL_FRAMEBUFFER,_target);
+    glViewport(0,0,_width,_height);
+    glUseProgram(m_upscaleProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D,m_colour);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D,m_depth);
+    glDrawArrays(GL_TRIANGLES,0,3);
+    glBindTexture(GL_TEXTURE_2D,0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D,0);
+  }
+  glBindVertexArray(0);
+  glDepthFunc(GL_LESS);
+  glViewport(0,0,_width,_height);
+}
@@ -0,0 +1,361 @@
+#include "Raymarcher.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace fps
+{
+
+// iq's rays were normalize(vec3(p.xy,2.0)) with p.y in -1..1, half the field of view is atan(1/2)
+const float Raymarcher::SHADER_FOV=static_cast<float>(2.0*std::atan(0.5)*180.0/M_PI);
+
+namespace
+{
+
+using sdf::Result;
+using sdf::Vec3T;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief loads and stores the same for a lone float as for the lane types, so one template marches both
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F>
+struct Packet
+{
+  static const size_t WIDTH=F::WIDTH;
+  typedef typename F::Mask Mask;
+  static F load(const float *_p) { return F::load(_p); }
+  static void store(const F &_v, float *o_p) { _v.store(o_p); }
+};
+
+template <>
+struct Packet<float>
+{
+  static const size_t WIDTH=1;
+  typedef bool Mask;
+  static float load(const float *_p) { return *_p; }
+  static void store(float _v, float *o_p) { *o_p=_v; }
+};
+
+template <typename F> Vec3T<F> splat(const Vec3 &_v) { return Vec3T<F>(F(_v.m_x),F(_v.m_y),F(_v.m_z)); }
+template <typename F> Vec3T<F> operator*(const F &_s, const Vec3T<F> &_v) { return _v*_s; }
+template <typename F> Vec3T<F> minimum(const Vec3T<F> &_v, float _s)
+{
+  return Vec3T<F>(vmin(_v.m_x,F(_s)),vmin(_v.m_y,F(_s)),vmin(_v.m_z,F(_s)));
+}
+template <typename F> Vec3T<F> normalize(const Vec3T<F> &_v) { return _v*(F(1.0f)/sdf::length(_v)); }
+template <typename F> F smoothstep(float _edge0, float _edge1, const F &_x)
+{
+  F t=sdf::clamp(F((_x-F(_edge0))/F(_edge1-_edge0)),0.0f,1.0f);
+  return t*t*(F(3.0f)-F(2.0f)*t);
+}
+template <typename F> F dot(const Vec3T<F> &_a, const Vec3 &_b)
+{
+  return _a.m_x*F(_b.m_x)+_a.m_y*F(_b.m_y)+_a.m_z*F(_b.m_z);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the steps and map() points a tile took, kept per lane count so a packet adds what its rays would
+//----------------------------------------------------------------------------------------------------------------------
+struct Counts
+{
+  uint64_t m_marchSteps=0;
+  uint64_t m_mapPoints=0;
+};
+
+template <typename F>
+Result<F> map(const Vec3T<F> &_p, const typename Packet<F>::Mask &_active, Counts &o_counts)
+{
+  o_counts.m_mapPoints+=static_cast<uint64_t>(countLanes(_active));
+  return SdfScene::mapLocal(_p);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the shader's castRay, lanes drop out as they hit or pass tmax
+/// @param [out] o_steps march steps of each lane, for the heatmap
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F>
+void castRay(const Raymarcher::Settings &_settings, const Vec3T<F> &_ro, const Vec3T<F> &_rd,
+             typename Packet<F>::Mask _active, F &o_t, F &o_m, F &o_steps, Counts &o_counts)
+{
+  F tmax(_settings.m_tmax);
+  F precis(_settings.m_precision);
+  F t(_settings.m_tmin);
+  F m(-1.0f);
+  F steps(0.0f);
+  for(int i=0; i<_settings.m_steps; ++i)
+  {
+    Result<F> res=map(_ro+_rd*t,_active,o_counts);
+    _active=andNot(_active,(res.m_distance<precis) | (t>tmax));
+    if(!any(_active))
+    {
+      break;
+    }
+    o_counts.m_marchSteps+=static_cast<uint64_t>(countLanes(_active));
+    t=select(_active,t+res.m_distance,t);
+    m=select(_active,res.m_material,m);
+    steps=select(_active,steps+F(1.0f),steps);
+  }
+  o_t=t;
+  o_m=select(t>tmax,F(-1.0f),m);
+  o_steps=steps;
+}
+
+template <typename F>
+F softshadow(const Raymarcher::Settings &_settings, const Vec3T<F> &_ro, const Vec3T<F> &_rd, float _mint,
+             float _tmax, typename Packet<F>::Mask _active, Counts &o_counts)
+{
+  F res(1.0f);
+  F t(_mint);
+  for(int i=0; i<_settings.m_shadowSteps; ++i)
+  {
+    F h=map(_ro+_rd*t,_active,o_counts).m_distance;
+    res=select(_active,vmin(res,F(8.0f)*h/t),res);
+    t=select(_active,t+sdf::clamp(h,0.02f,0.10f),t);
+    _active=andNot(_active,(h<F(0.001f)) | (t>F(_tmax)));
+    if(!any(_active))
+    {
+      break;
+    }
+  }
+  return sdf::clamp(res,0.0f,1.0f);
+}
+
+template <typename F>
+Vec3T<F> calcNormal(const Vec3T<F> &_pos, const typename Packet<F>::Mask &_active, Counts &o_counts)
+{
+  F e(SdfScene::NORMAL_EPSILON);
+  F z(0.0f);
+  Vec3T<F> ex(e,z,z);
+  Vec3T<F> ey(z,e,z);
+  Vec3T<F> ez(z,z,e);
+  Vec3T<F> nor(map(_pos+ex,_active,o_counts).m_distance-map(_pos-ex,_active,o_counts).m_distance,
+               map(_pos+ey,_active,o_counts).m_distance-map(_pos-ey,_active,o_counts).m_distance,
+               map(_pos+ez,_active,o_counts).m_distance-map(_pos-ez,_active,o_counts).m_distance);
+  return normalize(nor);
+}
+
+template <typename F>
+F calcAO(const Vec3T<F> &_pos, const Vec3T<F> &_nor, const typename Packet<F>::Mask &_active, Counts &o_counts)
+{
+  F occ(0.0f);
+  float sca=1.0f;
+  for(int i=0; i<5; ++i)
+  {
+    float hr=0.01f+0.12f*static_cast<float>(i)/4.0f;
+    F dd=map(_nor*F(hr)+_pos,_active,o_counts).m_distance;
+    occ=occ-(dd-F(hr))*F(sca);
+    sca*=0.95f;
+  }
+  return sdf::clamp(F(F(1.0f)-F(3.0f)*occ),0.0f,1.0f);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the shader's render() less the march, for lanes that hit something
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F>
+Vec3T<F> shade(const Raymarcher::Settings &_settings, const Vec3T<F> &_ro, const Vec3T<F> &_rd, const F &_t,
+               const F &_m, const typename Packet<F>::Mask &_hit, Counts &o_counts)
+{
+  Vec3 lig(-0.6f,0.7f,-0.5f);
+  lig.normalize();
+  Vec3 back(-lig.m_x,0.0f,-lig.m_z);
+  back.normalize();
+
+  Vec3T<F> pos=_ro+_t*_rd;
+  Vec3T<F> nor=calcNormal(pos,_hit,o_counts);
+  Vec3T<F> ref=_rd-F(F(2.0f)*sdf::dot(nor,_rd))*nor;
+
+  // material, the floor is a checker board
+  F mat=_m-F(1.0f);
+  Vec3T<F> col(F(0.45f)+F(0.3f)*vsin(F(0.05f)*mat),F(0.45f)+F(0.3f)*vsin(F(0.08f)*mat),
+               F(0.45f)+F(0.3f)*vsin(F(0.10f)*mat));
+  F f=sdf::mod(F(vfloor(F(5.0f)*pos.m_z)+vfloor(F(5.0f)*pos.m_x)),F(2.0f));
+  F checker=F(0.4f)+F(0.1f)*f;
+  typename Packet<F>::Mask floor=_m<F(1.5f);
+  col=Vec3T<F>(select(floor,checker,col.m_x),select(floor,checker,col.m_y),select(floor,checker,col.m_z));
+
+  // lighting
+  F occ= _settings.m_ambientOcclusion ? calcAO(pos,nor,_hit,o_counts) : F(1.0f);
+  F amb=sdf::clamp(F(F(0.5f)+F(0.5f)*nor.m_y),0.0f,1.0f);
+  F dif=sdf::clamp(dot(nor,lig),0.0f,1.0f);
+  F bac=sdf::clamp(dot(nor,back),0.0f,1.0f)*sdf::clamp(F(F(1.0f)-pos.m_y),0.0f,1.0f);
+  F dom=smoothstep(-0.1f,0.1f,ref.m_y);
+  F fre=sdf::clamp(F(F(1.0f)+sdf::dot(nor,_rd)),0.0f,1.0f);
+  fre=fre*fre;
+  F spe=vpow(sdf::clamp(dot(ref,lig),0.0f,1.0f),F(16.0f));
+
+  if(_settings.m_shadowSteps>0)
+  {
+    dif=dif*softshadow(_settings,pos,splat<F>(lig),0.02f,2.5f,_hit,o_counts);
+    dom=dom*softshadow(_settings,pos,ref,0.02f,2.5f,_hit,o_counts);
+  }
+
+  Vec3T<F> brdf=splat<F>(Vec3(0.02f,0.02f,0.02f));
+  brdf=brdf+splat<F>(Vec3(1.00f,0.90f,0.60f))*F(F(1.20f)*dif);
+  brdf=brdf+splat<F>(Vec3(1.00f,0.90f,0.60f))*F(F(1.20f)*spe*dif);
+  brdf=brdf+splat<F>(Vec3(0.50f,0.70f,1.00f))*F(F(0.30f)*amb*occ);
+  brdf=brdf+splat<F>(Vec3(0.50f,0.70f,1.00f))*F(F(0.40f)*dom*occ);
+  brdf=brdf+splat<F>(Vec3(0.25f,0.25f,0.25f))*F(F(0.30f)*bac*occ);
+  brdf=brdf+splat<F>(Vec3(1.00f,1.00f,1.00f))*F(F(0.40f)*fre*occ);
+  col=Vec3T<F>(col.m_x*brdf.m_x,col.m_y*brdf.m_y,col.m_z*brdf.m_z);
+
+  // fog
+  F fog=F(1.0f)-vexp(F(-0.0005f)*_t*_t);
+  Vec3T<F> sky=splat<F>(Vec3(0.8f,0.9f,1.0f));
+  return col+(sky-col)*fog;
+}
+
+uint8_t toByte(float _c)
+{
+  return static_cast<uint8_t>(std::min(std::max(_c,0.0f),1.0f)*255.0f+0.5f);
+}
+
+} // end anonymous namespace
+
+Raymarcher::Raymarcher(const SdfScene &_scene) :
+  m_scene(_scene)
+{
+}
+
+Mat4 Raymarcher::shaderView(float _time, float _mouseX, float _mouseY)
+{
+  float time=15.0f+_time;
+  Vec3 ro(-0.5f+3.5f*std::cos(0.1f*time+6.0f*_mouseX),1.0f+2.0f*_mouseY,0.5f+3.5f*std::sin(0.1f*time+6.0f*_mouseX));
+  Vec3 ta(-0.5f,-0.4f,0.5f);
+  // setCamera(ro,ta,0.0) builds the same basis as lookAt with y up
+  return lookAt(ro,ta,Vec3(0.0f,1.0f,0.0f));
+}
+
+template <typename F>
+void Raymarcher::renderTile(int _tile, const Mat4 &_view, float _fovy, RgbImage &o_image, Stats &o_stats) const
+{
+  typedef Packet<F> P;
+  const int width=static_cast<int>(P::WIDTH);
+  const int tileSize=m_settings.m_tileSize;
+  const int tilesX=(o_image.width()+tileSize-1)/tileSize;
+  const int x0=(_tile%tilesX)*tileSize;
+  const int y0=(_tile/tilesX)*tileSize;
+  const int x1=std::min(x0+tileSize,o_image.width());
+  const int y1=std::min(y0+tileSize,o_image.height());
+
+  // the camera basis out of the view matrix, and the eye in the shader's units
+  Vec3 right(_view.m_m[0][0],_view.m_m[1][0],_view.m_m[2][0]);
+  Vec3 up(_view.m_m[0][1],_view.m_m[1][1],_view.m_m[2][1]);
+  Vec3 front(-_view.m_m[0][2],-_view.m_m[1][2],-_view.m_m[2][2]);
+  Vec3 eye=right*-_view.m_m[3][0]+up*-_view.m_m[3][1]+front*_view.m_m[3][2];
+  Vec3T<F> ro=splat<F>((eye-m_scene.origin())/m_scene.scale());
+  float focal=1.0f/std::tan(_fovy*0.5f*static_cast<float>(M_PI/180.0));
+  float aspect=static_cast<float>(o_image.width())/static_cast<float>(o_image.height());
+
+  float lanes[P::WIDTH];
+  for(int i=0; i<width; ++i)
+  {
+    lanes[i]=static_cast<float>(i);
+  }
+  F lane=P::load(lanes);
+  Counts counts;
+  for(int y=y0; y<y1; ++y)
+  {
+    // p as the shader has it, from the pixel centres with y up
+    float py=-1.0f+2.0f*(static_cast<float>(o_image.height()-y)-0.5f)/static_cast<float>(o_image.height());
+    for(int x=x0; x<x1; x+=width)
+    {
+      int valid=std::min(width,x1-x);
+      typename P::Mask active=lane<F(static_cast<float>(valid));
+      F px=(F(-1.0f)+F(2.0f)*(lane+F(static_cast<float>(x)+0.5f))/F(static_cast<float>(o_image.width())))*F(aspect);
+      Vec3T<F> rd=normalize(Vec3T<F>(px*F(right.m_x)+F(py*up.m_x+focal*front.m_x),
+                                      px*F(right.m_y)+F(py*up.m_y+focal*front.m_y),
+                                      px*F(right.m_z)+F(py*up.m_z+focal*front.m_z)));
+      F t;
+      F m;
+      F steps;
+      castRay(m_settings,ro,rd,active,t,m,steps,counts);
+      typename P::Mask hit=andNot(active,m<F(-0.5f));
+      o_stats.m_rays+=static_cast<uint64_t>(valid);
+      o_stats.m_hits+=static_cast<uint64_t>(countLanes(hit));
+
+      Vec3T<F> col;
+      if(m_settings.m_heatmap)
+      {
+        F grey=steps/F(static_cast<float>(std::max(m_settings.m_steps,1)));
+        col=Vec3T<F>(grey,grey,grey);
+      }
+      else
+      {
+        Vec3T<F> sky=splat<F>(Vec3(0.8f,0.9f,1.0f));
+        col=sky;
+        if(any(hit))
+        {
+          Vec3T<F> lit=shade(m_settings,ro,rd,t,m,hit,counts);
+          col=Vec3T<F>(select(hit,lit.m_x,sky.m_x),select(hit,lit.m_y,sky.m_y),select(hit,lit.m_z,sky.m_z));
+        }
+        F gamma(0.4545f);
+        col=sdf::max(minimum(col,1.0f),0.0f);
+        col=Vec3T<F>(vpow(col.m_x,gamma),vpow(col.m_y,gamma),vpow(col.m_z,gamma));
+      }
+      float r[P::WIDTH];
+      float g[P::WIDTH];
+      float b[P::WIDTH];
+      P::store(col.m_x,r);
+      P::store(col.m_y,g);
+      P::store(col.m_z,b);
+      for(int i=0; i<valid; ++i)
+      {
+        uint8_t *pixel=o_image.pixel(x+i,y);
+        pixel[0]=toByte(r[i]);
+        pixel[1]=toByte(g[i]);
+        pixel[2]=toByte(b[i]);
+      }
+    }
+  }
+  o_stats.m_marchSteps+=counts.m_marchSteps;
+  o_stats.m_mapPoints+=counts.m_mapPoints;
+}
+
+void Raymarcher::render(const Mat4 &_view, float _fovy, int _width, int _height, JobSystem *_jobs, RgbImage &o_image)
+{
+  std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+  o_image.resize(_width,_height);
+  m_settings.m_tileSize=std::max(m_settings.m_tileSize,1);
+  int tilesX=(_width+m_settings.m_tileSize-1)/m_settings.m_tileSize;
+  int tilesY=(_height+m_settings.m_tileSize-1)/m_settings.m_tileSize;
+  size_t tiles=static_cast<size_t>(tilesX)*static_cast<size_t>(tilesY);
+
+  // every tile counts into its own stats, summed afterwards in tile order
+  std::vector<Stats> tileStats(tiles);
+  auto renderRange=[&](size_t _begin, size_t _end)
+  {
+    for(size_t i=_begin; i<_end; ++i)
+    {
+      if(m_settings.m_scalar)
+      {
+        renderTile<float>(static_cast<int>(i),_view,_fovy,o_image,tileStats[i]);
+      }
+      else
+      {
+        renderTile<FloatWide>(static_cast<int>(i),_view,_fovy,o_image,tileStats[i]);
+      }
+    }
+  };
+  if(_jobs!=nullptr && tiles>1)
+  {
+    _jobs->parallelFor(tiles,1,renderRange);
+  }
+  else
+  {
+    renderRange(0,tiles);
+  }
+
+  m_stats=Stats();
+  for(const Stats &s : tileStats)
+  {
+    m_stats.m_rays+=s.m_rays;
+    m_stats.m_marchSteps+=s.m_marchSteps;
+    m_stats.m_mapPoints+=s.m_mapPoints;
+    m_stats.m_hits+=s.m_hits;
+  }
+  m_stats.m_ms=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+} // end namespace fps
@@ -0,0 +1,82 @@
+#include "RgbImage.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+namespace fps
+{
+
+void RgbImage::resize(int _width, int _height)
+{
+  m_width=_width;
+  m_height=_height;
+  m_pixels.assign(3*static_cast<size_t>(_width)*_height,0);
+}
+
+bool RgbImage::writePPM(const std::string &_fname) const
+{
+  std::unique_ptr<FILE,int(*)(FILE *)> file(std::fopen(_fname.c_str(),"wb"),&std::fclose);
+  if(!file)
+  {
+    return false;
+  }
+  std::fprintf(file.get(),"P6\n%d %d\n255\n",m_width,m_height);
+  return std::fwrite(m_pixels.data(),1,m_pixels.size(),file.get())==m_pixels.size();
+}
+
+bool RgbImage::readPPM(const std::string &_fname)
+{
+  std::unique_ptr<FILE,int(*)(FILE *)> file(std::fopen(_fname.c_str(),"rb"),&std::fclose);
+  if(!file)
+  {
+    return false;
+  }
+  int width;
+  int height;
+  int maxval;
+  // the single whitespace after maxval ends the header
+  if(std::fscanf(file.get(),"P6 %d %d %d",&width,&height,&maxval)!=3 || maxval!=255 || width<0 || height<0 ||
+     std::fgetc(file.get())==EOF)
+  {
+    return false;
+  }
+  resize(width,height);
+  return std::fread(m_pixels.data(),1,m_pixels.size(),file.get())==m_pixels.size();
+}
+
+uint64_t RgbImage::hash() const
+{
+  uint64_t h=14695981039346656037ull;
+  auto add=[&h](uint8_t _byte)
+  {
+    h^=_byte;
+    h*=1099511628211ull;
+  };
+  for(int shift=0; shift<32; shift+=8)
+  {
+    add(static_cast<uint8_t>(static_cast<uint32_t>(m_width)>>shift));
+    add(static_cast<uint8_t>(static_cast<uint32_t>(m_height)>>shift));
+  }
+  for(uint8_t byte : m_pixels)
+  {
+    add(byte);
+  }
+  return h;
+}
+
+int RgbImage::maxDifference(const RgbImage &_a, const RgbImage &_b)
+{
+  if(_a.m_width!=_b.m_width || _a.m_height!=_b.m_height)
+  {
+    return 256;
+  }
+  int worst=0;
+  for(size_t i=0; i<_a.m_pixels.size(); ++i)
+  {
+    worst=std::max(worst,std::abs(static_cast<int>(_a.m_pixels[i])-static_cast<int>(_b.m_pixels[i])));
+  }
+  return worst;
+}
+
+} // end namespace fps
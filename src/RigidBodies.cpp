@@ -0,0 +1,712 @@
+#include "RigidBodies.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+namespace fps
+{
+
+const uint32_t RigidBodies::NO_BODY;
+
+namespace
+{
+
+// overlap left in place so resting contacts stay touching instead of flickering in and out
+const float SLOP=0.005f;
+// fraction of the remaining overlap removed per step
+const float CORRECTION=0.8f;
+// contacts one body can have with the static world in a step
+const size_t MAX_WORLD_CONTACTS=8;
+// bodies, bodies searched for contacts and islands per job
+const size_t BODY_GRAIN=2048;
+const size_t CONTACT_GRAIN=256;
+const size_t ISLAND_GRAIN=32;
+
+float clampf(float _v, float _lo, float _hi)
+{
+  return std::max(_lo,std::min(_v,_hi));
+}
+
+} // end anonymous namespace
+
+RigidBodies::RigidBodies() :
+  m_config()
+{
+}
+
+RigidBodies::RigidBodies(const Config &_config) :
+  m_config(_config)
+{
+}
+
+uint32_t RigidBodies::add(const Vec3 &_position, float _radius, float _mass, const Vec3 &_velocity)
+{
+  uint32_t i=static_cast<uint32_t>(m_size++);
+  bool movable=_mass>0.0f;
+  Vec3 v=movable ? _velocity : Vec3();
+  m_px.push_back(_position.m_x);
+  m_py.push_back(_position.m_y);
+  m_pz.push_back(_position.m_z);
+  m_vx.push_back(v.m_x);
+  m_vy.push_back(v.m_y);
+  m_vz.push_back(v.m_z);
+  m_ox.push_back(_position.m_x-v.m_x*m_dt);
+  m_oy.push_back(_position.m_y-v.m_y*m_dt);
+  m_oz.push_back(_position.m_z-v.m_z*m_dt);
+  m_radius.push_back(_radius);
+  m_invMass.push_back(movable ? 1.0f/_mass : 0.0f);
+  m_restitution.push_back(0.3f);
+  m_friction.push_back(0.5f);
+  // immovable bodies are permanently asleep so the kernels never move them
+  m_awake.push_back(movable ? 1.0f : 0.0f);
+  m_slowTime.push_back(0.0f);
+  m_reach.push_back(_radius);
+  return i;
+}
+
+void RigidBodies::setMaterial(uint32_t _i, float _restitution, float _friction)
+{
+  m_restitution[_i]=_restitution;
+  m_friction[_i]=_friction;
+}
+
+void RigidBodies::clear()
+{
+  m_size=0;
+  for(std::vector<float> *a : {&m_px,&m_py,&m_pz,&m_vx,&m_vy,&m_vz,&m_ox,&m_oy,&m_oz,&m_radius,
+                               &m_invMass,&m_restitution,&m_friction,&m_awake,&m_slowTime,&m_reach})
+  {
+    a->clear();
+  }
+  m_contacts.clear();
+}
+
+void RigidBodies::wake(uint32_t _i)
+{
+  if(m_invMass[_i]>0.0f && m_awake[_i]==0.0f)
+  {
+    m_awake[_i]=1.0f;
+    m_slowTime[_i]=0.0f;
+    // a sleeper is at rest, Verlet must not see the motion it had when it fell asleep
+    m_ox[_i]=m_px[_i];
+    m_oy[_i]=m_py[_i];
+    m_oz[_i]=m_pz[_i];
+  }
+}
+
+void RigidBodies::applyImpulse(uint32_t _i, const Vec3 &_impulse)
+{
+  wake(_i);
+  Vec3 dv=_impulse*m_invMass[_i];
+  m_vx[_i]+=dv.m_x;
+  m_vy[_i]+=dv.m_y;
+  m_vz[_i]+=dv.m_z;
+  m_ox[_i]-=dv.m_x*m_dt;
+  m_oy[_i]-=dv.m_y*m_dt;
+  m_oz[_i]-=dv.m_z*m_dt;
+}
+
+size_t RigidBodies::awakeCount() const
+{
+  return static_cast<size_t>(std::count(m_awake.begin(),m_awake.end(),1.0f));
+}
+
+float RigidBodies::effectiveInverseMass(uint32_t _i) const
+{
+  // sleeping bodies act as static until something wakes them
+  return _i==NO_BODY ? 0.0f : m_invMass[_i]*m_awake[_i];
+}
+
+void RigidBodies::parallelFor(size_t _count, size_t _grain, const JobSystem::RangeFunction &_function)
+{
+  if(m_jobs!=nullptr)
+  {
+    m_jobs->parallelFor(_count,_grain,_function);
+    return;
+  }
+  for(size_t begin=0; begin<_count; begin+=_grain)
+  {
+    _function(begin,std::min(begin+_grain,_count));
+  }
+}
+
+void RigidBodies::step(float _dt)
+{
+  if(m_size==0 || _dt<=0.0f)
+  {
+    return;
+  }
+  m_dt=_dt;
+  parallelFor(m_size,BODY_GRAIN,[this,_dt](size_t _begin, size_t _end)
+  {
+    integrateVelocities(_begin,_end,_dt);
+    // look as far ahead as each body can travel this step
+    for(size_t i=_begin; i<_end; ++i)
+    {
+      m_reach[i]=m_radius[i]+std::sqrt(m_vx[i]*m_vx[i]+m_vy[i]*m_vy[i]+m_vz[i]*m_vz[i])*_dt;
+    }
+  });
+  findContacts(_dt);
+  buildIslands();
+  parallelFor(m_islandCount,ISLAND_GRAIN,[this](size_t _begin, size_t _end)
+  {
+    solveIslands(_begin,_end);
+  });
+  parallelFor(m_size,BODY_GRAIN,[this,_dt](size_t _begin, size_t _end)
+  {
+    integratePositions(_begin,_end,_dt);
+  });
+  parallelFor(m_islandCount,ISLAND_GRAIN,[this](size_t _begin, size_t _end)
+  {
+    correctIslands(_begin,_end);
+  });
+  parallelFor(m_size,BODY_GRAIN,[this,_dt](size_t _begin, size_t _end)
+  {
+    updateSleep(_begin,_end,_dt);
+  });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// kernels, four bodies at a time with SSE and the scalar loop for the tail and non SSE builds. Sleeping
+// bodies are masked by m_awake rather than branched around.
+//----------------------------------------------------------------------------------------------------------------------
+void RigidBodies::integrateVelocities(size_t _begin, size_t _end, float _dt)
+{
+  const Vec3 gdt=m_config.gravity*_dt;
+  const bool verlet=m_config.integrator==VERLET;
+  const float invDt=1.0f/_dt;
+  size_t i=_begin;
+#if defined(__SSE2__)
+  if(m_config.simd)
+  {
+    const __m128 gx=_mm_set1_ps(gdt.m_x);
+    const __m128 gy=_mm_set1_ps(gdt.m_y);
+    const __m128 gz=_mm_set1_ps(gdt.m_z);
+    const __m128 rdt=_mm_set1_ps(invDt);
+    for(; i+4<=_end; i+=4)
+    {
+      __m128 awake=_mm_loadu_ps(&m_awake[i]);
+      __m128 vx, vy, vz;
+      if(verlet)
+      {
+        vx=_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_px[i]),_mm_loadu_ps(&m_ox[i])),rdt);
+        vy=_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_py[i]),_mm_loadu_ps(&m_oy[i])),rdt);
+        vz=_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_pz[i]),_mm_loadu_ps(&m_oz[i])),rdt);
+      }
+      else
+      {
+        vx=_mm_loadu_ps(&m_vx[i]);
+        vy=_mm_loadu_ps(&m_vy[i]);
+        vz=_mm_loadu_ps(&m_vz[i]);
+      }
+      _mm_storeu_ps(&m_vx[i],_mm_mul_ps(_mm_add_ps(vx,gx),awake));
+      _mm_storeu_ps(&m_vy[i],_mm_mul_ps(_mm_add_ps(vy,gy),awake));
+      _mm_storeu_ps(&m_vz[i],_mm_mul_ps(_mm_add_ps(vz,gz),awake));
+    }
+  }
+#endif
+  for(; i<_end; ++i)
+  {
+    float vx=verlet ? (m_px[i]-m_ox[i])*invDt : m_vx[i];
+    float vy=verlet ? (m_py[i]-m_oy[i])*invDt : m_vy[i];
+    float vz=verlet ? (m_pz[i]-m_oz[i])*invDt : m_vz[i];
+    m_vx[i]=(vx+gdt.m_x)*m_awake[i];
+    m_vy[i]=(vy+gdt.m_y)*m_awake[i];
+    m_vz[i]=(vz+gdt.m_z)*m_awake[i];
+  }
+}
+
+void RigidBodies::integratePositions(size_t _begin, size_t _end, float _dt)
+{
+  size_t i=_begin;
+#if defined(__SSE2__)
+  if(m_config.simd)
+  {
+    const __m128 dt=_mm_set1_ps(_dt);
+    for(; i+4<=_end; i+=4)
+    {
+      // sleeping bodies have zero velocity so need no mask
+      __m128 px=_mm_loadu_ps(&m_px[i]);
+      __m128 py=_mm_loadu_ps(&m_py[i]);
+      __m128 pz=_mm_loadu_ps(&m_pz[i]);
+      _mm_storeu_ps(&m_ox[i],px);
+      _mm_storeu_ps(&m_oy[i],py);
+      _mm_storeu_ps(&m_oz[i],pz);
+      _mm_storeu_ps(&m_px[i],_mm_add_ps(px,_mm_mul_ps(_mm_loadu_ps(&m_vx[i]),dt)));
+      _mm_storeu_ps(&m_py[i],_mm_add_ps(py,_mm_mul_ps(_mm_loadu_ps(&m_vy[i]),dt)));
+      _mm_storeu_ps(&m_pz[i],_mm_add_ps(pz,_mm_mul_ps(_mm_loadu_ps(&m_vz[i]),dt)));
+    }
+  }
+#endif
+  for(; i<_end; ++i)
+  {
+    m_ox[i]=m_px[i];
+    m_oy[i]=m_py[i];
+    m_oz[i]=m_pz[i];
+    m_px[i]+=m_vx[i]*_dt;
+    m_py[i]+=m_vy[i]*_dt;
+    m_pz[i]+=m_vz[i]*_dt;
+  }
+}
+
+void RigidBodies::updateSleep(size_t _begin, size_t _end, float _dt)
+{
+  const float sleepSpeed2=m_config.sleepSpeed*m_config.sleepSpeed;
+  size_t i=_begin;
+#if defined(__SSE2__)
+  if(m_config.simd)
+  {
+    const __m128 limit=_mm_set1_ps(sleepSpeed2);
+    const __m128 dt=_mm_set1_ps(_dt);
+    const __m128 sleepTime=_mm_set1_ps(m_config.sleepTime);
+    for(; i+4<=_end; i+=4)
+    {
+      __m128 vx=_mm_loadu_ps(&m_vx[i]);
+      __m128 vy=_mm_loadu_ps(&m_vy[i]);
+      __m128 vz=_mm_loadu_ps(&m_vz[i]);
+      __m128 speed2=_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx,vx),_mm_mul_ps(vy,vy)),_mm_mul_ps(vz,vz));
+      __m128 slow=_mm_cmplt_ps(speed2,limit);
+      __m128 slowTime=_mm_and_ps(slow,_mm_add_ps(_mm_loadu_ps(&m_slowTime[i]),dt));
+      __m128 sleep=_mm_cmpgt_ps(slowTime,sleepTime);
+      _mm_storeu_ps(&m_slowTime[i],slowTime);
+      _mm_storeu_ps(&m_awake[i],_mm_andnot_ps(sleep,_mm_loadu_ps(&m_awake[i])));
+      _mm_storeu_ps(&m_vx[i],_mm_andnot_ps(sleep,vx));
+      _mm_storeu_ps(&m_vy[i],_mm_andnot_ps(sleep,vy));
+      _mm_storeu_ps(&m_vz[i],_mm_andnot_ps(sleep,vz));
+    }
+  }
+#endif
+  for(; i<_end; ++i)
+  {
+    float speed2=m_vx[i]*m_vx[i]+m_vy[i]*m_vy[i]+m_vz[i]*m_vz[i];
+    m_slowTime[i]=speed2<sleepSpeed2 ? m_slowTime[i]+_dt : 0.0f;
+    if(m_slowTime[i]>m_config.sleepTime)
+    {
+      m_awake[i]=0.0f;
+      m_vx[i]=0.0f;
+      m_vy[i]=0.0f;
+      m_vz[i]=0.0f;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// contacts. Each range of bodies writes its own contact list and the lists are joined in range order, so the
+// batch comes out in the same order whichever threads found it. Bodies woken by a hit are only woken once
+// the search is over for the same reason.
+//----------------------------------------------------------------------------------------------------------------------
+void RigidBodies::findContacts(float _dt)
+{
+  size_t ranges=(m_size+CONTACT_GRAIN-1)/CONTACT_GRAIN;
+  if(m_rangeContacts.size()<2*ranges)
+  {
+    m_rangeContacts.resize(2*ranges);
+    m_rangeWakes.resize(ranges);
+  }
+  // world contacts first so they come first in every island, see correctIslands
+  parallelFor(m_size,CONTACT_GRAIN,[this,_dt](size_t _begin, size_t _end)
+  {
+    std::vector<Contact> &contacts=m_rangeContacts[_begin/CONTACT_GRAIN];
+    contacts.clear();
+    if(m_world==nullptr)
+    {
+      return;
+    }
+    for(size_t i=_begin; i<_end; ++i)
+    {
+      if(m_awake[i]!=0.0f)
+      {
+        worldContacts(static_cast<uint32_t>(i),_dt,contacts);
+      }
+    }
+  });
+  buildGrid();
+  parallelFor(m_size,CONTACT_GRAIN,[this,ranges,_dt](size_t _begin, size_t _end)
+  {
+    std::vector<Contact> &contacts=m_rangeContacts[ranges+_begin/CONTACT_GRAIN];
+    std::vector<uint32_t> &wakes=m_rangeWakes[_begin/CONTACT_GRAIN];
+    contacts.clear();
+    wakes.clear();
+    bodyContacts(_begin,_end,_dt,contacts,wakes);
+  });
+  m_contacts.clear();
+  for(size_t r=0; r<2*ranges; ++r)
+  {
+    m_contacts.insert(m_contacts.end(),m_rangeContacts[r].begin(),m_rangeContacts[r].end());
+  }
+  for(size_t r=0; r<ranges; ++r)
+  {
+    for(uint32_t j : m_rangeWakes[r])
+    {
+      wake(j);
+    }
+  }
+}
+
+void RigidBodies::worldContacts(uint32_t _i, float _dt, std::vector<Contact> &o_contacts) const
+{
+  CollisionWorld::Hit hits[MAX_WORLD_CONTACTS];
+  size_t count=m_world->collideSphere(position(_i),m_reach[_i],hits,MAX_WORLD_CONTACTS);
+  for(size_t h=0; h<count; ++h)
+  {
+    // the hit depth is measured from the reach, the separation from the surface
+    o_contacts.push_back(makeContact(_i,NO_BODY,hits[h].m_normal,m_reach[_i]-m_radius[_i]-hits[h].m_depth,_dt));
+  }
+}
+
+size_t RigidBodies::cell(int _x, int _y, int _z) const
+{
+  // rows along x hash together and x is added afterwards, so the three cells of a row that a body
+  // searches are neighbouring buckets and their bodies one contiguous run of m_cellItems
+  uint32_t h=(static_cast<uint32_t>(_y)*19349663u)^(static_cast<uint32_t>(_z)*83492791u);
+  return (h+static_cast<uint32_t>(_x))&static_cast<uint32_t>(m_cellMask);
+}
+
+namespace
+{
+
+const uint64_t KEY_MASK=0x1fffff;
+
+// the exact cell, buckets can hold several cells that hash alike
+uint64_t cellKey(int _x, int _y, int _z)
+{
+  return ((static_cast<uint64_t>(_x)&KEY_MASK)<<42)|((static_cast<uint64_t>(_y)&KEY_MASK)<<21)|(static_cast<uint64_t>(_z)&KEY_MASK);
+}
+
+// whether _key is one of the cells _x-1 to _x+1 of row _y _z
+bool inRow(uint64_t _key, int _x, int _y, int _z)
+{
+  uint64_t dx=((_key>>42)-static_cast<uint64_t>(_x-1))&KEY_MASK;
+  return (_key&((KEY_MASK<<21)|KEY_MASK))==(cellKey(0,_y,_z)) && dx<3;
+}
+
+} // end anonymous namespace
+
+void RigidBodies::buildGrid()
+{
+  size_t buckets=64;
+  while(buckets<2*m_size)
+  {
+    buckets*=2;
+  }
+  m_cellMask=static_cast<int>(buckets-1);
+  m_cellOf.resize(m_size);
+  m_bodyKeys.resize(m_size);
+  const float inv=1.0f/m_config.cellSize;
+  parallelFor(m_size,BODY_GRAIN,[this,inv](size_t _begin, size_t _end)
+  {
+    for(size_t i=_begin; i<_end; ++i)
+    {
+      int x=static_cast<int>(std::floor(m_px[i]*inv));
+      int y=static_cast<int>(std::floor(m_py[i]*inv));
+      int z=static_cast<int>(std::floor(m_pz[i]*inv));
+      m_cellOf[i]=static_cast<uint32_t>(cell(x,y,z));
+      m_bodyKeys[i]=cellKey(x,y,z);
+    }
+  });
+  // the counting sort itself is serial, it is a few ns a body
+  m_cellStart.assign(buckets+1,0);
+  for(uint32_t i=0; i<m_size; ++i)
+  {
+    ++m_cellStart[m_cellOf[i]+1];
+  }
+  for(size_t b=0; b<buckets; ++b)
+  {
+    m_cellStart[b+1]+=m_cellStart[b];
+  }
+  // bodies are copied out in bucket order so scanning a bucket reads contiguous memory
+  m_cellItems.resize(m_size);
+  m_cellKeys.resize(m_size);
+  m_cellBodies.resize(4*m_size);
+  std::vector<uint32_t> fill(m_cellStart.begin(),m_cellStart.end()-1);
+  for(uint32_t i=0; i<m_size; ++i)
+  {
+    uint32_t k=fill[m_cellOf[i]]++;
+    m_cellItems[k]=i;
+    m_cellKeys[k]=m_bodyKeys[i];
+    m_cellBodies[4*k]=m_px[i];
+    m_cellBodies[4*k+1]=m_py[i];
+    m_cellBodies[4*k+2]=m_pz[i];
+    m_cellBodies[4*k+3]=m_reach[i];
+  }
+}
+
+void RigidBodies::bodyContacts(size_t _begin, size_t _end, float _dt, std::vector<Contact> &o_contacts,
+                               std::vector<uint32_t> &o_wakes) const
+{
+  const float inv=1.0f/m_config.cellSize;
+  // walking the bodies in bucket order means bodies sharing a cell look at the same neighbour buckets one
+  // after another while they are still in cache
+  for(size_t item=_begin; item<_end; ++item)
+  {
+    uint32_t i=m_cellItems[item];
+    if(m_awake[i]==0.0f)
+    {
+      continue;
+    }
+    const float px=m_cellBodies[4*item];
+    const float py=m_cellBodies[4*item+1];
+    const float pz=m_cellBodies[4*item+2];
+    const float reach=m_cellBodies[4*item+3];
+    int cx=static_cast<int>(std::floor(px*inv));
+    int cy=static_cast<int>(std::floor(py*inv));
+    int cz=static_cast<int>(std::floor(pz*inv));
+    for(int z=cz-1; z<=cz+1; ++z)
+    {
+      for(int y=cy-1; y<=cy+1; ++y)
+      {
+        const size_t first=cell(cx-1,y,z);
+        // the row only wraps at the end of the table, then each cell is its own run
+        const int runs=first+3<=static_cast<size_t>(m_cellMask)+1 ? 1 : 3;
+        for(int run=0; run<runs; ++run)
+        {
+          const size_t b=runs==1 ? first : cell(cx-1+run,y,z);
+          const uint32_t end=m_cellStart[b+(runs==1 ? 3 : 1)];
+          for(uint32_t k=m_cellStart[b]; k<end; ++k)
+          {
+            const float *body=&m_cellBodies[4*k];
+            float dx=px-body[0];
+            float dy=py-body[1];
+            float dz=pz-body[2];
+            float limit=reach+body[3];
+            float dist2=dx*dx+dy*dy+dz*dz;
+            // buckets can hold other cells that hash alike, only bodies really in this row are taken so
+            // none is reported twice
+            if(dist2>=limit*limit || !inRow(m_cellKeys[k],cx,y,z))
+            {
+              continue;
+            }
+            uint32_t j=m_cellItems[k];
+            // a pair of awake bodies is found from both sides, keep the one from the lower index
+            if(j==i || (m_awake[j]!=0.0f && j<i))
+            {
+              continue;
+            }
+            float dist=std::sqrt(dist2);
+            Vec3 n=dist>0.0f ? Vec3(dx,dy,dz)/dist : Vec3(0.0f,1.0f,0.0f);
+            float separation=dist-m_radius[i]-m_radius[j];
+            if(m_awake[j]==0.0f && m_invMass[j]>0.0f && separation<0.0f && reach-m_radius[i]>m_config.sleepSpeed*_dt)
+            {
+              o_wakes.push_back(j);
+            }
+            o_contacts.push_back(makeContact(i,j,n,separation,_dt));
+          }
+        }
+      }
+    }
+  }
+}
+
+RigidBodies::Contact RigidBodies::makeContact(uint32_t _a, uint32_t _b, const Vec3 &_normal, float _separation, float _dt) const
+{
+  Contact c;
+  c.m_a=_a;
+  c.m_b=_b;
+  c.m_normal=_normal;
+  c.m_separation=_separation;
+  Vec3 vrel=velocity(_a);
+  float restitution=m_restitution[_a];
+  c.m_friction=m_friction[_a];
+  if(_b!=NO_BODY)
+  {
+    vrel-=velocity(_b);
+    restitution=std::max(restitution,m_restitution[_b]);
+    c.m_friction=std::sqrt(c.m_friction*m_friction[_b]);
+  }
+  float vn=vrel.dot(_normal);
+  if(_separation>0.0f)
+  {
+    // speculative, the body may close the gap this step but not pass through
+    c.m_target=-_separation/_dt;
+  }
+  else
+  {
+    c.m_target=vn<-m_config.restSpeed ? -restitution*vn : 0.0f;
+  }
+  Vec3 vt=vrel-_normal*vn;
+  float vtLength=vt.length();
+  c.m_tangent=vtLength>1.0e-6f ? vt/vtLength : Vec3();
+  c.m_normalImpulse=0.0f;
+  c.m_tangentImpulse=0.0f;
+  return c;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// islands, bodies joined by contacts through other moving bodies. Static geometry and sleeping bodies are not
+// moved by the solver so they do not join islands, and two islands never write the same body.
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t RigidBodies::findRoot(uint32_t _i)
+{
+  while(m_islandParent[_i]!=_i)
+  {
+    m_islandParent[_i]=m_islandParent[m_islandParent[_i]];
+    _i=m_islandParent[_i];
+  }
+  return _i;
+}
+
+void RigidBodies::buildIslands()
+{
+  m_islandParent.resize(m_size);
+  for(uint32_t i=0; i<m_size; ++i)
+  {
+    m_islandParent[i]=i;
+  }
+  // masses are fixed for the step, bodies woken while finding contacts are awake by now
+  for(Contact &c : m_contacts)
+  {
+    c.m_inverseMassA=effectiveInverseMass(c.m_a);
+    c.m_inverseMassB=effectiveInverseMass(c.m_b);
+    if(c.m_inverseMassA!=0.0f && c.m_inverseMassB!=0.0f)
+    {
+      uint32_t a=findRoot(c.m_a);
+      uint32_t b=findRoot(c.m_b);
+      // the lower index wins so the roots do not depend on anything but the contact order
+      m_islandParent[std::max(a,b)]=std::min(a,b);
+    }
+  }
+  // number the islands in order of first contact and counting sort the contacts into them, the order
+  // within an island stays the batch order
+  m_islandOf.assign(m_size,NO_BODY);
+  m_islandStart.clear();
+  m_islandStart.push_back(0);
+  m_contactIsland.resize(m_contacts.size());
+  for(size_t i=0; i<m_contacts.size(); ++i)
+  {
+    uint32_t root=findRoot(m_contacts[i].m_a);
+    if(m_islandOf[root]==NO_BODY)
+    {
+      m_islandOf[root]=static_cast<uint32_t>(m_islandStart.size()-1);
+      m_islandStart.push_back(0);
+    }
+    m_contactIsland[i]=m_islandOf[root];
+    ++m_islandStart[m_contactIsland[i]+1];
+  }
+  m_islandCount=m_islandStart.size()-1;
+  for(size_t k=0; k<m_islandCount; ++k)
+  {
+    m_islandStart[k+1]+=m_islandStart[k];
+  }
+  m_islandContacts.resize(m_contacts.size());
+  std::vector<uint32_t> fill(m_islandStart.begin(),m_islandStart.end()-1);
+  for(size_t i=0; i<m_contacts.size(); ++i)
+  {
+    m_islandContacts[fill[m_contactIsland[i]]++]=m_contacts[i];
+  }
+}
+
+void RigidBodies::solveIslands(size_t _begin, size_t _end)
+{
+  for(size_t island=_begin; island<_end; ++island)
+  {
+    Contact *first=&m_islandContacts[m_islandStart[island]];
+    Contact *last=&m_islandContacts[m_islandStart[island+1]];
+    for(int iteration=0; iteration<m_config.iterations; ++iteration)
+    {
+      for(Contact *c=first; c!=last; ++c)
+      {
+        solveContact(*c);
+      }
+    }
+  }
+}
+
+void RigidBodies::solveContact(Contact &_c)
+{
+  const float ia=_c.m_inverseMassA;
+  const float ib=_c.m_inverseMassB;
+  const float k=ia+ib;
+  if(k==0.0f)
+  {
+    return;
+  }
+  Vec3 vrel=velocity(_c.m_a);
+  if(_c.m_b!=NO_BODY)
+  {
+    vrel-=velocity(_c.m_b);
+  }
+  // normal impulse, the accumulated total can push but never pull
+  float vn=vrel.dot(_c.m_normal);
+  float total=std::max(_c.m_normalImpulse+(_c.m_target-vn)/k,0.0f);
+  float jn=total-_c.m_normalImpulse;
+  _c.m_normalImpulse=total;
+  // Coulomb friction, bounded by the normal impulse so far. The tangent is perpendicular to the normal
+  // so the normal impulse just applied does not change the tangential speed.
+  float vt=vrel.dot(_c.m_tangent);
+  float limit=_c.m_friction*_c.m_normalImpulse;
+  float tangentTotal=clampf(_c.m_tangentImpulse-vt/k,-limit,limit);
+  float jt=tangentTotal-_c.m_tangentImpulse;
+  _c.m_tangentImpulse=tangentTotal;
+  Vec3 j=_c.m_normal*jn+_c.m_tangent*jt;
+  if(ia!=0.0f)
+  {
+    m_vx[_c.m_a]+=j.m_x*ia;
+    m_vy[_c.m_a]+=j.m_y*ia;
+    m_vz[_c.m_a]+=j.m_z*ia;
+  }
+  // bodies of other islands may read a static or sleeping b, it is never written
+  if(ib!=0.0f)
+  {
+    m_vx[_c.m_b]-=j.m_x*ib;
+    m_vy[_c.m_b]-=j.m_y*ib;
+    m_vz[_c.m_b]-=j.m_z*ib;
+  }
+}
+
+void RigidBodies::correctIslands(size_t _begin, size_t _end)
+{
+  // the velocity solver alone lets deep piles sag, so overlaps left at the end of the step are projected
+  // out in a few Gauss-Seidel passes. World contacts come first in each island, walking backwards lets them
+  // have the last word so a pile cannot push its bottom layer through the floor.
+  for(size_t island=_begin; island<_end; ++island)
+  {
+    const Contact *first=&m_islandContacts[m_islandStart[island]];
+    const Contact *last=&m_islandContacts[m_islandStart[island+1]];
+    for(int iteration=0; iteration<m_config.iterations; ++iteration)
+    {
+      for(const Contact *c=last; c!=first; )
+      {
+        correctContact(*--c);
+      }
+    }
+  }
+}
+
+void RigidBodies::correctContact(const Contact &_c)
+{
+  const float ia=_c.m_inverseMassA;
+  const float ib=_c.m_inverseMassB;
+  const float k=ia+ib;
+  if(k==0.0f)
+  {
+    return;
+  }
+  // the separation now, from how far the bodies moved along the normal since the start of the step
+  Vec3 moved(m_px[_c.m_a]-m_ox[_c.m_a],m_py[_c.m_a]-m_oy[_c.m_a],m_pz[_c.m_a]-m_oz[_c.m_a]);
+  if(_c.m_b!=NO_BODY)
+  {
+    moved-=Vec3(m_px[_c.m_b]-m_ox[_c.m_b],m_py[_c.m_b]-m_oy[_c.m_b],m_pz[_c.m_b]-m_oz[_c.m_b]);
+  }
+  float separation=_c.m_separation+moved.dot(_c.m_normal);
+  if(separation>=-SLOP)
+  {
+    return;
+  }
+  Vec3 push=_c.m_normal*((-separation-SLOP)*CORRECTION/k);
+  if(ia!=0.0f)
+  {
+    m_px[_c.m_a]+=push.m_x*ia;
+    m_py[_c.m_a]+=push.m_y*ia;
+    m_pz[_c.m_a]+=push.m_z*ia;
+  }
+  if(ib!=0.0f)
+  {
+    m_px[_c.m_b]-=push.m_x*ib;
+    m_py[_c.m_b]-=push.m_y*ib;
+    m_pz[_c.m_b]-=push.m_z*ib;
+  }
+}
+
+} // end namespace fps
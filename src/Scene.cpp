@@ -0,0 +1,488 @@
+#include "Scene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fps
+{
+
+const uint32_t Scene::VERSION;
+const size_t SceneMesh::NAME_SIZE;
+
+static const char MAGIC[8]={'F','P','S','S','C','N','\n','\0'};
+// sections start on a cache line so the transform array can be uploaded directly
+static const size_t SECTION_ALIGN=64;
+static const size_t RECORD_SIZE[Scene::NUM_SECTIONS]=
+{
+  sizeof(SceneMesh),sizeof(SceneVertex),sizeof(SceneMaterial),sizeof(SceneObject),16*sizeof(float)
+};
+
+static size_t alignUp(size_t _v)
+{
+  return (_v+SECTION_ALIGN-1)&~(SECTION_ALIGN-1);
+}
+
+Scene::~Scene()
+{
+  close();
+}
+
+void Scene::close()
+{
+  if(m_map)
+  {
+    munmap(m_map,m_size);
+    m_map=nullptr;
+  }
+  m_image=nullptr;
+  m_header=nullptr;
+  m_size=0;
+}
+
+int Scene::findMesh(const std::string &_name) const
+{
+  for(size_t i=0; i<meshCount(); ++i)
+  {
+    if(_name==meshes()[i].m_name)
+    {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+bool Scene::open(const std::string &_fname)
+{
+  close();
+  int fd=::open(_fname.c_str(),O_RDONLY);
+  if(fd<0)
+  {
+    m_error=_fname+": cannot open";
+    return false;
+  }
+  struct stat st;
+  char magic[sizeof(MAGIC)]={0};
+  if(fstat(fd,&st)!=0 || pread(fd,magic,sizeof(magic),0)<0)
+  {
+    ::close(fd);
+    m_error=_fname+": cannot read";
+    return false;
+  }
+  if(static_cast<size_t>(st.st_size)<sizeof(Header) || std::memcmp(magic,MAGIC,sizeof(MAGIC))!=0)
+  {
+    // not compiled, treat it as text
+    ::close(fd);
+    std::ifstream in(_fname.c_str());
+    std::stringstream text;
+    text<<in.rdbuf();
+    return compile(text.str(),_fname);
+  }
+  void *map=mmap(nullptr,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  ::close(fd);
+  if(map==MAP_FAILED)
+  {
+    m_error=_fname+": mmap failed";
+    return false;
+  }
+  madvise(map,st.st_size,MADV_WILLNEED);
+  m_map=map;
+  m_image=static_cast<const unsigned char *>(map);
+  m_size=st.st_size;
+  if(!validate(m_size))
+  {
+    m_error=_fname+": "+m_error;
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool Scene::validate(size_t _size)
+{
+  const Header *header=reinterpret_cast<const Header *>(m_image);
+  if(header->m_version!=VERSION || header->m_sectionCount!=NUM_SECTIONS)
+  {
+    m_error="unsupported scene version";
+    return false;
+  }
+  for(int i=0; i<NUM_SECTIONS; ++i)
+  {
+    const SectionEntry &s=header->m_sections[i];
+    if(s.m_offset%SECTION_ALIGN!=0 || s.m_offset>_size || s.m_count>(_size-s.m_offset)/RECORD_SIZE[i])
+    {
+      m_error="corrupt section table";
+      return false;
+    }
+  }
+  if(header->m_sections[TRANSFORMS].m_count!=header->m_sections[OBJECTS].m_count)
+  {
+    m_error="transform count does not match object count";
+    return false;
+  }
+  m_header=header;
+  // indices are checked once here so the accessors can be used without checks
+  for(size_t i=0; i<meshCount(); ++i)
+  {
+    const SceneMesh &m=meshes()[i];
+    if(m.m_name[SceneMesh::NAME_SIZE-1]!='\0' || m.m_primitive[SceneMesh::NAME_SIZE-1]!='\0' ||
+       m.m_firstVertex>vertexCount() || m.m_vertexCount>vertexCount()-m.m_firstVertex)
+    {
+      m_header=nullptr;
+      m_error="bad mesh record";
+      return false;
+    }
+  }
+  for(size_t i=0; i<objectCount(); ++i)
+  {
+    const SceneObject &o=objects()[i];
+    if(o.m_mesh>=meshCount() || o.m_material>=materialCount())
+    {
+      m_header=nullptr;
+      m_error="bad object record";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Scene::save(const std::string &_fname)
+{
+  if(!m_header)
+  {
+    m_error="no scene loaded";
+    return false;
+  }
+  FILE *out=std::fopen(_fname.c_str(),"wb");
+  if(!out)
+  {
+    m_error=_fname+": cannot create";
+    return false;
+  }
+  bool ok=std::fwrite(m_image,1,m_size,out)==m_size;
+  ok=(std::fclose(out)==0) && ok;
+  if(!ok)
+  {
+    m_error=_fname+": write failed";
+  }
+  return ok;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// text compiler
+//----------------------------------------------------------------------------------------------------------------------
+namespace
+{
+
+void copyName(char *o_dst, const std::string &_src)
+{
+  std::memset(o_dst,0,SceneMesh::NAME_SIZE);
+  std::strncpy(o_dst,_src.c_str(),SceneMesh::NAME_SIZE-1);
+}
+
+// model matrix in ngl order, scale then rotate about x, y, z then translate
+void buildTransform(const Vec3 &_pos, const Vec3 &_rot, float _scale, float *o_m)
+{
+  const float toRad=3.14159265358979f/180.0f;
+  float cx=std::cos(_rot.m_x*toRad), sx=std::sin(_rot.m_x*toRad);
+  float cy=std::cos(_rot.m_y*toRad), sy=std::sin(_rot.m_y*toRad);
+  float cz=std::cos(_rot.m_z*toRad), sz=std::sin(_rot.m_z*toRad);
+  Mat4 rx, ry, rz, s;
+  rx.m_m[1][1]=cx; rx.m_m[1][2]=sx; rx.m_m[2][1]=-sx; rx.m_m[2][2]=cx;
+  ry.m_m[0][0]=cy; ry.m_m[0][2]=-sy; ry.m_m[2][0]=sy; ry.m_m[2][2]=cy;
+  rz.m_m[0][0]=cz; rz.m_m[0][1]=sz; rz.m_m[1][0]=-sz; rz.m_m[1][1]=cz;
+  s.m_m[0][0]=_scale; s.m_m[1][1]=_scale; s.m_m[2][2]=_scale;
+  Mat4 m=s*rx*ry*rz;
+  m.m_m[3][0]=_pos.m_x;
+  m.m_m[3][1]=_pos.m_y;
+  m.m_m[3][2]=_pos.m_z;
+  std::memcpy(o_m,&m.m_m[0][0],16*sizeof(float));
+}
+
+bool readVec3(std::istringstream &_in, Vec3 &o_v)
+{
+  return static_cast<bool>(_in>>o_v.m_x>>o_v.m_y>>o_v.m_z);
+}
+
+bool readColour(std::istringstream &_in, float *o_c)
+{
+  o_c[3]=1.0f;
+  return static_cast<bool>(_in>>o_c[0]>>o_c[1]>>o_c[2]);
+}
+
+} // end anonymous namespace
+
+bool Scene::compile(const std::string &_text, const std::string &_source)
+{
+  close();
+  std::vector<SceneMesh> meshes;
+  std::vector<SceneVertex> vertices;
+  std::vector<SceneMaterial> materials;
+  std::vector<SceneObject> objects;
+  std::vector<float> transforms;
+  std::map<std::string,uint32_t> meshIndex;
+  std::map<std::string,uint32_t> materialIndex;
+
+  std::istringstream text(_text);
+  std::string line;
+  int lineNumber=0;
+  // set while reading the v lines of a vertex mesh
+  SceneMesh *current=nullptr;
+  auto fail=[&](const std::string &_what)
+  {
+    m_error=_source+":"+std::to_string(lineNumber)+": "+_what;
+    return false;
+  };
+  while(std::getline(text,line))
+  {
+    ++lineNumber;
+    line=line.substr(0,line.find('#'));
+    std::istringstream in(line);
+    std::string keyword;
+    if(!(in>>keyword))
+    {
+      continue;
+    }
+    if(current)
+    {
+      if(keyword=="v")
+      {
+        Vec3 v;
+        if(!readVec3(in,v))
+        {
+          return fail("expected v x y z");
+        }
+        vertices.push_back({v.m_x,v.m_y,v.m_z});
+        ++current->m_vertexCount;
+        current->m_radius=std::max(current->m_radius,v.length());
+      }
+      else if(keyword=="end")
+      {
+        current=nullptr;
+      }
+      else
+      {
+        return fail("expected v or end inside mesh");
+      }
+    }
+    else if(keyword=="material")
+    {
+      std::string name;
+      if(!(in>>name) || materialIndex.count(name))
+      {
+        return fail("material needs a unique name");
+      }
+      SceneMaterial m;
+      std::memset(&m,0,sizeof(m));
+      copyName(m.m_name,name);
+      m.m_ambient[3]=m.m_diffuse[3]=m.m_specular[3]=1.0f;
+      std::string key;
+      while(in>>key)
+      {
+        bool ok= key=="ambient" ? readColour(in,m.m_ambient) :
+                 key=="diffuse" ? readColour(in,m.m_diffuse) :
+                 key=="specular" ? readColour(in,m.m_specular) :
+                 key=="shininess" ? static_cast<bool>(in>>m.m_shininess) : false;
+        if(!ok)
+        {
+          return fail("bad material field '"+key+"'");
+        }
+      }
+      materialIndex[name]=static_cast<uint32_t>(materials.size());
+      materials.push_back(m);
+    }
+    else if(keyword=="mesh")
+    {
+      std::string name;
+      std::string mode;
+      if(!(in>>name>>mode) || meshIndex.count(name))
+      {
+        return fail("mesh needs a unique name and a type");
+      }
+      SceneMesh m;
+      std::memset(&m,0,sizeof(m));
+      copyName(m.m_name,name);
+      m.m_firstVertex=static_cast<uint32_t>(vertices.size());
+      if(mode=="primitive")
+      {
+        std::string primitive;
+        std::string key;
+        if(!(in>>primitive>>key>>m.m_radius) || key!="radius")
+        {
+          return fail("expected mesh name primitive prim radius r");
+        }
+        m.m_mode=SceneMesh::PRIMITIVE;
+        copyName(m.m_primitive,primitive);
+      }
+      else if(mode=="lines" || mode=="triangles")
+      {
+        m.m_mode= mode=="lines" ? SceneMesh::LINES : SceneMesh::TRIANGLES;
+      }
+      else
+      {
+        return fail("unknown mesh type '"+mode+"'");
+      }
+      meshIndex[name]=static_cast<uint32_t>(meshes.size());
+      meshes.push_back(m);
+      if(m.m_mode!=SceneMesh::PRIMITIVE)
+      {
+        current=&meshes.back();
+      }
+    }
+    else if(keyword=="object")
+    {
+      std::string mesh;
+      std::string material;
+      if(!(in>>mesh>>material))
+      {
+        return fail("expected object mesh material");
+      }
+      if(!meshIndex.count(mesh))
+      {
+        return fail("unknown mesh '"+mesh+"'");
+      }
+      if(!materialIndex.count(material))
+      {
+        return fail("unknown material '"+material+"'");
+      }
+      SceneObject o;
+      std::memset(&o,0,sizeof(o));
+      o.m_mesh=meshIndex[mesh];
+      o.m_material=materialIndex[material];
+      Vec3 pos;
+      Vec3 rot;
+      float scale=1.0f;
+      std::string key;
+      while(in>>key)
+      {
+        bool ok=true;
+        if(key=="position")
+        {
+          ok=readVec3(in,pos);
+        }
+        else if(key=="rotate")
+        {
+          ok=readVec3(in,rot);
+        }
+        else if(key=="scale")
+        {
+          ok=static_cast<bool>(in>>scale);
+        }
+        else if(key=="collider")
+        {
+          std::string type;
+          float *p=o.m_collider.m_params;
+          in>>type;
+          if(type=="sphere")
+          {
+            o.m_collider.m_type=SceneCollider::SPHERE;
+            ok=static_cast<bool>(in>>p[0]);
+          }
+          else if(type=="box")
+          {
+            o.m_collider.m_type=SceneCollider::BOX;
+            ok=static_cast<bool>(in>>p[0]>>p[1]>>p[2]);
+          }
+          else if(type=="plane")
+          {
+            o.m_collider.m_type=SceneCollider::PLANE;
+            ok=static_cast<bool>(in>>p[0]>>p[1]>>p[2]>>p[3]);
+          }
+          else if(type=="mesh")
+          {
+            o.m_collider.m_type=SceneCollider::MESH;
+          }
+          else if(type=="sdf")
+          {
+            o.m_collider.m_type=SceneCollider::SDF;
+          }
+          else
+          {
+            return fail("unknown collider '"+type+"'");
+          }
+        }
+        else
+        {
+          ok=false;
+        }
+        if(!ok)
+        {
+          return fail("bad object field '"+key+"'");
+        }
+      }
+      // collider sizes are given in object units
+      if(o.m_collider.m_type==SceneCollider::SPHERE || o.m_collider.m_type==SceneCollider::BOX)
+      {
+        for(int i=0; i<3; ++i)
+        {
+          o.m_collider.m_params[i]*=scale;
+        }
+      }
+      else if(o.m_collider.m_type==SceneCollider::SDF)
+      {
+        if(!(scale>0.0f))
+        {
+          return fail("sdf collider needs a positive scale");
+        }
+        o.m_collider.m_params[0]=scale;
+      }
+      AABB box=AABB::fromSphere(pos,meshes[o.m_mesh].m_radius*std::fabs(scale));
+      std::memcpy(o.m_bounds,&box.m_min.m_x,3*sizeof(float));
+      std::memcpy(o.m_bounds+3,&box.m_max.m_x,3*sizeof(float));
+      std::memcpy(o.m_position,&pos.m_x,3*sizeof(float));
+      std::memcpy(o.m_rotation,&rot.m_x,3*sizeof(float));
+      o.m_scale=scale;
+      objects.push_back(o);
+      transforms.resize(transforms.size()+16);
+      buildTransform(pos,rot,scale,&transforms[transforms.size()-16]);
+    }
+    else
+    {
+      return fail("unknown keyword '"+keyword+"'");
+    }
+  }
+  if(current)
+  {
+    return fail("mesh not closed with end");
+  }
+
+  // lay the image out exactly as a compiled file
+  const void *data[NUM_SECTIONS]={meshes.data(),vertices.data(),materials.data(),objects.data(),transforms.data()};
+  const size_t counts[NUM_SECTIONS]={meshes.size(),vertices.size(),materials.size(),objects.size(),objects.size()};
+  Header header;
+  std::memset(&header,0,sizeof(header));
+  std::memcpy(header.m_magic,MAGIC,sizeof(MAGIC));
+  header.m_version=VERSION;
+  header.m_sectionCount=NUM_SECTIONS;
+  size_t offset=alignUp(sizeof(Header));
+  for(int i=0; i<NUM_SECTIONS; ++i)
+  {
+    header.m_sections[i].m_offset=offset;
+    header.m_sections[i].m_count=counts[i];
+    offset=alignUp(offset+counts[i]*RECORD_SIZE[i]);
+  }
+  m_compiled.resize(offset);
+  unsigned char *image=m_compiled.data();
+  std::memset(image,0,offset);
+  std::memcpy(image,&header,sizeof(header));
+  for(int i=0; i<NUM_SECTIONS; ++i)
+  {
+    if(counts[i])
+    {
+      std::memcpy(image+header.m_sections[i].m_offset,data[i],counts[i]*RECORD_SIZE[i]);
+    }
+  }
+  m_image=image;
+  m_size=offset;
+  return validate(m_size);
+}
+
+} // end namespace fps
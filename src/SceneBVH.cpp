@@ -0,0 +1,131 @@
+#include "SceneBVH.h"
+#include <algorithm>
+
+namespace fps
+{
+
+const uint32_t SceneBVH::LEAF_SIZE;
+
+void SceneBVH::build(const std::vector<AABB> &_bounds)
+{
+  m_bounds=_bounds;
+  m_nodes.clear();
+  m_order.resize(_bounds.size());
+  if(_bounds.empty())
+  {
+    return;
+  }
+  std::vector<Vec3> centres(_bounds.size());
+  for(uint32_t i=0; i<_bounds.size(); ++i)
+  {
+    m_order[i]=i;
+    centres[i]=_bounds[i].centre();
+  }
+  // a binary tree with leaves of LEAF_SIZE has at most 2n/LEAF_SIZE nodes
+  m_nodes.reserve(2*_bounds.size()/LEAF_SIZE+1);
+  buildRange(0,static_cast<uint32_t>(_bounds.size()),centres);
+}
+
+uint32_t SceneBVH::buildRange(uint32_t _first, uint32_t _count, std::vector<Vec3> &_centres)
+{
+  uint32_t index=static_cast<uint32_t>(m_nodes.size());
+  m_nodes.push_back(Node());
+  AABB box;
+  AABB centreBox;
+  for(uint32_t i=_first; i<_first+_count; ++i)
+  {
+    box.extend(m_bounds[m_order[i]]);
+    centreBox.extend(_centres[m_order[i]]);
+  }
+  m_nodes[index].m_box=box;
+  m_nodes[index].m_first=_first;
+  m_nodes[index].m_count=_count;
+  m_nodes[index].m_right=0;
+  if(_count<=LEAF_SIZE)
+  {
+    return index;
+  }
+  // median split along the longest axis of the centres, cheap to build and keeps the tree balanced
+  Vec3 size=centreBox.m_max-centreBox.m_min;
+  int axis=0;
+  if(size.m_y>size.m_x)
+  {
+    axis=1;
+  }
+  if(size.m_z>(axis==0 ? size.m_x : size.m_y))
+  {
+    axis=2;
+  }
+  uint32_t half=_count/2;
+  uint32_t *begin=&m_order[_first];
+  std::nth_element(begin,begin+half,begin+_count,[&_centres,axis](uint32_t _a, uint32_t _b)
+  {
+    const Vec3 &a=_centres[_a];
+    const Vec3 &b=_centres[_b];
+    return axis==0 ? a.m_x<b.m_x : axis==1 ? a.m_y<b.m_y : a.m_z<b.m_z;
+  });
+  buildRange(_first,half,_centres);
+  uint32_t right=buildRange(_first+half,_count-half,_centres);
+  m_nodes[index].m_right=right;
+  return index;
+}
+
+void SceneBVH::emit(const Node &_node, std::vector<uint32_t> &o_visible) const
+{
+  o_visible.insert(o_visible.end(),m_order.begin()+_node.m_first,m_order.begin()+_node.m_first+_node.m_count);
+}
+
+void SceneBVH::cull(const Frustum &_frustum, std::vector<uint32_t> &o_visible) const
+{
+  o_visible.clear();
+  if(m_nodes.empty())
+  {
+    return;
+  }
+  // depth is log2(n/LEAF_SIZE) for the median split so a small fixed stack is enough
+  uint32_t stack[64];
+  int top=0;
+  stack[top++]=0;
+  while(top>0)
+  {
+    const Node &node=m_nodes[stack[--top]];
+    Frustum::Result result=_frustum.classify(node.m_box);
+    if(result==Frustum::OUTSIDE)
+    {
+      continue;
+    }
+    if(result==Frustum::INSIDE)
+    {
+      emit(node,o_visible);
+    }
+    else if(node.m_right==0)
+    {
+      for(uint32_t i=node.m_first; i<node.m_first+node.m_count; ++i)
+      {
+        if(_frustum.visible(m_bounds[m_order[i]]))
+        {
+          o_visible.push_back(m_order[i]);
+        }
+      }
+    }
+    else
+    {
+      stack[top++]=node.m_right;
+      stack[top++]=static_cast<uint32_t>(&node-&m_nodes[0])+1;
+    }
+  }
+}
+
+void SceneBVH::cullBruteForce(const Frustum &_frustum, std::vector<uint32_t> &o_visible) const
+{
+  o_visible.clear();
+  for(uint32_t i=0; i<m_bounds.size(); ++i)
+  {
+    if(_frustum.visible(m_bounds[i]))
+    {
+      o_visible.push_back(i);
+    }
+  }
+}
+
+} // end namespace fps
@@ -0,0 +1,293 @@
+#include "SdfBrickCache.h"
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <utility>
+
+namespace fps
+{
+
+const int SdfBrickCache::BRICK;
+const int SdfBrickCache::SAMPLES;
+
+namespace
+{
+
+// brick coordinates packed 21 bits a side, enough for two million bricks along each axis
+const int KEY_BITS=21;
+const uint64_t KEY_MASK=(uint64_t(1)<<KEY_BITS)-1;
+// far bricks cost only a table entry, this many per baked brick the budget allows
+const size_t FAR_ENTRIES_PER_SLOT=4;
+
+float mix(float _a, float _b, float _t)
+{
+  return _a+(_b-_a)*_t;
+}
+
+int32_t unpack(uint64_t _bits)
+{
+  // sign extend the 21 bit field
+  int32_t v=static_cast<int32_t>(_bits&KEY_MASK);
+  return v>=(1<<(KEY_BITS-1)) ? v-(1<<KEY_BITS) : v;
+}
+
+} // end anonymous namespace
+
+SdfBrickCache::SdfBrickCache(const SdfScene &_scene, const Settings &_settings) :
+  m_scene(_scene),
+  m_settings(_settings)
+{
+  m_brickSize=m_settings.m_voxelSize*BRICK;
+  m_invVoxel=1.0f/m_settings.m_voxelSize;
+  m_invBrick=1.0f/m_brickSize;
+  m_maxSlots=std::max<size_t>(1,m_settings.m_budgetBytes/(SAMPLES*sizeof(float)));
+  m_maxEntries=m_maxSlots*(FAR_ENTRIES_PER_SLOT+1);
+}
+
+void SdfBrickCache::clear()
+{
+  m_entries.clear();
+  m_samples.clear();
+  m_slotCount=0;
+  m_free.clear();
+  std::lock_guard<std::mutex> lock(m_requestMutex);
+  m_requests.clear();
+}
+
+uint64_t SdfBrickCache::key(const Vec3 &_p) const
+{
+  uint64_t x=static_cast<uint64_t>(static_cast<int64_t>(std::floor(_p.m_x*m_invBrick)))&KEY_MASK;
+  uint64_t y=static_cast<uint64_t>(static_cast<int64_t>(std::floor(_p.m_y*m_invBrick)))&KEY_MASK;
+  uint64_t z=static_cast<uint64_t>(static_cast<int64_t>(std::floor(_p.m_z*m_invBrick)))&KEY_MASK;
+  return (x<<(2*KEY_BITS))|(y<<KEY_BITS)|z;
+}
+
+Vec3 SdfBrickCache::brickOrigin(uint64_t _key) const
+{
+  return Vec3(static_cast<float>(unpack(_key>>(2*KEY_BITS))),static_cast<float>(unpack(_key>>KEY_BITS)),
+              static_cast<float>(unpack(_key)))*m_brickSize;
+}
+
+const SdfBrickCache::Entry * SdfBrickCache::find(const Vec3 &_p) const
+{
+  uint64_t k=key(_p);
+  std::unordered_map<uint64_t,Entry>::const_iterator it=m_entries.find(k);
+  if(it==m_entries.end())
+  {
+    // a sweep steps through the same missing brick many times, update() sorts out the rest
+    std::lock_guard<std::mutex> lock(m_requestMutex);
+    if(m_requests.empty() || m_requests.back()!=k)
+    {
+      m_requests.push_back(k);
+    }
+    return nullptr;
+  }
+  it->second.m_used.store(m_tick,std::memory_order_relaxed);
+  return &it->second;
+}
+
+float SdfBrickCache::blend(int32_t _slot, const Vec3 &_origin, const Vec3 &_p) const
+{
+  const int row=BRICK+1;
+  const int slice=row*row;
+  float l[3]={(_p.m_x-_origin.m_x)*m_invVoxel,(_p.m_y-_origin.m_y)*m_invVoxel,(_p.m_z-_origin.m_z)*m_invVoxel};
+  int i[3];
+  float f[3];
+  for(int a=0; a<3; ++a)
+  {
+    // rounding can put a point a hair outside its own brick
+    i[a]=std::min(std::max(static_cast<int>(l[a]),0),BRICK-1);
+    f[a]=std::min(std::max(l[a]-static_cast<float>(i[a]),0.0f),1.0f);
+  }
+  const float *s=&m_samples[static_cast<size_t>(_slot)*SAMPLES+(i[2]*row+i[1])*row+i[0]];
+  float x00=mix(s[0],s[1],f[0]);
+  float x10=mix(s[row],s[row+1],f[0]);
+  float x01=mix(s[slice],s[slice+1],f[0]);
+  float x11=mix(s[slice+row],s[slice+row+1],f[0]);
+  return mix(mix(x00,x10,f[1]),mix(x01,x11,f[1]),f[2]);
+}
+
+float SdfBrickCache::distance(const Vec3 &_p) const
+{
+  const Entry *e=find(_p);
+  if(e==nullptr || e->m_slot<0)
+  {
+    return m_scene.distance(_p);
+  }
+  return blend(e->m_slot,brickOrigin(key(_p)),_p);
+}
+
+float SdfBrickCache::distanceAndNormal(const Vec3 &_p, Vec3 &o_normal) const
+{
+  const Entry *e=find(_p);
+  if(e==nullptr || e->m_slot<0)
+  {
+    return m_scene.distanceAndNormal(_p,o_normal);
+  }
+  // central differences half a voxel apart, wide enough to smooth over the voxel faces where the blend's
+  // own gradient jumps. A tetrahedron that wide leans to one side at the creases of unions, these do not
+  float h=0.5f*m_settings.m_voxelSize;
+  Vec3 n(distance(_p+Vec3(h,0.0f,0.0f))-distance(_p-Vec3(h,0.0f,0.0f)),
+         distance(_p+Vec3(0.0f,h,0.0f))-distance(_p-Vec3(0.0f,h,0.0f)),
+         distance(_p+Vec3(0.0f,0.0f,h))-distance(_p-Vec3(0.0f,0.0f,h)));
+  float len=n.length();
+  o_normal= len>0.0f ? n/len : Vec3(0.0f,1.0f,0.0f);
+  return blend(e->m_slot,brickOrigin(key(_p)),_p);
+}
+
+Vec3 SdfBrickCache::normal(const Vec3 &_p) const
+{
+  Vec3 n;
+  distanceAndNormal(_p,n);
+  return n;
+}
+
+void SdfBrickCache::bake(uint64_t _key, int32_t _slot)
+{
+  // every sample of the brick through the batch map
+  float x[SAMPLES];
+  float y[SAMPLES];
+  float z[SAMPLES];
+  Vec3 origin=brickOrigin(_key);
+  int n=0;
+  for(int k=0; k<=BRICK; ++k)
+  {
+    for(int j=0; j<=BRICK; ++j)
+    {
+      for(int i=0; i<=BRICK; ++i)
+      {
+        x[n]=origin.m_x+i*m_settings.m_voxelSize;
+        y[n]=origin.m_y+j*m_settings.m_voxelSize;
+        z[n]=origin.m_z+k*m_settings.m_voxelSize;
+        ++n;
+      }
+    }
+  }
+  m_scene.map(x,y,z,SAMPLES,&m_samples[static_cast<size_t>(_slot)*SAMPLES],nullptr);
+}
+
+void SdfBrickCache::evict(size_t _slots, size_t _entries)
+{
+  // least recently used first and by key among equals, so the choice is the same on every run. Bricks
+  // used in the tick just run are kept, the next one is likely to want them again
+  std::vector<std::pair<uint32_t,uint64_t>> old;
+  for(const std::pair<const uint64_t,Entry> &e : m_entries)
+  {
+    uint32_t used=e.second.m_used.load(std::memory_order_relaxed);
+    if(used!=m_tick)
+    {
+      old.push_back(std::make_pair(used,e.first));
+    }
+  }
+  std::sort(old.begin(),old.end());
+  for(const std::pair<uint32_t,uint64_t> &o : old)
+  {
+    if(_slots==0 && _entries==0)
+    {
+      break;
+    }
+    std::unordered_map<uint64_t,Entry>::iterator it=m_entries.find(o.second);
+    int32_t slot=it->second.m_slot;
+    if(slot<0 && _entries==0)
+    {
+      continue;
+    }
+    if(slot>=0)
+    {
+      m_free.push_back(slot);
+      _slots-= _slots>0 ? 1 : 0;
+    }
+    _entries-= _entries>0 ? 1 : 0;
+    m_entries.erase(it);
+  }
+}
+
+size_t SdfBrickCache::update(JobSystem *_jobs)
+{
+  std::vector<uint64_t> requests;
+  {
+    std::lock_guard<std::mutex> lock(m_requestMutex);
+    requests.swap(m_requests);
+  }
+  std::sort(requests.begin(),requests.end());
+  requests.erase(std::unique(requests.begin(),requests.end()),requests.end());
+
+  // a brick whose centre is further from a surface than its corners plus the band holds none
+  float reach=0.5f*std::sqrt(3.0f)*m_brickSize+m_settings.m_band;
+  std::vector<uint64_t> far;
+  std::vector<uint64_t> near;
+  for(uint64_t k : requests)
+  {
+    if(m_entries.count(k)!=0)
+    {
+      continue;
+    }
+    Vec3 centre=brickOrigin(k)+Vec3(0.5f,0.5f,0.5f)*m_brickSize;
+    if(std::fabs(m_scene.distance(centre))>reach)
+    {
+      far.push_back(k);
+    }
+    else if(near.size()<m_settings.m_maxBakesPerUpdate)
+    {
+      near.push_back(k);
+    }
+  }
+
+  size_t unallocated=m_maxSlots-m_slotCount;
+  size_t available=m_free.size()+unallocated;
+  size_t slotsShort= near.size()>available ? near.size()-available : 0;
+  size_t entries=m_entries.size()+near.size()+far.size();
+  size_t entriesOver= entries>m_maxEntries ? entries-m_maxEntries : 0;
+  if(slotsShort!=0 || entriesOver!=0)
+  {
+    evict(slotsShort,entriesOver);
+  }
+  // whatever could not be made room for is asked for again by the next query
+  near.resize(std::min(near.size(),m_free.size()+unallocated));
+  far.resize(std::min(far.size(),m_maxEntries-std::min(m_maxEntries,m_entries.size()+near.size())));
+
+  std::vector<std::pair<uint64_t,int32_t>> bakes;
+  for(uint64_t k : near)
+  {
+    int32_t slot;
+    if(!m_free.empty())
+    {
+      slot=m_free.back();
+      m_free.pop_back();
+    }
+    else
+    {
+      slot=static_cast<int32_t>(m_slotCount++);
+    }
+    bakes.push_back(std::make_pair(k,slot));
+  }
+  m_samples.resize(m_slotCount*SAMPLES);
+  auto bakeRange=[this,&bakes](size_t _begin, size_t _end)
+  {
+    for(size_t i=_begin; i<_end; ++i)
+    {
+      bake(bakes[i].first,bakes[i].second);
+    }
+  };
+  if(_jobs!=nullptr && bakes.size()>1)
+  {
+    _jobs->parallelFor(bakes.size(),1,bakeRange);
+  }
+  else
+  {
+    bakeRange(0,bakes.size());
+  }
+
+  for(const std::pair<uint64_t,int32_t> &b : bakes)
+  {
+    m_entries.emplace(std::piecewise_construct,std::forward_as_tuple(b.first),std::forward_as_tuple(b.second,m_tick));
+  }
+  for(uint64_t k : far)
+  {
+    m_entries.emplace(std::piecewise_construct,std::forward_as_tuple(k),std::forward_as_tuple(-1,m_tick));
+  }
+  ++m_tick;
+  return bakes.size();
+}
+
+} // end namespace fps
@@ -0,0 +1,181 @@
+#include "SdfScene.h"
+#include <algorithm>
+
+namespace fps
+{
+
+const size_t SdfScene::WIDTH;
+const float SdfScene::NORMAL_EPSILON=0.001f;
+
+namespace
+{
+
+using sdf::Result;
+using sdf::Vec3T;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a whole number of batches through mapLocal, the tail padded with copies of the last point
+//----------------------------------------------------------------------------------------------------------------------
+template <typename F>
+void mapBatches(const Vec3 &_origin, float _scale, const float *_x, const float *_y, const float *_z, size_t _count,
+                float *o_distance, float *o_material)
+{
+  const size_t width=F::WIDTH;
+  F ox(_origin.m_x);
+  F oy(_origin.m_y);
+  F oz(_origin.m_z);
+  F scale(_scale);
+  F invScale(1.0f/_scale);
+  auto run=[&](const float *_px, const float *_py, const float *_pz, float *o_d, float *o_m)
+  {
+    Vec3T<F> p((F::load(_px)-ox)*invScale,(F::load(_py)-oy)*invScale,(F::load(_pz)-oz)*invScale);
+    Result<F> r=SdfScene::mapLocal(p);
+    (r.m_distance*scale).store(o_d);
+    if(o_m!=nullptr)
+    {
+      r.m_material.store(o_m);
+    }
+  };
+  size_t i=0;
+  for(; i+width<=_count; i+=width)
+  {
+    run(_x+i,_y+i,_z+i,o_distance+i,o_material!=nullptr ? o_material+i : nullptr);
+  }
+  if(i<_count)
+  {
+    float x[width];
+    float y[width];
+    float z[width];
+    float d[width];
+    float m[width];
+    size_t left=_count-i;
+    for(size_t j=0; j<width; ++j)
+    {
+      size_t k=i+std::min(j,left-1);
+      x[j]=_x[k];
+      y[j]=_y[k];
+      z[j]=_z[k];
+    }
+    run(x,y,z,d,m);
+    std::copy(d,d+left,o_distance+i);
+    if(o_material!=nullptr)
+    {
+      std::copy(m,m+left,o_material+i);
+    }
+  }
+}
+
+} // end anonymous namespace
+
+template <typename F>
+Result<F> SdfScene::mapLocal(const Vec3T<F> &_p)
+{
+  using namespace sdf;
+  typedef Vec3T<F> V;
+  auto at=[&_p](float _x, float _y, float _z) { return _p-V(F(_x),F(_y),F(_z)); };
+  auto box=[](float _s) { return V(F(_s),F(_s),F(_s)); };
+
+  Result<F> res=opU(Result<F>(sdPlane(_p),F(1.0f)),
+                    Result<F>(sdSphere(at(0.0f,0.25f,0.0f),0.25f),F(46.9f)));
+  res=opU(res,Result<F>(sdBox(at(1.0f,0.25f,0.0f),box(0.25f)),F(3.0f)));
+  res=opU(res,Result<F>(udRoundBox(at(1.0f,0.25f,1.0f),box(0.15f),0.1f),F(41.0f)));
+  res=opU(res,Result<F>(sdTorus(at(0.0f,0.25f,1.0f),0.20f,0.05f),F(25.0f)));
+  res=opU(res,Result<F>(sdCapsule(_p,V(F(-1.3f),F(0.10f),F(-0.1f)),V(F(-0.8f),F(0.50f),F(0.2f)),0.1f),F(31.9f)));
+  res=opU(res,Result<F>(sdTriPrism(at(-1.0f,0.25f,-1.0f),0.25f,0.05f),F(43.5f)));
+  res=opU(res,Result<F>(sdCylinder(at(1.0f,0.30f,-1.0f),0.1f,0.2f),F(8.0f)));
+  res=opU(res,Result<F>(sdCone(at(0.0f,0.50f,-1.0f),0.8f,0.6f,0.3f),F(55.0f)));
+  res=opU(res,Result<F>(sdTorus82(at(0.0f,0.25f,2.0f),0.20f,0.05f),F(50.0f)));
+  res=opU(res,Result<F>(sdTorus88(at(-1.0f,0.25f,2.0f),0.20f,0.05f),F(43.0f)));
+  res=opU(res,Result<F>(sdCylinder6(at(1.0f,0.30f,2.0f),0.1f,0.2f),F(12.0f)));
+  res=opU(res,Result<F>(sdHexPrism(at(-1.0f,0.20f,1.0f),0.25f,0.05f),F(17.0f)));
+
+  res=opU(res,Result<F>(opS(udRoundBox(at(-2.0f,0.2f,1.0f),box(0.15f),0.05f),
+                            sdSphere(at(-2.0f,0.2f,1.0f),0.25f)),F(13.0f)));
+  V ring=at(-2.0f,0.2f,0.0f);
+  V slots(vatan2(_p.m_x+F(2.0f),_p.m_z)/F(6.2831f),_p.m_y,F(0.02f)+F(0.5f)*length(ring));
+  res=opU(res,Result<F>(opS(sdTorus82(ring,0.20f,0.1f),
+                            sdCylinder(opRep(slots,0.05f,1.0f,0.05f),0.02f,0.6f)),F(51.0f)));
+  res=opU(res,Result<F>(F(0.7f)*sdSphere(at(-2.0f,0.25f,-1.0f),0.2f)+
+                        F(0.03f)*vsin(F(50.0f)*_p.m_x)*vsin(F(50.0f)*_p.m_y)*vsin(F(50.0f)*_p.m_z),F(65.0f)));
+  res=opU(res,Result<F>(F(0.5f)*sdTorus(opTwist(at(-2.0f,0.25f,2.0f)),0.20f,0.05f),F(46.7f)));
+
+  res=opU(res,Result<F>(sdConeSection(at(0.0f,0.35f,-2.0f),0.15f,0.2f,0.1f),F(13.67f)));
+
+  res=opU(res,Result<F>(sdEllipsoid(at(1.0f,0.35f,-2.0f),V(F(0.15f),F(0.2f),F(0.05f))),F(43.17f)));
+
+  return res;
+}
+
+template Result<float> SdfScene::mapLocal(const Vec3T<float> &);
+template Result<Float4> SdfScene::mapLocal(const Vec3T<Float4> &);
+template Result<Float8> SdfScene::mapLocal(const Vec3T<Float8> &);
+
+SdfScene::SdfScene(const Vec3 &_origin, float _scale)
+{
+  setPlacement(_origin,_scale);
+}
+
+void SdfScene::setPlacement(const Vec3 &_origin, float _scale)
+{
+  m_origin=_origin;
+  m_scale=_scale;
+  m_invScale=1.0f/_scale;
+}
+
+Result<float> SdfScene::map(const Vec3 &_p) const
+{
+  Vec3 q=(_p-m_origin)*m_invScale;
+  Result<float> r=mapLocal(Vec3T<float>(q.m_x,q.m_y,q.m_z));
+  r.m_distance*=m_scale;
+  return r;
+}
+
+void SdfScene::map(const float *_x, const float *_y, const float *_z, size_t _count,
+                   float *o_distance, float *o_material) const
+{
+  mapBatches<FloatWide>(m_origin,m_scale,_x,_y,_z,_count,o_distance,o_material);
+}
+
+void SdfScene::mapScalar(const float *_x, const float *_y, const float *_z, size_t _count,
+                         float *o_distance, float *o_material) const
+{
+  for(size_t i=0; i<_count; ++i)
+  {
+    Result<float> r=map(Vec3(_x[i],_y[i],_z[i]));
+    o_distance[i]=r.m_distance;
+    if(o_material!=nullptr)
+    {
+      o_material[i]=r.m_material;
+    }
+  }
+}
+
+float SdfScene::distanceAndNormal(const Vec3 &_p, Vec3 &o_normal) const
+{
+  // tetrahedron corners (1,-1,-1) (-1,-1,1) (-1,1,-1) (1,1,1), the weighted sum of the four samples is the
+  // gradient and their plain sum cancels the first order terms
+  static const float kx[4]={1.0f,-1.0f,-1.0f,1.0f};
+  static const float ky[4]={-1.0f,-1.0f,1.0f,1.0f};
+  static const float kz[4]={-1.0f,1.0f,-1.0f,1.0f};
+  Vec3 q=(_p-m_origin)*m_invScale;
+  Float4 h(NORMAL_EPSILON);
+  Vec3T<Float4> corners(Float4(q.m_x)+Float4::load(kx)*h,Float4(q.m_y)+Float4::load(ky)*h,
+                        Float4(q.m_z)+Float4::load(kz)*h);
+  float d[4];
+  mapLocal(corners).m_distance.store(d);
+  Vec3 n(d[0]*kx[0]+d[1]*kx[1]+d[2]*kx[2]+d[3]*kx[3],
+         d[0]*ky[0]+d[1]*ky[1]+d[2]*ky[2]+d[3]*ky[3],
+         d[0]*kz[0]+d[1]*kz[1]+d[2]*kz[2]+d[3]*kz[3]);
+  float len=n.length();
+  o_normal= len>0.0f ? n/len : Vec3(0.0f,1.0f,0.0f);
+  return 0.25f*(d[0]+d[1]+d[2]+d[3])*m_scale;
+}
+
+Vec3 SdfScene::normal(const Vec3 &_p) const
+{
+  Vec3 n;
+  distanceAndNormal(_p,n);
+  return n;
+}
+
+} // end namespace fps
@@ -0,0 +1,413 @@
+#include "Simulation.h"
+#include "Frustum.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace fps
+{
+
+static const float DEG_TO_RAD=static_cast<float>(M_PI/180.0);
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief commands that can wait for a tick, far more than a tick of input ever produces
+//----------------------------------------------------------------------------------------------------------------------
+static const size_t COMMAND_QUEUE_SIZE=1024;
+
+Simulation::Simulation(double _dt, int _maxSteps) :
+  m_timestep(_dt,_maxSteps),
+  m_commands(COMMAND_QUEUE_SIZE),
+  m_replaying(false),
+  m_quit(false)
+{
+  m_debris.setWorld(&m_collisionWorld);
+  m_debris.setJobSystem(&m_jobs);
+}
+
+Simulation::~Simulation()
+{
+  stop();
+}
+
+double Simulation::now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Simulation::setObjectBatches(const std::vector<int> &_objectBatch, size_t _batchCount)
+{
+  m_objectBatch=_objectBatch;
+  m_batchCount=_batchCount;
+  m_dirty=true;
+}
+
+void Simulation::setScene(const Scene &_scene)
+{
+  const SceneObject *objects=_scene.objects();
+  const SceneMesh *meshes=_scene.meshes();
+  std::vector<AABB> bounds(_scene.objectCount());
+  m_transforms.clear();
+  for(size_t i=0; i<_scene.objectCount(); ++i)
+  {
+    const SceneObject &o=objects[i];
+    bounds[i]=o.bounds();
+    m_transforms.add(Vec3(o.m_position[0],o.m_position[1],o.m_position[2]),
+                     Vec3(o.m_rotation[0],o.m_rotation[1],o.m_rotation[2]),Vec3(o.m_scale,o.m_scale,o.m_scale));
+  }
+  m_sceneBVH.build(bounds);
+
+  // colliders are static so the world is built once, the model matrices place mesh colliders
+  m_transforms.updateModels();
+  m_collisionWorld.clear();
+  for(size_t i=0; i<_scene.objectCount(); ++i)
+  {
+    const SceneCollider &c=objects[i].m_collider;
+    Vec3 pos(objects[i].m_position[0],objects[i].m_position[1],objects[i].m_position[2]);
+    const SceneMesh &mesh=meshes[objects[i].m_mesh];
+    switch(c.m_type)
+    {
+      case SceneCollider::SPHERE : m_collisionWorld.addSphere(pos,c.m_params[0]); break;
+      case SceneCollider::BOX :
+      {
+        Vec3 half(c.m_params[0],c.m_params[1],c.m_params[2]);
+        m_collisionWorld.addBox(AABB(pos-half,pos+half));
+        break;
+      }
+      case SceneCollider::PLANE :
+        m_collisionWorld.addPlane(Vec3(c.m_params[0],c.m_params[1],c.m_params[2]),c.m_params[3]);
+      break;
+      case SceneCollider::MESH :
+        if(mesh.m_mode==SceneMesh::TRIANGLES)
+        {
+          m_collisionWorld.addTriangles(&_scene.vertices()[mesh.m_firstVertex].m_x,mesh.m_vertexCount,
+                                        m_transforms.model(static_cast<uint32_t>(i)));
+        }
+      break;
+      case SceneCollider::SDF :
+      {
+        // a sixty fourth of a shader unit resolves the thinnest parts of the shader's scene
+        SdfBrickCache::Settings cache;
+        cache.m_voxelSize=c.m_params[0]/64.0f;
+        m_collisionWorld.addField(SdfScene(pos,c.m_params[0]),cache);
+        break;
+      }
+      default : break;
+    }
+  }
+  m_collisionWorld.build();
+  m_controller.setCollisionWorld(&m_collisionWorld);
+  m_debris.clear();
+  m_dirty=true;
+}
+
+void Simulation::record(InputRecording *_recording)
+{
+  m_recording=_recording;
+  if(m_recording!=nullptr)
+  {
+    // a replay starts from the same edge state
+    m_jumpHeld=false;
+    m_recording->begin(m_timestep.dt(),m_controller.state());
+  }
+}
+
+bool Simulation::replay(InputRecording *_recording, bool _realTime)
+{
+  if(_recording!=nullptr && _recording->dt()!=m_timestep.dt())
+  {
+    FPS_LOG_ERROR("input recorded at %g Hz cannot be replayed at %g Hz",1.0/_recording->dt(),1.0/m_timestep.dt());
+    return false;
+  }
+  m_replay=_recording;
+  m_replayRealTime=_realTime;
+  m_tickPending=false;
+  m_replaySteps=0;
+  m_replaying.store(m_replay!=nullptr,std::memory_order_release);
+  if(m_replay!=nullptr)
+  {
+    m_jumpHeld=false;
+    m_replay->rewind();
+    m_controller.setState(m_replay->camera());
+    m_debris.clear();
+    m_timestep.reset();
+    m_dirty=true;
+  }
+  return true;
+}
+
+void Simulation::start()
+{
+  if(running())
+  {
+    return;
+  }
+  // the renderer has something to draw before the first tick
+  publish(0.0f);
+  m_timestep.reset();
+  m_quit.store(false,std::memory_order_relaxed);
+  m_thread=std::thread(&Simulation::run,this);
+}
+
+void Simulation::stop()
+{
+  if(!running())
+  {
+    return;
+  }
+  m_quit.store(true,std::memory_order_release);
+  m_thread.join();
+}
+
+void Simulation::run()
+{
+  double last=now();
+  while(!m_quit.load(std::memory_order_acquire))
+  {
+    double current=now();
+    // a replay as fast as possible takes its next tick once the renderer has the last one
+    if(m_replay!=nullptr && !m_replayRealTime && m_snapshots.fresh())
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    advance(current-last);
+    last=current;
+    if(m_replay!=nullptr && !m_replayRealTime)
+    {
+      continue;
+    }
+    // sleep to the next step boundary, a command waits at most one step for its tick
+    double wait=(1.0-m_timestep.alpha())*m_timestep.dt();
+    std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+  }
+}
+
+int Simulation::advance(double _seconds)
+{
+  double begin=now();
+  int steps= m_replay!=nullptr ? replayInput(_seconds,begin) : liveInput(_seconds,begin);
+  float dt=static_cast<float>(m_timestep.dt());
+  Vec3 before=m_controller.position();
+  for(int i=0; i<steps; ++i)
+  {
+    m_controller.step(dt);
+    m_debris.step(dt);
+  }
+  m_tick+=steps;
+  // between ticks nothing is querying, so the distance field bricks the steps asked for can be baked
+  m_collisionWorld.updateFields(&m_jobs);
+  // only ticks that change the picture are published so an idle scene stops repainting, once the debris
+  // settles one more snapshot carries its resting place
+  size_t awake=m_debris.awakeCount();
+  if(m_dirty || m_controller.position()!=before || awake!=0 || m_publishedAwake!=0 || m_transforms.dirtyCount()!=0)
+  {
+    publish(static_cast<float>((now()-begin)*1000.0));
+  }
+  return steps;
+}
+
+int Simulation::liveInput(double _seconds, double _begin)
+{
+  Command command;
+  while(m_commands.tryPop(command))
+  {
+    apply(command);
+    // the viewport belongs to whoever runs the recording
+    if(m_recording!=nullptr && command.m_type!=Command::VIEWPORT)
+    {
+      m_recordedTick.m_commands.push_back(InputRecording::Command{static_cast<uint8_t>(command.m_type),command.m_x,
+                                                                  command.m_y});
+    }
+  }
+  apply(m_input.collect(_begin));
+  int steps=m_timestep.advance(_seconds);
+  if(m_recording!=nullptr)
+  {
+    m_recordedTick.m_steps=steps;
+    m_recordedTick.m_input=m_input.state();
+    m_recording->add(m_recordedTick);
+    m_recordedTick.m_commands.clear();
+  }
+  return steps;
+}
+
+int Simulation::replayInput(double _seconds, double _begin)
+{
+  // only the viewport is taken live, keys and the mouse would pull the camera off the recorded path
+  Command command;
+  while(m_commands.tryPop(command))
+  {
+    if(command.m_type==Command::VIEWPORT)
+    {
+      apply(command);
+    }
+  }
+  m_input.collect(_begin);
+  if(m_replayRealTime)
+  {
+    m_replaySteps+=m_timestep.advance(_seconds);
+  }
+  if(!m_tickPending && !(m_tickPending=m_replay->next(m_recordedTick)))
+  {
+    // publish the end even if the last ticks changed nothing, the renderer learns of it from a snapshot
+    m_replay=nullptr;
+    m_replaying.store(false,std::memory_order_release);
+    m_dirty=true;
+    return 0;
+  }
+  if(m_replayRealTime)
+  {
+    if(m_recordedTick.m_steps>m_replaySteps)
+    {
+      return 0;
+    }
+    m_replaySteps-=m_recordedTick.m_steps;
+  }
+  m_tickPending=false;
+  for(const InputRecording::Command &recorded : m_recordedTick.m_commands)
+  {
+    apply(Command{static_cast<Command::Type>(recorded.m_type),recorded.m_x,recorded.m_y});
+  }
+  apply(m_recordedTick.m_input);
+  return m_recordedTick.m_steps;
+}
+
+void Simulation::apply(const Command &_command)
+{
+  switch(_command.m_type)
+  {
+    case Command::LOOK :
+      m_controller.setLook(m_controller.pitch()+_command.m_x,m_controller.yaw()+_command.m_y);
+      m_dirty=true;
+    break;
+    case Command::VIEWPORT :
+      m_aspect= _command.m_y>0.0f ? _command.m_x/_command.m_y : 1.0f;
+      m_dirty=true;
+    break;
+    case Command::SPAWN_DEBRIS :
+      spawnDebris();
+      m_dirty=true;
+    break;
+  }
+}
+
+void Simulation::apply(const InputState &_input)
+{
+  for(int a=0; a<CameraController::NUM_ACTIONS; ++a)
+  {
+    // a tap that went down and up within the tick still moves the camera for its steps
+    if(a!=CameraController::JUMP)
+    {
+      m_controller.setAction(static_cast<CameraController::Action>(a),_input.active(static_cast<InputCommand>(a)));
+    }
+  }
+  // the controller consumes a jump on its next step, so only a press starts one and holding the key through a
+  // landing does not jump again. Letting go cuts the rise short, as the demo always has
+  bool jump=_input.active(INPUT_JUMP);
+  if(_input.m_presses[INPUT_JUMP]!=0)
+  {
+    m_controller.setAction(CameraController::JUMP,true);
+  }
+  else if(m_jumpHeld && !jump)
+  {
+    m_controller.physics().velocity.m_y=0;
+  }
+  m_jumpHeld=jump;
+  for(int i=0; i<_input.m_presses[INPUT_SPAWN_DEBRIS]; ++i)
+  {
+    spawnDebris();
+    m_dirty=true;
+  }
+  if(_input.m_pitch!=0.0f || _input.m_yaw!=0.0f)
+  {
+    m_controller.setLook(m_controller.pitch()+_input.m_pitch,m_controller.yaw()+_input.m_yaw);
+    m_dirty=true;
+  }
+}
+
+void Simulation::spawnDebris()
+{
+  // a small block ahead of the camera, thrown the way it is looking
+  const int side=4;
+  Vec3 front=m_controller.front();
+  Vec3 centre=m_controller.position()+front*(4.0f*m_debrisRadius*side);
+  for(int i=0; i<side*side*side; ++i)
+  {
+    Vec3 offset(static_cast<float>(i%side),static_cast<float>((i/side)%side),static_cast<float>(i/(side*side)));
+    offset=(offset-Vec3(0.5f,0.5f,0.5f)*(side-1))*(2.2f*m_debrisRadius);
+    m_debris.add(centre+offset,m_debrisRadius,1.0f,front*m_debrisSpeed);
+  }
+}
+
+void Simulation::publish(float _simMs)
+{
+  FrameSnapshot &s=m_snapshots.back();
+  s.m_tick=m_tick;
+  // the current state became current when the accumulator last crossed a step
+  s.m_time=now()-m_timestep.alpha()*m_timestep.dt();
+  s.m_dt=m_timestep.dt();
+  s.m_simMs=_simMs;
+  s.m_previousEye=m_controller.prevPosition();
+  s.m_eye=m_controller.position();
+  s.m_front=m_controller.front();
+  s.m_up=m_controller.up();
+  s.m_view=lookAt(s.m_eye,s.m_eye+s.m_front,s.m_up);
+  s.m_projection=perspective(m_fov,m_aspect,m_near,m_far);
+
+  // the renderer draws from anywhere between the previous and current eye, so cull from far enough behind
+  // the current one that the narrowest side of the frustum still holds every eye in between
+  float travel=(s.m_eye-s.m_previousEye).length();
+  float halfTan=std::tan(m_fov*0.5f*DEG_TO_RAD)*std::min(1.0f,m_aspect);
+  float back=travel*std::sqrt(1.0f+halfTan*halfTan)/halfTan;
+  Vec3 cullEye=s.m_eye-s.m_front*back;
+  Frustum frustum(lookAt(cullEye,cullEye+s.m_front,s.m_up)*perspective(m_fov,m_aspect,m_near,m_far+back+travel));
+
+  // one batch pass over the objects that moved since the last tick
+  m_transforms.updateModels();
+  m_sceneBVH.cull(frustum,m_visible);
+  s.m_batchTransforms.resize(m_batchCount);
+  for(std::vector<float> &batch : s.m_batchTransforms)
+  {
+    batch.clear();
+  }
+  s.m_meshObjects.clear();
+  s.m_meshTransforms.clear();
+  const float *transforms=m_transforms.models();
+  for(uint32_t index : m_visible)
+  {
+    int batch= index<m_objectBatch.size() ? m_objectBatch[index] : -1;
+    std::vector<float> &out= batch>=0 ? s.m_batchTransforms[batch] : s.m_meshTransforms;
+    out.insert(out.end(),transforms+16*index,transforms+16*index+16);
+    if(batch<0)
+    {
+      s.m_meshObjects.push_back(index);
+    }
+  }
+
+  // translation only matrices, the sphere mesh already has the body radius
+  s.m_debrisTransforms.resize(16*m_debris.size());
+  for(uint32_t i=0; i<m_debris.size(); ++i)
+  {
+    float *m=&s.m_debrisTransforms[16*i];
+    Vec3 p=m_debris.position(i);
+    std::fill(m,m+16,0.0f);
+    m[0]=m[5]=m[10]=m[15]=1.0f;
+    m[12]=p.m_x;
+    m[13]=p.m_y;
+    m[14]=p.m_z;
+  }
+
+  s.m_visibleCount=m_visible.size();
+  s.m_objectCount=m_sceneBVH.size();
+  s.m_debrisCount=m_debris.size();
+  s.m_debrisAwake=m_debris.awakeCount();
+  s.m_velocity=m_controller.physics().velocity.m_y;
+  m_publishedAwake=s.m_debrisAwake;
+  m_dirty=false;
+  m_snapshots.publish();
+  if(m_onPublish)
+  {
+    m_onPublish();
+  }
+}
+
+} // end namespace fps
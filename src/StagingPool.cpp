@@ -0,0 +1,116 @@
+#include "StagingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#if defined(__linux__)
+  #include <sys/mman.h>
+#endif
+
+namespace fps
+{
+
+static std::atomic<uint64_t> s_allocations(0);
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief anything this big is aligned and sized to 2MB so the kernel can back it with huge pages
+//----------------------------------------------------------------------------------------------------------------------
+static const size_t HUGE_PAGE=2*1024*1024;
+static const size_t PAGE=4096;
+
+static size_t roundUp(size_t _size, size_t _alignment)
+{
+  return (_size+_alignment-1)/_alignment*_alignment;
+}
+
+StagingBuffer::~StagingBuffer()
+{
+  free(m_data);
+}
+
+uint64_t StagingBuffer::allocations()
+{
+  return s_allocations.load(std::memory_order_relaxed);
+}
+
+void StagingBuffer::resize(size_t _size)
+{
+  if(_size>m_capacity)
+  {
+    // grow by at least half again so dragging a window edge doesn't allocate on every event
+    size_t capacity=std::max(_size,m_capacity+m_capacity/2);
+    size_t alignment= capacity>=HUGE_PAGE ? HUGE_PAGE : PAGE;
+    capacity=roundUp(capacity,alignment);
+    void *data=nullptr;
+    if(posix_memalign(&data,alignment,capacity)!=0)
+    {
+      throw std::bad_alloc();
+    }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if(alignment==HUGE_PAGE)
+    {
+      madvise(data,capacity,MADV_HUGEPAGE);
+    }
+#endif
+    free(m_data);
+    m_data=static_cast<unsigned char *>(data);
+    m_capacity=capacity;
+    s_allocations.fetch_add(1,std::memory_order_relaxed);
+  }
+  m_size=_size;
+}
+
+StagingPool::Handle StagingPool::acquire(size_t _size)
+{
+  std::unique_ptr<StagingBuffer> buffer;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_free.empty())
+    {
+      // best fit is the smallest idle buffer that is big enough, otherwise grow the largest
+      auto best=m_free.end();
+      for(auto it=m_free.begin(); it!=m_free.end(); ++it)
+      {
+        bool fits=(*it)->capacity()>=_size;
+        if(best==m_free.end())
+        {
+          best=it;
+        }
+        else if(fits && ((*best)->capacity()<_size || (*it)->capacity()<(*best)->capacity()))
+        {
+          best=it;
+        }
+        else if(!fits && (*best)->capacity()<_size && (*it)->capacity()>(*best)->capacity())
+        {
+          best=it;
+        }
+      }
+      buffer=std::move(*best);
+      m_free.erase(best);
+    }
+  }
+  if(!buffer)
+  {
+    buffer.reset(new StagingBuffer);
+  }
+  buffer->resize(_size);
+  return Handle(buffer.release(),Releaser{this});
+}
+
+void StagingPool::release(StagingBuffer *_buffer)
+{
+  std::unique_ptr<StagingBuffer> buffer(_buffer);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(m_free.size()<m_maxFree)
+  {
+    m_free.push_back(std::move(buffer));
+  }
+}
+
+size_t StagingPool::idle() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_free.size();
+}
+
+} // end namespace fps
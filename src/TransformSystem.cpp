@@ -0,0 +1,316 @@
+#include "TransformSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined(__AVX__)
+  #include <immintrin.h>
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+namespace fps
+{
+
+const size_t TransformSystem::WIDTH;
+
+namespace
+{
+
+struct Quat
+{
+  float x, y, z, w;
+};
+
+Quat multiply(const Quat &_a, const Quat &_b)
+{
+  return Quat{_a.w*_b.x+_a.x*_b.w+_a.y*_b.z-_a.z*_b.y,
+              _a.w*_b.y-_a.x*_b.z+_a.y*_b.w+_a.z*_b.x,
+              _a.w*_b.z+_a.x*_b.y-_a.y*_b.x+_a.z*_b.w,
+              _a.w*_b.w-_a.x*_b.x-_a.y*_b.y-_a.z*_b.z};
+}
+
+// rotate about x then y then z, the row vector Rx*Ry*Rz of ngl is the quaternion qz*qy*qx
+Quat fromEuler(const Vec3 &_degrees)
+{
+  const float halfToRad=3.14159265358979f/360.0f;
+  Quat qx={std::sin(_degrees.m_x*halfToRad),0.0f,0.0f,std::cos(_degrees.m_x*halfToRad)};
+  Quat qy={0.0f,std::sin(_degrees.m_y*halfToRad),0.0f,std::cos(_degrees.m_y*halfToRad)};
+  Quat qz={0.0f,0.0f,std::sin(_degrees.m_z*halfToRad),std::cos(_degrees.m_z*halfToRad)};
+  return multiply(qz,multiply(qy,qx));
+}
+
+#if defined(__SSE2__)
+//----------------------------------------------------------------------------------------------------------------------
+// the same kernel is written once against these wrappers and instantiated for the widest ISA we have
+//----------------------------------------------------------------------------------------------------------------------
+struct SSE
+{
+  typedef __m128 R;
+  static const size_t W=4;
+  static R load(const float *_p) { return _mm_loadu_ps(_p); }
+  static R set1(float _v) { return _mm_set1_ps(_v); }
+  static R add(R _a, R _b) { return _mm_add_ps(_a,_b); }
+  static R sub(R _a, R _b) { return _mm_sub_ps(_a,_b); }
+  static R mul(R _a, R _b) { return _mm_mul_ps(_a,_b); }
+  // row _row of W matrices, lane n of _a.._d goes to element 0..3 of matrix n
+  static void storeRow(float *o_m, int _row, R _a, R _b, R _c, R _d)
+  {
+    _MM_TRANSPOSE4_PS(_a,_b,_c,_d);
+    _mm_storeu_ps(o_m+4*_row,_a);
+    _mm_storeu_ps(o_m+16+4*_row,_b);
+    _mm_storeu_ps(o_m+32+4*_row,_c);
+    _mm_storeu_ps(o_m+48+4*_row,_d);
+  }
+};
+#endif
+
+#if defined(__AVX__)
+struct AVX
+{
+  typedef __m256 R;
+  static const size_t W=8;
+  static R load(const float *_p) { return _mm256_loadu_ps(_p); }
+  static R set1(float _v) { return _mm256_set1_ps(_v); }
+  static R add(R _a, R _b) { return _mm256_add_ps(_a,_b); }
+  static R sub(R _a, R _b) { return _mm256_sub_ps(_a,_b); }
+  static R mul(R _a, R _b) { return _mm256_mul_ps(_a,_b); }
+  static void storeRow(float *o_m, int _row, R _a, R _b, R _c, R _d)
+  {
+    SSE::storeRow(o_m,_row,_mm256_castps256_ps128(_a),_mm256_castps256_ps128(_b),
+                  _mm256_castps256_ps128(_c),_mm256_castps256_ps128(_d));
+    SSE::storeRow(o_m+64,_row,_mm256_extractf128_ps(_a,1),_mm256_extractf128_ps(_b,1),
+                  _mm256_extractf128_ps(_c,1),_mm256_extractf128_ps(_d,1));
+  }
+};
+typedef AVX Wide;
+#elif defined(__SSE2__)
+typedef SSE Wide;
+#endif
+
+#if defined(__SSE2__)
+// model matrices of W objects from the SoA arrays, see composeScalar for the element layout
+template<typename V>
+void composeBlock(const float *_px, const float *_py, const float *_pz,
+                  const float *_qx, const float *_qy, const float *_qz, const float *_qw,
+                  const float *_sx, const float *_sy, const float *_sz, float *o_m)
+{
+  typedef typename V::R R;
+  R x=V::load(_qx), y=V::load(_qy), z=V::load(_qz), w=V::load(_qw);
+  R two=V::set1(2.0f);
+  R one=V::set1(1.0f);
+  R zero=V::set1(0.0f);
+  R x2=V::mul(x,two), y2=V::mul(y,two), z2=V::mul(z,two);
+  R xx=V::mul(x,x2), yy=V::mul(y,y2), zz=V::mul(z,z2);
+  R xy=V::mul(x,y2), xz=V::mul(x,z2), yz=V::mul(y,z2);
+  R wx=V::mul(w,x2), wy=V::mul(w,y2), wz=V::mul(w,z2);
+  R sx=V::load(_sx), sy=V::load(_sy), sz=V::load(_sz);
+  V::storeRow(o_m,0,V::mul(sx,V::sub(one,V::add(yy,zz))),V::mul(sx,V::add(xy,wz)),V::mul(sx,V::sub(xz,wy)),zero);
+  V::storeRow(o_m,1,V::mul(sy,V::sub(xy,wz)),V::mul(sy,V::sub(one,V::add(xx,zz))),V::mul(sy,V::add(yz,wx)),zero);
+  V::storeRow(o_m,2,V::mul(sz,V::add(xz,wy)),V::mul(sz,V::sub(yz,wx)),V::mul(sz,V::sub(one,V::add(xx,yy))),zero);
+  V::storeRow(o_m,3,V::load(_px),V::load(_py),V::load(_pz),one);
+}
+
+// modelView=model*view for one object, each output row is a weighted sum of the view rows
+void modelViewSSE(const float *_m, const __m128 *_view, float *o_mv)
+{
+  for(int r=0; r<4; ++r)
+  {
+    const float *row=_m+4*r;
+    __m128 sum=_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(row[0]),_view[0]),_mm_mul_ps(_mm_set1_ps(row[1]),_view[1])),
+                          _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row[2]),_view[2]),_mm_mul_ps(_mm_set1_ps(row[3]),_view[3])));
+    _mm_storeu_ps(o_mv+4*r,sum);
+  }
+}
+#endif
+
+} // end anonymous namespace
+
+void TransformSystem::clear()
+{
+  m_size=0;
+  m_dirtyCount=0;
+  grow();
+}
+
+void TransformSystem::grow()
+{
+  // pad with identity transforms that are never dirty so whole blocks can always be processed
+  size_t padded=(m_size+WIDTH-1)/WIDTH*WIDTH;
+  m_px.resize(padded,0.0f);
+  m_py.resize(padded,0.0f);
+  m_pz.resize(padded,0.0f);
+  m_qx.resize(padded,0.0f);
+  m_qy.resize(padded,0.0f);
+  m_qz.resize(padded,0.0f);
+  m_qw.resize(padded,1.0f);
+  m_sx.resize(padded,1.0f);
+  m_sy.resize(padded,1.0f);
+  m_sz.resize(padded,1.0f);
+  m_dirty.resize(padded,0);
+  m_models.resize(16*padded,0.0f);
+  m_modelViews.resize(16*padded,0.0f);
+}
+
+uint32_t TransformSystem::add(const Vec3 &_position, const Vec3 &_rotation, const Vec3 &_scale)
+{
+  uint32_t i=static_cast<uint32_t>(m_size++);
+  if(m_size>m_px.size())
+  {
+    grow();
+  }
+  m_dirty[i]=0;
+  setPosition(i,_position);
+  setRotation(i,_rotation);
+  setScale(i,_scale);
+  return i;
+}
+
+void TransformSystem::setPosition(uint32_t _i, const Vec3 &_position)
+{
+  m_px[_i]=_position.m_x;
+  m_py[_i]=_position.m_y;
+  m_pz[_i]=_position.m_z;
+  m_dirtyCount+=m_dirty[_i]^1;
+  m_dirty[_i]=1;
+}
+
+void TransformSystem::setRotation(uint32_t _i, const Vec3 &_degrees)
+{
+  Quat q=fromEuler(_degrees);
+  m_qx[_i]=q.x;
+  m_qy[_i]=q.y;
+  m_qz[_i]=q.z;
+  m_qw[_i]=q.w;
+  m_dirtyCount+=m_dirty[_i]^1;
+  m_dirty[_i]=1;
+}
+
+void TransformSystem::setScale(uint32_t _i, const Vec3 &_scale)
+{
+  m_sx[_i]=_scale.m_x;
+  m_sy[_i]=_scale.m_y;
+  m_sz[_i]=_scale.m_z;
+  m_dirtyCount+=m_dirty[_i]^1;
+  m_dirty[_i]=1;
+}
+
+void TransformSystem::markAllDirty()
+{
+  std::memset(m_dirty.data(),1,m_size);
+  m_dirtyCount=m_size;
+}
+
+size_t TransformSystem::dirtyCount() const
+{
+  return m_dirtyCount;
+}
+
+void TransformSystem::composeScalar(size_t _i)
+{
+  float x=m_qx[_i], y=m_qy[_i], z=m_qz[_i], w=m_qw[_i];
+  float xx=2.0f*x*x, yy=2.0f*y*y, zz=2.0f*z*z;
+  float xy=2.0f*x*y, xz=2.0f*x*z, yz=2.0f*y*z;
+  float wx=2.0f*w*x, wy=2.0f*w*y, wz=2.0f*w*z;
+  float *m=&m_models[16*_i];
+  // transpose of the usual column vector rotation, each row scaled by its axis
+  m[0]=m_sx[_i]*(1.0f-yy-zz); m[1]=m_sx[_i]*(xy+wz);      m[2]=m_sx[_i]*(xz-wy);       m[3]=0.0f;
+  m[4]=m_sy[_i]*(xy-wz);      m[5]=m_sy[_i]*(1.0f-xx-zz); m[6]=m_sy[_i]*(yz+wx);       m[7]=0.0f;
+  m[8]=m_sz[_i]*(xz+wy);      m[9]=m_sz[_i]*(yz-wx);      m[10]=m_sz[_i]*(1.0f-xx-yy); m[11]=0.0f;
+  m[12]=m_px[_i];             m[13]=m_py[_i];             m[14]=m_pz[_i];              m[15]=1.0f;
+}
+
+void TransformSystem::modelViewScalar(size_t _i, const Mat4 &_view)
+{
+  const float *m=&m_models[16*_i];
+  float *mv=&m_modelViews[16*_i];
+  for(int r=0; r<4; ++r)
+  {
+    for(int c=0; c<4; ++c)
+    {
+      mv[4*r+c]=m[4*r]*_view.m_m[0][c]+m[4*r+1]*_view.m_m[1][c]+m[4*r+2]*_view.m_m[2][c]+m[4*r+3]*_view.m_m[3][c];
+    }
+  }
+}
+
+size_t TransformSystem::pass(const Mat4 *_view, bool _simd)
+{
+  size_t rebuilt=0;
+  if(m_dirtyCount==0 && _view==nullptr)
+  {
+    return 0;
+  }
+#if defined(__SSE2__)
+  __m128 view[4];
+  if(_view)
+  {
+    for(int r=0; r<4; ++r)
+    {
+      view[r]=_mm_loadu_ps(_view->m_m[r]);
+    }
+  }
+#endif
+  for(size_t block=0; block<m_size; block+=WIDTH)
+  {
+    // a block with no dirty objects keeps its matrices, checked a word at a time
+    uint64_t flags=0;
+    std::memcpy(&flags,&m_dirty[block],WIDTH);
+    if(flags!=0)
+    {
+#if defined(__SSE2__)
+      if(_simd)
+      {
+        composeBlock<Wide>(&m_px[block],&m_py[block],&m_pz[block],&m_qx[block],&m_qy[block],&m_qz[block],
+                           &m_qw[block],&m_sx[block],&m_sy[block],&m_sz[block],&m_models[16*block]);
+      }
+      else
+#endif
+      {
+        for(size_t i=block; i<block+WIDTH; ++i)
+        {
+          composeScalar(i);
+        }
+      }
+      std::memset(&m_dirty[block],0,WIDTH);
+    }
+    if(_view)
+    {
+      size_t end=std::min(block+WIDTH,m_size);
+      for(size_t i=block; i<end; ++i)
+      {
+#if defined(__SSE2__)
+        if(_simd)
+        {
+          modelViewSSE(&m_models[16*i],view,&m_modelViews[16*i]);
+          continue;
+        }
+#endif
+        modelViewScalar(i,*_view);
+      }
+    }
+  }
+  rebuilt=m_dirtyCount;
+  m_dirtyCount=0;
+  return rebuilt;
+}
+
+size_t TransformSystem::updateModels()
+{
+  return pass(nullptr,true);
+}
+
+size_t TransformSystem::update(const Mat4 &_view)
+{
+  return pass(&_view,true);
+}
+
+size_t TransformSystem::updateModelsScalar()
+{
+  return pass(nullptr,false);
+}
+
+size_t TransformSystem::updateScalar(const Mat4 &_view)
+{
+  return pass(&_view,false);
+}
+
+} // end namespace fps
@@ -1,49 +1,94 @@
 /****************************************************************************
 basic OpenGL demo modified from http://qt-project.org/doc/qt-5.0/qtgui/openglwindow.html
+usage FPS_Camera [--size WxH] [--msaa n] [--gl major.minor]
+                 [--offscreen [--frames n] [--warmup n] [--session file.fpsi]
+                              [--hash] [--out prefix]]
+--offscreen draws --frames frames of a camera path with no window and prints
+their times, the path is a recorded input session or a walk in a circle.
+--hash prints every frame's image hash and --out writes the frames as PPM.
+It uses Qt's offscreen platform unless QT_QPA_PLATFORM names another, e.g.
+eglfs with EGL_PLATFORM=surfaceless for Mesa with no display at all
 ****************************************************************************/
 #include <QtGui/QGuiApplication>
-#include <iostream>
 #include "NGLScene.h"
+#include "OffscreenRenderer.h"
+#include "Log.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 
 
 int main(int argc, char **argv)
 {
-  QGuiApplication app(argc, argv);
-  // create an OpenGL format specifier
-  QSurfaceFormat format;
-  // set the number of samples for multisampling
-  // will need to enable glEnable(GL_MULTISAMPLE); once we have a context
-  format.setSamples(4);
+  int width=1024;
+  int height=720;
+  int samples=4;
+  int major=4;
+  int minor=5;
   #if defined( __APPLE__)
     // at present mac osx Mountain Lion only supports GL3.2
     // the new mavericks will have GL 4.x so can change
-    format.setMajorVersion(4);
-    format.setMinorVersion(1);
-  #else
-    // with luck we have the latest GL version so set to that
-    format.setMajorVersion(4);
-    format.setMinorVersion(5);
+    minor=1;
   #endif
+  bool offscreen=false;
+  OffscreenRenderer::Settings run;
+  for(int i=1; i<argc; ++i)
+  {
+    if(!std::strcmp(argv[i],"--size") && i+1<argc && std::sscanf(argv[i+1],"%dx%d",&width,&height)==2) ++i;
+    else if(!std::strcmp(argv[i],"--msaa") && i+1<argc) samples=std::atoi(argv[++i]);
+    else if(!std::strcmp(argv[i],"--gl") && i+1<argc && std::sscanf(argv[i+1],"%d.%d",&major,&minor)==2) ++i;
+    else if(!std::strcmp(argv[i],"--offscreen")) offscreen=true;
+    else if(!std::strcmp(argv[i],"--frames") && i+1<argc) run.m_frames=std::atoi(argv[++i]);
+    else if(!std::strcmp(argv[i],"--warmup") && i+1<argc) run.m_warmup=std::atoi(argv[++i]);
+    else if(!std::strcmp(argv[i],"--session") && i+1<argc) run.m_session=argv[++i];
+    else if(!std::strcmp(argv[i],"--hash")) run.m_hash=true;
+    else if(!std::strcmp(argv[i],"--out") && i+1<argc) run.m_outPrefix=argv[++i];
+    // anything else is left for Qt, e.g. -platform
+  }
+  if(width<=0 || height<=0 || samples<0)
+  {
+    std::fprintf(stderr,"bad size %dx%d or sample count %d\n",width,height,samples);
+    return EXIT_FAILURE;
+  }
+  // a build server has no display for the default platform to open
+  if(offscreen && qgetenv("QT_QPA_PLATFORM").isEmpty())
+  {
+    qputenv("QT_QPA_PLATFORM","offscreen");
+  }
+
+  QGuiApplication app(argc, argv);
+  // create an OpenGL format specifier
+  QSurfaceFormat format;
+  // set the number of samples for multisampling, the offscreen targets carry their own
+  // will need to enable glEnable(GL_MULTISAMPLE); once we have a context
+  format.setSamples(offscreen ? 0 : samples);
+  // with luck we have the latest GL version, --gl asks for less (llvmpipe is 4.5 on recent Mesa)
+  format.setMajorVersion(major);
+  format.setMinorVersion(minor);
   // now we are going to set to CoreProfile OpenGL so we can't use and old Immediate mode GL
   format.setProfile(QSurfaceFormat::CoreProfile);
   // now set the depth buffer to 24 bits
   format.setDepthBufferSize(24);
   // set that as the default format for all windows
   QSurfaceFormat::setDefaultFormat(format);
+  // we can now query the version to see if it worked
+  FPS_LOG_INFO("Profile is %d %d",format.majorVersion(),format.minorVersion());
+
+  if(offscreen)
+  {
+    run.m_width=width;
+    run.m_height=height;
+    run.m_samples=samples;
+    return OffscreenRenderer(run).run();
+  }
 
   // now we are going to create our scene window
   NGLScene window;
-
-  // we can now query the version to see if it worked
-  std::cout<<"Profile is "<<format.majorVersion()<<" "<<format.minorVersion()<<"\n";
   // set the window size
-  window.resize(1024, 720);
+  window.resize(width, height);
   // and finally show
   window.show();
 
   return app.exec();
 }
-
-
-
@@ -0,0 +1,37 @@
+/****************************************************************************
+the camera body, fast bodies at a 30Hz tick must not tunnel through a wall
+thinner than one tick of their movement
+****************************************************************************/
+#include "Test.h"
+#include "CameraController.h"
+
+namespace
+{
+
+void cameraDoesNotTunnel()
+{
+  fps::CollisionWorld world;
+  world.addPlane(fps::Vec3(0.0f,1.0f,0.0f),1.0f);
+  world.addBox(fps::AABB(fps::Vec3(-1.0e4f,-1.0f,-20.05f),fps::Vec3(1.0e4f,50.0f,-20.0f)));
+  world.build();
+  std::vector<fps::CameraController> bodies(1000);
+  for(size_t i=0; i<bodies.size(); ++i)
+  {
+    bodies[i].setCollisionWorld(&world);
+    bodies[i].reset(fps::Vec3(static_cast<float>(i%100),0.0f,0.0f));
+    bodies[i].setLook(0.0f,static_cast<float>(i%120)-60.0f);
+    bodies[i].setAction(fps::CameraController::FORWARD,true);
+    bodies[i].m_walkSpeed=500.0f;
+  }
+  for(size_t s=0; s<30; ++s)
+  {
+    for(size_t i=0; i<bodies.size(); ++i)
+    {
+      bodies[i].step(1.0f/30.0f);
+      CHECK(bodies[i].position().m_z>=-20.0f,"camera %zu tunnelled through the wall on step %zu",i,s);
+    }
+  }
+}
+TEST("camera_does_not_tunnel",cameraDoesNotTunnel);
+
+} // end anonymous namespace
@@ -0,0 +1,62 @@
+/****************************************************************************
+camera body sweeps, the spatial hash broadphase must report the same first
+hit as testing every collider
+****************************************************************************/
+#include "Test.h"
+#include "CollisionWorld.h"
+#include <cmath>
+#include <random>
+
+namespace
+{
+
+// spheres, boxes and triangles at the density of the collision benchmarks, over a floor
+void sweepMatchesBruteForce()
+{
+  const size_t counts[]={10,1000,10000};
+  for(size_t count : counts)
+  {
+    fps::CollisionWorld world;
+    float half=4.0f*std::sqrt(static_cast<float>(count));
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> pos(-half,half);
+    std::uniform_real_distribution<float> size(0.2f,2.0f);
+    std::uniform_real_distribution<float> move(-0.5f,0.5f);
+    for(size_t i=0; i<count; ++i)
+    {
+      fps::Vec3 c(pos(rng),size(rng)*2.0f,pos(rng));
+      switch(i%3)
+      {
+        case 0 : world.addSphere(c,size(rng)); break;
+        case 1 :
+        {
+          fps::Vec3 e(size(rng),size(rng),size(rng));
+          world.addBox(fps::AABB(c-e,c+e));
+          break;
+        }
+        default : world.addTriangle(c,c+fps::Vec3(size(rng),0.0f,0.0f),c+fps::Vec3(0.0f,size(rng),size(rng))); break;
+      }
+    }
+    world.addPlane(fps::Vec3(0.0f,1.0f,0.0f),1.0f);
+    world.build();
+    size_t hits=0;
+    for(size_t i=0; i<1000; ++i)
+    {
+      // a tick of camera movement from a random place in the level, some long enough to cross cells
+      fps::Vec3 start(pos(rng),1.0f+size(rng),pos(rng));
+      fps::Vec3 end=start+fps::Vec3(move(rng),move(rng),move(rng))*(i%10==0 ? 20.0f : 1.0f);
+      fps::CollisionWorld::Hit grid;
+      fps::CollisionWorld::Hit brute;
+      bool a=world.sweepSphere(start,end,1.0f,grid);
+      bool b=world.sweepSphereBruteForce(start,end,1.0f,brute);
+      CHECK(a==b && (!a || (grid.m_collider==brute.m_collider && grid.m_time==brute.m_time)),
+            "sweep %zu mismatch at %zu colliders, grid %d %u %g brute force %d %u %g",i,count,a,grid.m_collider,
+            grid.m_time,b,brute.m_collider,brute.m_time);
+      hits+= a ? 1 : 0;
+    }
+    CHECK(hits!=0,"no sweep touched a collider at %zu colliders",count);
+  }
+}
+TEST("collision_sweep_matches_brute_force",sweepMatchesBruteForce);
+
+} // end anonymous namespace
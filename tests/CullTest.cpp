@@ -0,0 +1,85 @@
+/****************************************************************************
+frustum culling, the BVH must find exactly the objects the brute force loop
+does and the SSE box test must agree with the scalar one
+****************************************************************************/
+#include "Test.h"
+#include "SceneBVH.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+
+// objects spread over a 1000 unit square as in the cull benchmarks, plus a few huge ones that straddle planes
+std::vector<fps::AABB> scatter(size_t _count, unsigned _seed)
+{
+  std::mt19937 rng(_seed);
+  std::uniform_real_distribution<float> pos(-500.0f,500.0f);
+  std::uniform_real_distribution<float> height(0.0f,20.0f);
+  std::uniform_real_distribution<float> radius(0.5f,3.0f);
+  std::vector<fps::AABB> bounds(_count);
+  for(size_t i=0; i<_count; ++i)
+  {
+    float r= i%97==0 ? 100.0f*radius(rng) : radius(rng);
+    bounds[i]=fps::AABB::fromSphere(fps::Vec3(pos(rng),height(rng),pos(rng)),r);
+  }
+  return bounds;
+}
+
+// a few views, looking out across the level from inside it and in at it from above
+std::vector<fps::Mat4> views()
+{
+  fps::Mat4 project=fps::perspective(45.0f,16.0f/9.0f,0.05f,350.0f);
+  fps::Vec3 up(0.0f,1.0f,0.0f);
+  std::vector<fps::Mat4> out;
+  out.push_back(fps::lookAt(fps::Vec3(0.0f,5.0f,0.0f),fps::Vec3(100.0f,0.0f,-100.0f),up)*project);
+  out.push_back(fps::lookAt(fps::Vec3(-400.0f,2.0f,300.0f),fps::Vec3(0.0f,2.0f,0.0f),up)*project);
+  out.push_back(fps::lookAt(fps::Vec3(0.0f,300.0f,1.0f),fps::Vec3(0.0f,0.0f,0.0f),up)*project);
+  out.push_back(fps::lookAt(fps::Vec3(600.0f,10.0f,0.0f),fps::Vec3(700.0f,10.0f,0.0f),up)*project);
+  return out;
+}
+
+void cullMatchesBruteForce()
+{
+  const size_t counts[]={1,7,100,10000};
+  for(size_t count : counts)
+  {
+    fps::SceneBVH bvh;
+    bvh.build(scatter(count,1234));
+    for(const fps::Mat4 &viewProject : views())
+    {
+      fps::Frustum frustum(viewProject);
+      std::vector<uint32_t> tree;
+      std::vector<uint32_t> brute;
+      bvh.cull(frustum,tree);
+      bvh.cullBruteForce(frustum,brute);
+      std::sort(tree.begin(),tree.end());
+      CHECK(tree==brute,"cull mismatch at %zu objects, tree %zu brute force %zu",count,tree.size(),brute.size());
+    }
+  }
+}
+TEST("cull_bvh_matches_brute_force",cullMatchesBruteForce);
+
+void classifyMatchesScalar()
+{
+  std::vector<fps::AABB> bounds=scatter(20000,77);
+  size_t results[3]={0,0,0};
+  for(const fps::Mat4 &viewProject : views())
+  {
+    fps::Frustum frustum(viewProject);
+    for(size_t i=0; i<bounds.size(); ++i)
+    {
+      fps::Frustum::Result simd=frustum.classify(bounds[i]);
+      fps::Frustum::Result scalar=frustum.classifyScalar(bounds[i]);
+      CHECK(simd==scalar,"box %zu classified %d against %d by the scalar test",i,simd,scalar);
+      ++results[simd];
+    }
+  }
+  // the views have to exercise all three outcomes for the comparison to mean anything
+  CHECK(results[fps::Frustum::OUTSIDE]!=0 && results[fps::Frustum::INTERSECTS]!=0 &&
+        results[fps::Frustum::INSIDE]!=0,"classified %zu outside %zu intersecting %zu inside",
+        results[fps::Frustum::OUTSIDE],results[fps::Frustum::INTERSECTS],results[fps::Frustum::INSIDE]);
+}
+TEST("frustum_classify_matches_scalar",classifyMatchesScalar);
+
+} // end anonymous namespace
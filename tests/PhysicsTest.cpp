@@ -0,0 +1,80 @@
+/****************************************************************************
+debris bodies, the SSE kernels must follow the scalar ones for both
+integrators, a resting layer must fall asleep and stepping on a JobSystem
+must give the single thread result bit for bit. The scenes are the ones
+PhysicsBench times, from bench/PhysicsScenes.h
+****************************************************************************/
+#include "Test.h"
+#include "PhysicsScenes.h"
+#include <memory>
+
+namespace
+{
+
+const float DT=1.0f/120.0f;
+
+void checkKernels(fps::RigidBodies::Integrator _integrator)
+{
+  // an odd count leaves a part filled group of four at the end
+  const size_t count=1001;
+  std::shared_ptr<bench::PhysicsScene> simd=bench::makeScene(count,bench::activeConfig(_integrator,true),false);
+  std::shared_ptr<bench::PhysicsScene> scalar=bench::makeScene(count,bench::activeConfig(_integrator,false),false);
+  for(int s=0; s<240; ++s)
+  {
+    simd->m_bodies.step(DT);
+    scalar->m_bodies.step(DT);
+  }
+  for(uint32_t i=0; i<count; ++i)
+  {
+    fps::Vec3 p=simd->m_bodies.position(i);
+    fps::Vec3 q=scalar->m_bodies.position(i);
+    CHECK((p-q).length()<=1.0e-3f && p.m_y>=-1.0f,"body %u at %g %g %g, the scalar step has it at %g %g %g",i,
+          p.m_x,p.m_y,p.m_z,q.m_x,q.m_y,q.m_z);
+  }
+}
+
+void eulerMatchesScalar() { checkKernels(fps::RigidBodies::SEMI_IMPLICIT_EULER); }
+TEST("rigid_euler_matches_scalar",eulerMatchesScalar);
+
+void verletMatchesScalar() { checkKernels(fps::RigidBodies::VERLET); }
+TEST("rigid_verlet_matches_scalar",verletMatchesScalar);
+
+void restingBodiesSleep()
+{
+  const size_t count=1000;
+  std::shared_ptr<bench::PhysicsScene> scene=bench::makeScene(count,fps::RigidBodies::Config(),true);
+  for(int s=0; s<240 && scene->m_bodies.awakeCount()!=0; ++s)
+  {
+    scene->m_bodies.step(DT);
+  }
+  CHECK(scene->m_bodies.awakeCount()==0,"%zu of %zu resting bodies never slept",scene->m_bodies.awakeCount(),count);
+}
+TEST("rigid_resting_bodies_sleep",restingBodiesSleep);
+
+void threadedMatchesSerial()
+{
+  const size_t count=4096;
+  const size_t threads[]={1,2,4,8};
+  std::shared_ptr<bench::PhysicsScene> serial=bench::makeHeaps(count,0);
+  for(int s=0; s<60; ++s)
+  {
+    serial->m_bodies.step(DT);
+  }
+  for(size_t t : threads)
+  {
+    std::shared_ptr<bench::PhysicsScene> threaded=bench::makeHeaps(count,t);
+    for(int s=0; s<60; ++s)
+    {
+      threaded->m_bodies.step(DT);
+    }
+    for(uint32_t i=0; i<count; ++i)
+    {
+      CHECK(serial->m_bodies.position(i)==threaded->m_bodies.position(i) &&
+            serial->m_bodies.velocity(i)==threaded->m_bodies.velocity(i),
+            "%zu thread step differs from the serial one at body %u",t,i);
+    }
+  }
+}
+TEST("rigid_threaded_matches_serial",threadedMatchesSerial);
+
+} // end anonymous namespace
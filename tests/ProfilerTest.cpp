@@ -0,0 +1,57 @@
+/****************************************************************************
+frame timing, the history read from another thread while frames are being
+published must never give a frame with stages from two different frames
+****************************************************************************/
+#include "Test.h"
+#include "FrameProfiler.h"
+#include <atomic>
+#include <thread>
+
+namespace
+{
+
+void historyNotTorn()
+{
+  fps::FrameProfiler profiler;
+  std::atomic<bool> done(false);
+  std::atomic<bool> torn(false);
+  std::atomic<size_t> reads(0);
+  // every stage but FRAME, which endFrame measures itself, holds the frame number
+  std::thread reader([&]()
+  {
+    while(!done.load(std::memory_order_acquire) && !torn.load(std::memory_order_relaxed))
+    {
+      for(const fps::FrameProfiler::FrameTimes &times : profiler.history())
+      {
+        for(int s=1; s<fps::FrameProfiler::NUM_STAGES; ++s)
+        {
+          if(s!=fps::FrameProfiler::FRAME && times[s]!=times[0])
+          {
+            torn.store(true,std::memory_order_relaxed);
+          }
+        }
+      }
+      reads.fetch_add(1,std::memory_order_relaxed);
+    }
+  });
+  for(int frame=1; frame<=200000 && !torn.load(std::memory_order_relaxed); ++frame)
+  {
+    for(int s=0; s<fps::FrameProfiler::NUM_STAGES; ++s)
+    {
+      if(s!=fps::FrameProfiler::FRAME)
+      {
+        profiler.addMs(static_cast<fps::FrameProfiler::Stage>(s),static_cast<float>(frame));
+      }
+    }
+    profiler.endFrame();
+  }
+  done.store(true,std::memory_order_release);
+  reader.join();
+  CHECK(!torn.load(),"history() returned a frame with stages from two frames after %zu reads",reads.load());
+  CHECK(profiler.frameCount()==200000 && profiler.history().size()==fps::FrameProfiler::HISTORY,
+        "%zu frames in the history after %llu published",profiler.history().size(),
+        static_cast<unsigned long long>(profiler.frameCount()));
+}
+TEST("profiler_history_not_torn",historyNotTorn);
+
+} // end anonymous namespace
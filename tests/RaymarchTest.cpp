@@ -0,0 +1,65 @@
+/****************************************************************************
+the CPU raymarcher, SIMD ray packets must shade the same picture as one ray
+at a time. The live pass's resolution controller must settle on its target
+****************************************************************************/
+#include "Test.h"
+#include "DynamicResolution.h"
+#include "Raymarcher.h"
+#include <cmath>
+#include <deque>
+
+namespace
+{
+
+void packetsMatchScalar()
+{
+  // an odd width leaves a part filled packet at the end of every row
+  const int width=97;
+  const int height=40;
+  fps::Mat4 view=fps::Raymarcher::shaderView(1.0f,0.0f,0.0f);
+  fps::Raymarcher scalar;
+  fps::Raymarcher packets;
+  scalar.settings().m_scalar=true;
+  packets.settings().m_scalar=false;
+  fps::RgbImage a;
+  fps::RgbImage b;
+  scalar.render(view,fps::Raymarcher::SHADER_FOV,width,height,nullptr,a);
+  packets.render(view,fps::Raymarcher::SHADER_FOV,width,height,nullptr,b);
+  int difference=fps::RgbImage::maxDifference(a,b);
+  size_t scalarHits=static_cast<size_t>(scalar.stats().m_hits);
+  size_t packetHits=static_cast<size_t>(packets.stats().m_hits);
+  CHECK(difference<=1 && packetHits==scalarHits,"raymarch packets off by %d with %zu hits against %zu",difference,
+        packetHits,scalarHits);
+  CHECK(scalarHits!=0,"no ray hit the scene");
+}
+TEST("raymarch_packets_match_scalar",packetsMatchScalar);
+
+void resolutionSettles()
+{
+  // a frame costs a fixed part and a part per pixel, and its time is only known a few frames later as with
+  // the GL_TIME_ELAPSED ring
+  const float fixedMs=2.0f;
+  const float fullFrameMs=30.0f;
+  fps::DynamicResolution controller;
+  std::deque<float> inFlight;
+  for(int i=0; i<300; ++i)
+  {
+    float scale=controller.scale();
+    inFlight.push_back(fixedMs+fullFrameMs*scale*scale);
+    if(inFlight.size()>3)
+    {
+      controller.addFrame(inFlight.front());
+      inFlight.pop_front();
+    }
+  }
+  const fps::DynamicResolution::Settings &settings=controller.settings();
+  float scale=controller.scale();
+  float ms=fixedMs+fullFrameMs*scale*scale;
+  // within the band, or as close as a step of the scale gets
+  float stepMs=fullFrameMs*(2.0f*scale*settings.m_step+settings.m_step*settings.m_step);
+  CHECK(std::fabs(ms-settings.m_targetMs)<=settings.m_tolerance*settings.m_targetMs+stepMs,
+        "dynamic resolution settled at %g (%g ms) against a target of %g ms",scale,ms,settings.m_targetMs);
+}
+TEST("dynamic_resolution_settles",resolutionSettles);
+
+} // end anonymous namespace
@@ -0,0 +1,236 @@
+/****************************************************************************
+scene loading, a text scene and the file FPSSceneCompile makes of it must
+load the same records, and a compiled file that is cut short or has a bad
+header, section table or record must be refused rather than mapped
+****************************************************************************/
+#include "Test.h"
+#include "Scene.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+// every kind of mesh, material field and collider the format has
+const char *TEXT=
+  "material copper ambient 0.19125 0.0735 0.0225 diffuse 0.7038 0.27048 0.0828 specular 0.256777 0.137622 0.086014 "
+  "shininess 12.8\n"
+  "material grey diffuse 0.5 0.5 0.5\n"
+  "mesh teapot primitive teapot radius 2\n"
+  "mesh marker lines\n"
+  "  v -0.5 -0.5 0\n"
+  "  v 0.5 1.0 0\n"
+  "end\n"
+  "mesh ramp triangles\n"
+  "  v 0 0 0\n"
+  "  v 4 0 0\n"
+  "  v 0 2 4\n"
+  "end\n"
+  "object teapot copper position -2 -3 0 rotate 10 20 30 scale 1.5 collider sphere 2\n"
+  "object teapot grey position 2 3 0 collider box 1 2 3\n"
+  "object marker copper\n"
+  "object ramp grey position 0 0 -5 collider mesh\n"
+  "object marker grey collider plane 0 1 0 1\n";
+
+std::string tempName(const char *_what)
+{
+  return std::string("/tmp/fps_scene_test_")+_what+"_"+std::to_string(getpid());
+}
+
+bool sameSection(const void *_a, const void *_b, size_t _bytes)
+{
+  return _bytes==0 || (_a!=nullptr && _b!=nullptr && std::memcmp(_a,_b,_bytes)==0);
+}
+
+void roundTrip()
+{
+  std::string text=tempName("text")+".scene";
+  std::string binary=tempName("binary")+".fpsb";
+  {
+    std::ofstream out(text.c_str());
+    out<<TEXT;
+  }
+  fps::Scene fromText;
+  fps::Scene fromBinary;
+  bool compiled=fromText.open(text) && fromText.save(binary);
+  bool mapped=compiled && fromBinary.open(binary);
+  std::remove(text.c_str());
+  std::remove(binary.c_str());
+  CHECK(compiled,"%s",fromText.error().c_str());
+  CHECK(mapped && fromBinary.mapped() && !fromText.mapped(),"compiled scene not mapped, %s",
+        fromBinary.error().c_str());
+
+  CHECK(fromText.meshCount()==3 && fromText.vertexCount()==5 && fromText.materialCount()==2 &&
+        fromText.objectCount()==5,"text scene has %zu meshes %zu vertices %zu materials %zu objects",
+        fromText.meshCount(),fromText.vertexCount(),fromText.materialCount(),fromText.objectCount());
+  CHECK(fromBinary.meshCount()==fromText.meshCount() && fromBinary.vertexCount()==fromText.vertexCount() &&
+        fromBinary.materialCount()==fromText.materialCount() && fromBinary.objectCount()==fromText.objectCount(),
+        "compiled scene has %zu meshes %zu vertices %zu materials %zu objects",fromBinary.meshCount(),
+        fromBinary.vertexCount(),fromBinary.materialCount(),fromBinary.objectCount());
+  CHECK(sameSection(fromBinary.meshes(),fromText.meshes(),fromText.meshCount()*sizeof(fps::SceneMesh)),
+        "mesh records differ");
+  CHECK(sameSection(fromBinary.vertices(),fromText.vertices(),fromText.vertexCount()*sizeof(fps::SceneVertex)),
+        "vertices differ");
+  CHECK(sameSection(fromBinary.materials(),fromText.materials(),
+                    fromText.materialCount()*sizeof(fps::SceneMaterial)),"material records differ");
+  CHECK(sameSection(fromBinary.objects(),fromText.objects(),fromText.objectCount()*sizeof(fps::SceneObject)),
+        "object records differ");
+  CHECK(sameSection(fromBinary.transforms(),fromText.transforms(),fromText.objectCount()*16*sizeof(float)),
+        "transforms differ");
+  // the transforms go straight to an instance buffer, so the mapping must keep them aligned
+  CHECK(reinterpret_cast<uintptr_t>(fromBinary.transforms())%64==0,"mapped transforms not 64 byte aligned");
+  CHECK(fromBinary.findMesh("ramp")==2 && fromBinary.findMesh("missing")==-1,"findMesh on the mapped scene");
+  const fps::SceneMesh &ramp=fromBinary.meshes()[2];
+  CHECK(ramp.m_mode==fps::SceneMesh::TRIANGLES && ramp.m_firstVertex==2 && ramp.m_vertexCount==3,
+        "ramp mesh mode %u first %u count %u",ramp.m_mode,ramp.m_firstVertex,ramp.m_vertexCount);
+  const fps::SceneObject &box=fromBinary.objects()[1];
+  CHECK(box.m_mesh==0 && box.m_material==1 && box.m_collider.m_type==fps::SceneCollider::BOX &&
+        box.m_collider.m_params[1]==2.0f,"box object mesh %u material %u collider %u",box.m_mesh,box.m_material,
+        box.m_collider.m_type);
+}
+TEST("scene_text_and_compiled_match",roundTrip);
+
+//----------------------------------------------------------------------------------------------------------------------
+// the compiled layout as Scene writes it, an 8 byte magic, version and section count, then an offset and a
+// count per section
+//----------------------------------------------------------------------------------------------------------------------
+const size_t VERSION_AT=8;
+const size_t SECTIONS_AT=16;
+
+template<typename T> T read(const std::vector<unsigned char> &_image, size_t _at)
+{
+  T v;
+  std::memcpy(&v,&_image[_at],sizeof(T));
+  return v;
+}
+
+template<typename T> void write(std::vector<unsigned char> &io_image, size_t _at, T _v)
+{
+  std::memcpy(&io_image[_at],&_v,sizeof(T));
+}
+
+size_t offsetAt(fps::Scene::Section _s) { return SECTIONS_AT+16*_s; }
+size_t countAt(fps::Scene::Section _s) { return SECTIONS_AT+16*_s+8; }
+
+// byte offset of the first record of a section in the image
+size_t sectionStart(const std::vector<unsigned char> &_image, fps::Scene::Section _s)
+{
+  return static_cast<size_t>(read<uint64_t>(_image,offsetAt(_s)));
+}
+
+// the file the text scene compiles to
+bool compiledImage(std::vector<unsigned char> &o_image)
+{
+  std::string fname=tempName("image")+".fpsb";
+  fps::Scene scene;
+  bool ok=scene.compile(TEXT) && scene.save(fname);
+  if(ok)
+  {
+    std::ifstream in(fname.c_str(),std::ios::binary);
+    o_image.assign(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+  }
+  std::remove(fname.c_str());
+  return ok && !o_image.empty();
+}
+
+// write the image out and open it, the error (never empty) if it was refused or an empty string if it was loaded
+std::string openImage(const std::vector<unsigned char> &_image)
+{
+  std::string fname=tempName("bad")+".fpsb";
+  {
+    std::ofstream out(fname.c_str(),std::ios::binary);
+    out.write(reinterpret_cast<const char *>(_image.data()),static_cast<std::streamsize>(_image.size()));
+  }
+  fps::Scene scene;
+  bool ok=scene.open(fname);
+  std::remove(fname.c_str());
+  return ok ? std::string() : scene.error()+" ";
+}
+
+bool refused(const std::string &_error, const char *_why)
+{
+  return _error.find(_why)!=std::string::npos;
+}
+
+void corruptRefused()
+{
+  std::vector<unsigned char> good;
+  CHECK(compiledImage(good),"the test scene did not compile");
+  CHECK(openImage(good).empty(),"the unmodified image was refused, %s",openImage(good).c_str());
+
+  // cut short inside the transforms, past the header so it is still taken as compiled
+  std::vector<unsigned char> bad(good.begin(),good.end()-1);
+  std::string error=openImage(bad);
+  CHECK(refused(error,"corrupt section table"),"a truncated file was %s",error.empty() ? "loaded" : error.c_str());
+  // too short for a header, so read as text which it is not
+  bad.assign(good.begin(),good.begin()+SECTIONS_AT);
+  error=openImage(bad);
+  CHECK(!error.empty(),"a file cut inside its header was loaded");
+
+  bad=good;
+  write<uint32_t>(bad,VERSION_AT,fps::Scene::VERSION+1);
+  error=openImage(bad);
+  CHECK(refused(error,"unsupported scene version"),"another version was %s",error.empty() ? "loaded" : error.c_str());
+  bad=good;
+  write<uint32_t>(bad,VERSION_AT+4,fps::Scene::NUM_SECTIONS+1);
+  error=openImage(bad);
+  CHECK(refused(error,"unsupported scene version"),"a different section count was %s",
+        error.empty() ? "loaded" : error.c_str());
+
+  // a section misaligned, past the end, or with more records than the file holds
+  bad=good;
+  write<uint64_t>(bad,offsetAt(fps::Scene::VERTICES),sectionStart(good,fps::Scene::VERTICES)+4);
+  error=openImage(bad);
+  CHECK(refused(error,"corrupt section table"),"a misaligned section was %s",error.empty() ? "loaded" : error.c_str());
+  bad=good;
+  write<uint64_t>(bad,offsetAt(fps::Scene::MATERIALS),(good.size()+64)&~static_cast<size_t>(63));
+  error=openImage(bad);
+  CHECK(refused(error,"corrupt section table"),"a section past the end was %s",
+        error.empty() ? "loaded" : error.c_str());
+  bad=good;
+  write<uint64_t>(bad,countAt(fps::Scene::MESHES),good.size()/sizeof(fps::SceneMesh)+1);
+  error=openImage(bad);
+  CHECK(refused(error,"corrupt section table"),"a count past the end was %s",error.empty() ? "loaded" : error.c_str());
+  bad=good;
+  write<uint64_t>(bad,countAt(fps::Scene::TRANSFORMS),read<uint64_t>(good,countAt(fps::Scene::TRANSFORMS))-1);
+  error=openImage(bad);
+  CHECK(refused(error,"transform count"),"fewer transforms than objects was %s",
+        error.empty() ? "loaded" : error.c_str());
+
+  // mesh records, an unterminated name and vertex ranges outside the vertex array
+  size_t mesh=sectionStart(good,fps::Scene::MESHES)+sizeof(fps::SceneMesh);
+  bad=good;
+  std::memset(&bad[mesh],'x',fps::SceneMesh::NAME_SIZE);
+  error=openImage(bad);
+  CHECK(refused(error,"bad mesh record"),"an unterminated mesh name was %s",error.empty() ? "loaded" : error.c_str());
+  bad=good;
+  write<uint32_t>(bad,mesh+offsetof(fps::SceneMesh,m_firstVertex),6);
+  error=openImage(bad);
+  CHECK(refused(error,"bad mesh record"),"a first vertex past the end was %s",error.empty() ? "loaded" : error.c_str());
+  bad=good;
+  write<uint32_t>(bad,mesh+offsetof(fps::SceneMesh,m_vertexCount),6);
+  error=openImage(bad);
+  CHECK(refused(error,"bad mesh record"),"a vertex range past the end was %s",error.empty() ? "loaded" : error.c_str());
+
+  // object records naming a mesh or material that is not there
+  size_t object=sectionStart(good,fps::Scene::OBJECTS)+2*sizeof(fps::SceneObject);
+  bad=good;
+  write<uint32_t>(bad,object+offsetof(fps::SceneObject,m_mesh),3);
+  error=openImage(bad);
+  CHECK(refused(error,"bad object record"),"an object with mesh 3 of 3 was %s",error.empty() ? "loaded" : error.c_str());
+  bad=good;
+  write<uint32_t>(bad,object+offsetof(fps::SceneObject,m_material),2);
+  error=openImage(bad);
+  CHECK(refused(error,"bad object record"),"an object with material 2 of 2 was %s",
+        error.empty() ? "loaded" : error.c_str());
+}
+TEST("scene_corrupt_file_refused",corruptRefused);
+
+} // end anonymous namespace
@@ -0,0 +1,142 @@
+/****************************************************************************
+the raymarched scene's distance field on the CPU, the SIMD batches must
+match the scalar reference, camera sweeps must stop on the surface and the
+brick cache must stay within a voxel of the field while it evicts
+****************************************************************************/
+#include "Test.h"
+#include "CollisionWorld.h"
+#include "SdfBrickCache.h"
+#include "SdfScene.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+
+void batchesMatchScalar()
+{
+  // points scattered through the shader's scene, an odd count exercises the padded tail too
+  const size_t n=1003;
+  fps::SdfScene scene;
+  std::mt19937 rng(19);
+  std::uniform_real_distribution<float> xz(-2.5f,2.5f);
+  std::uniform_real_distribution<float> y(-0.1f,1.0f);
+  std::vector<float> px(n);
+  std::vector<float> py(n);
+  std::vector<float> pz(n);
+  for(size_t i=0; i<n; ++i)
+  {
+    px[i]=xz(rng);
+    py[i]=y(rng);
+    pz[i]=xz(rng);
+  }
+  std::vector<float> d(n);
+  std::vector<float> m(n);
+  std::vector<float> refD(n);
+  std::vector<float> refM(n);
+  scene.map(&px[0],&py[0],&pz[0],n,&d[0],&m[0]);
+  scene.mapScalar(&px[0],&py[0],&pz[0],n,&refD[0],&refM[0]);
+  for(size_t i=0; i<n; ++i)
+  {
+    CHECK(std::fabs(d[i]-refD[i])<=1.0e-5f*(1.0f+std::fabs(refD[i])) && m[i]==refM[i],
+          "sdf batch mismatch at %zu: %g/%g against %g/%g",i,d[i],m[i],refD[i],refM[i]);
+  }
+}
+TEST("sdf_batches_match_scalar",batchesMatchScalar);
+
+void sweepContactsOnSurface()
+{
+  // the field at the scale of scenes/raymarch.scene, swept by the camera body over one tick of walking
+  const float radius=1.0f;
+  fps::SdfScene field(fps::Vec3(0.0f,-1.0f,0.0f),6.0f);
+  fps::CollisionWorld world;
+  world.addField(field);
+  world.build();
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> xz(-15.0f,15.0f);
+  std::uniform_real_distribution<float> up(0.0f,2.0f);
+  std::uniform_real_distribution<float> move(-0.5f,0.5f);
+  size_t sweeps=0;
+  size_t hits=0;
+  while(sweeps<1000)
+  {
+    fps::Vec3 start(xz(rng),0.0f,xz(rng));
+    // start just clear of whatever is below
+    start.m_y=up(rng);
+    if(field.distance(start)<radius)
+    {
+      continue;
+    }
+    fps::Vec3 end=start+fps::Vec3(move(rng),move(rng)-0.5f,move(rng));
+    fps::CollisionWorld::Hit hit;
+    ++sweeps;
+    if(!world.sweepSphere(start,end,radius,hit))
+    {
+      continue;
+    }
+    fps::Vec3 p=start+(end-start)*hit.m_time;
+    // the displaced sphere is not a true distance bound so a contact can land slightly inside, as m_depth
+    float gap=field.distance(p)-radius;
+    CHECK(gap<=1.0e-3f && std::fabs(hit.m_depth-std::max(-gap,0.0f))<=1.0e-4f &&
+          std::fabs(hit.m_normal.length()-1.0f)<=1.0e-4f && hit.m_normal.dot(end-start)<0.0f,
+          "sdf contact %zu off the surface by %g, depth %g",sweeps,gap,hit.m_depth);
+    ++hits;
+  }
+  CHECK(hits!=0,"no sdf sweep touched the field");
+}
+TEST("sdf_sweep_contacts_on_surface",sweepContactsOnSurface);
+
+void cacheWithinAVoxel()
+{
+  fps::SdfScene field(fps::Vec3(0.0f,-1.0f,0.0f),6.0f);
+  fps::SdfBrickCache::Settings settings;
+  settings.m_voxelSize=6.0f/64.0f;
+  // small enough that following the points around has to evict
+  settings.m_budgetBytes=64*fps::SdfBrickCache::SAMPLES*sizeof(float);
+  size_t capacity=settings.m_budgetBytes/(fps::SdfBrickCache::SAMPLES*sizeof(float));
+  // points near the surfaces, where collision queries land
+  std::vector<fps::Vec3> points;
+  std::mt19937 rng(23);
+  std::uniform_real_distribution<float> xz(-15.0f,15.0f);
+  std::uniform_real_distribution<float> y(-1.0f,3.0f);
+  while(points.size()<2000)
+  {
+    fps::Vec3 p(xz(rng),y(rng),xz(rng));
+    if(std::fabs(field.distance(p))<settings.m_band)
+    {
+      points.push_back(p);
+    }
+  }
+  fps::SdfBrickCache cache(field,settings);
+  const size_t window=256;
+  size_t baked=0;
+  for(size_t begin=0; begin<points.size(); begin+=window)
+  {
+    size_t end=std::min(points.size(),begin+window);
+    // query the window and bake what it asked for until nothing more is
+    for(int pass=0; pass<64; ++pass)
+    {
+      for(size_t i=begin; i<end; ++i)
+      {
+        cache.distance(points[i]);
+      }
+      size_t bricks=cache.update(nullptr);
+      baked+=bricks;
+      if(bricks==0)
+      {
+        break;
+      }
+    }
+    for(size_t i=begin; i<end; ++i)
+    {
+      float error=std::fabs(cache.distance(points[i])-field.distance(points[i]));
+      CHECK(error<=settings.m_voxelSize && cache.residentBricks()<=capacity,
+            "sdf cache off by %g at point %zu with %zu bricks resident",error,i,cache.residentBricks());
+    }
+  }
+  CHECK(baked>capacity,"only %zu bricks baked, the cache never had to evict",baked);
+}
+TEST("sdf_cache_within_a_voxel",cacheWithinAVoxel);
+
+} // end anonymous namespace
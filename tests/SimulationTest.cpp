@@ -0,0 +1,281 @@
+/****************************************************************************
+the simulation thread's hand off, snapshots published by a writer thread
+must reach a reader thread whole and in order. A tick's input must turn by
+the summed motion of its samples and keep a tap shorter than the tick. Jump
+starts on a press, not on landing with the key held, and letting go cuts it.
+A recorded session, written out and read back, must replay the same path
+and its end must be published even when the last ticks changed nothing
+****************************************************************************/
+#include "Test.h"
+#include "Simulation.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <thread>
+
+namespace
+{
+
+void snapshotHandoff()
+{
+  const uint64_t publishes=20000;
+  const size_t payload=1024;
+  fps::TripleBuffer<fps::FrameSnapshot> buffer;
+  std::thread writer([&buffer]()
+  {
+    for(uint64_t tick=1; tick<=publishes; ++tick)
+    {
+      fps::FrameSnapshot &s=buffer.back();
+      s.m_tick=tick;
+      s.m_debrisTransforms.assign(payload,static_cast<float>(tick));
+      buffer.publish();
+    }
+  });
+  uint64_t last=0;
+  bool ok=true;
+  while(ok && last<publishes)
+  {
+    if(!buffer.acquire())
+    {
+      continue;
+    }
+    const fps::FrameSnapshot &s=buffer.front();
+    ok=s.m_debrisTransforms.size()==payload && s.m_tick>last;
+    for(size_t i=0; ok && i<payload; ++i)
+    {
+      ok=s.m_debrisTransforms[i]==static_cast<float>(s.m_tick);
+    }
+    if(ok)
+    {
+      last=s.m_tick;
+    }
+  }
+  writer.join();
+  CHECK(ok,"snapshot torn or out of order after %llu",static_cast<unsigned long long>(last));
+}
+TEST("sim_snapshot_handoff",snapshotHandoff);
+
+void inputCoalesces()
+{
+  fps::InputSystem input;
+  input.bindings().bindKey(1,fps::INPUT_FORWARD);
+  input.bindings().bindButton(2,fps::INPUT_LOOK);
+  // motion before the look button goes down does not turn
+  input.push(fps::InputSample::motion(100.0f,100.0f,0.5));
+  input.push(fps::InputSample::button(2,true,1.0));
+  input.push(fps::InputSample::key(1,true,1.0));
+  input.push(fps::InputSample::key(1,false,1.5));
+  for(int i=0; i<100; ++i)
+  {
+    input.push(fps::InputSample::motion(1.0f,-2.0f,1.0+i*0.01));
+  }
+  // stamped after the tick began, left for the next one
+  input.push(fps::InputSample::motion(50.0f,50.0f,3.0));
+  const fps::InputState &state=input.collect(2.0);
+  float degrees=input.bindings().m_lookDegreesPerPixel;
+  CHECK(state.m_motions==100 && std::fabs(state.m_yaw-100.0f*degrees)<=1.0e-3f &&
+        std::fabs(state.m_pitch+200.0f*degrees)<=1.0e-3f,"input collected %zu motions turning %g %g",
+        state.m_motions,state.m_pitch,state.m_yaw);
+  CHECK(state.active(fps::INPUT_FORWARD) && !state.m_held[fps::INPUT_FORWARD] && state.m_held[fps::INPUT_LOOK],
+        "forward active %d held %d, look held %d",state.active(fps::INPUT_FORWARD),state.m_held[fps::INPUT_FORWARD],
+        state.m_held[fps::INPUT_LOOK]);
+  CHECK(input.collect(4.0).m_motions==1 && !input.state().active(fps::INPUT_FORWARD),
+        "input lost the late motion or kept a released key");
+}
+TEST("input_coalesces_a_tick",inputCoalesces);
+
+const double DT=1.0/120.0;
+const int JUMP_KEY=' ';
+
+// advance single steps until the camera is back on the ground, counting the ticks that started a rise
+int untilLanded(fps::Simulation &_sim, int _maxTicks)
+{
+  int jumps=0;
+  for(int i=0; i<_maxTicks; ++i)
+  {
+    float before=_sim.controller().physics().velocity.m_y;
+    _sim.advance(DT);
+    jumps+= before<=0.0f && _sim.controller().physics().velocity.m_y>0.0f ? 1 : 0;
+    if(_sim.controller().grounded())
+    {
+      break;
+    }
+  }
+  return jumps;
+}
+
+void jumpOnPressEdge()
+{
+  fps::Simulation sim(DT,16);
+  sim.input().bindings().bindKey(JUMP_KEY,fps::INPUT_JUMP);
+  sim.controller().reset(fps::Vec3(0.0f,0.0f,0.0f));
+  sim.advance(DT);
+  CHECK(sim.controller().grounded(),"the camera did not start on the ground");
+
+  // one press jumps once, holding the key through the landing and well after does not jump again
+  sim.input().push(fps::InputSample::key(JUMP_KEY,true,0.0));
+  sim.advance(DT);
+  CHECK(sim.controller().physics().velocity.m_y>0.0f && !sim.controller().grounded(),"a press did not jump");
+  int jumps=untilLanded(sim,1000);
+  CHECK(jumps==0 && sim.controller().grounded(),"held jump rose %d more times before landing",jumps);
+  for(int i=0; i<240; ++i)
+  {
+    sim.advance(DT);
+    CHECK(sim.controller().grounded(),"holding jump jumped again %d ticks after landing",i);
+  }
+
+  // letting go on the ground does nothing, the next press jumps again
+  sim.input().push(fps::InputSample::key(JUMP_KEY,false,0.0));
+  sim.advance(DT);
+  CHECK(sim.controller().grounded(),"letting go on the ground left it");
+  sim.input().push(fps::InputSample::key(JUMP_KEY,true,0.0));
+  sim.advance(DT);
+  CHECK(sim.controller().physics().velocity.m_y>0.0f,"a second press did not jump");
+
+  // letting go while rising cuts the rise, the velocity is zeroed before the tick's step adds gravity
+  for(int i=0; i<5; ++i)
+  {
+    sim.advance(DT);
+  }
+  CHECK(sim.controller().physics().velocity.m_y>0.0f,"the jump stopped rising on its own");
+  float height=sim.controller().position().m_y;
+  sim.input().push(fps::InputSample::key(JUMP_KEY,false,0.0));
+  sim.advance(DT);
+  CHECK(sim.controller().physics().velocity.m_y<=0.0f && sim.controller().position().m_y<=height,
+        "letting go left the camera rising at %g",sim.controller().physics().velocity.m_y);
+  jumps=untilLanded(sim,1000);
+  CHECK(jumps==0 && sim.controller().grounded(),"released jump rose %d more times before landing",jumps);
+
+  // a tap shorter than a tick still jumps, and is cut on the tick after
+  sim.input().push(fps::InputSample::key(JUMP_KEY,true,0.0));
+  sim.input().push(fps::InputSample::key(JUMP_KEY,false,0.0));
+  sim.advance(DT);
+  CHECK(sim.controller().physics().velocity.m_y>0.0f,"a tap within one tick did not jump");
+  sim.advance(DT);
+  CHECK(sim.controller().physics().velocity.m_y<=0.0f,"a tap rose past the tick after it");
+}
+TEST("sim_jump_on_press_edge",jumpOnPressEdge);
+
+// a scripted session of walking, jumping, looking and throwing debris, recorded through the live input
+void recordSession(size_t _ticks, fps::InputRecording &o_recording, std::vector<fps::Vec3> &o_path)
+{
+  fps::Simulation sim(DT,16);
+  fps::InputBindings &bindings=sim.input().bindings();
+  bindings.bindKey('W',fps::INPUT_FORWARD);
+  bindings.bindKey('A',fps::INPUT_LEFT);
+  bindings.bindKey(JUMP_KEY,fps::INPUT_JUMP);
+  bindings.bindKey('B',fps::INPUT_SPAWN_DEBRIS);
+  bindings.bindButton(1,fps::INPUT_LOOK);
+  sim.controller().reset(fps::Vec3(0.0f,5.0f,15.0f));
+  sim.record(&o_recording);
+  for(size_t i=0; i<_ticks; ++i)
+  {
+    int phase=static_cast<int>(i%240);
+    fps::InputSystem &input=sim.input();
+    if(phase==0) input.push(fps::InputSample::key('W',true,0.0));
+    if(phase==30) input.push(fps::InputSample::key(JUMP_KEY,true,0.0));
+    if(phase==40) input.push(fps::InputSample::key(JUMP_KEY,false,0.0));
+    if(phase==60) input.push(fps::InputSample::button(1,true,0.0));
+    if(phase>60 && phase<120) input.push(fps::InputSample::motion(3.0f,phase%7-3.0f,0.0));
+    if(phase==120)
+    {
+      input.push(fps::InputSample::button(1,false,0.0));
+      input.push(fps::InputSample::key('A',true,0.0));
+      input.push(fps::InputSample::key('B',true,0.0));
+      input.push(fps::InputSample::key('B',false,0.0));
+    }
+    if(phase==180) input.push(fps::InputSample::key('W',false,0.0));
+    if(phase==200) input.push(fps::InputSample::key('A',false,0.0));
+    // uneven frame times so ticks take none, one or a few steps
+    sim.advance(DT*(0.5+(i%5)*0.4));
+    o_path.push_back(sim.controller().position());
+  }
+  sim.record(nullptr);
+}
+
+void replayFollowsRecording()
+{
+  fps::InputRecording recorded;
+  std::vector<fps::Vec3> path;
+  recordSession(1200,recorded,path);
+  CHECK(recorded.tickCount()==path.size(),"recorded %llu ticks of %zu",
+        static_cast<unsigned long long>(recorded.tickCount()),path.size());
+  // through a file, as FPS_INPUT_RECORD and FPSReplay use it
+  std::string fname="/tmp/fps_replay_test_"+std::to_string(getpid())+".fpsi";
+  fps::InputRecording recording;
+  bool written=recorded.write(fname);
+  bool read=written && recording.read(fname);
+  std::remove(fname.c_str());
+  CHECK(written && read,"%s",written ? recording.error().c_str() : recorded.error().c_str());
+
+  // from somewhere else entirely, the replay puts the camera back where the recording started
+  fps::Simulation sim(DT,16);
+  sim.controller().reset(fps::Vec3(0.0f,-50.0f,0.0f));
+  CHECK(sim.replay(&recording,false),"the recording's step was refused");
+  for(size_t i=0; i<path.size(); ++i)
+  {
+    sim.advance(0.0);
+    fps::Vec3 p=sim.controller().position();
+    CHECK(p==path[i],"replay tick %zu at %g %g %g, recorded %g %g %g",i,p.m_x,p.m_y,p.m_z,path[i].m_x,path[i].m_y,
+          path[i].m_z);
+  }
+  sim.advance(0.0);
+  CHECK(!sim.replaying(),"replay did not end after the %zu recorded ticks",path.size());
+}
+TEST("input_replay_follows_recording",replayFollowsRecording);
+
+void truncatedRecordingRefused()
+{
+  fps::InputRecording recorded;
+  std::vector<fps::Vec3> path;
+  recordSession(240,recorded,path);
+  std::string fname="/tmp/fps_truncated_test_"+std::to_string(getpid())+".fpsi";
+  CHECK(recorded.write(fname),"%s",recorded.error().c_str());
+  // cut the last tick short by a byte
+  struct stat info;
+  bool cut=stat(fname.c_str(),&info)==0 && truncate(fname.c_str(),info.st_size-1)==0;
+  fps::InputRecording recording;
+  bool read=recording.read(fname);
+  std::remove(fname.c_str());
+  CHECK(cut && !read && !recording.error().empty(),"a truncated recording was read");
+}
+TEST("input_truncated_recording_refused",truncatedRecordingRefused);
+
+void replayEndPublished()
+{
+  // standing still on the ground, so only the replay's first tick publishes
+  fps::InputRecording recording;
+  {
+    fps::Simulation sim(DT,16);
+    sim.controller().reset(fps::Vec3(0.0f,0.0f,0.0f));
+    sim.advance(DT);
+    sim.record(&recording);
+    for(int i=0; i<240; ++i)
+    {
+      sim.advance(DT);
+    }
+    sim.record(nullptr);
+  }
+
+  fps::Simulation sim(DT,16);
+  CHECK(sim.replay(&recording,false),"the recording's step was refused");
+  // taking each snapshot as it comes, the way the renderer paces a replay
+  for(uint64_t i=0; i<recording.tickCount(); ++i)
+  {
+    sim.acquire();
+    sim.advance(0.0);
+  }
+  sim.acquire();
+  uint64_t tick=sim.snapshot().m_tick;
+  CHECK(sim.replaying() && tick!=0,"replay ended early or never published");
+  sim.advance(0.0);
+  CHECK(sim.acquire(),"the end of the replay published no snapshot, last one at tick %llu",
+        static_cast<unsigned long long>(tick));
+  CHECK(!sim.replaying(),"replay did not end after %llu recorded ticks",
+        static_cast<unsigned long long>(recording.tickCount()));
+}
+TEST("input_replay_end_published",replayEndPublished);
+
+} // end anonymous namespace
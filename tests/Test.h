@@ -0,0 +1,70 @@
+#ifndef TEST_H__
+#define TEST_H__
+
+#include <functional>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Test.h
+/// @brief tiny test harness in the style of Bench.h. Each test registers a function at static initialisation
+/// time, the runner calls them in turn and a CHECK that fails reports where and why and ends its function.
+//----------------------------------------------------------------------------------------------------------------------
+namespace test
+{
+
+typedef std::function<void()> Body;
+
+struct Test
+{
+  std::string name;
+  Body body;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief all tests linked into the executable
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<Test> & registry();
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief registers a test at static initialisation time
+//----------------------------------------------------------------------------------------------------------------------
+struct Registrar
+{
+  Registrar(const char *_name, Body _body)
+  {
+    registry().push_back({_name,_body});
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief mark the running test as failed with a printf style message
+//----------------------------------------------------------------------------------------------------------------------
+void fail(const char *_file, int _line, const char *_fmt, ...)
+#if defined(__GNUC__)
+  __attribute__((format(printf,3,4)))
+#endif
+;
+
+} // end namespace test
+
+#define TEST_CONCAT_INNER(a,b) a##b
+#define TEST_CONCAT(a,b) TEST_CONCAT_INNER(a,b)
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief TEST("name",function)
+//----------------------------------------------------------------------------------------------------------------------
+#define TEST(...) static test::Registrar TEST_CONCAT(s_testRegistrar,__LINE__)(__VA_ARGS__)
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief CHECK(condition,"format",...) fails the test and returns from the (void) function it is in
+//----------------------------------------------------------------------------------------------------------------------
+#define CHECK(_condition,...) \
+  do \
+  { \
+    if(!(_condition)) \
+    { \
+      test::fail(__FILE__,__LINE__,__VA_ARGS__); \
+      return; \
+    } \
+  } while(false)
+
+#endif
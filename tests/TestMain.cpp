@@ -0,0 +1,78 @@
+/****************************************************************************
+test runner, usage
+  FPSTests [--filter substring]
+prints one line per test and exits non zero if any of them failed, ctest
+runs it as the FPSTests test
+****************************************************************************/
+#include "Test.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+int s_failures=0;
+
+} // end anonymous namespace
+
+namespace test
+{
+
+std::vector<Test> & registry()
+{
+  static std::vector<Test> s_registry;
+  return s_registry;
+}
+
+void fail(const char *_file, int _line, const char *_fmt, ...)
+{
+  ++s_failures;
+  std::fprintf(stderr,"%s:%d: ",_file,_line);
+  va_list args;
+  va_start(args,_fmt);
+  std::vfprintf(stderr,_fmt,args);
+  va_end(args);
+  std::fprintf(stderr,"\n");
+}
+
+} // end namespace test
+
+int main(int argc, char **argv)
+{
+  typedef std::chrono::steady_clock Clock;
+  std::string filter;
+  for(int i=1; i<argc; ++i)
+  {
+    if(!strcmp(argv[i],"--filter") && i+1<argc) filter=argv[++i];
+    else
+    {
+      std::cerr<<"usage : "<<argv[0]<<" [--filter substring]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  size_t run=0;
+  size_t failed=0;
+  for(const test::Test &t : test::registry())
+  {
+    if(!filter.empty() && t.name.find(filter)==std::string::npos)
+    {
+      continue;
+    }
+    int before=s_failures;
+    Clock::time_point start=Clock::now();
+    t.body();
+    double ms=std::chrono::duration<double,std::milli>(Clock::now()-start).count();
+    bool ok= s_failures==before;
+    std::printf("%-4s %s (%.1f ms)\n",ok ? "ok" : "FAIL",t.name.c_str(),ms);
+    std::fflush(stdout);
+    ++run;
+    failed+= ok ? 0 : 1;
+  }
+  std::printf("%zu of %zu tests passed\n",run-failed,run);
+  return failed==0 && run!=0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
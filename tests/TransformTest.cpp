@@ -0,0 +1,143 @@
+/****************************************************************************
+object transforms, the SIMD passes must build the same model and model view
+matrices as the scalar ones, and both the matrices Scene compiles with
+Euler angles applied x then y then z
+****************************************************************************/
+#include "Test.h"
+#include "Scene.h"
+#include "TransformSystem.h"
+#include <cmath>
+#include <random>
+#include <sstream>
+
+namespace
+{
+
+const fps::Mat4 VIEW=fps::lookAt(fps::Vec3(3.0f,5.0f,15.0f),fps::Vec3(0.0f,5.0f,0.0f),fps::Vec3(0.0f,1.0f,0.0f));
+
+// the passes order their arithmetic differently so only agree to float rounding, scaled by the size of the value
+bool near(float _a, float _b)
+{
+  return std::fabs(_a-_b)<=1e-5f*(1.0f+std::fabs(_b));
+}
+
+// index of the first of _count matrices that differ, _count if none do
+size_t firstMismatch(const float *_a, const float *_b, size_t _count)
+{
+  for(size_t i=0; i<16*_count; ++i)
+  {
+    if(!near(_a[i],_b[i]))
+    {
+      return i/16;
+    }
+  }
+  return _count;
+}
+
+// model matrix in ngl order, scale then rotate about x, y, z then translate, one rotation matrix per axis
+fps::Mat4 reference(const fps::Vec3 &_pos, const fps::Vec3 &_rot, const fps::Vec3 &_scale)
+{
+  const float toRad=3.14159265358979f/180.0f;
+  fps::Mat4 rx, ry, rz, s;
+  rx.m_m[1][1]=std::cos(_rot.m_x*toRad); rx.m_m[1][2]=std::sin(_rot.m_x*toRad);
+  rx.m_m[2][1]=-rx.m_m[1][2];            rx.m_m[2][2]=rx.m_m[1][1];
+  ry.m_m[0][0]=std::cos(_rot.m_y*toRad); ry.m_m[0][2]=-std::sin(_rot.m_y*toRad);
+  ry.m_m[2][0]=-ry.m_m[0][2];            ry.m_m[2][2]=ry.m_m[0][0];
+  rz.m_m[0][0]=std::cos(_rot.m_z*toRad); rz.m_m[0][1]=std::sin(_rot.m_z*toRad);
+  rz.m_m[1][0]=-rz.m_m[0][1];            rz.m_m[1][1]=rz.m_m[0][0];
+  s.m_m[0][0]=_scale.m_x; s.m_m[1][1]=_scale.m_y; s.m_m[2][2]=_scale.m_z;
+  fps::Mat4 m=s*rx*ry*rz;
+  m.m_m[3][0]=_pos.m_x;
+  m.m_m[3][1]=_pos.m_y;
+  m.m_m[3][2]=_pos.m_z;
+  return m;
+}
+
+void simdMatchesScalar()
+{
+  // a count that leaves the last block part full whichever WIDTH is built
+  const size_t count=8*13+5;
+  std::mt19937 rng(4321);
+  std::uniform_real_distribution<float> pos(-100.0f,100.0f);
+  std::uniform_real_distribution<float> angle(-180.0f,180.0f);
+  std::uniform_real_distribution<float> scale(0.2f,3.0f);
+  fps::TransformSystem simd;
+  fps::TransformSystem scalar;
+  std::vector<fps::Vec3> p(count), r(count), s(count);
+  for(size_t i=0; i<count; ++i)
+  {
+    p[i]=fps::Vec3(pos(rng),pos(rng),pos(rng));
+    r[i]=fps::Vec3(angle(rng),angle(rng),angle(rng));
+    s[i]=fps::Vec3(scale(rng),scale(rng),scale(rng));
+    simd.add(p[i],r[i],s[i]);
+    scalar.add(p[i],r[i],s[i]);
+  }
+  CHECK(simd.updateModels()==count && scalar.updateModelsScalar()==count,"not every new object was rebuilt");
+  size_t bad=firstMismatch(simd.models(),scalar.models(),count);
+  CHECK(bad==count,"model %zu of %zu differs from the scalar pass",bad,count);
+  for(size_t i=0; i<count; ++i)
+  {
+    fps::Mat4 m=reference(p[i],r[i],s[i]);
+    CHECK(firstMismatch(simd.model(static_cast<uint32_t>(i)),&m.m_m[0][0],1)==1,
+          "model %zu differs from rotating about x, y then z",i);
+  }
+
+  // only a few objects change, in the first and the part full last block
+  const uint32_t moved[]={0,3,static_cast<uint32_t>(count-1)};
+  for(uint32_t i : moved)
+  {
+    p[i]=fps::Vec3(pos(rng),pos(rng),pos(rng));
+    r[i]=fps::Vec3(angle(rng),angle(rng),angle(rng));
+    s[i]=fps::Vec3(scale(rng),scale(rng),scale(rng));
+    simd.setPosition(i,p[i]);
+    simd.setRotation(i,r[i]);
+    simd.setScale(i,s[i]);
+    scalar.setPosition(i,p[i]);
+    scalar.setRotation(i,r[i]);
+    scalar.setScale(i,s[i]);
+  }
+  simd.update(VIEW);
+  scalar.updateScalar(VIEW);
+  bad=firstMismatch(simd.models(),scalar.models(),count);
+  CHECK(bad==count,"model %zu of %zu differs from the scalar pass after a partial update",bad,count);
+  bad=firstMismatch(simd.modelViews(),scalar.modelViews(),count);
+  CHECK(bad==count,"model view %zu of %zu differs from the scalar pass",bad,count);
+  for(size_t i=0; i<count; ++i)
+  {
+    fps::Mat4 m=reference(p[i],r[i],s[i])*VIEW;
+    CHECK(firstMismatch(&simd.modelViews()[16*i],&m.m_m[0][0],1)==1,"model view %zu differs from model*view",i);
+  }
+}
+TEST("transform_simd_matches_scalar",simdMatchesScalar);
+
+// objects as a level places them, the transform system rebuilt from their records must match the compiled matrices
+void matchesScene()
+{
+  std::mt19937 rng(8765);
+  std::uniform_real_distribution<float> pos(-100.0f,100.0f);
+  std::uniform_real_distribution<float> angle(-180.0f,180.0f);
+  std::uniform_real_distribution<float> scale(0.2f,3.0f);
+  std::ostringstream text;
+  text<<"material grey\nmesh teapot primitive teapot radius 1\n";
+  for(size_t i=0; i<8*3+3; ++i)
+  {
+    text<<"object teapot grey position "<<pos(rng)<<" "<<pos(rng)<<" "<<pos(rng)<<" rotate "<<angle(rng)<<" "
+        <<angle(rng)<<" "<<angle(rng)<<" scale "<<scale(rng)<<"\n";
+  }
+  fps::Scene scene;
+  CHECK(scene.compile(text.str()),"%s",scene.error().c_str());
+  fps::TransformSystem transforms;
+  for(size_t i=0; i<scene.objectCount(); ++i)
+  {
+    const fps::SceneObject &o=scene.objects()[i];
+    transforms.add(fps::Vec3(o.m_position[0],o.m_position[1],o.m_position[2]),
+                   fps::Vec3(o.m_rotation[0],o.m_rotation[1],o.m_rotation[2]),
+                   fps::Vec3(o.m_scale,o.m_scale,o.m_scale));
+  }
+  transforms.updateModels();
+  size_t bad=firstMismatch(transforms.models(),scene.transforms(),scene.objectCount());
+  CHECK(bad==scene.objectCount(),"object %zu of %zu differs from the compiled scene",bad,scene.objectCount());
+}
+TEST("transform_matches_scene",matchesScene);
+
+} // end anonymous namespace
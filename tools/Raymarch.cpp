@@ -0,0 +1,112 @@
+/****************************************************************************
+render the raymarched scene on the CPU, for golden images on machines with
+no GPU and to see what the march costs where
+usage FPSRaymarch [--size WxH] [--time t] [--mouse x y]
+                  [--eye x y z --target x y z] [--fov degrees]
+                  [--threads n] [--tile n] [--scalar] [--heatmap]
+                  [--out frame.ppm] [--compare golden.ppm] [--tolerance n]
+by default the camera is iq's original orbit at iGlobalTime t and the
+mouse at x y in 0..1. --heatmap draws the march steps of each pixel instead
+of shading. With --compare the exit status is a failure when any channel
+differs from the golden image by more than the tolerance
+****************************************************************************/
+#include "Raymarcher.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+int main(int argc, char **argv)
+{
+  int width=640;
+  int height=360;
+  float time=1.0f;
+  float mouse[2]={0.0f,0.0f};
+  bool ownCamera=false;
+  fps::Vec3 eye;
+  fps::Vec3 target;
+  float fov=fps::Raymarcher::SHADER_FOV;
+  size_t threads=0;
+  std::string out;
+  std::string golden;
+  int tolerance=0;
+  fps::Raymarcher raymarcher;
+  fps::Raymarcher::Settings &settings=raymarcher.settings();
+  for(int i=1; i<argc; ++i)
+  {
+    if(!std::strcmp(argv[i],"--size") && i+1<argc && std::sscanf(argv[i+1],"%dx%d",&width,&height)==2) ++i;
+    else if(!std::strcmp(argv[i],"--time") && i+1<argc) time=std::strtof(argv[++i],nullptr);
+    else if(!std::strcmp(argv[i],"--mouse") && i+2<argc)
+    {
+      mouse[0]=std::strtof(argv[++i],nullptr);
+      mouse[1]=std::strtof(argv[++i],nullptr);
+    }
+    else if(!std::strcmp(argv[i],"--eye") && i+3<argc)
+    {
+      eye=fps::Vec3(std::strtof(argv[i+1],nullptr),std::strtof(argv[i+2],nullptr),std::strtof(argv[i+3],nullptr));
+      ownCamera=true;
+      i+=3;
+    }
+    else if(!std::strcmp(argv[i],"--target") && i+3<argc)
+    {
+      target=fps::Vec3(std::strtof(argv[i+1],nullptr),std::strtof(argv[i+2],nullptr),std::strtof(argv[i+3],nullptr));
+      i+=3;
+    }
+    else if(!std::strcmp(argv[i],"--fov") && i+1<argc) fov=std::strtof(argv[++i],nullptr);
+    else if(!std::strcmp(argv[i],"--threads") && i+1<argc) threads=std::strtoull(argv[++i],nullptr,10);
+    else if(!std::strcmp(argv[i],"--tile") && i+1<argc) settings.m_tileSize=std::atoi(argv[++i]);
+    else if(!std::strcmp(argv[i],"--scalar")) settings.m_scalar=true;
+    else if(!std::strcmp(argv[i],"--heatmap")) settings.m_heatmap=true;
+    else if(!std::strcmp(argv[i],"--out") && i+1<argc) out=argv[++i];
+    else if(!std::strcmp(argv[i],"--compare") && i+1<argc) golden=argv[++i];
+    else if(!std::strcmp(argv[i],"--tolerance") && i+1<argc) tolerance=std::atoi(argv[++i]);
+    else
+    {
+      std::fprintf(stderr,"usage %s [--size WxH] [--time t] [--mouse x y] [--eye x y z --target x y z] [--fov degrees]"
+                   " [--threads n] [--tile n] [--scalar] [--heatmap] [--out frame.ppm] [--compare golden.ppm]"
+                   " [--tolerance n]\n",argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if(width<=0 || height<=0)
+  {
+    std::fprintf(stderr,"bad image size %dx%d\n",width,height);
+    return EXIT_FAILURE;
+  }
+
+  fps::Mat4 view= ownCamera ? fps::lookAt(eye,target,fps::Vec3(0.0f,1.0f,0.0f)) :
+                              fps::Raymarcher::shaderView(time,mouse[0],mouse[1]);
+  fps::JobSystem jobs(threads);
+  fps::RgbImage image;
+  raymarcher.render(view,fov,width,height,&jobs,image);
+
+  const fps::Raymarcher::Stats &stats=raymarcher.stats();
+  double rays=static_cast<double>(stats.m_rays);
+  std::printf("%dx%d %s on %zu threads: %.2f ms, %.1f%% hits, %.2f march steps and %.2f map points per ray,"
+              " hash %016" PRIx64 "\n",width,height,settings.m_scalar ? "scalar" : "packets",jobs.threadCount(),
+              stats.m_ms,100.0*static_cast<double>(stats.m_hits)/rays,static_cast<double>(stats.m_marchSteps)/rays,
+              static_cast<double>(stats.m_mapPoints)/rays,image.hash());
+
+  if(!out.empty() && !image.writePPM(out))
+  {
+    std::fprintf(stderr,"could not write %s\n",out.c_str());
+    return EXIT_FAILURE;
+  }
+  if(!golden.empty())
+  {
+    fps::RgbImage reference;
+    if(!reference.readPPM(golden))
+    {
+      std::fprintf(stderr,"could not read %s\n",golden.c_str());
+      return EXIT_FAILURE;
+    }
+    int difference=fps::RgbImage::maxDifference(image,reference);
+    std::printf("largest difference from %s: %d\n",golden.c_str(),difference);
+    if(difference>tolerance)
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/****************************************************************************
+fly a recorded input session through the simulation with no window, to time
+the simulation on exactly the workload of another build or machine
+usage FPSReplay session.fpsi [--scene file] [--realtime] [--size WxH]
+the session is what the demo wrote with FPS_INPUT_RECORD and the scene is
+the one it had loaded (scenes/default.scene by default). Every tick is taken
+straight after the last unless --realtime paces them as they were played.
+Prints what a tick cost, the slowest tick so a spike can be found again, and
+a hash of the camera path that two builds agree on when they flew it alike
+****************************************************************************/
+#include "Simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+  std::string session;
+  std::string sceneFile="scenes/default.scene";
+  bool realTime=false;
+  int width=1920;
+  int height=1080;
+  for(int i=1; i<argc; ++i)
+  {
+    if(!std::strcmp(argv[i],"--scene") && i+1<argc) sceneFile=argv[++i];
+    else if(!std::strcmp(argv[i],"--realtime")) realTime=true;
+    else if(!std::strcmp(argv[i],"--size") && i+1<argc && std::sscanf(argv[i+1],"%dx%d",&width,&height)==2) ++i;
+    else if(session.empty() && argv[i][0]!='-') session=argv[i];
+    else
+    {
+      std::fprintf(stderr,"usage %s session.fpsi [--scene file] [--realtime] [--size WxH]\n",argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if(session.empty())
+  {
+    std::fprintf(stderr,"usage %s session.fpsi [--scene file] [--realtime] [--size WxH]\n",argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  fps::InputRecording recording;
+  if(!recording.read(session))
+  {
+    std::fprintf(stderr,"%s\n",recording.error().c_str());
+    return EXIT_FAILURE;
+  }
+  fps::Scene scene;
+  if(!scene.open(sceneFile))
+  {
+    std::fprintf(stderr,"%s\n",scene.error().c_str());
+    return EXIT_FAILURE;
+  }
+  // the demo's step cap, a recorded tick never holds more
+  fps::Simulation sim(recording.dt(),16);
+  sim.setScene(scene);
+  sim.post(fps::Simulation::Command::viewport(width,height));
+  if(!sim.replay(&recording,realTime))
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<double> tickMs;
+  tickMs.reserve(recording.tickCount());
+  size_t slowest=0;
+  uint64_t path=14695981039346656037ull;
+  auto add=[&path](float _value)
+  {
+    uint32_t bits;
+    std::memcpy(&bits,&_value,sizeof(bits));
+    for(int shift=0; shift<32; shift+=8)
+    {
+      path^=static_cast<uint8_t>(bits>>shift);
+      path*=1099511628211ull;
+    }
+  };
+  double start=fps::Simulation::now();
+  double last=start;
+  while(sim.replaying())
+  {
+    double begin=fps::Simulation::now();
+    sim.advance(begin-last);
+    last=begin;
+    if(!sim.replaying())
+    {
+      break;
+    }
+    tickMs.push_back((fps::Simulation::now()-begin)*1000.0);
+    if(tickMs.back()>tickMs[slowest])
+    {
+      slowest=tickMs.size()-1;
+    }
+    if(sim.acquire())
+    {
+      const fps::FrameSnapshot &s=sim.snapshot();
+      add(s.m_eye.m_x);
+      add(s.m_eye.m_y);
+      add(s.m_eye.m_z);
+      add(s.m_front.m_x);
+      add(s.m_front.m_y);
+      add(s.m_front.m_z);
+    }
+    if(realTime)
+    {
+      std::this_thread::sleep_for(std::chrono::duration<double>(recording.dt()));
+    }
+  }
+  double seconds=fps::Simulation::now()-start;
+  if(tickMs.empty())
+  {
+    std::printf("%s holds no ticks\n",session.c_str());
+    return EXIT_SUCCESS;
+  }
+
+  std::vector<double> sorted(tickMs);
+  std::sort(sorted.begin(),sorted.end());
+  double total=0.0;
+  for(double ms : tickMs)
+  {
+    total+=ms;
+  }
+  const fps::CameraController::State camera=sim.controller().state();
+  std::printf("%zu ticks, %llu steps (%.1f s recorded) in %.3f s\n",tickMs.size(),
+              static_cast<unsigned long long>(recording.stepCount()),recording.seconds(),seconds);
+  std::printf("tick min/avg/p99/max %.3f/%.3f/%.3f/%.3f ms, slowest is tick %zu\n",sorted.front(),
+              total/tickMs.size(),sorted[std::min(sorted.size()-1,sorted.size()*99/100)],sorted.back(),slowest);
+  std::printf("camera ends at %.4f %.4f %.4f, path hash %016" PRIx64 "\n",camera.m_position.m_x,
+              camera.m_position.m_y,camera.m_position.m_z,path);
+  return EXIT_SUCCESS;
+}
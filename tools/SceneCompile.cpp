@@ -0,0 +1,25 @@
+/****************************************************************************
+compile a text scene into the binary form Scene::open maps directly
+usage FPSSceneCompile level.scene level.fpsb
+****************************************************************************/
+#include "Scene.h"
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char **argv)
+{
+  if(argc!=3)
+  {
+    std::fprintf(stderr,"usage %s in.scene out.fpsb\n",argv[0]);
+    return EXIT_FAILURE;
+  }
+  fps::Scene scene;
+  if(!scene.open(argv[1]) || !scene.save(argv[2]))
+  {
+    std::fprintf(stderr,"%s\n",scene.error().c_str());
+    return EXIT_FAILURE;
+  }
+  std::printf("%s: %zu meshes %zu vertices %zu materials %zu objects\n",argv[2],scene.meshCount(),
+              scene.vertexCount(),scene.materialCount(),scene.objectCount());
+  return EXIT_SUCCESS;
+}